@@ -0,0 +1,377 @@
+/**
+ * \file   adaptive-k-path.cpp
+ * \brief  Adaptive refinement of a path through reciprocal space
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "adaptive-k-path.h"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "constants.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Set up a path for refinement
+ *
+ * \param[in] k_coarse Initial list of wave vectors [1/m]
+ * \param[in] solver   Function that finds the bands at each point
+ */
+AdaptiveKPath::AdaptiveKPath(const std::vector<arma::vec> &k_coarse,
+                             const Solver                 &solver) :
+    _k_coarse(k_coarse),
+    _solver(solver),
+    _E_tol(5e-3*e),
+    _overlap_tol(0.9),
+    _deg_tol(1e-4*e),
+    _min_spacing(0.0),
+    _max_points(1000)
+{
+    if(_k_coarse.size() < 2)
+        throw std::invalid_argument("An adaptive path needs at least two wave vectors");
+}
+
+/**
+ * \brief Find the bands at a set of points, in parallel
+ */
+void AdaptiveKPath::evaluate(std::vector<Point> &points) const
+{
+    std::exception_ptr error;
+
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int ip = 0; ip < points.size(); ++ip)
+    {
+        try
+        {
+            _solver(points[ip].k, points[ip].E, points[ip].X, points[ip].E_below, points[ip].E_above);
+
+            if(points[ip].X.n_cols != points[ip].E.size())
+            {
+                std::ostringstream oss;
+                oss << "Solver returned " << points[ip].E.size() << " energies but "
+                    << points[ip].X.n_cols << " eigenvectors";
+                throw std::length_error(oss.str());
+            }
+        }
+        catch(...)
+        {
+#pragma omp critical
+            error = std::current_exception();
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+/**
+ * \brief Label the sets of degenerate bands
+ *
+ * \param[in] E Band energies, in ascending order [J]
+ *
+ * \returns The index of the degenerate set that contains each band
+ */
+arma::uvec AdaptiveKPath::find_degenerate_sets(const arma::vec &E) const
+{
+    arma::uvec set(E.size());
+    unsigned int iset = 0;
+
+    for(unsigned int ib = 0; ib < E.size(); ++ib)
+    {
+        if(ib > 0 && E(ib) - E(ib-1) > _deg_tol)
+            ++iset;
+
+        set(ib) = iset;
+    }
+
+    return set;
+}
+
+/**
+ * \brief Find whether the lowest or highest degenerate set at a point
+ *        continues past the bands that were returned by the solver
+ *
+ * \param[in]  p           Point on the path
+ * \param[out] cut_lowest  True if the lowest set continues to lower bands
+ * \param[out] cut_highest True if the highest set continues to higher bands
+ */
+void AdaptiveKPath::find_cut_sets(const Point &p,
+                                  bool        &cut_lowest,
+                                  bool        &cut_highest) const
+{
+    cut_lowest  = (p.E(0) - p.E_below <= _deg_tol);
+    cut_highest = (p.E_above - p.E(p.E.size()-1) <= _deg_tol);
+}
+
+/**
+ * \brief Find the smallest overlap between the eigenvectors at two points
+ *
+ * \details The squared overlaps are summed over each pair of degenerate
+ *          sets, and normalised by the size of the smaller set.  For each
+ *          set at the first point, the best match at the second point is
+ *          found.  The result is the worst of these matches, which is
+ *          close to one when every band continues smoothly.
+ *
+ *          Only part of a set that continues past the returned bands is
+ *          known, and its eigenvectors can mix with the missing bands.  The
+ *          lowest or highest set is therefore skipped if it is cut at
+ *          either point.
+ */
+double AdaptiveKPath::find_min_overlap(const Point &a,
+                                       const Point &b) const
+{
+    const arma::cx_mat O = a.X.t() * b.X;
+
+    const arma::uvec set_a = find_degenerate_sets(a.E);
+    const arma::uvec set_b = find_degenerate_sets(b.E);
+    const unsigned int n_sets_a = set_a(set_a.size()-1) + 1;
+    const unsigned int n_sets_b = set_b(set_b.size()-1) + 1;
+
+    arma::mat  W     = arma::zeros(n_sets_a, n_sets_b); // Summed squared overlap between sets
+    arma::uvec n_a   = arma::zeros<arma::uvec>(n_sets_a);
+    arma::uvec n_b   = arma::zeros<arma::uvec>(n_sets_b);
+
+    for(unsigned int i = 0; i < set_a.size(); ++i)
+        ++n_a(set_a(i));
+
+    for(unsigned int j = 0; j < set_b.size(); ++j)
+        ++n_b(set_b(j));
+
+    for(unsigned int j = 0; j < O.n_cols; ++j)
+        for(unsigned int i = 0; i < O.n_rows; ++i)
+            W(set_a(i), set_b(j)) += std::norm(O(i,j));
+
+    bool cut_lowest_a  = false;
+    bool cut_highest_a = false;
+    bool cut_lowest_b  = false;
+    bool cut_highest_b = false;
+    find_cut_sets(a, cut_lowest_a, cut_highest_a);
+    find_cut_sets(b, cut_lowest_b, cut_highest_b);
+
+    double min_overlap = 1.0;
+
+    for(unsigned int I = 0; I < n_sets_a; ++I)
+    {
+        if((I == 0            && (cut_lowest_a  || cut_lowest_b)) ||
+           (I == n_sets_a - 1 && (cut_highest_a || cut_highest_b)))
+            continue;
+
+        double best = 0.0;
+
+        for(unsigned int J = 0; J < n_sets_b; ++J)
+            best = std::max(best, W(I,J)/std::min(n_a(I), n_b(J)));
+
+        min_overlap = std::min(min_overlap, best);
+    }
+
+    return min_overlap;
+}
+
+/**
+ * \brief Find the error in an interval, relative to the tolerances
+ *
+ * \param[in] a   Point at start of interval
+ * \param[in] mid Point at middle of interval
+ * \param[in] b   Point at end of interval
+ *
+ * \returns The larger of the interpolation error in energy and the
+ *          shortfall in overlap, each scaled so that the interval needs to
+ *          be split if the result is greater than one.
+ */
+double AdaptiveKPath::find_error(const Point &a,
+                                 const Point &mid,
+                                 const Point &b) const
+{
+    double E_err = 0.0;
+
+    for(unsigned int ib = 0; ib < mid.E.size(); ++ib)
+        E_err = std::max(E_err, std::abs(mid.E(ib) - 0.5*(a.E(ib) + b.E(ib))));
+
+    const double overlap = std::min(find_min_overlap(a, mid), find_min_overlap(mid, b));
+    double overlap_err = 0.0;
+
+    if(_overlap_tol < 1.0)
+        overlap_err = (1.0 - overlap)/(1.0 - _overlap_tol);
+    else if(overlap < _overlap_tol)
+        overlap_err = std::numeric_limits<double>::infinity();
+
+    return std::max(E_err/_E_tol, overlap_err);
+}
+
+/**
+ * \brief Find the bands along the refined path
+ *
+ * \details The bands are found at each point on the coarse path.  Each
+ *          interval that needs refinement is then split, and the
+ *          midpoints of all such intervals are found together.  This
+ *          repeats until no interval needs refinement, or until the
+ *          intervals reach the minimum spacing, or until the maximum
+ *          number of points is reached.
+ *
+ *          Each new interval inherits the error of the interval that it
+ *          was split from.  If there are more intervals than the remaining
+ *          number of points allows, those with the largest error are split
+ *          first.  The error of the coarse intervals is unknown, so they
+ *          are all split before any others.
+ */
+void AdaptiveKPath::refine()
+{
+    const size_t n_coarse = _k_coarse.size();
+
+    if(_max_points < n_coarse)
+    {
+        std::ostringstream oss;
+        oss << "Maximum number of points (" << _max_points << ") is smaller than the "
+            << n_coarse << " points on the coarse path";
+        throw std::domain_error(oss.str());
+    }
+
+    _points.assign(n_coarse, Point());
+
+    for(unsigned int ip = 0; ip < n_coarse; ++ip)
+    {
+        _points[ip].k = _k_coarse[ip];
+        _points[ip].s = (ip == 0) ? 0.0 : _points[ip-1].s + arma::norm(_k_coarse[ip] - _k_coarse[ip-1]);
+    }
+
+    evaluate(_points);
+
+    // Intervals to be split at the next level
+    std::vector<Interval> intervals;
+
+    for(unsigned int ip = 0; ip + 1 < n_coarse; ++ip)
+    {
+        if(_points[ip+1].s - _points[ip].s > _min_spacing)
+            intervals.push_back({ip, ip+1, std::numeric_limits<double>::infinity()});
+    }
+
+    while(!intervals.empty() && _points.size() < _max_points)
+    {
+        const size_t n_remaining = _max_points - _points.size();
+
+        if(intervals.size() > n_remaining)
+        {
+            std::stable_sort(intervals.begin(), intervals.end(),
+                             [](const Interval &i1, const Interval &i2) {return i1.error > i2.error;});
+            intervals.resize(n_remaining);
+        }
+
+        std::vector<Point> midpoints(intervals.size());
+
+        for(unsigned int i = 0; i < intervals.size(); ++i)
+        {
+            const auto &a = _points[intervals[i].a];
+            const auto &b = _points[intervals[i].b];
+            midpoints[i].s = 0.5*(a.s + b.s);
+            midpoints[i].k = 0.5*(a.k + b.k);
+        }
+
+        evaluate(midpoints);
+
+        std::vector<Interval> next;
+
+        for(unsigned int i = 0; i < intervals.size(); ++i)
+        {
+            const size_t ia    = intervals[i].a;
+            const size_t ib    = intervals[i].b;
+            const double error = find_error(_points[ia], midpoints[i], _points[ib]);
+            const bool   split = error > 1.0 && 0.5*(_points[ib].s - _points[ia].s) > _min_spacing;
+
+            const size_t imid = _points.size();
+            _points.push_back(midpoints[i]);
+
+            if(split)
+            {
+                next.push_back({ia, imid, error});
+                next.push_back({imid, ib, error});
+            }
+        }
+
+        intervals.swap(next);
+    }
+
+    std::stable_sort(_points.begin(), _points.end(),
+                     [](const Point &p1, const Point &p2) {return p1.s < p2.s;});
+
+    track_bands();
+}
+
+/**
+ * \brief Follow each band along the path
+ *
+ * \details At each step, the pair of bands with the largest overlap is
+ *          matched first, and this repeats until all bands are matched.
+ */
+void AdaptiveKPath::track_bands()
+{
+    const size_t nb = _points.front().E.size();
+    _order.assign(_points.size(), arma::uvec(nb));
+
+    for(unsigned int t = 0; t < nb; ++t)
+        _order[0](t) = t;
+
+    for(unsigned int ip = 1; ip < _points.size(); ++ip)
+    {
+        const arma::cx_mat O = _points[ip-1].X.t() * _points[ip].X;
+
+        std::vector<bool> tracked(nb, false); // Whether each tracked band has been matched
+        std::vector<bool> used(nb, false);    // Whether each band at this point has been used
+
+        for(unsigned int n_matched = 0; n_matched < nb; ++n_matched)
+        {
+            double       best   = -1.0;
+            unsigned int t_best = 0;
+            unsigned int j_best = 0;
+
+            for(unsigned int t = 0; t < nb; ++t)
+            {
+                if(tracked[t])
+                    continue;
+
+                for(unsigned int j = 0; j < nb; ++j)
+                {
+                    if(used[j])
+                        continue;
+
+                    const double w = std::norm(O(_order[ip-1](t), j));
+
+                    if(w > best)
+                    {
+                        best   = w;
+                        t_best = t;
+                        j_best = j;
+                    }
+                }
+            }
+
+            _order[ip](t_best) = j_best;
+            tracked[t_best] = true;
+            used[j_best]    = true;
+        }
+    }
+}
+
+/**
+ * \brief Get the band energies at a point, in the order given by tracking
+ *        each band from the start of the path [J]
+ */
+arma::vec AdaptiveKPath::get_E_tracked(const size_t ip) const
+{
+    const auto &E     = _points.at(ip).E;
+    const auto &order = _order.at(ip);
+    arma::vec E_tracked(E.size());
+
+    for(unsigned int t = 0; t < E.size(); ++t)
+        E_tracked(t) = E(order(t));
+
+    return E_tracked;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
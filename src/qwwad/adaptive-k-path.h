@@ -0,0 +1,148 @@
+/**
+ * \file   adaptive-k-path.h
+ * \brief  Adaptive refinement of a path through reciprocal space
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_ADAPTIVE_K_PATH_H
+#define QWWAD_ADAPTIVE_K_PATH_H
+
+#include <functional>
+#include <vector>
+#include <armadillo>
+
+namespace QWWAD
+{
+/**
+ * \brief A path through reciprocal space, refined where the bands change
+ *        rapidly
+ *
+ * \details The path starts from a coarse list of wave vectors.  Each
+ *          interval is split at its midpoint if either:
+ *
+ *          - the energy of any band at the midpoint differs from the linear
+ *            interpolation between the ends by more than a tolerance, which
+ *            detects strong curvature, extrema and kinks; or
+ *          - the eigenvectors at neighbouring points overlap by less than a
+ *            tolerance, which detects crossings and strong mixing.
+ *
+ *          Bands whose energies lie within a small tolerance of each other
+ *          are treated as a single degenerate set when finding overlaps, so
+ *          that arbitrary mixing within a degenerate set does not cause
+ *          refinement.  The solver also gives the energies of the nearest
+ *          bands outside the ones that it returns.  If a degenerate set
+ *          extends past either end, only part of it is known, and so it is
+ *          left out of the overlap test.
+ *
+ *          If the maximum number of points is reached, the intervals with
+ *          the largest error at the previous level are split first.
+ *
+ *          Each level of refinement is processed in parallel.  The solver is
+ *          therefore called from several threads at once, and must be
+ *          thread-safe.
+ *
+ *          After refinement, the identity of each band is followed along
+ *          the path by matching eigenvectors with the largest overlap.
+ */
+class AdaptiveKPath
+{
+public:
+    /**
+     * \brief Function that finds the bands at a wave vector
+     *
+     * \details The arguments are the wave vector [1/m], the energies [J]
+     *          and eigenvectors (one per column) of the bands, in ascending
+     *          order of energy, and the energies of the nearest bands below
+     *          and above those that are returned [J].  The last two should
+     *          be -∞ and +∞ if there is no such band.
+     */
+    typedef std::function<void(const arma::vec &, arma::vec &, arma::cx_mat &, double &, double &)> Solver;
+
+private:
+    /// Solution at a single point on the path
+    struct Point {
+        double       s;       ///< Distance along path [1/m]
+        arma::vec    k;       ///< Wave vector [1/m]
+        arma::vec    E;       ///< Energy of each band, in ascending order [J]
+        arma::cx_mat X;       ///< Eigenvector of each band, one per column
+        double       E_below; ///< Energy of nearest band below those returned [J]
+        double       E_above; ///< Energy of nearest band above those returned [J]
+    };
+
+    /// An interval between two points, to be split at its midpoint
+    struct Interval {
+        size_t a;     ///< Index of point at start
+        size_t b;     ///< Index of point at end
+        double error; ///< Error of the interval that contained it, relative to tolerance
+    };
+
+    std::vector<arma::vec> _k_coarse; ///< Initial list of wave vectors [1/m]
+    Solver                 _solver;   ///< Function that finds bands at each point
+
+    double _E_tol;       ///< Tolerance on interpolation error in energy [J]
+    double _overlap_tol; ///< Smallest allowed overlap between neighbouring eigenvectors
+    double _deg_tol;     ///< Largest energy separation between degenerate bands [J]
+    double _min_spacing; ///< Smallest interval that is split [1/m]
+    size_t _max_points;  ///< Largest number of points on the path
+
+    std::vector<Point>      _points; ///< Points on path, in order
+    std::vector<arma::uvec> _order;  ///< Index of each tracked band at each point
+
+    void evaluate(std::vector<Point> &points) const;
+
+    double find_error(const Point &a,
+                      const Point &mid,
+                      const Point &b) const;
+
+    double find_min_overlap(const Point &a,
+                            const Point &b) const;
+
+    arma::uvec find_degenerate_sets(const arma::vec &E) const;
+
+    void find_cut_sets(const Point &p,
+                       bool        &cut_lowest,
+                       bool        &cut_highest) const;
+
+    void track_bands();
+
+public:
+    AdaptiveKPath(const std::vector<arma::vec> &k_coarse,
+                  const Solver                 &solver);
+
+    void refine();
+
+    /// Set the tolerance on the interpolation error in energy [J]
+    inline void set_energy_tolerance(const double E_tol) {_E_tol = E_tol;}
+
+    /// Set the smallest allowed overlap between neighbouring eigenvectors (0 to 1)
+    inline void set_overlap_tolerance(const double overlap_tol) {_overlap_tol = overlap_tol;}
+
+    /// Set the largest energy separation between degenerate bands [J]
+    inline void set_degeneracy_tolerance(const double deg_tol) {_deg_tol = deg_tol;}
+
+    /// Set the smallest interval that is split [1/m]
+    inline void set_min_spacing(const double min_spacing) {_min_spacing = min_spacing;}
+
+    /// Set the largest number of points on the path
+    inline void set_max_points(const size_t max_points) {_max_points = max_points;}
+
+    /// Get the number of points on the path
+    inline size_t get_n_points() const {return _points.size();}
+
+    /// Get the distance along the path to a point [1/m]
+    inline double get_s(const size_t ip) const {return _points.at(ip).s;}
+
+    /// Get the wave vector at a point [1/m]
+    inline const arma::vec & get_k(const size_t ip) const {return _points.at(ip).k;}
+
+    /// Get the band energies at a point, in ascending order [J]
+    inline const arma::vec & get_E(const size_t ip) const {return _points.at(ip).E;}
+
+    /// Get the eigenvectors at a point, in ascending order of energy
+    inline const arma::cx_mat & get_eigenvectors(const size_t ip) const {return _points.at(ip).X;}
+
+    arma::vec get_E_tracked(const size_t ip) const;
+};
+} // namespace QWWAD
+#endif // QWWAD_ADAPTIVE_K_PATH_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,266 @@
+/**
+ * \file   carrier-carrier-form-factors.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Tables of form-factor data for carrier-carrier scattering
+ */
+
+#include "carrier-carrier-form-factors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "constants.h"
+#include "maths-helpers.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/** Tabulate the matrix element defined as
+ *    C_if⁺(q,z') = ∫_{z'}^∞ dz ψ_i(z) ψ_f(z)/exp(qz)]
+ *  for a given wavevector, with respect to position
+ */
+static arma::vec find_Cif_p(const arma::vec &psi_if,
+                            const arma::vec &exp_qz,
+                            const arma::vec &z)
+{
+    const size_t nz = z.size();
+    arma::vec Cif_p(nz);
+    const double dz=z[1]-z[0];
+
+    Cif_p[nz-1] = psi_if[nz-1] / exp_qz[nz-1] * dz;
+
+    for(int iz = nz-2; iz >=0; iz--)
+        Cif_p[iz] = Cif_p[iz+1] + psi_if[iz] / exp_qz[iz] * dz;
+
+    return Cif_p;
+}
+
+/**
+ * \brief Tabulate scattering matrix element component.
+ *
+ * \details defined as:
+ *    C_if⁻(q,z') = ∫_{-∞}^{z'} dz ψ_i(z) ψ_f(z) exp(qz)
+ *  for a given wavevector, with respect to position
+ *
+ * Note that the upper limit has to be the point just BEFORE each z'
+ * value so that we don't double count
+ */
+static arma::vec find_Cif_m(const arma::vec &psi_if,
+                            const arma::vec &exp_qz,
+                            const arma::vec &z)
+{
+    const size_t nz = z.size();
+    arma::vec Cif_m(nz);
+    const double dz = z[1]-z[0];
+
+    // Seed the first value as zero
+    Cif_m[0] = 0;
+
+    // Now, perform a block integration by summing on top of the previous
+    // value in the array
+    for(unsigned int iz = 1; iz < nz; iz++)
+        Cif_m[iz] = Cif_m[iz-1] + psi_if[iz-1] * exp_qz[iz-1] * dz;
+
+    return Cif_m;
+}
+
+/**
+ * \brief Create an array of exp(qz) with respect to position
+ *
+ * \param q[in]       Scattering vector [1/m]
+ * \param z[in]       Spatial positions [m]
+ */
+static arma::vec find_exp_qz(const double q, const arma::vec &z)
+{
+    // Use the start of the z array as the origin, so as to minimise the
+    // magnitude of the exponential terms
+    return exp(q * (z - z[0]));
+}
+
+/**
+ * \brief Set up empty tables on a grid of scattering vectors
+ *
+ * \param[in] subbands All subbands in the system
+ * \param[in] q_perp   Scattering vector samples, shared by all transitions [1/m]
+ * \param[in] T        Carrier temperature, for the screening [K]
+ */
+CarrierCarrierFormFactors::CarrierCarrierFormFactors(const std::vector<Subband> &subbands,
+                                                     const arma::vec            &q_perp,
+                                                     const double                T) :
+    _subbands(subbands),
+    _q_perp(q_perp),
+    _T(T),
+    _n_A_hits(0),
+    _n_A_misses(0)
+{
+    if(_q_perp.size() < 2)
+        throw std::invalid_argument("Need at least two scattering vector samples");
+}
+
+/**
+ * \brief Tabulate the matrix element I_jg(q,z) at each position
+ *
+ * \param[in] q_perp Scattering vector [1/m]
+ * \param[in] psi_jg Product of wavefunctions ψ_j ψ_g
+ * \param[in] z      Spatial positions [m]
+ *
+ * \details The matrix element is defined as
+ *            I_jg(q,z') = ∫dz ψ_j(z) ψ_g(z) exp(-q|z-z'|).
+ *          The modulus is removed by splitting the integral at z', so that
+ *            I_jg(q,z') = C_jg⁻(q,z')/exp(qz') + C_jg⁺(q,z') exp(qz'),
+ *          and the z' dependence is separated from the z dependence.
+ */
+arma::vec CarrierCarrierFormFactors::find_Ijg(const double     q_perp,
+                                              const arma::vec &psi_jg,
+                                              const arma::vec &z)
+{
+    const auto expTerm   = find_exp_qz(q_perp, z);
+    const auto Cjg_plus  = find_Cif_p(psi_jg, expTerm, z);
+    const auto Cjg_minus = find_Cif_m(psi_jg, expTerm, z);
+
+    return Cjg_minus/expTerm + Cjg_plus%expTerm;
+}
+
+/**
+ * \brief Find the polarizability of a subband, referred to by Smet as e_sc
+ *
+ * \param[in] isb    Subband
+ * \param[in] q_perp Scattering vector [1/m]
+ * \param[in] T      Carrier temperature [K]
+ */
+double CarrierCarrierFormFactors::find_PI(const Subband &isb,
+                                          const double   q_perp,
+                                          const double   T)
+{
+    const double m = isb.get_effective_mass();    // Effective mass at band-edge [kg]
+
+    // Now perform the integration, equation 44 of Smet [QWWAD3, 10.238]
+    const double Ek_max = isb.get_Ek_at_k(isb.get_k_max(T));
+    const size_t nE = 101;
+    const double dE = Ek_max/(nE-1);
+
+    arma::vec PI_integrand_dE(nE);
+
+    // Integrate from bottom of subband up to Ek_max (Ef + 5kT)
+    for(unsigned int iE = 0; iE < nE; ++iE)
+    {
+        const double Ek = iE*dE; // Kinetic energy
+        const double ki = isb.get_k_at_Ek(Ek);
+        const double Et = isb.get_E_total_at_k(ki);
+
+        // Find low-temperature polarizability *at this wave-vector*
+        // Equation 43 of Smet, QWWAD3, 10.236
+        double P0 = m/(pi*hBar*hBar);
+
+        if(q_perp>2*ki)
+            P0 -= m/(pi*hBar*hBar)*sqrt(1-4*ki*ki/(q_perp*q_perp));
+
+        const double cosh_term = cosh((Et - isb.get_Ef())/(2*kB*T));
+        PI_integrand_dE[iE] = P0/(4*kB*T*cosh_term*cosh_term);
+    }
+
+    const double result = integral(PI_integrand_dE, dE);
+    return result;
+}
+
+/**
+ * \brief Look up the matrix element I_jg(q,z) at each scattering vector
+ *
+ * \details The table is computed and cached if it has not been found
+ *          already.  I_jg is symmetric in j and g, so it is stored under
+ *          the ordered pair of indices.
+ */
+const arma::mat & CarrierCarrierFormFactors::get_I_table(const unsigned int j,
+                                                         const unsigned int g)
+{
+    auto &Ijg = _I[std::make_tuple(std::min(j,g), std::max(j,g))];
+
+    if(Ijg.is_empty())
+    {
+        const auto z = _subbands[j].z_array();
+        const arma::vec psi_jg = _subbands[j].psi_array() % _subbands[g].psi_array();
+        const size_t nq = _q_perp.size();
+        Ijg.set_size(z.size(), nq);
+
+        for(unsigned int iq = 0; iq < nq; ++iq)
+            Ijg.col(iq) = find_Ijg(_q_perp[iq], psi_jg, z);
+    }
+
+    return Ijg;
+}
+
+/**
+ * \brief Look up the matrix element A_ijfg at each scattering vector
+ *
+ * \details The table is computed and cached if it has not been found already
+ */
+const arma::vec & CarrierCarrierFormFactors::get_A_table(const unsigned int i,
+                                                         const unsigned int j,
+                                                         const unsigned int f,
+                                                         const unsigned int g)
+{
+    // Order the indices within each pair, and then order the pairs
+    auto if_pair = std::make_tuple(std::min(i,f), std::max(i,f));
+    auto jg_pair = std::make_tuple(std::min(j,g), std::max(j,g));
+
+    if(jg_pair < if_pair)
+        std::swap(if_pair, jg_pair);
+
+    const auto key = std::make_tuple(std::get<0>(if_pair), std::get<1>(if_pair),
+                                     std::get<0>(jg_pair), std::get<1>(jg_pair));
+
+    auto &Aijfg = _A[key];
+
+    if(!Aijfg.is_empty())
+    {
+        ++_n_A_hits;
+        return Aijfg;
+    }
+
+    ++_n_A_misses;
+
+    // The integral over the second pair of states depends only on that
+    // pair, so it is shared by every transition that involves it
+    const unsigned int a = std::get<0>(if_pair);
+    const unsigned int b = std::get<1>(if_pair);
+    const auto &Ijg = get_I_table(std::get<0>(jg_pair), std::get<1>(jg_pair));
+
+    const auto z  = _subbands[a].z_array();
+    const double dz = z[1] - z[0];
+    const arma::vec psi_if = _subbands[a].psi_array() % _subbands[b].psi_array();
+    const size_t nq = _q_perp.size();
+    Aijfg.set_size(nq);
+
+    for(unsigned int iq = 0; iq < nq; ++iq)
+    {
+        const arma::vec Aijfg_integrand = psi_if % Ijg.col(iq);
+        Aijfg[iq] = integral(Aijfg_integrand, dz);
+    }
+
+    return Aijfg;
+}
+
+/**
+ * \brief Look up the polarizability of a subband at each scattering vector
+ *
+ * \details The table is computed and cached if it has not been found already
+ */
+const arma::vec & CarrierCarrierFormFactors::get_PI_table(const unsigned int i)
+{
+    auto &PI_table = _PI[i];
+
+    if(PI_table.is_empty())
+    {
+        const size_t nq = _q_perp.size();
+        PI_table.set_size(nq);
+
+        for(unsigned int iq = 0; iq < nq; ++iq)
+            PI_table[iq] = find_PI(_subbands[i], _q_perp[iq], _T);
+    }
+
+    return PI_table;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
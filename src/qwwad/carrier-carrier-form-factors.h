@@ -0,0 +1,84 @@
+/**
+ * \file   carrier-carrier-form-factors.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Tables of form-factor data for carrier-carrier scattering
+ */
+
+#ifndef QWWAD_CARRIER_CARRIER_FORM_FACTORS_H
+#define QWWAD_CARRIER_CARRIER_FORM_FACTORS_H
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <armadillo>
+#include "subband.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Tables of form-factor data that are shared between carrier-carrier
+ *        transitions
+ *
+ * \details All tables are found on a single grid of scattering vectors,
+ *          which is shared by every transition, so each table is keyed only
+ *          by its subband indices.
+ *
+ *          The matrix element A_ijfg depends only on the products ψ_i ψ_f
+ *          and ψ_j ψ_g, so it is unchanged by swapping i↔f, j↔g or the
+ *          pairs (if)↔(jg).  Each table is stored under the canonical
+ *          ordering of its indices.
+ */
+class CarrierCarrierFormFactors
+{
+private:
+    std::vector<Subband> _subbands; ///< All subbands in the system
+    arma::vec            _q_perp;   ///< Scattering vector samples [1/m]
+    double               _T;        ///< Carrier temperature, for screening [K]
+
+    /// Matrix element A_ijfg at each scattering vector
+    std::map<std::tuple<unsigned int, unsigned int, unsigned int, unsigned int>, arma::vec> _A;
+
+    /// Polarizability of a subband at each scattering vector
+    std::map<unsigned int, arma::vec> _PI;
+
+    /// Integral I_jg(q,z) for a pair of subbands, with one column per scattering vector
+    std::map<std::tuple<unsigned int, unsigned int>, arma::mat> _I;
+
+    size_t _n_A_hits;   ///< Number of A_ijfg lookups that found a cached table
+    size_t _n_A_misses; ///< Number of A_ijfg tables that were computed
+
+public:
+    CarrierCarrierFormFactors(const std::vector<Subband> &subbands,
+                              const arma::vec            &q_perp,
+                              const double                T);
+
+    const arma::vec & get_A_table(const unsigned int i,
+                                  const unsigned int j,
+                                  const unsigned int f,
+                                  const unsigned int g);
+
+    const arma::mat & get_I_table(const unsigned int j,
+                                  const unsigned int g);
+
+    const arma::vec & get_PI_table(const unsigned int i);
+
+    /// Get the scattering vector samples [1/m]
+    inline const arma::vec & get_q_perp() const {return _q_perp;}
+
+    /// Get the number of A_ijfg lookups that found a cached table
+    inline size_t get_n_A_hits() const {return _n_A_hits;}
+
+    /// Get the number of A_ijfg tables that were computed
+    inline size_t get_n_A_misses() const {return _n_A_misses;}
+
+    static arma::vec find_Ijg(const double     q_perp,
+                              const arma::vec &psi_jg,
+                              const arma::vec &z);
+
+    static double find_PI(const Subband &isb,
+                          const double   q_perp,
+                          const double   T);
+};
+} // namespace QWWAD
+#endif // QWWAD_CARRIER_CARRIER_FORM_FACTORS_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -1,5 +1,6 @@
 #include "eigenstate.h"
 #include <sstream>
+#include <stdexcept>
 #include "maths-helpers.h"
 #include "file-io.h"
 
@@ -165,7 +166,7 @@ void Eigenstate::write_to_file(const std::string             &Eigenval_name,
 double Eigenstate::get_expectation_position() const
 {
     const auto dz = _z[1] - _z[0];
-    const decltype(_psi) dz_av = _psi * _psi * _z;
+    const decltype(_psi) dz_av = _psi % _psi % _z;
 
     return integral(dz_av, dz);
 }
@@ -184,7 +185,8 @@ double Eigenstate::get_expectation_position() const
  *       not too important however, because the matrix element for an
  *       intrasubband transition is never really used!
  */
-double mij(const Eigenstate &i, const Eigenstate &j)
+double Eigenstate::get_position_matrix_element(const Eigenstate &i,
+                                               const Eigenstate &j)
 {
     // FIXME: Currently it is assumed that both states use same spatial grid
     const auto z = i.get_position_samples();
@@ -203,11 +205,148 @@ double mij(const Eigenstate &i, const Eigenstate &j)
     const auto psi_i = i.get_wavefunction_samples();
     const auto psi_j = j.get_wavefunction_samples();
 
-    const arma::vec dmij = psi_i * (z - z0) * psi_j;
+    const arma::vec dmij = psi_i % (z - z0) % psi_j;
 
     return integral(dmij, dz);
 }
 
+/**
+ * \brief Collect the wavefunctions for a set of states into a matrix
+ *
+ * \param[in] states The eigenstates, which must all use the same spatial grid
+ *
+ * \returns A matrix with one column for each state [m^{-0.5}]
+ */
+arma::mat Eigenstate::get_wavefunction_matrix(const std::vector<Eigenstate> &states)
+{
+    if(states.empty())
+        throw std::invalid_argument("No eigenstates were given");
+
+    const auto nz  = states[0]._psi.size();
+    const auto nst = states.size();
+    arma::mat psi(nz, nst);
+
+    for(unsigned int ist = 0; ist < nst; ++ist)
+    {
+        if(states[ist]._psi.size() != nz)
+        {
+            std::ostringstream oss;
+            oss << "State " << ist+1 << " has " << states[ist]._psi.size()
+                << " spatial samples, but state 1 has " << nz << ".";
+            throw std::length_error(oss.str());
+        }
+
+        psi.col(ist) = states[ist]._psi;
+    }
+
+    return psi;
+}
+
+/**
+ * \brief Find the overlap ∫ψ_i ψ_j dz between all pairs of states
+ *
+ * \param[in] states The eigenstates, which must all use the same spatial grid
+ *
+ * \details The diagonal elements are unity.  Off-diagonal elements are only
+ *          zero if the states are orthogonal, which is not the case for
+ *          solutions of a nonparabolic Hamiltonian.
+ */
+arma::mat Eigenstate::get_overlap_matrix(const std::vector<Eigenstate> &states)
+{
+    const auto psi = get_wavefunction_matrix(states);
+    const auto z   = states[0]._z;
+    const arma::vec w = quadrature_weights(z.size(), z[1] - z[0]);
+
+    const arma::mat w_psi = arma::diagmat(w) * psi;
+    return psi.t() * w_psi;
+}
+
+/**
+ * \brief Find the dipole matrix elements ∫ψ_i z ψ_j dz between all pairs of states [m]
+ *
+ * \param[in] states The eigenstates, which must all use the same spatial grid
+ *
+ * \details All elements are found together as the matrix product ΨᵀZΨ,
+ *          where Z contains the quadrature weight times the position at
+ *          each point.  As in get_position_matrix_element(), each
+ *          off-diagonal element is taken relative to the point halfway
+ *          between the expectation positions of the two states, which
+ *          removes the dependence on the origin when the states are not
+ *          orthogonal.  The diagonal elements give the expectation
+ *          position of each state.
+ */
+arma::mat Eigenstate::get_position_matrix(const std::vector<Eigenstate> &states)
+{
+    const auto psi = get_wavefunction_matrix(states);
+    const auto z   = states[0]._z;
+    const arma::vec w = quadrature_weights(z.size(), z[1] - z[0]);
+
+    const arma::mat w_psi = arma::diagmat(w) * psi;
+    const arma::mat S     = psi.t() * w_psi;
+    const arma::mat wz_psi = arma::diagmat(z) * w_psi;
+    arma::mat Z = psi.t() * wz_psi;
+
+    // Shift each element to its pivot point, z0 = (<z>_i + <z>_j)/2
+    const arma::vec z_exp = Z.diag();
+    const auto nst = states.size();
+
+    for(unsigned int j = 0; j < nst; ++j)
+    {
+        for(unsigned int i = 0; i < nst; ++i)
+        {
+            if(i != j)
+                Z(i,j) -= 0.5*(z_exp[i] + z_exp[j]) * S(i,j);
+        }
+    }
+
+    return Z;
+}
+
+/**
+ * \brief Find the matrix elements ∫ψ_i z² ψ_j dz between all pairs of states [m^2]
+ *
+ * \param[in] states The eigenstates, which must all use the same spatial grid
+ *
+ * \details Positions are measured from the origin of the spatial grid
+ */
+arma::mat Eigenstate::get_position_squared_matrix(const std::vector<Eigenstate> &states)
+{
+    const auto psi = get_wavefunction_matrix(states);
+    const auto z   = states[0]._z;
+    const arma::vec wz2 = quadrature_weights(z.size(), z[1] - z[0]) % z % z;
+
+    const arma::mat wz2_psi = arma::diagmat(wz2) * psi;
+    return psi.t() * wz2_psi;
+}
+
+/**
+ * \brief Find the matrix elements ∫ψ_i dψ_j/dz dz between all pairs of states [1/m]
+ *
+ * \param[in] states The eigenstates, which must all use the same spatial grid
+ *
+ * \details The momentum matrix element is p_ij = -iħ times this value.  The
+ *          derivatives are found by central differences, with the end points
+ *          taken as zero, and all elements are then found together as the
+ *          matrix product ΨᵀDΨ.
+ */
+arma::mat Eigenstate::get_momentum_matrix(const std::vector<Eigenstate> &states)
+{
+    const auto psi = get_wavefunction_matrix(states);
+    const auto z   = states[0]._z;
+    const auto nz  = z.size();
+    const auto dz  = z[1] - z[0];
+
+    if(nz < 3)
+        throw std::length_error("Need at least three spatial samples to find derivatives");
+
+    arma::mat d_psi_dz(nz, states.size(), arma::fill::zeros);
+    d_psi_dz.rows(1, nz-2) = (psi.rows(2, nz-1) - psi.rows(0, nz-3))/(2*dz);
+
+    const arma::vec w = quadrature_weights(nz, dz);
+    const arma::mat w_psi = arma::diagmat(w) * psi;
+    return w_psi.t() * d_psi_dz;
+}
+
 /**
  * \brief Find the largest probability density at any point in a set of eigenstates
  */
@@ -8,6 +8,7 @@
 #define QWWAD_EIGENSTATE
 
 #include <string>
+#include <vector>
 #include <armadillo>
 
 namespace QWWAD {
@@ -25,6 +26,8 @@ private:
     double get_total_probability() const;
     void normalise();
 
+    static arma::mat get_wavefunction_matrix(const std::vector<Eigenstate> &states);
+
 public:
     Eigenstate(decltype(_E)   E,
                decltype(_z)   z,
@@ -56,6 +59,11 @@ public:
     // TODO: Should probably be part of an Operator class
     static double get_position_matrix_element(const Eigenstate &i,
                                               const Eigenstate &j);
+
+    static arma::mat get_overlap_matrix(const std::vector<Eigenstate> &states);
+    static arma::mat get_position_matrix(const std::vector<Eigenstate> &states);
+    static arma::mat get_position_squared_matrix(const std::vector<Eigenstate> &states);
+    static arma::mat get_momentum_matrix(const std::vector<Eigenstate> &states);
 };
 } // namespace
 #endif
@@ -0,0 +1,459 @@
+/**
+ * \file   ensemble-monte-carlo.cpp
+ * \brief  Ensemble Monte Carlo simulation of in-plane carrier transport
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "ensemble-monte-carlo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include "constants.h"
+#include "scattering-calculator.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Create a Monte Carlo simulation
+ *
+ * \param[in] subbands The subbands in the system
+ * \param[in] Ek_max   Largest kinetic energy in the rate tables [J]
+ * \param[in] nEk      Number of points in the kinetic-energy grid
+ */
+EnsembleMonteCarlo::EnsembleMonteCarlo(const std::vector<Subband> &subbands,
+                                       const double                Ek_max,
+                                       const size_t                nEk) :
+    _subbands(subbands),
+    _Ek(arma::linspace(0, Ek_max, nEk)),
+    _dEk(Ek_max/(nEk-1)),
+    _F(0.0),
+    _q(-e),
+    _Te0(300),
+    _nhist(100)
+{
+    if(_subbands.empty())
+        throw std::invalid_argument("No subbands were given for Monte Carlo simulation");
+
+    if(nEk < 2)
+        throw std::domain_error("At least two kinetic-energy samples are needed");
+
+    if(Ek_max <= 0)
+        throw std::domain_error("Maximum kinetic energy must be positive");
+}
+
+/**
+ * \brief Add a table of scattering rates for a process
+ *
+ * \param[in] i  Initial subband index
+ * \param[in] f  Final subband index
+ * \param[in] dE Energy gained by carrier in each event [J]
+ * \param[in] Ek Initial kinetic energy at each sample, in ascending order [J]
+ * \param[in] W  Scattering rate at each sample [1/s]
+ *
+ * \details The rates are interpolated linearly onto the kinetic-energy
+ *          grid.  Below the first sample, the rate is zero.  Above the last
+ *          sample, the last rate is used.
+ */
+void EnsembleMonteCarlo::add_rate_table(const unsigned int  i,
+                                        const unsigned int  f,
+                                        const double        dE,
+                                        const arma::vec    &Ek,
+                                        const arma::vec    &W)
+{
+    const auto nst = _subbands.size();
+
+    if(i >= nst || f >= nst)
+    {
+        std::ostringstream oss;
+        oss << "Rate table for transition " << i+1 << "→" << f+1
+            << " refers to a subband outside the system (" << nst << " subbands).";
+        throw std::domain_error(oss.str());
+    }
+
+    if(Ek.size() != W.size() || Ek.empty())
+        throw std::length_error("Rate table must contain the same, non-zero, number of energies and rates");
+
+    for(unsigned int iE = 1; iE < Ek.size(); ++iE)
+    {
+        if(Ek[iE] < Ek[iE-1])
+            throw std::invalid_argument("Energies in rate table must be in ascending order");
+    }
+
+    const auto nEk = _Ek.size();
+    arma::vec W_grid(nEk);
+
+    for(unsigned int iE = 0; iE < nEk; ++iE)
+    {
+        const auto E = _Ek[iE];
+
+        if(E < Ek[0])
+            W_grid[iE] = 0.0;
+        else if(E >= Ek[Ek.size()-1])
+            W_grid[iE] = W[W.size()-1];
+        else
+        {
+            // Find the first sample above this energy
+            const auto upper = std::upper_bound(Ek.begin(), Ek.end(), E) - Ek.begin();
+            const auto E0 = Ek[upper-1];
+            const auto E1 = Ek[upper];
+            W_grid[iE] = (E1 > E0) ? W[upper-1] + (W[upper] - W[upper-1]) * (E - E0)/(E1 - E0)
+                                   : W[upper];
+        }
+    }
+
+    if(arma::any(W_grid < 0))
+        throw std::domain_error("Scattering rates must not be negative");
+
+    _tables.push_back({i, f, dE, W_grid});
+}
+
+/**
+ * \brief Add rate tables for every pair of subbands using a scattering calculator
+ *
+ * \param[in] calc Scattering-rate calculator
+ * \param[in] dE   Energy gained by carrier in each event [J]
+ *
+ * \details Transitions with zero rate throughout the grid are skipped.
+ */
+void EnsembleMonteCarlo::add_mechanism(const ScatteringCalculator &calc,
+                                       const double                dE)
+{
+    const auto nst = _subbands.size();
+
+    if(calc.get_subbands().size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Scattering calculator has " << calc.get_subbands().size()
+            << " subbands, but the simulation has " << nst << ".";
+        throw std::length_error(oss.str());
+    }
+
+    const auto ntx = nst*nst;
+    const auto nEk = _Ek.size();
+    arma::uvec i_idx(ntx);
+    arma::uvec f_idx(ntx);
+    arma::mat  ki(nEk, ntx);
+
+    for(unsigned int i = 0; i < nst; ++i)
+    {
+        for(unsigned int f = 0; f < nst; ++f)
+        {
+            const auto itx = i*nst + f;
+            i_idx[itx] = i;
+            f_idx[itx] = f;
+
+            for(unsigned int iE = 0; iE < nEk; ++iE)
+                ki(iE, itx) = _subbands[i].get_k_at_Ek(_Ek[iE]);
+        }
+    }
+
+    const arma::mat W = calc.get_rate_tables(i_idx, f_idx, ki);
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        const arma::vec W_tx = W.col(itx);
+
+        if(arma::any(W_tx > 0))
+            add_rate_table(i_idx[itx], f_idx[itx], dE, _Ek, W_tx);
+    }
+}
+
+/**
+ * \brief Find the scattering rate for a process at a given kinetic energy [1/s]
+ */
+double EnsembleMonteCarlo::get_rate(const RateTable &table,
+                                    const double     Ek) const
+{
+    const auto nEk = _Ek.size();
+    const double x = Ek/_dEk;
+
+    if(x >= nEk-1)
+        return table.W[nEk-1];
+
+    const auto iE = (unsigned int)x;
+    const auto frac = x - iE;
+
+    return table.W[iE] + (table.W[iE+1] - table.W[iE])*frac;
+}
+
+/**
+ * \brief Find the in-plane group velocity in the direction of the field [m/s]
+ *
+ * \param[in] isb Subband index
+ * \param[in] kx  Wave-vector component in direction of field [1/m]
+ * \param[in] k   Magnitude of wave-vector [1/m]
+ *
+ * \details The velocity is found from the gradient of the dispersion, so
+ *          that nonparabolicity is included.
+ */
+double EnsembleMonteCarlo::get_velocity(const unsigned int isb,
+                                        const double       kx,
+                                        const double       k) const
+{
+    if(k == 0.0)
+        return 0.0;
+
+    const auto &sb = _subbands[isb];
+    const double dk = 1e-4*k;
+    const double dE_dk = (sb.get_Ek_at_k(k + dk) - sb.get_Ek_at_k(k - dk))/(2*dk);
+
+    return dE_dk/hBar * kx/k;
+}
+
+/**
+ * \brief Run the simulation
+ *
+ * \param[in] pop0       Initial population of each subband (any units)
+ * \param[in] nparticles Number of simulated carriers
+ * \param[in] t_total    Total simulation time [s]
+ * \param[in] nsamples   Number of equally-spaced sampling times
+ * \param[in] seed       Seed for random-number generation
+ *
+ * \details Carriers start with a thermal distribution of kinetic energy at
+ *          the initial temperature.  The steady-state results are averaged
+ *          over the second half of the sampling times.
+ *
+ * \returns The transient and steady-state results
+ */
+MonteCarloResult EnsembleMonteCarlo::run(const arma::vec     &pop0,
+                                         const size_t         nparticles,
+                                         const double         t_total,
+                                         const size_t         nsamples,
+                                         const unsigned long  seed) const
+{
+    const auto nst = _subbands.size();
+
+    if(pop0.size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Initial population is given for " << pop0.size() << " subbands, but there are "
+            << nst << ".";
+        throw std::length_error(oss.str());
+    }
+
+    if(arma::any(pop0 < 0) || arma::accu(pop0) <= 0)
+        throw std::domain_error("Initial populations must be non-negative, with a positive total");
+
+    if(nparticles == 0 || nsamples == 0 || t_total <= 0)
+        throw std::domain_error("Need a positive number of particles, samples and simulation time");
+
+    if(_nhist == 0)
+        throw std::domain_error("Need at least one histogram bin");
+
+    // Group the rate tables by initial subband, and find the maximum total
+    // scattering rate out of each subband
+    std::vector<std::vector<unsigned int>> tables_from(nst);
+    arma::vec Gamma(nst, arma::fill::zeros);
+
+    {
+        arma::mat W_total(_Ek.size(), nst, arma::fill::zeros);
+
+        for(unsigned int itab = 0; itab < _tables.size(); ++itab)
+        {
+            tables_from[_tables[itab].i].push_back(itab);
+            W_total.col(_tables[itab].i) += _tables[itab].W;
+        }
+
+        for(unsigned int isb = 0; isb < nst; ++isb)
+            Gamma[isb] = W_total.col(isb).max();
+    }
+
+    const arma::vec pop_cum = arma::cumsum(pop0);
+    const arma::vec t       = arma::linspace(t_total/nsamples, t_total, nsamples);
+    const size_t    is_ss   = nsamples/2;       // First steady-state sample
+    const size_t    nss     = nsamples - is_ss; // Number of steady-state samples
+    const double    kT      = kB*_Te0;
+    const double    dkx_dt  = _q*_F/hBar;       // Rate of change of wave-vector in free flight
+    const double    Ek_max  = _Ek[_Ek.size()-1];
+
+    // Totals for a block of particles
+    struct BlockResult {
+        arma::vec  v_t;
+        arma::vec  Ek_t;
+        arma::vec  count;
+        arma::vec  v_sum;
+        double     Ek_sum;
+        arma::mat  hist;
+        arma::vec  n_scatter;
+    };
+
+    const size_t block_size = 256;
+    const size_t nblocks    = (nparticles + block_size - 1)/block_size;
+    std::vector<BlockResult> blocks(nblocks);
+    std::exception_ptr error;
+
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int iblock = 0; iblock < nblocks; ++iblock)
+    {
+        try
+        {
+            auto &block = blocks[iblock];
+            block.v_t       = arma::zeros(nsamples);
+            block.Ek_t      = arma::zeros(nsamples);
+            block.count     = arma::zeros(nst);
+            block.v_sum     = arma::zeros(nst);
+            block.Ek_sum    = 0.0;
+            block.hist      = arma::zeros(_nhist, nst);
+            block.n_scatter = arma::zeros(_tables.size());
+
+            const size_t ip_stop = std::min((iblock+1)*block_size, nparticles);
+
+            for(size_t ip = iblock*block_size; ip < ip_stop; ++ip)
+            {
+                // Each particle has its own random-number stream
+                const unsigned long long seed_ll = seed;
+                const unsigned long long ip_ll   = ip;
+                std::seed_seq seq{(unsigned int)(seed_ll & 0xffffffff), (unsigned int)(seed_ll >> 32),
+                                  (unsigned int)(ip_ll   & 0xffffffff), (unsigned int)(ip_ll   >> 32)};
+                std::mt19937_64 rng(seq);
+                std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+                // Pick the initial subband according to the population, and a
+                // thermal kinetic energy
+                const double r_sb = uniform(rng)*pop_cum[nst-1];
+                unsigned int isb = 0;
+
+                while(isb < nst-1 && pop_cum[isb] <= r_sb)
+                    ++isb;
+
+                const double Ek0  = (kT > 0) ? -kT*log(1.0 - uniform(rng)) : 0.0;
+                const double k0   = _subbands[isb].get_k_at_Ek(Ek0);
+                const double phi0 = 2*pi*uniform(rng);
+                double kx = k0*cos(phi0);
+                double ky = k0*sin(phi0);
+                double t_now = 0.0;
+
+                for(unsigned int is = 0; is < nsamples; ++is)
+                {
+                    // Fly and scatter until the next sampling time.  Since the
+                    // flight-time distribution is memoryless, any flight that
+                    // would pass the sampling time is simply truncated.
+                    while(true)
+                    {
+                        const double t_flight = (Gamma[isb] > 0)
+                                                ? -log(1.0 - uniform(rng))/Gamma[isb]
+                                                : std::numeric_limits<double>::infinity();
+
+                        if(t_now + t_flight >= t[is])
+                        {
+                            kx += dkx_dt*(t[is] - t_now);
+                            t_now = t[is];
+                            break;
+                        }
+
+                        kx += dkx_dt*t_flight;
+                        t_now += t_flight;
+
+                        const double k  = hypot(kx, ky);
+                        const double Ek = _subbands[isb].get_Ek_at_k(k);
+
+                        // Select a process, or self-scattering if the random
+                        // number lies beyond the sum of the real rates
+                        double r_W = uniform(rng)*Gamma[isb];
+
+                        for(const auto itab : tables_from[isb])
+                        {
+                            const auto &table = _tables[itab];
+                            r_W -= get_rate(table, Ek);
+
+                            if(r_W < 0)
+                            {
+                                const double Ek_f = Ek + _subbands[isb].get_E_min()
+                                                  - _subbands[table.f].get_E_min() + table.dE;
+
+                                // Reject events that would violate energy
+                                // conservation due to interpolation error
+                                if(Ek_f >= 0)
+                                {
+                                    const double k_f   = _subbands[table.f].get_k_at_Ek(Ek_f);
+                                    const double phi_f = 2*pi*uniform(rng);
+                                    kx  = k_f*cos(phi_f);
+                                    ky  = k_f*sin(phi_f);
+                                    isb = table.f;
+                                    block.n_scatter[itab] += 1;
+                                }
+
+                                break;
+                            }
+                        }
+                    }
+
+                    const double k  = hypot(kx, ky);
+                    const double Ek = _subbands[isb].get_Ek_at_k(k);
+                    const double v  = get_velocity(isb, kx, k);
+
+                    block.v_t[is]  += v;
+                    block.Ek_t[is] += Ek;
+
+                    if(is >= is_ss)
+                    {
+                        const auto ibin = std::min((size_t)(Ek/Ek_max*_nhist), _nhist-1);
+                        block.count[isb]      += 1;
+                        block.v_sum[isb]      += v;
+                        block.Ek_sum          += Ek;
+                        block.hist(ibin, isb) += 1;
+                    }
+                }
+            }
+        }
+        catch(...)
+        {
+#pragma omp critical
+            error = std::current_exception();
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+
+    // Sum the blocks in order, so that the result doesn't depend on threading
+    arma::vec v_t       = arma::zeros(nsamples);
+    arma::vec Ek_t      = arma::zeros(nsamples);
+    arma::vec count     = arma::zeros(nst);
+    arma::vec v_sum     = arma::zeros(nst);
+    double    Ek_sum    = 0.0;
+    arma::mat hist      = arma::zeros(_nhist, nst);
+    arma::vec n_scatter = arma::zeros(_tables.size());
+
+    for(const auto &block : blocks)
+    {
+        v_t       += block.v_t;
+        Ek_t      += block.Ek_t;
+        count     += block.count;
+        v_sum     += block.v_sum;
+        Ek_sum    += block.Ek_sum;
+        hist      += block.hist;
+        n_scatter += block.n_scatter;
+    }
+
+    const double n_ss = (double)nparticles*nss; // Number of steady-state samples
+
+    MonteCarloResult result;
+    result.t             = t;
+    result.v_drift_t     = v_t/nparticles;
+    result.Ek_mean_t     = Ek_t/nparticles;
+    result.population    = count/n_ss;
+    result.v_drift       = arma::zeros(nst);
+    result.v_drift_total = arma::accu(v_sum)/n_ss;
+    result.Ek_mean       = Ek_sum/n_ss;
+    result.Ek_bins       = (arma::linspace(0, _nhist-1, _nhist) + 0.5)*Ek_max/_nhist;
+    result.distribution  = hist/n_ss;
+    result.n_scatter     = n_scatter;
+
+    for(unsigned int isb = 0; isb < nst; ++isb)
+    {
+        if(count[isb] > 0)
+            result.v_drift[isb] = v_sum[isb]/count[isb];
+    }
+
+    return result;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,127 @@
+/**
+ * \file   ensemble-monte-carlo.h
+ * \brief  Ensemble Monte Carlo simulation of in-plane carrier transport
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_ENSEMBLE_MONTE_CARLO_H
+#define QWWAD_ENSEMBLE_MONTE_CARLO_H
+
+#include <vector>
+#include <armadillo>
+#include "subband.h"
+
+namespace QWWAD
+{
+class ScatteringCalculator;
+
+/**
+ * \brief Results from an ensemble Monte Carlo simulation
+ */
+struct MonteCarloResult
+{
+    arma::vec t;              ///< Sampling times [s]
+    arma::vec v_drift_t;      ///< Ensemble-average in-plane velocity at each time [m/s]
+    arma::vec Ek_mean_t;      ///< Ensemble-average kinetic energy at each time [J]
+
+    arma::vec population;     ///< Steady-state fraction of carriers in each subband
+    arma::vec v_drift;        ///< Steady-state average velocity in each subband [m/s]
+    double    v_drift_total;  ///< Steady-state average velocity of all carriers [m/s]
+    double    Ek_mean;        ///< Steady-state mean kinetic energy [J]
+    arma::vec Ek_bins;        ///< Centre of each kinetic-energy histogram bin [J]
+    arma::mat distribution;   ///< Steady-state fraction of carriers in each energy bin (rows) and subband (columns)
+    arma::vec n_scatter;      ///< Number of real scattering events for each rate table
+};
+
+/**
+ * \brief An ensemble Monte Carlo simulation of carriers in a set of subbands
+ *
+ * \details Each carrier drifts freely in-plane under a constant electric
+ *          field, and is scattered between subbands according to a set of
+ *          tabulated rates.  Each table gives the rate of scattering from
+ *          subband i to subband f as a function of initial kinetic energy,
+ *          together with the energy gained by the carrier (e.g., the phonon
+ *          energy for absorption).
+ *
+ *          Free-flight times are generated using the self-scattering scheme.
+ *          The total rate out of each subband is bounded by a constant,
+ *          and scattering events are chosen by rejection against this bound.
+ *          The direction of the final wave-vector is chosen at random.
+ *
+ *          The rate tables are interpolated onto a uniform kinetic-energy
+ *          grid.  Carriers above the top of the grid use the rates at the
+ *          top of the grid.
+ *
+ *          Carriers are independent, so the simulation is divided into
+ *          fixed blocks of carriers which may run on separate threads.  Each
+ *          carrier has its own random-number stream, seeded from the global
+ *          seed and its index, and the results are summed block-by-block in
+ *          a fixed order.  A given seed therefore gives identical results
+ *          regardless of the number of threads.
+ */
+class EnsembleMonteCarlo
+{
+private:
+    /// Rates for one scattering process between a pair of subbands
+    struct RateTable {
+        unsigned int i;  ///< Initial subband index
+        unsigned int f;  ///< Final subband index
+        double       dE; ///< Energy gained by carrier [J]
+        arma::vec    W;  ///< Rate at each kinetic energy on the grid [1/s]
+    };
+
+    std::vector<Subband>   _subbands; ///< Subbands in the system
+    arma::vec              _Ek;       ///< Kinetic-energy grid [J]
+    double                 _dEk;      ///< Spacing of kinetic-energy grid [J]
+    std::vector<RateTable> _tables;   ///< Rate tables for all processes
+
+    double _F;      ///< In-plane electric field [V/m]
+    double _q;      ///< Charge of carriers [C]
+    double _Te0;    ///< Temperature of initial carrier distribution [K]
+    size_t _nhist;  ///< Number of kinetic-energy histogram bins
+
+    double get_rate(const RateTable &table,
+                    const double     Ek) const;
+
+    double get_velocity(const unsigned int isb,
+                        const double       kx,
+                        const double       k) const;
+
+public:
+    EnsembleMonteCarlo(const std::vector<Subband> &subbands,
+                       const double                Ek_max,
+                       const size_t                nEk);
+
+    void add_rate_table(const unsigned int  i,
+                        const unsigned int  f,
+                        const double        dE,
+                        const arma::vec    &Ek,
+                        const arma::vec    &W);
+
+    void add_mechanism(const ScatteringCalculator &calc,
+                       const double                dE);
+
+    /// Set the in-plane electric field [V/m]
+    void set_field(const double F) {_F = F;}
+
+    /// Set the charge of the carriers [C]
+    void set_charge(const double q) {_q = q;}
+
+    /// Set the temperature of the initial carrier distribution [K]
+    void set_initial_temperature(const double Te0) {_Te0 = Te0;}
+
+    /// Set the number of bins in the kinetic-energy histogram
+    void set_histogram_bins(const size_t nhist) {_nhist = nhist;}
+
+    /// Get the number of rate tables
+    size_t get_n_tables() const {return _tables.size();}
+
+    MonteCarloResult run(const arma::vec     &pop0,
+                         const size_t         nparticles,
+                         const double         t_total,
+                         const size_t         nsamples,
+                         const unsigned long  seed) const;
+};
+} // namespace QWWAD
+#endif // QWWAD_ENSEMBLE_MONTE_CARLO_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -7,9 +7,11 @@
 #include "fermi.h"
 
 #include "constants.h"
+#include <cmath>
+#include <exception>
+#include <sstream>
 #include <stdexcept>
-#include <gsl/gsl_errno.h>
-#include <gsl/gsl_roots.h>
+#include <gsl/gsl_math.h>
 #include <gsl/gsl_sf_dilog.h>
 #include <gsl/gsl_sf_fermi_dirac.h>
 
@@ -93,57 +95,76 @@ double find_pop(const double Esb,
 }
 
 /**
- * \brief Parameters used for checking the population
- */
-struct pop_params {
-    double Esb;     ///< Subband minimum [J]
-    double m0;      ///< Band-edge effective mass [kg]
-    double Te;      ///< Temperature of carrier distribution [K]
-    double alpha;   ///< Nonparabolicity [1/J]
-    double V;       ///< Band-edge [J]
-    double N;       ///< Population we expect to find [m^{-3}]
-};
-
-/**
- * \brief Find the error in population for a given Fermi energy
+ * \brief Find the rate of change of subband population with Fermi energy
+ *
+ * \param Esb   Energy of the subband minimum [J]
+ * \param E_F   Quasi-Fermi energy [J]
+ * \param m0    Band-edge effective mass [kg]
+ * \param Te    Temperature of electron distribution [K]
+ * \param alpha Nonparabolicity parameter [1/J]
+ * \param V     Energy of the band edge [J]
+ *
+ * \returns dN/dE_F [m^{-2}J^{-1}]
+ *
+ * \details The derivative is found analytically from the Fermi integrals,
+ *          using dF_j(x)/dx = F_{j-1}(x).
  */
-double find_pop_error(double E_F, void *params)
+double find_pop_derivative(const double Esb,
+                           const double E_F,
+                           const double m0,
+                           const double Te,
+                           const double alpha,
+                           const double V)
 {
-    const pop_params *p = reinterpret_cast<pop_params *>(params);
-    return find_pop(p->Esb, E_F, p->m0, p->Te, p->alpha, p->V) - p->N;
-}
+    const double rho_p = m0/(pi*hBar*hBar);
+    const double x     = (E_F - Esb)/(kB*Te);
 
-/**
- * \brief Parameters used for checking the population of multiple subbands
- */
-struct total_pop_params {
-    arma::vec Esb;   ///< Subband minimum [J]
-    double    m0;    ///< Band-edge effective mass [kg]
-    double    Te;    ///< Temperature of carrier distribution [K]
-    double    alpha; ///< Nonparabolicity [1/J]
-    double    V;     ///< Band-edge [J]
-    double    N;     ///< Population we expect to find [m^{-3}]
-};
+    // Consistent with the underflow limit in find_pop
+    if(gsl_fcmp(x,-700,1e-6) == -1)
+        return 0;
+
+    if(gsl_fcmp(alpha,0,1e-6) == 0)
+        return rho_p*gsl_sf_fermi_dirac_m1(x);
+
+    return rho_p * (
+            (1.0 + 2.0 * alpha * (Esb-V)) * gsl_sf_fermi_dirac_m1(x)
+            + 2*alpha*kB*Te * gsl_sf_fermi_dirac_0(x)
+            );
+}
 
 /**
- * \brief Find the error in the total population for multiple subbands
+ * \brief Find the total population of a set of subbands and its derivative
+ *
+ * \param[in]  Esb    Array of subband minima [J]
+ * \param[in]  E_F    Quasi-Fermi energy [J]
+ * \param[in]  m0     Band-edge effective mass [kg]
+ * \param[in]  Te     Temperature of carrier distribution [K]
+ * \param[in]  alpha  Nonparabolicity parameter [1/J]
+ * \param[in]  V      Band-edge [J]
+ * \param[out] dN_dEF Derivative of total population with respect to E_F [m^{-2}J^{-1}]
+ *
+ * \returns Total population [m^{-2}]
  */
-double find_total_pop_error(double E_F, void *params)
+static double find_total_pop(const arma::vec &Esb,
+                             const double     E_F,
+                             const double     m0,
+                             const double     Te,
+                             const double     alpha,
+                             const double     V,
+                             double          &dN_dEF)
 {
-    const total_pop_params *p = reinterpret_cast<total_pop_params *>(params);
-
-    // Find total population in each subband, using the same global Fermi
-    // energy
     double N_total = 0.0;
-    const size_t nst = p->Esb.size();
+    dN_dEF = 0.0;
 
-    for(unsigned int ist = 0; ist < nst; ist++)
-        N_total += find_pop(p->Esb[ist], E_F, p->m0, p->Te, p->alpha, p->V);
+    for(unsigned int ist = 0; ist < Esb.size(); ++ist)
+    {
+        N_total += find_pop(Esb[ist], E_F, m0, Te, alpha, V);
+        dN_dEF  += find_pop_derivative(Esb[ist], E_F, m0, Te, alpha, V);
+    }
 
-    return N_total - p->N;
+    return N_total;
 }
 
-
 /** 
  * \brief Find quasi-Fermi energy for a single subband with known population and temperature
  *
@@ -176,56 +197,17 @@ double find_fermi(const double Esb,
                   const double alpha,
                   const double V)
 {
-    double E_F = 0;
-
     // Use the analytical form if possible
     if(gsl_fcmp(alpha, 0.0, 1.0e-6) == 0)
     {
         // Eq. 2.85, QWWAD4
-        E_F = Esb + kB*Te * log(std::expm1((N*pi*hBar*hBar)/(m*kB*Te)));
+        return Esb + kB*Te * log(std::expm1((N*pi*hBar*hBar)/(m*kB*Te)));
     }
-    else
-    {
-        // Set limits for search [J]
-        double E_min=Esb-100.0*kB*Te;
-        double E_max=Esb+100.0*kB*Te;
 
-        // Set parameters for search
-        pop_params params = {Esb, m, Te, alpha, V, N};
-
-        // Find the signs of ∫f(E_min) - N at the endpoints
-        const int sign_min=GSL_SIGN(find_pop_error(E_min, &params));
-        const int sign_max=GSL_SIGN(find_pop_error(E_max, &params));
-
-        // We can solve the Fermi integral only if there is a sign-change 
-        // between the limits
-        const bool solvable=!(sign_min==sign_max);
-
-        if(solvable)
-        {
-            gsl_function F;
-            F.function = &find_pop_error;
-            F.params   = &params;
-            gsl_root_fsolver *solver = gsl_root_fsolver_alloc(gsl_root_fsolver_brent);
-            gsl_root_fsolver_set(solver, &F, E_min, E_max);
-
-            int status;
-            // Solve iteratively
-            do
-            {
-                status = gsl_root_fsolver_iterate(solver);
-                E_F   = gsl_root_fsolver_root(solver);
-                E_min = gsl_root_fsolver_x_lower(solver);
-                E_max = gsl_root_fsolver_x_upper(solver);
-                status = gsl_root_test_interval(E_min, E_max, 1e-8*e, 0);
-            }while(status == GSL_CONTINUE);
-
-            gsl_root_fsolver_free(solver);
-        }
-        else throw std::runtime_error("No quasi-Fermi energy in range.");
-    }
+    arma::vec Esb_array(1);
+    Esb_array[0] = Esb;
 
-    return E_F;
+    return find_fermi_global(Esb_array, m, N, Te, alpha, V);
 }
 
 /** 
@@ -266,6 +248,20 @@ double find_fermi_global(const std::vector<Eigenstate> &states,
  * \param V     Band-edge [J]
  *
  * \returns The Fermi energy for the entire system [J]
+ *
+ * \details The total population is a convex, increasing function of the
+ *          Fermi energy, so it is bracketed by two analytical limits
+ *          for parabolic subbands:
+ *
+ *          - The nondegenerate (Boltzmann) limit overestimates the
+ *            population, and so gives a lower bound on E_F.
+ *          - The degenerate (T = 0) limit underestimates the population,
+ *            and so gives an upper bound on E_F.
+ *
+ *          Newton iteration starts from the upper bound, using the
+ *          analytical derivative of the population.  Any step that leaves
+ *          the bracket is replaced by bisection.  For nonparabolic subbands,
+ *          the bracket is widened if necessary.
  */
 double find_fermi_global(const arma::vec &Esb,
                          const double     m0,
@@ -276,46 +272,139 @@ double find_fermi_global(const arma::vec &Esb,
 {
     const size_t nst = Esb.size();
 
-    // Set limits for search [J]
-    double E_min=Esb[0]-100.0*kB*Te;
-    double E_max=Esb[nst-1]+500.0*kB*Te;
+    if(nst == 0)
+        throw std::invalid_argument("Cannot find Fermi energy without any subbands.");
+
+    if(N <= 0 || Te <= 0)
+        throw std::domain_error("Population and temperature must be positive to find Fermi energy.");
+
+    const double kT    = kB*Te;
+    const double rho_p = m0/(pi*hBar*hBar); // Parabolic density of states [J^{-1}m^{-2}]
+    const arma::vec E  = arma::sort(Esb);
+
+    // Nondegenerate limit: N = rho kT sum exp[(E_F - E_i)/kT]
+    double S = 0.0;
+
+    for(unsigned int ist = 0; ist < nst; ++ist)
+        S += exp(-(E[ist] - E[0])/kT);
+
+    double E_lo = E[0] + kT*log(N/(rho_p*kT*S));
 
-    // Find bisector of the limits [J]
-    double E_F=(E_min+E_max)/2.0;
+    // Degenerate limit: fill the subbands in order of energy until E_F lies
+    // below the next subband
+    double E_hi   = E[0];
+    double E_sum  = 0.0;
 
-    // Set parameters for search
-    total_pop_params params = {Esb, m0, Te, alpha, V, N};
+    for(unsigned int ist = 0; ist < nst; ++ist)
+    {
+        E_sum += E[ist];
+        E_hi   = (N/rho_p + E_sum)/(ist+1);
+
+        if(ist+1 == nst || E_hi <= E[ist+1])
+            break;
+    }
+
+    // Make sure that the root is bracketed
+    double dN_dEF = 0.0;
+    unsigned int iwiden = 0;
+
+    while(find_total_pop(E, E_lo, m0, Te, alpha, V, dN_dEF) > N)
+    {
+        E_lo -= 10.0*kT;
+
+        if(++iwiden > 100)
+            throw std::runtime_error("No quasi-Fermi energy in range.");
+    }
+
+    while(find_total_pop(E, E_hi, m0, Te, alpha, V, dN_dEF) < N)
+    {
+        E_hi += 10.0*kT;
+
+        if(++iwiden > 200)
+            throw std::runtime_error("No quasi-Fermi energy in range.");
+    }
+
+    const double tol = 1e-10*e; // Tolerance for Fermi energy [J]
+    double E_F = E_hi;
+
+    for(unsigned int iter = 0; iter < 200; ++iter)
+    {
+        const double dN = find_total_pop(E, E_F, m0, Te, alpha, V, dN_dEF) - N;
+
+        if(dN == 0.0)
+            return E_F;
+
+        // Narrow the bracket
+        if(dN > 0)
+            E_hi = E_F;
+        else
+            E_lo = E_F;
+
+        double E_F_new = E_F - dN/dN_dEF;
+
+        // Bisect if the Newton step is unusable
+        if(!(dN_dEF > 0) || !(E_F_new > E_lo && E_F_new < E_hi))
+            E_F_new = 0.5*(E_lo + E_hi);
+
+        const double step = fabs(E_F_new - E_F);
+        E_F = E_F_new;
 
-    // Find the signs of ∫f(E_min) - N at the endpoints
-    const int sign_min=GSL_SIGN(find_total_pop_error(E_min, &params));
-    const int sign_max=GSL_SIGN(find_total_pop_error(E_max, &params));
+        if(step < tol || E_hi - E_lo < tol)
+            return E_F;
+    }
+
+    throw std::runtime_error("Fermi energy did not converge.");
+}
+
+/**
+ * \brief Find Fermi energies for many combinations of population and temperature
+ *
+ * \param Esb   Array of subband minima [J]
+ * \param m0    Mass of carriers at band edge [kg]
+ * \param N     Population density of system for each case [m^{-2}]
+ * \param Te    Temperature of carrier distribution for each case [K]
+ * \param alpha Nonparabolicity parameter [1/J]
+ * \param V     Band-edge [J]
+ *
+ * \returns The Fermi energy for each case [J]
+ *
+ * \details The cases are independent, and are shared between threads.
+ */
+arma::vec find_fermi_global(const arma::vec &Esb,
+                            const double     m0,
+                            const arma::vec &N,
+                            const arma::vec &Te,
+                            const double     alpha,
+                            const double     V)
+{
+    if(N.size() != Te.size())
+    {
+        std::ostringstream oss;
+        oss << "Number of populations (" << N.size() << ") and temperatures ("
+            << Te.size() << ") do not match.";
+        throw std::length_error(oss.str());
+    }
 
-    // We can solve the Fermi integral only if there is a sign-change 
-    // between the limits
-    const bool solvable=!(sign_min==sign_max);
+    const unsigned int ncase = N.size();
+    arma::vec E_F(ncase);
+    std::exception_ptr error;
 
-    if(solvable)
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int icase = 0; icase < ncase; ++icase)
     {
-        gsl_function F;
-        F.function = &find_total_pop_error;
-        F.params   = &params;
-        gsl_root_fsolver *solver = gsl_root_fsolver_alloc(gsl_root_fsolver_brent);
-        gsl_root_fsolver_set(solver, &F, E_min, E_max);
-
-        int status;
-        // Solve iteratively
-        do
+        try
+        {
+            E_F[icase] = find_fermi_global(Esb, m0, N[icase], Te[icase], alpha, V);
+        }
+        catch(...)
         {
-            status = gsl_root_fsolver_iterate(solver);
-            E_F   = gsl_root_fsolver_root(solver);
-            E_min = gsl_root_fsolver_x_lower(solver);
-            E_max = gsl_root_fsolver_x_upper(solver);
-            status = gsl_root_test_interval(E_min, E_max, 1e-8*e, 0);
-        }while(status == GSL_CONTINUE);
-
-        gsl_root_fsolver_free(solver);
+#pragma omp critical
+            error = std::current_exception();
+        }
     }
-    else throw std::runtime_error("No quasi-Fermi energy in range.");
+
+    if(error)
+        std::rethrow_exception(error);
 
     return E_F;
 }
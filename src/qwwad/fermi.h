@@ -23,6 +23,13 @@ double find_pop(const double Esb,
                 const double alpha=0,
                 const double V=0);
 
+double find_pop_derivative(const double Esb,
+                           const double E_F,
+                           const double md,
+                           const double Te,
+                           const double alpha=0,
+                           const double V=0);
+
 double find_fermi(const double Esb,
                   const double m0,
                   const double N,
@@ -43,6 +50,13 @@ double find_fermi_global(const std::vector<Eigenstate> &states,
                          const double                   Te,
                          const double                   alpha=0,
                          const double                   V=0);
+
+arma::vec find_fermi_global(const arma::vec &Esb,
+                            const double     m0,
+                            const arma::vec &N,
+                            const arma::vec &Te,
+                            const double     alpha=0,
+                            const double     V=0);
 } // namespace
 #endif
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
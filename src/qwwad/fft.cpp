@@ -0,0 +1,215 @@
+/**
+ * \file   fft.cpp
+ * \brief  Fast Fourier transforms on 3D grids
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "constants.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Set up transforms for a given grid size
+ *
+ * \param[in] n1 Number of points in first direction
+ * \param[in] n2 Number of points in second direction
+ * \param[in] n3 Number of points in third direction
+ */
+FFT3D::FFT3D(const size_t n1,
+             const size_t n2,
+             const size_t n3)
+{
+    _n[0] = n1;
+    _n[1] = n2;
+    _n[2] = n3;
+
+    for(unsigned int dim = 0; dim < 3; ++dim)
+    {
+        const auto n = _n[dim];
+
+        if(n == 0)
+            throw std::domain_error("FFT grid must contain at least one point in each direction");
+
+        _twiddle[dim].resize(n);
+
+        for(unsigned int j = 0; j < n; ++j)
+            _twiddle[dim][j] = std::polar(1.0, -2.0*pi*j/n);
+
+        // Split the size into factors, taking radix-4 steps first
+        size_t remainder = n;
+
+        for(const size_t p : {4, 2, 3, 5})
+        {
+            while(remainder % p == 0)
+            {
+                _factors[dim].push_back(p);
+                remainder /= p;
+            }
+        }
+
+        for(size_t p = 7; remainder > 1; p += 2)
+        {
+            while(remainder % p == 0)
+            {
+                _factors[dim].push_back(p);
+                remainder /= p;
+            }
+        }
+
+        if(_factors[dim].empty())
+            _factors[dim].push_back(1);
+    }
+}
+
+/**
+ * \brief Find the smallest grid size that can be transformed efficiently,
+ *        and which contains at least a given number of points
+ *
+ * \details The result has no prime factors other than 2, 3 and 5
+ */
+size_t FFT3D::get_good_size(const size_t n)
+{
+    for(size_t good = std::max(n, static_cast<size_t>(1));; ++good)
+    {
+        size_t remainder = good;
+
+        for(const size_t p : {2, 3, 5})
+            while(remainder % p == 0)
+                remainder /= p;
+
+        if(remainder == 1)
+            return good;
+    }
+}
+
+/**
+ * \brief Recursive mixed-radix transform
+ *
+ * \param[in]  in           First input value
+ * \param[out] out          Contiguous output array
+ * \param[in]  n            Number of points to transform
+ * \param[in]  stride       Spacing between input values
+ * \param[in]  factors      Factors of n, largest first in the recursion
+ * \param[in]  twiddle      exp(-2 pi i j/N) for the full length, N
+ * \param[in]  twiddle_step N/n
+ * \param[in]  forward      True for forward transform
+ * \param      scratch      Workspace, with at least as many elements as the largest factor
+ *
+ * \details The input is split into p interleaved sets of n/p values, where
+ *          p is the first factor.  Each set is transformed, and the results
+ *          are combined using a p-point transform.
+ */
+void FFT3D::transform_1d(const std::complex<double>              *in,
+                         std::complex<double>                    *out,
+                         const size_t                             n,
+                         const size_t                             stride,
+                         const size_t                            *factors,
+                         const std::vector<std::complex<double>> &twiddle,
+                         const size_t                             twiddle_step,
+                         const bool                               forward,
+                         std::complex<double>                    *scratch)
+{
+    const size_t p = factors[0];
+    const size_t m = n/p;
+
+    // exp(-+2 pi i j/N) for a given j
+    auto w = [&](const size_t j) {return forward ? twiddle[j] : std::conj(twiddle[j]);};
+
+    if(m == 1)
+    {
+        for(size_t k = 0; k < p; ++k)
+        {
+            std::complex<double> sum = 0.0;
+
+            for(size_t j = 0; j < p; ++j)
+                sum += in[j*stride] * w(((j*k) % p)*twiddle_step);
+
+            out[k] = sum;
+        }
+
+        return;
+    }
+
+    for(size_t j = 0; j < p; ++j)
+        transform_1d(in + j*stride, out + j*m, m, stride*p, factors + 1, twiddle, twiddle_step*p,
+                     forward, scratch);
+
+    for(size_t k = 0; k < m; ++k)
+    {
+        for(size_t j = 0; j < p; ++j)
+            scratch[j] = out[j*m + k] * w(((j*k) % n)*twiddle_step);
+
+        for(size_t q = 0; q < p; ++q)
+        {
+            std::complex<double> sum = 0.0;
+
+            for(size_t j = 0; j < p; ++j)
+                sum += scratch[j] * w(((j*q) % p)*m*twiddle_step);
+
+            out[q*m + k] = sum;
+        }
+    }
+}
+
+/**
+ * \brief Transform the data along each direction in turn
+ */
+void FFT3D::transform(arma::cx_vec &data,
+                      const bool    forward) const
+{
+    if(data.size() != get_n_total())
+    {
+        std::ostringstream oss;
+        oss << "FFT data has " << data.size() << " points, but grid has " << get_n_total();
+        throw std::length_error(oss.str());
+    }
+
+    const size_t stride[3] = {1, _n[0], _n[0]*_n[1]};
+    std::vector<std::complex<double>> line;
+    std::vector<std::complex<double>> result;
+    std::vector<std::complex<double>> scratch;
+
+    for(unsigned int dim = 0; dim < 3; ++dim)
+    {
+        const auto n = _n[dim];
+
+        if(n == 1)
+            continue;
+
+        line.resize(n);
+        result.resize(n);
+        scratch.resize(*std::max_element(_factors[dim].begin(), _factors[dim].end()));
+
+        // The other two directions, which label each line
+        const unsigned int d1 = (dim + 1)%3;
+        const unsigned int d2 = (dim + 2)%3;
+
+        for(size_t i2 = 0; i2 < _n[d2]; ++i2)
+        {
+            for(size_t i1 = 0; i1 < _n[d1]; ++i1)
+            {
+                const size_t offset = i1*stride[d1] + i2*stride[d2];
+
+                for(size_t i = 0; i < n; ++i)
+                    line[i] = data[offset + i*stride[dim]];
+
+                transform_1d(line.data(), result.data(), n, 1, _factors[dim].data(), _twiddle[dim], 1,
+                             forward, scratch.data());
+
+                for(size_t i = 0; i < n; ++i)
+                    data[offset + i*stride[dim]] = result[i];
+            }
+        }
+    }
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
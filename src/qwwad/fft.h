@@ -0,0 +1,76 @@
+/**
+ * \file   fft.h
+ * \brief  Fast Fourier transforms on 3D grids
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_FFT_H
+#define QWWAD_FFT_H
+
+#include <complex>
+#include <vector>
+#include <armadillo>
+
+namespace QWWAD
+{
+/**
+ * \brief Fast Fourier transform on a 3D grid
+ *
+ * \details Any grid size may be used, but the transforms are fastest when
+ *          the size in each direction has only small prime factors.
+ *          get_good_size() gives suitable sizes.  Data is stored in a flat
+ *          array, with element (i,j,k) at i + n1*(j + n2*k).
+ *
+ *          Neither transform is normalised, so a forward transform followed
+ *          by a backward transform multiplies the data by n1*n2*n3:
+ *
+ *          - forward:  F(q) = sum_x f(x) exp(-2 pi i q.x/n)
+ *          - backward: f(x) = sum_q F(q) exp(+2 pi i q.x/n)
+ *
+ *          The twiddle factors are found once, when the object is created.
+ *          The transforms do not modify the object, so one object may be
+ *          shared between threads.
+ */
+class FFT3D
+{
+private:
+    size_t _n[3]; ///< Number of points in each direction
+
+    std::vector<std::complex<double>> _twiddle[3]; ///< exp(-2 pi i j/n) for j < n in each direction
+    std::vector<size_t>               _factors[3]; ///< Factors of the size in each direction
+
+    void transform(arma::cx_vec &data,
+                   const bool    forward) const;
+
+    static void transform_1d(const std::complex<double>              *in,
+                             std::complex<double>                    *out,
+                             const size_t                             n,
+                             const size_t                             stride,
+                             const size_t                            *factors,
+                             const std::vector<std::complex<double>> &twiddle,
+                             const size_t                             twiddle_step,
+                             const bool                               forward,
+                             std::complex<double>                    *scratch);
+
+public:
+    FFT3D(const size_t n1,
+          const size_t n2,
+          const size_t n3);
+
+    /// Apply forward transform in place
+    void forward(arma::cx_vec &data) const {transform(data, true);}
+
+    /// Apply backward transform in place
+    void backward(arma::cx_vec &data) const {transform(data, false);}
+
+    /// Get the number of points in a given direction (0, 1 or 2)
+    size_t get_n(const unsigned int dim) const {return _n[dim];}
+
+    /// Get the total number of points in the grid
+    size_t get_n_total() const {return _n[0]*_n[1]*_n[2];}
+
+    static size_t get_good_size(const size_t n);
+};
+} // namespace QWWAD
+#endif // QWWAD_FFT_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
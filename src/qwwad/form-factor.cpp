@@ -0,0 +1,167 @@
+/**
+ * \file   form-factor.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Form factors for phonon scattering between a pair of subbands
+ */
+
+#include "form-factor.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "maths-helpers.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Find the squared form factor for a table of phonon wave-vectors
+ *
+ * \param[in] z      Spatial sampling points (uniformly spaced) [m]
+ * \param[in] psi_if Product of initial- and final-state wavefunctions [1/m]
+ * \param[in] Kz     Phonon wave-vector samples (uniformly spaced) [1/m]
+ *
+ * \details The form factor is \f$G_{if}(K_z) = \int \psi_i \psi_f e^{iK_z z}\,\mathrm{d}z\f$,
+ *          evaluated using the same quadrature rule as QWWAD::integral.
+ *
+ *          Since both grids are uniform, the phase factor at each position obeys
+ *          \f$e^{i(K_z + \Delta K_z)z} = e^{iK_z z}e^{i\Delta K_z z}\f$, so the
+ *          whole table is built by stepping a set of phasors along the Kz grid
+ *          with one complex multiplication per sample.  The phasors are
+ *          periodically recomputed directly to stop rounding errors from
+ *          accumulating.
+ *
+ * \returns The squared form factor \f$|G_{if}(K_z)|^2\f$ at each wave-vector
+ */
+arma::vec find_Gsqr_table(const arma::vec &z,
+                          const arma::vec &psi_if,
+                          const arma::vec &Kz)
+{
+    const size_t nz  = z.size();
+    const size_t nKz = Kz.size();
+
+    if(nz < 2)
+        throw std::runtime_error("Need at least two points for numerical integration.");
+
+    if(psi_if.size() != nz)
+    {
+        std::ostringstream oss;
+        oss << "Wavefunction product has " << psi_if.size()
+            << " samples, but " << nz << " spatial points were given.";
+        throw std::length_error(oss.str());
+    }
+
+    arma::vec Gsqr(nKz);
+
+    if(nKz == 0)
+        return Gsqr;
+
+    const auto dz  = z[1] - z[0];
+    const auto dKz = (nKz > 1) ? Kz[1] - Kz[0] : 0.0;
+
+    for(unsigned int iKz = 2; iKz < nKz; ++iKz)
+    {
+        if(fabs(Kz[iKz] - Kz[0] - iKz*dKz) > 1e-6*fabs(dKz))
+            throw std::invalid_argument("Phonon wave-vector samples must be uniformly spaced");
+    }
+
+    // Fold the quadrature weights into the product density, so that each
+    // form-factor reduces to a plain weighted sum of the phasors
+    const arma::vec rho = quadrature_weights(nz, dz) % psi_if;
+
+    // Real and imaginary parts of the phasors exp(i Kz z) and their step exp(i dKz z).
+    // These are kept as separate real arrays so that the inner loops vectorise.
+    arma::vec c(nz);
+    arma::vec s(nz);
+    arma::vec c_step(nz);
+    arma::vec s_step(nz);
+
+    for(unsigned int iz = 0; iz < nz; ++iz)
+    {
+        c_step[iz] = cos(dKz*z[iz]);
+        s_step[iz] = sin(dKz*z[iz]);
+    }
+
+    const size_t n_resync = 64; // Number of recurrence steps between exact evaluations
+
+    for(unsigned int iKz = 0; iKz < nKz; ++iKz)
+    {
+        if(iKz % n_resync == 0)
+        {
+            for(unsigned int iz = 0; iz < nz; ++iz)
+            {
+                c[iz] = cos(Kz[iKz]*z[iz]);
+                s[iz] = sin(Kz[iKz]*z[iz]);
+            }
+        }
+
+        double G_re = 0.0;
+        double G_im = 0.0;
+
+        for(unsigned int iz = 0; iz < nz; ++iz)
+        {
+            G_re += rho[iz]*c[iz];
+            G_im += rho[iz]*s[iz];
+        }
+
+        Gsqr[iKz] = G_re*G_re + G_im*G_im;
+
+        // Advance the phasors to the next wave-vector
+        if((iKz + 1) % n_resync != 0)
+        {
+            for(unsigned int iz = 0; iz < nz; ++iz)
+            {
+                const auto c_next = c[iz]*c_step[iz] - s[iz]*s_step[iz];
+                s[iz] = s[iz]*c_step[iz] + c[iz]*s_step[iz];
+                c[iz] = c_next;
+            }
+        }
+    }
+
+    return Gsqr;
+}
+
+/**
+ * \brief Find the squared form factor for a table of phonon wave-vectors
+ *
+ * \param[in] z     Spatial sampling points (uniformly spaced) [m]
+ * \param[in] psi_i Initial-state wavefunction [m^{-1/2}]
+ * \param[in] psi_f Final-state wavefunction [m^{-1/2}]
+ * \param[in] Kz    Phonon wave-vector samples (uniformly spaced) [1/m]
+ *
+ * \returns The squared form factor \f$|G_{if}(K_z)|^2\f$ at each wave-vector
+ */
+arma::vec find_Gsqr_table(const arma::vec &z,
+                          const arma::vec &psi_i,
+                          const arma::vec &psi_f,
+                          const arma::vec &Kz)
+{
+    if(psi_i.size() != psi_f.size())
+    {
+        std::ostringstream oss;
+        oss << "Wavefunctions have different numbers of samples: " << psi_i.size()
+            << " and " << psi_f.size() << ".";
+        throw std::length_error(oss.str());
+    }
+
+    const arma::vec psi_if = psi_i % psi_f;
+    return find_Gsqr_table(z, psi_if, Kz);
+}
+
+/**
+ * \brief Find the squared form factor between a pair of subbands
+ *
+ * \param[in] isb Initial subband
+ * \param[in] fsb Final subband
+ * \param[in] Kz  Phonon wave-vector samples (uniformly spaced) [1/m]
+ *
+ * \returns The squared form factor \f$|G_{if}(K_z)|^2\f$ at each wave-vector
+ */
+arma::vec find_Gsqr_table(const Subband   &isb,
+                          const Subband   &fsb,
+                          const arma::vec &Kz)
+{
+    return find_Gsqr_table(isb.z_array(), isb.psi_array(), fsb.psi_array(), Kz);
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,29 @@
+/**
+ * \file   form-factor.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Form factors for phonon scattering between a pair of subbands
+ */
+
+#ifndef QWWAD_FORM_FACTOR_H
+#define QWWAD_FORM_FACTOR_H
+
+#include <armadillo>
+#include "subband.h"
+
+namespace QWWAD
+{
+arma::vec find_Gsqr_table(const arma::vec &z,
+                          const arma::vec &psi_if,
+                          const arma::vec &Kz);
+
+arma::vec find_Gsqr_table(const arma::vec &z,
+                          const arma::vec &psi_i,
+                          const arma::vec &psi_f,
+                          const arma::vec &Kz);
+
+arma::vec find_Gsqr_table(const Subband   &isb,
+                          const Subband   &fsb,
+                          const arma::vec &Kz);
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
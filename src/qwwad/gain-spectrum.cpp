@@ -0,0 +1,295 @@
+/**
+ * \file   gain-spectrum.cpp
+ * \brief  Intersubband optical gain and absorption spectrum
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "gain-spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include "constants.h"
+#include "maths-helpers.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Initialise a gain spectrum calculation
+ *
+ * \param[in] subbands The subbands in the system, with their carrier
+ *                     distributions set
+ * \param[in] z        Dipole matrix element between each pair of subbands [m]
+ * \param[in] n_r      Refractive index
+ * \param[in] L        Length of the structure, e.g., one period of a
+ *                     cascade laser [m]
+ *
+ * \details Every pair of subbands with a nonzero dipole matrix element
+ *          contributes to the spectrum.  The linewidth is initially 10 meV
+ *          for all transitions.
+ */
+GainSpectrum::GainSpectrum(const std::vector<Subband> &subbands,
+                           const arma::mat            &z,
+                           const double                n_r,
+                           const double                L) :
+    _subbands(subbands),
+    _z(z),
+    _n_r(n_r),
+    _L(L),
+    _dispersion(false),
+    _nk(101)
+{
+    const auto nst = _subbands.size();
+
+    if(nst == 0)
+        throw std::invalid_argument("No subbands were given for gain spectrum");
+
+    if(_z.n_rows != nst || _z.n_cols != nst)
+    {
+        std::ostringstream oss;
+        oss << "Dipole matrix is " << _z.n_rows << "x" << _z.n_cols << ", but there are "
+            << nst << " subbands.";
+        throw std::length_error(oss.str());
+    }
+
+    if(_n_r <= 0 || _L <= 0)
+        throw std::domain_error("Refractive index and length must be positive");
+
+    set_linewidth(10e-3*e);
+
+    for(unsigned int i = 0; i < nst; ++i)
+    {
+        for(unsigned int j = 0; j < nst; ++j)
+        {
+            if(_subbands[i].get_E_min() > _subbands[j].get_E_min() && _z(i,j) != 0.0)
+                _transitions.push_back({i, j});
+        }
+    }
+}
+
+/**
+ * \brief Use the same linewidth for all transitions
+ *
+ * \param[in] Gamma Full-width at half-maximum [J]
+ */
+void GainSpectrum::set_linewidth(const double Gamma)
+{
+    if(Gamma <= 0)
+        throw std::domain_error("Linewidth must be positive");
+
+    const auto nst = _subbands.size();
+    _Gamma = arma::ones(nst, nst) * Gamma;
+}
+
+/**
+ * \brief Set the linewidth of each transition
+ *
+ * \param[in] Gamma Matrix of full-width at half-maximum linewidths [J].
+ *                  Element (u,l) is used for the transition between
+ *                  upper subband u and lower subband l.
+ */
+void GainSpectrum::set_linewidths(const arma::mat &Gamma)
+{
+    const auto nst = _subbands.size();
+
+    if(Gamma.n_rows != nst || Gamma.n_cols != nst)
+    {
+        std::ostringstream oss;
+        oss << "Linewidth matrix is " << Gamma.n_rows << "x" << Gamma.n_cols << ", but there are "
+            << nst << " subbands.";
+        throw std::length_error(oss.str());
+    }
+
+    for(const auto &tx : _transitions)
+    {
+        if(Gamma(tx.u, tx.l) <= 0)
+        {
+            std::ostringstream oss;
+            oss << "Linewidth for transition " << tx.u+1 << "→" << tx.l+1 << " must be positive";
+            throw std::domain_error(oss.str());
+        }
+    }
+
+    _Gamma = Gamma;
+}
+
+/**
+ * \brief Find the lifetime-broadened linewidth of each transition [J]
+ *
+ * \param[in] W Matrix of scattering rates [1/s].  Element (i,f) gives the
+ *              rate of scattering from subband i to subband f.
+ *
+ * \details The linewidth of the transition between subbands i and j is
+ *          ħ(1/τ_i + 1/τ_j), where 1/τ_i is the total rate of scattering out
+ *          of subband i.
+ */
+arma::mat GainSpectrum::get_linewidths_from_rates(const arma::mat &W)
+{
+    if(W.n_rows != W.n_cols)
+        throw std::invalid_argument("Rate matrix must be square");
+
+    const arma::vec W_out = arma::sum(W, 1) - W.diag();
+    const auto nst = W.n_rows;
+    arma::mat Gamma(nst, nst);
+
+    for(unsigned int j = 0; j < nst; ++j)
+    {
+        for(unsigned int i = 0; i < nst; ++i)
+            Gamma(i,j) = hBar*(W_out[i] + W_out[j]);
+    }
+
+    return Gamma;
+}
+
+/**
+ * \brief Set the number of wave-vector samples used when the dispersion is enabled
+ */
+void GainSpectrum::set_k_samples(const size_t nk)
+{
+    if(nk < 2)
+        throw std::domain_error("At least two wave-vector samples are needed");
+
+    _nk = nk;
+}
+
+/**
+ * \brief Find the contribution of one transition to the spectrum,
+ *        without the photon-energy dependent pre-factor
+ *
+ * \param[in] tx Transition
+ * \param[in] E  Photon energies [J]
+ *
+ * \returns |z_ul|² Σ ΔN L(E) at each photon energy [m^2 J^{-1}]
+ */
+arma::vec GainSpectrum::get_transition_spectrum(const Transition &tx,
+                                                const arma::vec  &E) const
+{
+    const auto &usb = _subbands[tx.u];
+    const auto &lsb = _subbands[tx.l];
+    const auto gamma = _Gamma(tx.u, tx.l)/2; // Half-width at half-maximum
+
+    // Population difference [m^{-2}] and transition energy [J] for each
+    // line that makes up the transition
+    arma::vec dN;
+    arma::vec E_ul;
+
+    if(_dispersion)
+    {
+        // Sample the in-plane wave-vector up to the point where both
+        // subbands are practically empty
+        const auto k_max = std::max(usb.get_k_max(usb.get_Te()),
+                                    lsb.get_k_max(lsb.get_Te()));
+        const arma::vec k = arma::linspace(0, k_max, _nk);
+
+        arma::vec f_u;
+        arma::vec Ek_u;
+        arma::vec f_l;
+        arma::vec Ek_l;
+        usb.get_occupation_at_k(k, f_u, Ek_u);
+        lsb.get_occupation_at_k(k, f_l, Ek_l);
+
+        // The sheet density in each wave-vector interval is k dk f(k)/π
+        dN   = quadrature_weights(_nk, k_max/(_nk-1)) % k % (f_u - f_l) / pi;
+        E_ul = (usb.get_E_min() + Ek_u) - (lsb.get_E_min() + Ek_l);
+    }
+    else
+    {
+        dN   = arma::vec(1);
+        E_ul = arma::vec(1);
+        dN[0]   = usb.get_total_population() - lsb.get_total_population();
+        E_ul[0] = usb.get_E_min() - lsb.get_E_min();
+    }
+
+    arma::vec spectrum = arma::zeros(E.size());
+
+    for(unsigned int iline = 0; iline < dN.size(); ++iline)
+    {
+        if(dN[iline] == 0.0)
+            continue;
+
+        const arma::vec dE = E - E_ul[iline];
+        spectrum += dN[iline] * (gamma/pi) / (dE % dE + gamma*gamma);
+    }
+
+    return spectrum * _z(tx.u, tx.l) * _z(tx.u, tx.l);
+}
+
+/**
+ * \brief Find the gain due to all transitions
+ *
+ * \param[in] E Photon energies [J]
+ *
+ * \returns Gain at each photon energy [1/m].  Negative values indicate absorption.
+ */
+arma::vec GainSpectrum::get_gain(const arma::vec &E) const
+{
+    const auto ntx = _transitions.size();
+    arma::mat spectra = arma::zeros(E.size(), ntx);
+    std::exception_ptr error;
+
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        try
+        {
+            spectra.col(itx) = get_transition_spectrum(_transitions[itx], E);
+        }
+        catch(...)
+        {
+#pragma omp critical
+            error = std::current_exception();
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+
+    // Sum over transitions in a fixed order, so that the result doesn't
+    // depend on threading
+    arma::vec total = arma::zeros(E.size());
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+        total += spectra.col(itx);
+
+    const arma::vec omega = E/hBar;
+    return pi*e*e*omega % total / (eps0*_n_r*c*_L);
+}
+
+/**
+ * \brief Find the gain due to a single transition
+ *
+ * \param[in] E Photon energies [J]
+ * \param[in] u Index of upper subband
+ * \param[in] l Index of lower subband
+ *
+ * \details The subbands are swapped if u is below l
+ *
+ * \returns Gain at each photon energy [1/m].  Negative values indicate absorption.
+ */
+arma::vec GainSpectrum::get_gain(const arma::vec    &E,
+                                 const unsigned int  u,
+                                 const unsigned int  l) const
+{
+    if(u >= _subbands.size() || l >= _subbands.size())
+    {
+        std::ostringstream oss;
+        oss << "Transition " << u+1 << "→" << l+1 << " refers to a subband outside the system ("
+            << _subbands.size() << " subbands).";
+        throw std::domain_error(oss.str());
+    }
+
+    // Order the subbands so that the upper one comes first
+    Transition tx = {u, l};
+
+    if(_subbands[u].get_E_min() < _subbands[l].get_E_min())
+        tx = {l, u};
+
+    const arma::vec omega = E/hBar;
+    return pi*e*e*omega % get_transition_spectrum(tx, E) / (eps0*_n_r*c*_L);
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
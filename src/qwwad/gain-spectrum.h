@@ -0,0 +1,84 @@
+/**
+ * \file   gain-spectrum.h
+ * \brief  Intersubband optical gain and absorption spectrum
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_GAIN_SPECTRUM_H
+#define QWWAD_GAIN_SPECTRUM_H
+
+#include <vector>
+#include <armadillo>
+#include "subband.h"
+
+namespace QWWAD
+{
+/**
+ * \brief The optical gain spectrum for intersubband transitions in a 2D system
+ *
+ * \details Each pair of subbands contributes a Lorentzian line at its
+ *          transition energy, weighted by the squared dipole matrix element
+ *          and the difference in population between the upper and lower
+ *          subbands.  The gain for TM-polarised light is
+ *
+ *            g(ħω) = πe²ω/(ε₀ n c L) Σ |z_ul|² ΔN_ul L_ul(ħω),
+ *
+ *          where L is the length of the structure and L_ul is a Lorentzian
+ *          lineshape with unit area.  Negative values indicate absorption.
+ *
+ *          By default, each transition has a single line at the energy
+ *          separation of the subband minima.  If the dispersion is enabled,
+ *          vertical transitions at each in-plane wave-vector are summed
+ *          instead.  This accounts for differences in the effective mass
+ *          or nonparabolicity of the subbands, which broaden and shift the
+ *          line.
+ */
+class GainSpectrum
+{
+private:
+    /// A pair of subbands that contribute to the spectrum
+    struct Transition {
+        unsigned int u; ///< Index of upper subband
+        unsigned int l; ///< Index of lower subband
+    };
+
+    std::vector<Subband>    _subbands;    ///< The subbands in the system
+    arma::mat               _z;           ///< Dipole matrix elements [m]
+    double                  _n_r;         ///< Refractive index
+    double                  _L;           ///< Length of structure [m]
+    arma::mat               _Gamma;       ///< FWHM linewidth of each transition [J]
+    bool                    _dispersion;  ///< Sum over in-plane wave-vector
+    size_t                  _nk;          ///< Number of wave-vector samples
+    std::vector<Transition> _transitions; ///< Transitions that contribute to the spectrum
+
+    arma::vec get_transition_spectrum(const Transition &tx,
+                                      const arma::vec  &E) const;
+
+public:
+    GainSpectrum(const std::vector<Subband> &subbands,
+                 const arma::mat            &z,
+                 const double                n_r,
+                 const double                L);
+
+    void set_linewidth(const double Gamma);
+    void set_linewidths(const arma::mat &Gamma);
+
+    static arma::mat get_linewidths_from_rates(const arma::mat &W);
+
+    /// Include the in-plane dispersion of the subbands
+    inline void enable_dispersion(const bool enabled) {_dispersion = enabled;}
+
+    void set_k_samples(const size_t nk);
+
+    /// Get the number of transitions that contribute to the spectrum
+    inline size_t get_n_transitions() const {return _transitions.size();}
+
+    arma::vec get_gain(const arma::vec &E) const;
+
+    arma::vec get_gain(const arma::vec    &E,
+                       const unsigned int  u,
+                       const unsigned int  l) const;
+};
+} // namespace QWWAD
+#endif // QWWAD_GAIN_SPECTRUM_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
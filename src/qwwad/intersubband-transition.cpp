@@ -22,13 +22,8 @@ IntersubbandTransition::IntersubbandTransition(const decltype(_isb) isb,
     _ki(ki),
     _Wif(Wif)
 {
-    const auto nki = _ki.size();
-
     // Tabulate the initial kinetic energy for each initial state in table
-    _Eki.resize(nki);
-
-    for(unsigned int iki = 0; iki < nki; ++iki)
-        _Eki[iki] = isb.get_Ek_at_k(_ki[iki]);
+    isb.get_Ek_at_k(_ki, _Eki);
 }
 
 /**
@@ -36,17 +31,13 @@ IntersubbandTransition::IntersubbandTransition(const decltype(_isb) isb,
  */
 double IntersubbandTransition::get_average_rate() const
 {
-    const auto nki = _ki.size();
     const auto dki = _ki[1] - _ki[0];
 
-    arma::vec Wbar_integrand_ki(nki);
+    arma::vec f_FD;
+    arma::vec Eki;
+    _isb.get_occupation_at_k(_ki, f_FD, Eki);
 
-    for(unsigned int iki=0; iki<nki; ++iki)
-    {
-        const auto ki   = _ki[iki];
-        const auto f_FD = _isb.get_occupation_at_k(ki);
-        Wbar_integrand_ki[iki] = _Wif[iki]*ki*f_FD;
-    } // End loop over ki
+    const arma::vec Wbar_integrand_ki = _Wif % _ki % f_FD;
 
     const auto N = _isb.get_total_population();
     const auto Wif_avg = integral(Wbar_integrand_ki, dki)/(pi*N);
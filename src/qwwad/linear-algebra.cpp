@@ -14,6 +14,7 @@
 #include "linear-algebra.h"
 #include "lapack-declarations.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "maths-helpers.h"
@@ -505,5 +506,65 @@ factorise_tridiag_LDL_T(arma::vec const &A_diag,
         throw std::runtime_error(oss.str());
     }
 }
+
+/**
+ * \brief Allocate workspace for a Hermitian eigenvalue problem
+ *
+ * \param[in] N Order of matrix
+ */
+HermitianEigenSolver::HermitianEigenSolver(const size_t N) :
+    _N(N),
+    _rwork(arma::zeros(std::max(1, 3*_N - 2)))
+{
+    // Query LAPACK for the optimal size of the workspace
+    char jobz  = 'V';
+    char uplo  = 'L';
+    int  lwork = -1;
+    int  info  = 0;
+    std::complex<double> work_query = 0;
+    std::complex<double> A_dummy    = 0;
+    double               E_dummy    = 0;
+
+    zheev_(&jobz, &uplo, &_N, &A_dummy, &_N, &E_dummy, &work_query, &lwork, _rwork.memptr(), &info);
+
+    lwork = std::max(static_cast<int>(work_query.real()), std::max(1, 2*_N - 1));
+    _work = arma::zeros<arma::cx_vec>(lwork);
+}
+
+/**
+ * \brief Find all eigenvalues and eigenvectors of a Hermitian matrix
+ *
+ * \param[in,out] A Hermitian matrix.  Only the lower triangle is used.  On
+ *                  output, the columns contain the normalised eigenvectors.
+ * \param[out]    E Eigenvalues, in ascending order
+ */
+void HermitianEigenSolver::solve(arma::cx_mat &A,
+                                 arma::vec    &E)
+{
+    if(A.n_rows != static_cast<unsigned int>(_N) || A.n_cols != static_cast<unsigned int>(_N))
+    {
+        std::ostringstream oss;
+        oss << "Matrix has size " << A.n_rows << "x" << A.n_cols << ", but eigensolver was set up "
+            << "for order " << _N;
+        throw std::length_error(oss.str());
+    }
+
+    E.set_size(_N);
+
+    char jobz  = 'V';
+    char uplo  = 'L';
+    int  lwork = _work.size();
+    int  info  = 0;
+
+    zheev_(&jobz, &uplo, &_N, A.memptr(), &_N, E.memptr(), _work.memptr(), &lwork,
+           _rwork.memptr(), &info);
+
+    if(info != 0)
+    {
+        std::ostringstream oss;
+        oss << "Cannot solve Hermitian eigenproblem. (LAPACK error code: " << info << ")";
+        throw std::runtime_error(oss.str());
+    }
+}
 } // namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
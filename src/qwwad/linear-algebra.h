@@ -187,6 +187,27 @@ solve_cyclic_matrix(arma::vec A_sub,
 void matrixProduct(double*      pB,
                    double*      pA,
                    const size_t N);
+
+/**
+ * \brief Solver for dense Hermitian eigenvalue problems with reusable workspace
+ *
+ * \details The LAPACK workspace is allocated once for a given order of
+ *          matrix and reused for every subsequent problem.  A solver must
+ *          not be shared between threads, but each thread may have its own.
+ */
+class HermitianEigenSolver
+{
+private:
+    int          _N;     ///< Order of matrix
+    arma::cx_vec _work;  ///< Complex workspace for LAPACK
+    arma::vec    _rwork; ///< Real workspace for LAPACK
+
+public:
+    explicit HermitianEigenSolver(const size_t N);
+
+    void solve(arma::cx_mat &A,
+               arma::vec    &E);
+};
 } // namespace
 #endif //QWWAD_LINEAR_ALGEBRA_H
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -121,5 +121,39 @@ double sf_brillouin(const double J,
     const auto y = tJp1_tJ * coth(tJp1_tJ * x) - 1.0/tJ*coth(x/tJ);
     return y;
 }
+
+/**
+ * \brief Find the weight of each sample in a numerical integral
+ *
+ * \param[in] n  Number of samples
+ * \param[in] dx Spatial step between samples
+ *
+ * \details Uses the same rule as the integral() function, so that the
+ *          weighted sum of a set of samples matches their integral.  This
+ *          allows integrals to be written as dot products or matrix products.
+ */
+arma::vec quadrature_weights(const size_t n,
+                             const double dx)
+{
+    arma::vec w(n);
+
+    if(GSL_IS_ODD(n) && n >= 3)
+    {
+        // Simpson's rule
+        for(unsigned int i = 0; i < n; ++i)
+            w[i] = (i == 0 || i == n-1) ? 1.0 : (GSL_IS_ODD(i) ? 4.0 : 2.0);
+
+        w *= dx/3.0;
+    }
+    else
+    {
+        // Trapezium rule
+        w.fill(dx);
+        w[0]   /= 2.0;
+        w[n-1] /= 2.0;
+    }
+
+    return w;
+}
 } // namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
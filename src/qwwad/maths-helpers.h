@@ -7,9 +7,11 @@
 #ifndef QWWAD_MATHS_HELPERS_H
 #define QWWAD_MATHS_HELPERS_H
 
+#include <cmath>
 #include <cstddef>
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 
 #include <gsl/gsl_math.h>
 
@@ -109,6 +111,179 @@ complex_type integral(const arma::Col<complex_type>& y, const real_type dx)
         return trapz(y, dx);
 }
 
+/**
+ * \brief Recursive step for adaptive Simpson integration
+ *
+ * \details Splits the interval [a,b] in half, and compares the sum of the
+ *          Simpson estimates for each half with the estimate for the whole
+ *          interval.  Halves are refined further until the difference is
+ *          within tolerance, or the recursion limit is reached, or the
+ *          number of function evaluations runs out.  In the last two cases,
+ *          the best available estimate is used and converged is set false.
+ */
+template <class Function>
+double integral_adaptive_step(const Function     &f,
+                              const double        a,
+                              const double        b,
+                              const double        fa,
+                              const double        fm,
+                              const double        fb,
+                              const double        whole,
+                              const double        tol,
+                              const unsigned int  depth,
+                              size_t             &n_evals_left,
+                              bool               &converged)
+{
+    if(n_evals_left < 2)
+    {
+        converged = false;
+        return whole;
+    }
+
+    const double m   = (a + b)/2;
+    const double lm  = (a + m)/2;
+    const double rm  = (m + b)/2;
+    const double flm = f(lm);
+    const double frm = f(rm);
+    n_evals_left -= 2;
+
+    const double left  = (m - a)/6 * (fa + 4*flm + fm);
+    const double right = (b - m)/6 * (fm + 4*frm + fb);
+    const double delta = left + right - whole;
+
+    // Accept the Richardson-extrapolated estimate if it's good enough
+    if(fabs(delta) <= 15*tol)
+        return left + right + delta/15;
+
+    // At the recursion limit, the best available estimate is used.  This
+    // happens near discontinuities that weren't given as breakpoints.
+    if(depth == 0)
+    {
+        converged = false;
+        return left + right + delta/15;
+    }
+
+    return integral_adaptive_step(f, a, m, fa, flm, fm, left,  tol/2, depth-1, n_evals_left, converged) +
+           integral_adaptive_step(f, m, b, fm, frm, fb, right, tol/2, depth-1, n_evals_left, converged);
+}
+
+/**
+ * \brief Integrate a function using adaptive Simpson quadrature
+ *
+ * \param[in] f           Function to integrate.  Any callable object taking and
+ *                        returning a double may be used
+ * \param[in] breakpoints Limits of the integral and any points at which the
+ *                        function is known to change abruptly, in ascending order
+ * \param[in] rel_tol     Tolerance, relative to the magnitude of the integral
+ * \param[in] max_depth   Maximum number of interval bisections
+ * \param[in] max_evals   Maximum number of function evaluations, after the
+ *                        initial sampling of each interval
+ * \param[out] converged  If given, set to false if the tolerance was not
+ *                        met everywhere before either limit was reached
+ *
+ * \details Each interval between breakpoints is first split into a few
+ *          panels, which gives an estimate of the magnitude of the integral.
+ *          The panels are then refined independently, with the absolute
+ *          tolerance shared between them in proportion to their width, so
+ *          that points are concentrated wherever the function varies rapidly.
+ *
+ * \returns The integral
+ */
+template <class Function>
+double integral_adaptive(const Function     &f,
+                         const arma::vec    &breakpoints,
+                         const double        rel_tol,
+                         const unsigned int  max_depth = 30,
+                         const size_t        max_evals = 100000,
+                         bool               *converged = nullptr)
+{
+    if(converged)
+        *converged = true;
+
+    const size_t nbreak = breakpoints.size();
+
+    if(nbreak < 2)
+        throw std::invalid_argument("Need at least two breakpoints for adaptive integration.");
+
+    if(rel_tol <= 0)
+        throw std::domain_error("Tolerance for adaptive integration must be positive.");
+
+    const unsigned int npanel = 8; // Initial number of panels per interval
+    const double L = breakpoints[nbreak-1] - breakpoints[0];
+
+    if(L <= 0)
+        return 0.0;
+
+    // Initial sampling of all panels
+    std::vector<double> a_panel;
+    std::vector<double> b_panel;
+    std::vector<double> fa_panel;
+    std::vector<double> fm_panel;
+    std::vector<double> fb_panel;
+    std::vector<double> S_panel;
+    double S_abs = 0.0; // Estimate of the integral of |f|
+
+    for(unsigned int ibreak = 0; ibreak < nbreak-1; ++ibreak)
+    {
+        const double a = breakpoints[ibreak];
+        const double b = breakpoints[ibreak+1];
+
+        if(b < a)
+            throw std::invalid_argument("Breakpoints for adaptive integration must be in ascending order.");
+
+        if(b == a)
+            continue;
+
+        const double h = (b - a)/npanel;
+        double fa = f(a);
+
+        for(unsigned int ipanel = 0; ipanel < npanel; ++ipanel)
+        {
+            const double x0 = a + ipanel*h;
+            const double x1 = (ipanel == npanel-1) ? b : x0 + h;
+            const double fm = f((x0 + x1)/2);
+            const double fb = f(x1);
+            const double S  = (x1 - x0)/6 * (fa + 4*fm + fb);
+
+            a_panel.push_back(x0);
+            b_panel.push_back(x1);
+            fa_panel.push_back(fa);
+            fm_panel.push_back(fm);
+            fb_panel.push_back(fb);
+            S_panel.push_back(S);
+            S_abs += (x1 - x0)/6 * (fabs(fa) + 4*fabs(fm) + fabs(fb));
+
+            fa = fb;
+        }
+    }
+
+    if(S_abs == 0.0)
+        return 0.0;
+
+    const double tol = rel_tol*S_abs;
+    double result = 0.0;
+    size_t n_evals_left = max_evals;
+    bool   panels_converged = true;
+
+    for(unsigned int ipanel = 0; ipanel < a_panel.size(); ++ipanel)
+    {
+        const double w = b_panel[ipanel] - a_panel[ipanel];
+        result += integral_adaptive_step(f,
+                                         a_panel[ipanel], b_panel[ipanel],
+                                         fa_panel[ipanel], fm_panel[ipanel], fb_panel[ipanel],
+                                         S_panel[ipanel],
+                                         tol*w/L,
+                                         max_depth,
+                                         n_evals_left,
+                                         panels_converged);
+    }
+
+    if(converged)
+        *converged = panels_converged;
+
+    return result;
+}
+
 double lookup_y_from_x(const arma::vec &x_values,
                        const arma::vec &y_values,
                        const double     x0);
@@ -126,6 +301,9 @@ unsigned int Theta(const double x);
 
 double sf_brillouin(const double J,
                     const double x);
+
+arma::vec quadrature_weights(const size_t n,
+                             const double dx);
 } // namespace
 #endif
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,345 @@
+/**
+ * \file   plane-wave-solver.cpp
+ * \brief  Iterative plane-wave eigensolver for pseudopotential calculations
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "plane-wave-solver.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include "constants.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Set up the real-space grid and local potential
+ *
+ * \param[in] G         Basis vectors [1/m]
+ * \param[in] A0        Lattice constant [m]
+ * \param[in] potential Crystal potential
+ * \param[in] mass      Particle mass [kg]
+ */
+PlaneWaveSolver::PlaneWaveSolver(const std::vector<arma::vec> &G,
+                                 const double                  A0,
+                                 const CrystalPotential       &potential,
+                                 const double                  mass) :
+    _G(3, G.size()),
+    _b(3),
+    _m(find_lattice_indices(G, A0, _b)),
+    _fft(find_grid_size(_m, 0), find_grid_size(_m, 1), find_grid_size(_m, 2)),
+    _grid_index(G.size()),
+    _V_r(_fft.get_n_total()),
+    _V0(0.0),
+    _mass(mass),
+    _tol(1e-6*e),
+    _max_iter(200),
+    _n_iter(0)
+{
+    const size_t n[3] = {_fft.get_n(0), _fft.get_n(1), _fft.get_n(2)};
+    arma::uvec used = arma::zeros<arma::uvec>(_fft.get_n_total());
+
+    for(unsigned int iG = 0; iG < G.size(); ++iG)
+    {
+        _G.col(iG) = G[iG];
+
+        size_t i[3];
+
+        for(unsigned int dim = 0; dim < 3; ++dim)
+            i[dim] = (_m(dim,iG) + n[dim]) % n[dim];
+
+        _grid_index(iG) = i[0] + n[0]*(i[1] + n[1]*i[2]);
+
+        if(used(_grid_index(iG)))
+        {
+            std::ostringstream oss;
+            oss << "Basis vector " << iG << " appears more than once";
+            throw std::invalid_argument(oss.str());
+        }
+
+        used(_grid_index(iG)) = 1;
+    }
+
+    // The potential is needed for every difference between a pair of basis
+    // vectors, which lies within a box of twice the size of the basis
+    const long long q_max[3] = {arma::abs(_m.row(0)).max()*2,
+                                arma::abs(_m.row(1)).max()*2,
+                                arma::abs(_m.row(2)).max()*2};
+
+    std::vector<arma::vec> q;
+    std::vector<size_t>    q_index;
+
+    for(long long qz = -q_max[2]; qz <= q_max[2]; ++qz)
+    {
+        for(long long qy = -q_max[1]; qy <= q_max[1]; ++qy)
+        {
+            for(long long qx = -q_max[0]; qx <= q_max[0]; ++qx)
+            {
+                arma::vec q_vec(3);
+                q_vec(0) = qx*_b(0);
+                q_vec(1) = qy*_b(1);
+                q_vec(2) = qz*_b(2);
+                q.push_back(q_vec);
+
+                const size_t ix = (qx + n[0]) % n[0];
+                const size_t iy = (qy + n[1]) % n[1];
+                const size_t iz = (qz + n[2]) % n[2];
+                q_index.push_back(ix + n[0]*(iy + n[1]*iz));
+            }
+        }
+    }
+
+    const arma::cx_vec V_q = potential.get_V_q(q);
+
+    _V_r.zeros();
+
+    for(unsigned int iq = 0; iq < q.size(); ++iq)
+        _V_r(q_index[iq]) = V_q(iq);
+
+    _V0 = std::real(_V_r(0));
+
+    // V(r) = sum_q V(q) exp(iq.r)
+    _fft.backward(_V_r);
+}
+
+/**
+ * \brief Find the number of real-space grid points in one direction
+ *
+ * \details The product of the potential, with components up to 2m_max, and a
+ *          wavefunction, with components up to m_max, is only needed for
+ *          components up to m_max.  A grid with more than 4m_max points
+ *          ensures that none of these are aliased.
+ */
+size_t PlaneWaveSolver::find_grid_size(const arma::imat   &m,
+                                       const unsigned int  dim)
+{
+    const size_t m_max = arma::abs(m.row(dim)).max();
+    return FFT3D::get_good_size(4*m_max + 1);
+}
+
+/**
+ * \brief Apply the Hamiltonian to a set of vectors
+ *
+ * \param[in]  T  Kinetic energy of each plane wave [J]
+ * \param[in]  X  Vectors, one per column
+ * \param[out] HX Result of applying Hamiltonian to each vector
+ */
+void PlaneWaveSolver::apply_H(const arma::vec    &T,
+                              const arma::cx_mat &X,
+                              arma::cx_mat       &HX) const
+{
+    const size_t N       = X.n_rows;
+    const size_t n_total = _fft.get_n_total();
+    HX.set_size(N, X.n_cols);
+
+#pragma omp parallel
+    {
+        arma::cx_vec grid(n_total);
+
+#pragma omp for schedule(static)
+        for(unsigned int icol = 0; icol < X.n_cols; ++icol)
+        {
+            grid.zeros();
+
+            for(unsigned int iG = 0; iG < N; ++iG)
+                grid(_grid_index(iG)) = X(iG,icol);
+
+            _fft.backward(grid);
+            grid %= _V_r;
+            _fft.forward(grid);
+
+            for(unsigned int iG = 0; iG < N; ++iG)
+                HX(iG,icol) = grid(_grid_index(iG))/static_cast<double>(n_total) + T(iG)*X(iG,icol);
+        }
+    }
+}
+
+/**
+ * \brief Orthonormalise new columns of a matrix against the existing ones
+ *
+ * \param[in,out] V       Matrix of vectors.  The first n_fixed columns must
+ *                        already be orthonormal.
+ * \param[in]     n_fixed Number of columns that are already orthonormal
+ *
+ * \returns The number of new columns that are kept
+ *
+ * \details Classical Gram-Schmidt is applied twice to each new column.  Any
+ *          column that lies (almost) within the span of the others is
+ *          removed.
+ */
+size_t PlaneWaveSolver::orthonormalise(arma::cx_mat &V,
+                                       const size_t  n_fixed)
+{
+    size_t n_kept = n_fixed;
+
+    for(size_t j = n_fixed; j < V.n_cols; ++j)
+    {
+        arma::cx_vec v = V.col(j);
+        const double norm_initial = arma::norm(v);
+
+        if(norm_initial == 0.0)
+            continue;
+
+        if(n_kept > 0)
+        {
+            for(unsigned int pass = 0; pass < 2; ++pass)
+            {
+                const arma::cx_mat V_kept = V.cols(0, n_kept-1);
+                const arma::cx_vec overlap = V_kept.t() * v;
+                v -= V_kept * overlap;
+            }
+        }
+
+        const double norm_final = arma::norm(v);
+
+        if(norm_final > 1e-8*norm_initial)
+        {
+            V.col(n_kept) = v/norm_final;
+            ++n_kept;
+        }
+    }
+
+    V.resize(V.n_rows, n_kept);
+
+    return n_kept - n_fixed;
+}
+
+/**
+ * \brief Find the lowest bands at a given wave vector
+ *
+ * \param[in]     k       Wave vector [1/m]
+ * \param[in]     n_bands Number of bands to find
+ * \param[out]    E       Energy of each band [J]
+ * \param[in,out] X       Coefficients of each band, one per column.  If this
+ *                        has the correct size on input, it is used as the
+ *                        initial guess.  This speeds up the solution when
+ *                        stepping through closely spaced wave vectors.
+ *
+ * \details The search space is restarted from the current estimates once it
+ *          grows to four times the number of bands.
+ */
+void PlaneWaveSolver::solve(const arma::vec &k,
+                            const size_t     n_bands,
+                            arma::vec       &E,
+                            arma::cx_mat    &X) const
+{
+    const size_t N = _G.n_cols;
+
+    if(n_bands == 0 || n_bands > N)
+    {
+        std::ostringstream oss;
+        oss << "Cannot find " << n_bands << " bands using " << N << " plane waves";
+        throw std::domain_error(oss.str());
+    }
+
+    const size_t max_subspace = 4*n_bands;
+
+    // Smallest allowed denominator in preconditioner [J]
+    const double min_denominator = 1e-3*e;
+
+    // Kinetic energy of each plane wave, and diagonal of Hamiltonian [J]
+    arma::vec T(N);
+
+    for(unsigned int iG = 0; iG < N; ++iG)
+    {
+        const arma::vec G_plus_k = _G.col(iG) + k;
+        T(iG) = hBar*hBar/(2*_mass) * dot(G_plus_k, G_plus_k);
+    }
+
+    const arma::vec diag = T + _V0;
+
+    arma::cx_mat V;
+
+    if(X.n_rows == N && X.n_cols == n_bands)
+        V = X;
+    else
+    {
+        // Start from the plane waves with the lowest diagonal energy
+        const arma::uvec order = arma::sort_index(diag);
+        V = arma::zeros<arma::cx_mat>(N, n_bands);
+
+        for(unsigned int ib = 0; ib < n_bands; ++ib)
+            V(order(ib), ib) = 1.0;
+    }
+
+    if(orthonormalise(V, 0) < n_bands)
+        throw std::runtime_error("Initial guess for plane-wave eigensolver is linearly dependent");
+
+    arma::cx_mat AV;
+    apply_H(T, V, AV);
+
+    for(_n_iter = 1; _n_iter <= _max_iter; ++_n_iter)
+    {
+        // Rayleigh-Ritz projection onto the search space
+        arma::cx_mat H_sub = V.t() * AV;
+        H_sub = 0.5*(H_sub + H_sub.t());
+
+        arma::vec    theta;
+        arma::cx_mat Y;
+        arma::eig_sym(theta, Y, H_sub);
+
+        const arma::cx_mat Y_bands = Y.cols(0, n_bands-1);
+        X = V * Y_bands;
+        const arma::cx_mat AX = AV * Y_bands;
+        E = theta.subvec(0, n_bands-1);
+
+        // Preconditioned corrections for each unconverged band
+        arma::cx_mat corrections(N, n_bands);
+        size_t n_new = 0;
+
+        for(unsigned int ib = 0; ib < n_bands; ++ib)
+        {
+            arma::cx_vec r = AX.col(ib) - E(ib)*X.col(ib);
+
+            if(arma::norm(r) <= _tol)
+                continue;
+
+            for(unsigned int iG = 0; iG < N; ++iG)
+            {
+                double denominator = diag(iG) - E(ib);
+
+                if(std::abs(denominator) < min_denominator)
+                    denominator = (denominator < 0) ? -min_denominator : min_denominator;
+
+                r(iG) /= denominator;
+            }
+
+            corrections.col(n_new) = r;
+            ++n_new;
+        }
+
+        if(n_new == 0)
+            return;
+
+        // Restart from the current estimates if the search space is full
+        if(V.n_cols + n_new > max_subspace)
+        {
+            V  = X;
+            AV = AX;
+        }
+
+        const size_t n_old = V.n_cols;
+        V.resize(N, n_old + n_new);
+        V.cols(n_old, n_old + n_new - 1) = corrections.cols(0, n_new - 1);
+
+        if(orthonormalise(V, n_old) == 0)
+            throw std::runtime_error("Plane-wave eigensolver stagnated before reaching tolerance");
+
+        arma::cx_mat A_new;
+        apply_H(T, V.cols(n_old, V.n_cols - 1), A_new);
+
+        AV.resize(N, V.n_cols);
+        AV.cols(n_old, V.n_cols - 1) = A_new;
+    }
+
+    std::ostringstream oss;
+    oss << "Plane-wave eigensolver did not converge in " << _max_iter << " iterations";
+    throw std::runtime_error(oss.str());
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,89 @@
+/**
+ * \file   plane-wave-solver.h
+ * \brief  Iterative plane-wave eigensolver for pseudopotential calculations
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_PLANE_WAVE_SOLVER_H
+#define QWWAD_PLANE_WAVE_SOLVER_H
+
+#include <vector>
+#include <armadillo>
+
+#include "fft.h"
+#include "pplb-functions.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Iterative solver for the lowest bands of a plane-wave Hamiltonian
+ *
+ * \details The Hamiltonian matrix is never stored.  The kinetic energy is
+ *          diagonal in the plane-wave basis.  The local crystal potential is
+ *          applied by transforming each wavefunction onto a real-space grid,
+ *          multiplying by V(r) and transforming back.  The grid is large
+ *          enough to avoid aliasing, so the result is identical to
+ *          multiplying by the dense matrix of V(G-G').
+ *
+ *          The lowest bands are found using block Davidson iteration, with
+ *          corrections preconditioned by the diagonal of the Hamiltonian.
+ *          The memory use is linear in the number of basis vectors, and the
+ *          time per iteration scales as N log N.
+ *
+ *          The basis vectors must lie on a rectangular reciprocal lattice,
+ *          with spacing 2 pi/(n A0) in each direction for some integer n.
+ *          This is the case for vectors generated for any orthorhombic
+ *          supercell.
+ */
+class PlaneWaveSolver
+{
+private:
+    arma::mat    _G;          ///< Basis vectors, one per column [1/m]
+    arma::vec    _b;          ///< Reciprocal lattice spacing in each direction [1/m]
+    arma::imat   _m;          ///< Index of each basis vector on the reciprocal lattice (3 x N)
+    FFT3D        _fft;        ///< Transform between reciprocal and real space
+    arma::uvec   _grid_index; ///< Position of each basis vector in the FFT grid
+    arma::cx_vec _V_r;        ///< Local potential at each real-space grid point [J]
+    double       _V0;         ///< Average potential, V(q = 0) [J]
+    double       _mass;       ///< Particle mass [kg]
+
+    double         _tol;      ///< Tolerance on residual norm [J]
+    size_t         _max_iter; ///< Maximum number of iterations
+    mutable size_t _n_iter;   ///< Number of iterations used in last solution
+
+    static size_t find_grid_size(const arma::imat   &m,
+                                 const unsigned int  dim);
+
+    void apply_H(const arma::vec    &T,
+                 const arma::cx_mat &X,
+                 arma::cx_mat       &HX) const;
+
+    static size_t orthonormalise(arma::cx_mat &V,
+                                 const size_t  n_fixed);
+
+public:
+    PlaneWaveSolver(const std::vector<arma::vec> &G,
+                    const double                  A0,
+                    const CrystalPotential       &potential,
+                    const double                  mass);
+
+    void solve(const arma::vec &k,
+               const size_t     n_bands,
+               arma::vec       &E,
+               arma::cx_mat    &X) const;
+
+    /// Set the tolerance on the norm of each residual vector [J]
+    inline void set_tolerance(const double tol) {_tol = tol;}
+
+    /// Set the maximum number of iterations
+    inline void set_max_iterations(const size_t max_iter) {_max_iter = max_iter;}
+
+    /// Get the number of iterations used in the last solution
+    inline size_t get_iterations() const {return _n_iter;}
+
+    /// Get the number of points in the real-space grid in a given direction (0, 1 or 2)
+    inline size_t get_grid_size(const unsigned int dim) const {return _fft.get_n(dim);}
+};
+} // namespace QWWAD
+#endif // QWWAD_PLANE_WAVE_SOLVER_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
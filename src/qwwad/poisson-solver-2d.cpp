@@ -0,0 +1,508 @@
+/**
+ * \file   poisson-solver-2d.cpp
+ * \brief  Poisson solver for 2D cross-sections
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "poisson-solver-2d.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace QWWAD
+{
+/**
+ * \brief Create a 2D Poisson solver
+ *
+ * \param[in] eps Permittivity of each cell [F/m].  Element (i,j) is the
+ *                cell at column i in the x direction and row j in the
+ *                y direction.
+ * \param[in] dx  Cell width in x direction [m]
+ * \param[in] dy  Cell width in y direction [m]
+ */
+PoissonSolver2D::PoissonSolver2D(const arma::mat &eps,
+                                 const double     dx,
+                                 const double     dy) :
+    _eps(eps),
+    _dx(dx),
+    _dy(dy),
+    _nx(eps.n_rows),
+    _ny(eps.n_cols),
+    _dirichlet(4),
+    _bc_value(4),
+    _tol(1e-10),
+    _max_iter(200),
+    _n_iter(0)
+{
+    if(_nx == 0 || _ny == 0)
+        throw std::invalid_argument("Permittivity map is empty");
+
+    if(dx <= 0 || dy <= 0)
+        throw std::invalid_argument("Cell widths must be positive");
+
+    if(_eps.min() <= 0)
+        throw std::domain_error("Permittivity must be positive in all cells");
+
+    for(const auto edge : {EDGE_X_MIN, EDGE_X_MAX, EDGE_Y_MIN, EDGE_Y_MAX})
+    {
+        _dirichlet[edge] = arma::zeros<arma::uvec>(get_edge_length(edge));
+        _bc_value[edge]  = arma::zeros(get_edge_length(edge));
+    }
+
+    build_levels();
+}
+
+/**
+ * \brief Get the number of cells along an edge of the domain
+ */
+size_t PoissonSolver2D::get_edge_length(const PoissonEdge edge) const
+{
+    return (edge == EDGE_X_MIN || edge == EDGE_X_MAX) ? _ny : _nx;
+}
+
+/**
+ * \brief Fix the potential along an entire edge
+ *
+ * \param[in] edge The edge of the domain
+ * \param[in] V    Potential [V]
+ */
+void PoissonSolver2D::set_dirichlet(const PoissonEdge edge,
+                                    const double      V)
+{
+    set_boundary(edge, 0, get_edge_length(edge) - 1, true, V);
+}
+
+/**
+ * \brief Fix the potential along part of an edge
+ *
+ * \param[in] edge  The edge of the domain
+ * \param[in] first Index of first cell along the edge
+ * \param[in] last  Index of last cell along the edge (inclusive)
+ * \param[in] V     Potential [V]
+ *
+ * \details This can be used to describe a contact or gate electrode.
+ */
+void PoissonSolver2D::set_dirichlet(const PoissonEdge  edge,
+                                    const unsigned int first,
+                                    const unsigned int last,
+                                    const double       V)
+{
+    set_boundary(edge, first, last, true, V);
+}
+
+/**
+ * \brief Fix the normal electric field along an entire edge
+ *
+ * \param[in] edge The edge of the domain
+ * \param[in] E_n  Component of field pointing out of the domain [V/m]
+ */
+void PoissonSolver2D::set_neumann(const PoissonEdge edge,
+                                  const double      E_n)
+{
+    set_boundary(edge, 0, get_edge_length(edge) - 1, false, E_n);
+}
+
+/**
+ * \brief Fix the normal electric field along part of an edge
+ *
+ * \param[in] edge  The edge of the domain
+ * \param[in] first Index of first cell along the edge
+ * \param[in] last  Index of last cell along the edge (inclusive)
+ * \param[in] E_n   Component of field pointing out of the domain [V/m]
+ */
+void PoissonSolver2D::set_neumann(const PoissonEdge  edge,
+                                  const unsigned int first,
+                                  const unsigned int last,
+                                  const double       E_n)
+{
+    set_boundary(edge, first, last, false, E_n);
+}
+
+void PoissonSolver2D::set_boundary(const PoissonEdge  edge,
+                                   const unsigned int first,
+                                   const unsigned int last,
+                                   const bool         dirichlet,
+                                   const double       value)
+{
+    const auto n = get_edge_length(edge);
+
+    if(first > last || last >= n)
+    {
+        std::ostringstream oss;
+        oss << "Boundary segment " << first << ".." << last << " lies outside edge with "
+            << n << " cells.";
+        throw std::domain_error(oss.str());
+    }
+
+    for(unsigned int k = first; k <= last; ++k)
+    {
+        _dirichlet[edge](k) = dirichlet ? 1 : 0;
+        _bc_value[edge](k)  = value;
+    }
+
+    // The operator depends on which boundary cells are fixed, so the
+    // multigrid hierarchy must be rebuilt
+    build_levels();
+}
+
+/**
+ * \brief Set up the operator on every multigrid level
+ */
+void PoissonSolver2D::build_levels()
+{
+    Level fine;
+    fine.nx   = _nx;
+    fine.ny   = _ny;
+    fine.fx   = 1;
+    fine.fy   = 1;
+    fine.Tx   = arma::zeros(_nx+1, _ny);
+    fine.Ty   = arma::zeros(_nx, _ny+1);
+
+    // Interior faces use the harmonic mean of the permittivity in the
+    // neighbouring cells
+    for(unsigned int j = 0; j < _ny; ++j)
+    {
+        for(unsigned int i = 1; i < _nx; ++i)
+        {
+            const double eps_face = 2.0*_eps(i-1,j)*_eps(i,j)/(_eps(i-1,j) + _eps(i,j));
+            fine.Tx(i,j) = eps_face*_dy/_dx;
+        }
+
+        // Dirichlet boundaries lie half a cell from the cell centre
+        if(_dirichlet[EDGE_X_MIN](j))
+            fine.Tx(0,j) = 2.0*_eps(0,j)*_dy/_dx;
+
+        if(_dirichlet[EDGE_X_MAX](j))
+            fine.Tx(_nx,j) = 2.0*_eps(_nx-1,j)*_dy/_dx;
+    }
+
+    for(unsigned int i = 0; i < _nx; ++i)
+    {
+        for(unsigned int j = 1; j < _ny; ++j)
+        {
+            const double eps_face = 2.0*_eps(i,j-1)*_eps(i,j)/(_eps(i,j-1) + _eps(i,j));
+            fine.Ty(i,j) = eps_face*_dx/_dy;
+        }
+
+        if(_dirichlet[EDGE_Y_MIN](i))
+            fine.Ty(i,0) = 2.0*_eps(i,0)*_dx/_dy;
+
+        if(_dirichlet[EDGE_Y_MAX](i))
+            fine.Ty(i,_ny) = 2.0*_eps(i,_ny-1)*_dx/_dy;
+    }
+
+    fine.diag = fine.Tx.rows(0,_nx-1) + fine.Tx.rows(1,_nx)
+              + fine.Ty.cols(0,_ny-1) + fine.Ty.cols(1,_ny);
+
+    _levels.clear();
+    _levels.push_back(fine);
+
+    // Coarsen until the grid is small enough to solve directly
+    while(_levels.back().nx * _levels.back().ny > 64 &&
+          (_levels.back().nx > 2 || _levels.back().ny > 2))
+    {
+        _levels.push_back(coarsen(_levels.back()));
+    }
+
+    // The operator is only invertible if the potential is fixed somewhere
+    bool has_dirichlet = false;
+
+    for(const auto &d : _dirichlet)
+        has_dirichlet = has_dirichlet || arma::any(d);
+
+    _coarse_inverse.reset();
+
+    if(has_dirichlet)
+    {
+        const auto &c = _levels.back();
+        const unsigned int n = c.nx * c.ny;
+        arma::mat A = arma::zeros(n, n);
+
+        for(unsigned int j = 0; j < c.ny; ++j)
+        {
+            for(unsigned int i = 0; i < c.nx; ++i)
+            {
+                const unsigned int k = i + c.nx*j;
+                A(k,k) = c.diag(i,j);
+
+                if(i > 0)      A(k, k-1)    = -c.Tx(i,j);
+                if(i < c.nx-1) A(k, k+1)    = -c.Tx(i+1,j);
+                if(j > 0)      A(k, k-c.nx) = -c.Ty(i,j);
+                if(j < c.ny-1) A(k, k+c.nx) = -c.Ty(i,j+1);
+            }
+        }
+
+        _coarse_inverse = arma::inv(A);
+    }
+}
+
+/**
+ * \brief Form the operator on the next coarser grid
+ *
+ * \details Each coarse cell contains up to 2x2 fine cells.  Coarse faces
+ *          are twice as tall and the distance between cell centres is twice
+ *          as large, so each coarse face conductance is half the sum of the
+ *          fine faces that it contains.
+ */
+PoissonSolver2D::Level PoissonSolver2D::coarsen(const Level &fine)
+{
+    Level coarse;
+    coarse.fx = (fine.nx > 2) ? 2 : 1;
+    coarse.fy = (fine.ny > 2) ? 2 : 1;
+    coarse.nx = (fine.nx + coarse.fx - 1)/coarse.fx;
+    coarse.ny = (fine.ny + coarse.fy - 1)/coarse.fy;
+    coarse.Tx = arma::zeros(coarse.nx+1, coarse.ny);
+    coarse.Ty = arma::zeros(coarse.nx, coarse.ny+1);
+
+    for(unsigned int J = 0; J < coarse.ny; ++J)
+    {
+        for(unsigned int I = 0; I <= coarse.nx; ++I)
+        {
+            const unsigned int i = std::min(I*coarse.fx, fine.nx);
+
+            for(unsigned int j = J*coarse.fy; j < std::min((J+1)*coarse.fy, fine.ny); ++j)
+                coarse.Tx(I,J) += fine.Tx(i,j);
+
+            coarse.Tx(I,J) /= coarse.fx;
+        }
+    }
+
+    for(unsigned int I = 0; I < coarse.nx; ++I)
+    {
+        for(unsigned int J = 0; J <= coarse.ny; ++J)
+        {
+            const unsigned int j = std::min(J*coarse.fy, fine.ny);
+
+            for(unsigned int i = I*coarse.fx; i < std::min((I+1)*coarse.fx, fine.nx); ++i)
+                coarse.Ty(I,J) += fine.Ty(i,j);
+
+            coarse.Ty(I,J) /= coarse.fy;
+        }
+    }
+
+    coarse.diag = coarse.Tx.rows(0,coarse.nx-1) + coarse.Tx.rows(1,coarse.nx)
+                + coarse.Ty.cols(0,coarse.ny-1) + coarse.Ty.cols(1,coarse.ny);
+
+    return coarse;
+}
+
+/**
+ * \brief Apply the discretised operator on a given level
+ */
+arma::mat PoissonSolver2D::apply(const Level     &level,
+                                 const arma::mat &u)
+{
+    arma::mat Au = level.diag % u;
+
+    for(unsigned int j = 0; j < level.ny; ++j)
+    {
+        for(unsigned int i = 0; i < level.nx; ++i)
+        {
+            if(i > 0)          Au(i,j) -= level.Tx(i,j)   * u(i-1,j);
+            if(i < level.nx-1) Au(i,j) -= level.Tx(i+1,j) * u(i+1,j);
+            if(j > 0)          Au(i,j) -= level.Ty(i,j)   * u(i,j-1);
+            if(j < level.ny-1) Au(i,j) -= level.Ty(i,j+1) * u(i,j+1);
+        }
+    }
+
+    return Au;
+}
+
+/**
+ * \brief Perform one red-black Gauss-Seidel sweep
+ *
+ * \param[in]     level   Multigrid level
+ * \param[in,out] u       Solution estimate
+ * \param[in]     b       Right-hand side
+ * \param[in]     forward If true, red cells are updated first.  Otherwise,
+ *                        black cells are updated first.
+ *
+ * \details Cells of the same colour are independent, so each half-sweep is
+ *          shared between threads.  Reversing the order of the colours
+ *          after the coarse-grid correction keeps the V-cycle symmetric.
+ */
+void PoissonSolver2D::smooth(const Level     &level,
+                             arma::mat       &u,
+                             const arma::mat &b,
+                             const bool       forward)
+{
+    for(unsigned int ipass = 0; ipass < 2; ++ipass)
+    {
+        const unsigned int colour = forward ? ipass : 1 - ipass;
+
+#pragma omp parallel for
+        for(unsigned int j = 0; j < level.ny; ++j)
+        {
+            for(unsigned int i = (j + colour)%2; i < level.nx; i += 2)
+            {
+                double s = b(i,j);
+
+                if(i > 0)          s += level.Tx(i,j)   * u(i-1,j);
+                if(i < level.nx-1) s += level.Tx(i+1,j) * u(i+1,j);
+                if(j > 0)          s += level.Ty(i,j)   * u(i,j-1);
+                if(j < level.ny-1) s += level.Ty(i,j+1) * u(i,j+1);
+
+                u(i,j) = s/level.diag(i,j);
+            }
+        }
+    }
+}
+
+/**
+ * \brief Apply one multigrid V-cycle, starting from a zero solution
+ *
+ * \param[in]  ilevel Index of level
+ * \param[out] u      Approximate solution
+ * \param[in]  b      Right-hand side
+ */
+void PoissonSolver2D::v_cycle(const unsigned int  ilevel,
+                              arma::mat          &u,
+                              const arma::mat    &b) const
+{
+    const auto &level = _levels[ilevel];
+    u = arma::zeros(level.nx, level.ny);
+
+    // Solve directly on the coarsest grid
+    if(ilevel == _levels.size() - 1)
+    {
+        for(unsigned int k = 0; k < level.nx*level.ny; ++k)
+        {
+            double s = 0.0;
+
+            for(unsigned int l = 0; l < level.nx*level.ny; ++l)
+                s += _coarse_inverse(k,l) * b(l%level.nx, l/level.nx);
+
+            u(k%level.nx, k/level.nx) = s;
+        }
+
+        return;
+    }
+
+    const unsigned int nsweeps = 2;
+
+    for(unsigned int isweep = 0; isweep < nsweeps; ++isweep)
+        smooth(level, u, b, true);
+
+    // Restrict the residual by summing over the cells in each coarse cell
+    const arma::mat r = b - apply(level, u);
+    const auto &coarse = _levels[ilevel+1];
+    arma::mat b_coarse = arma::zeros(coarse.nx, coarse.ny);
+
+    for(unsigned int j = 0; j < level.ny; ++j)
+        for(unsigned int i = 0; i < level.nx; ++i)
+            b_coarse(i/coarse.fx, j/coarse.fy) += r(i,j);
+
+    arma::mat u_coarse;
+    v_cycle(ilevel+1, u_coarse, b_coarse);
+
+    // Piecewise-constant prolongation of the correction
+    for(unsigned int j = 0; j < level.ny; ++j)
+        for(unsigned int i = 0; i < level.nx; ++i)
+            u(i,j) += u_coarse(i/coarse.fx, j/coarse.fy);
+
+    for(unsigned int isweep = 0; isweep < nsweeps; ++isweep)
+        smooth(level, u, b, false);
+}
+
+/**
+ * \brief Find the right-hand side of the discretised equation
+ *
+ * \param[in] rho Charge density in each cell [C/m^3]
+ *
+ * \details Each element is the charge per unit depth in a cell, together
+ *          with the contributions from the boundary conditions.
+ */
+arma::mat PoissonSolver2D::get_rhs(const arma::mat &rho) const
+{
+    arma::mat b = rho*_dx*_dy;
+    const auto &fine = _levels[0];
+
+    for(unsigned int j = 0; j < _ny; ++j)
+    {
+        if(_dirichlet[EDGE_X_MIN](j))
+            b(0,j) += fine.Tx(0,j)*_bc_value[EDGE_X_MIN](j);
+        else
+            b(0,j) -= _eps(0,j)*_bc_value[EDGE_X_MIN](j)*_dy;
+
+        if(_dirichlet[EDGE_X_MAX](j))
+            b(_nx-1,j) += fine.Tx(_nx,j)*_bc_value[EDGE_X_MAX](j);
+        else
+            b(_nx-1,j) -= _eps(_nx-1,j)*_bc_value[EDGE_X_MAX](j)*_dy;
+    }
+
+    for(unsigned int i = 0; i < _nx; ++i)
+    {
+        if(_dirichlet[EDGE_Y_MIN](i))
+            b(i,0) += fine.Ty(i,0)*_bc_value[EDGE_Y_MIN](i);
+        else
+            b(i,0) -= _eps(i,0)*_bc_value[EDGE_Y_MIN](i)*_dx;
+
+        if(_dirichlet[EDGE_Y_MAX](i))
+            b(i,_ny-1) += fine.Ty(i,_ny)*_bc_value[EDGE_Y_MAX](i);
+        else
+            b(i,_ny-1) -= _eps(i,_ny-1)*_bc_value[EDGE_Y_MAX](i)*_dx;
+    }
+
+    return b;
+}
+
+/**
+ * \brief Find the electrostatic potential for a given charge distribution
+ *
+ * \param[in] rho Charge density in each cell [C/m^3]
+ *
+ * \returns Potential at the centre of each cell [V]
+ */
+arma::mat PoissonSolver2D::solve(const arma::mat &rho) const
+{
+    if(rho.n_rows != _nx || rho.n_cols != _ny)
+    {
+        std::ostringstream oss;
+        oss << "Charge density has " << rho.n_rows << "x" << rho.n_cols << " cells, but "
+            << "permittivity map has " << _nx << "x" << _ny << " cells.";
+        throw std::length_error(oss.str());
+    }
+
+    if(_coarse_inverse.is_empty())
+        throw std::domain_error("The potential must be fixed on part of the boundary");
+
+    const arma::mat b = get_rhs(rho);
+    const double b_norm = sqrt(arma::accu(b % b));
+
+    arma::mat phi = arma::zeros(_nx, _ny);
+    _n_iter = 0;
+
+    if(b_norm == 0.0)
+        return phi;
+
+    // Preconditioned conjugate-gradient iteration
+    arma::mat r = b;
+    arma::mat z;
+    v_cycle(0, z, r);
+    arma::mat p = z;
+    double rz = arma::accu(r % z);
+
+    for(_n_iter = 1; _n_iter <= _max_iter; ++_n_iter)
+    {
+        const arma::mat Ap = apply(_levels[0], p);
+        const double alpha = rz/arma::accu(p % Ap);
+
+        phi += alpha*p;
+        r   -= alpha*Ap;
+
+        if(sqrt(arma::accu(r % r)) <= _tol*b_norm)
+            return phi;
+
+        v_cycle(0, z, r);
+        const double rz_new = arma::accu(r % z);
+        p  = z + (rz_new/rz)*p;
+        rz = rz_new;
+    }
+
+    std::ostringstream oss;
+    oss << "2D Poisson solver did not converge within " << _max_iter << " iterations.";
+    throw std::runtime_error(oss.str());
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,141 @@
+/**
+ * \file   poisson-solver-2d.h
+ * \brief  Poisson solver for 2D cross-sections
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_POISSON_SOLVER_2D_H
+#define QWWAD_POISSON_SOLVER_2D_H
+
+#include <vector>
+#include <armadillo>
+
+namespace QWWAD
+{
+/**
+ * \brief Edge of a rectangular 2D domain
+ */
+enum PoissonEdge
+{
+    EDGE_X_MIN, ///< Edge at x = 0
+    EDGE_X_MAX, ///< Edge at the largest x
+    EDGE_Y_MIN, ///< Edge at y = 0
+    EDGE_Y_MAX  ///< Edge at the largest y
+};
+
+/**
+ * \brief Poisson solver for a 2D cross-section on a uniform rectangular grid
+ *
+ * \details The equation -∇·(ε∇φ) = ρ is discretised using cell-centred
+ *          finite volumes.  Each cell has its own permittivity, and the
+ *          harmonic mean is used at each face so that the normal
+ *          displacement is continuous at material interfaces.
+ *
+ *          Each cell along the edge of the domain has either a fixed
+ *          potential (Dirichlet) or a fixed outward normal electric field
+ *          (Neumann).  By default, all edges have zero normal field.  At
+ *          least one Dirichlet cell is needed to fix the potential.
+ *
+ *          The linear system is solved by conjugate-gradient iteration,
+ *          preconditioned by one geometric multigrid V-cycle.  Coarse grids
+ *          are formed by merging 2x2 blocks of cells, and the face
+ *          conductances are merged to match.  Red-black Gauss-Seidel
+ *          smoothing is used on each level, and the coarsest grid is solved
+ *          directly.  The memory use and the time per iteration are linear
+ *          in the number of cells, and the number of iterations is almost
+ *          independent of the grid size.
+ */
+class PoissonSolver2D
+{
+private:
+    /// Discretised operator on one multigrid level
+    struct Level {
+        unsigned int nx;   ///< Number of cells in x direction
+        unsigned int ny;   ///< Number of cells in y direction
+        unsigned int fx;   ///< Coarsening factor in x direction, relative to finer level
+        unsigned int fy;   ///< Coarsening factor in y direction, relative to finer level
+        arma::mat    Tx;   ///< Conductance of faces normal to x [F/m] (nx+1 by ny)
+        arma::mat    Ty;   ///< Conductance of faces normal to y [F/m] (nx by ny+1)
+        arma::mat    diag; ///< Diagonal of operator [F/m]
+    };
+
+    arma::mat    _eps;   ///< Permittivity of each cell [F/m]
+    double       _dx;    ///< Cell width in x direction [m]
+    double       _dy;    ///< Cell width in y direction [m]
+    unsigned int _nx;    ///< Number of cells in x direction
+    unsigned int _ny;    ///< Number of cells in y direction
+
+    std::vector<arma::uvec> _dirichlet; ///< Flag for Dirichlet condition at each cell on each edge
+    std::vector<arma::vec>  _bc_value;  ///< Boundary potential [V] or outward field [V/m]
+
+    std::vector<Level> _levels;         ///< Multigrid levels, from finest to coarsest
+    arma::mat          _coarse_inverse; ///< Inverse of operator on coarsest level
+
+    double         _tol;      ///< Relative tolerance on residual
+    size_t         _max_iter; ///< Maximum number of iterations
+    mutable size_t _n_iter;   ///< Number of iterations used in last solution
+
+    size_t get_edge_length(const PoissonEdge edge) const;
+
+    void set_boundary(const PoissonEdge  edge,
+                      const unsigned int first,
+                      const unsigned int last,
+                      const bool         dirichlet,
+                      const double       value);
+
+    void build_levels();
+
+    static Level coarsen(const Level &fine);
+
+    static arma::mat apply(const Level     &level,
+                           const arma::mat &u);
+
+    static void smooth(const Level     &level,
+                       arma::mat       &u,
+                       const arma::mat &b,
+                       const bool       forward);
+
+    void v_cycle(const unsigned int  ilevel,
+                 arma::mat          &u,
+                 const arma::mat    &b) const;
+
+    arma::mat get_rhs(const arma::mat &rho) const;
+
+public:
+    PoissonSolver2D(const arma::mat &eps,
+                    const double     dx,
+                    const double     dy);
+
+    void set_dirichlet(const PoissonEdge edge,
+                       const double      V);
+
+    void set_dirichlet(const PoissonEdge  edge,
+                       const unsigned int first,
+                       const unsigned int last,
+                       const double       V);
+
+    void set_neumann(const PoissonEdge edge,
+                     const double      E_n);
+
+    void set_neumann(const PoissonEdge  edge,
+                     const unsigned int first,
+                     const unsigned int last,
+                     const double       E_n);
+
+    arma::mat solve(const arma::mat &rho) const;
+
+    /// Set the tolerance on the residual, relative to the right-hand side
+    inline void set_tolerance(const double tol) {_tol = tol;}
+
+    /// Set the maximum number of iterations
+    inline void set_max_iterations(const size_t max_iter) {_max_iter = max_iter;}
+
+    /// Get the number of iterations used in the last solution
+    inline size_t get_iterations() const {return _n_iter;}
+
+    /// Get the number of multigrid levels
+    inline size_t get_n_levels() const {return _levels.size();}
+};
+} // namespace QWWAD
+#endif // QWWAD_POISSON_SOLVER_2D_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
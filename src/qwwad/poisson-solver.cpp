@@ -10,6 +10,8 @@
 #include "linear-algebra.h"
 #include "poisson-solver.h"
 
+#include <cmath>
+#include <sstream>
 #include <stdexcept>
 
 namespace QWWAD
@@ -34,7 +36,9 @@ PoissonSolver::PoissonSolver(const decltype(_eps) &eps,
     _corner_point(0.0),
     _D_diag(arma::zeros(_eps.size())),
     _L_sub(arma::zeros(_eps.size()-1)),
-    _boundary_type(bt)
+    _boundary_type(bt),
+    _nl_tol(1e-9),
+    _nl_max_iter(100)
 {
     compute_half_index_permittivity();
 
@@ -189,24 +193,17 @@ arma::vec PoissonSolver::solve(const arma::vec &rho) const
 }
 
 /**
- * \brief Solves the Poisson equation for a given charge-density and potential drop
+ * \brief Find the contribution of an applied potential drop to the right-hand side
+ *        of the Poisson equation
  *
- * \param[in] rho    The charge density profile [C m^{-3}]
  * \param[in] V_drop The total potential drop across the structure [J]
  *
- * \return The potential profile [J]
+ * \return The boundary term at each point
  */
-arma::vec PoissonSolver::solve(const arma::vec &rho,
-                               const double     V_drop) const
+arma::vec PoissonSolver::get_bias_rhs(const double V_drop) const
 {
     const auto n = _eps.size();
-
-    if (rho.size() != n)
-    {
-        throw std::runtime_error("Permittivity and charge density arrays have different sizes");
-    }
-
-    auto rhs = rho; // Set right-hand-side to the charge-density
+    arma::vec b = arma::zeros(n);
 
     // We want to fix the potential just BEFORE the structure to 0
     //   i.e., phi[-1] = 0
@@ -218,7 +215,32 @@ arma::vec PoissonSolver::solve(const arma::vec &rho,
     const auto V_next = V_drop * n / (n+1);
 
     // The boundary condition is then set according to QWWAD4, 3.110.
-    rhs(n-1) += _diag(n-1) * V_next;
+    b(n-1) = _diag(n-1) * V_next;
+
+    return b;
+}
+
+/**
+ * \brief Solves the Poisson equation for a given charge-density and potential drop
+ *
+ * \param[in] rho    The charge density profile [C m^{-3}]
+ * \param[in] V_drop The total potential drop across the structure [J]
+ *
+ * \return The potential profile [J]
+ */
+arma::vec PoissonSolver::solve(const arma::vec &rho,
+                               const double     V_drop) const
+{
+    const auto n = _eps.size();
+
+    if (rho.size() != n)
+    {
+        throw std::runtime_error("Permittivity and charge density arrays have different sizes");
+    }
+
+    // Set right-hand-side to the charge-density, plus the contribution from
+    // the fixed potential beyond the end of the structure
+    const arma::vec rhs = rho + get_bias_rhs(V_drop);
 
     if(_boundary_type == MIXED)
     {
@@ -254,5 +276,110 @@ arma::vec PoissonSolver::solve_laplace(const double V_drop) const
 
     return phi; 
 }
+
+/**
+ * \brief Solve the Poisson equation for a charge density that depends on the potential
+ *
+ * \param[in] model     Model for the charge density
+ * \param[in] phi_guess Initial guess at the potential [V]
+ * \param[in] V_drop    Potential drop across the structure [V].  Only used
+ *                      with Dirichlet boundary conditions.
+ *
+ * \details Uses Newton iteration.  The Jacobian is the Poisson matrix, less
+ *          the derivative of the charge density on the diagonal.  The charge
+ *          density falls as the potential rises, so the Jacobian remains
+ *          positive definite and tridiagonal, and each step uses the same
+ *          LDLᵀ factorisation as the linear problem.
+ *
+ *          Each step is damped logarithmically where it is large compared
+ *          with the potential scale of the charge model (typically kT/e).
+ *          This keeps the exponential carrier densities from overshooting
+ *          in heavily doped regions.
+ *
+ *          With Dirichlet boundary conditions, the bias is applied and the
+ *          potential is referenced to the first point in the same way as
+ *          solve(rho, V_drop).  The result is therefore a fixed point of that
+ *          linear solution, φ = solve(ρ(φ), V_drop), and matches it exactly
+ *          when there is no charge.  The reference point makes the Jacobian
+ *          a rank-one update of a tridiagonal matrix, which is handled using
+ *          the Sherman-Morrison formula.
+ *
+ * \return The potential profile [V]
+ */
+arma::vec PoissonSolver::solve_nonlinear(const ChargeModel &model,
+                                         const arma::vec   &phi_guess,
+                                         const double       V_drop) const
+{
+    const auto n = _eps.size();
+
+    if(phi_guess.size() != n)
+        throw std::runtime_error("Permittivity and potential arrays have different sizes");
+
+    if(_boundary_type == MIXED)
+        throw std::runtime_error("Nonlinear Poisson solutions are not available with mixed boundaries.");
+
+    // Contribution of fixed potential beyond the end of the structure, as in
+    // the linear solver
+    const bool dirichlet = (_boundary_type == DIRICHLET);
+    const arma::vec b = dirichlet ? get_bias_rhs(V_drop) : arma::vec(arma::zeros(n));
+
+    const double scale = model.get_potential_scale();
+
+    if(scale <= 0)
+        throw std::domain_error("Potential scale of charge model must be positive");
+
+    // Solution of the Poisson equation before it is referenced to the first
+    // point.  This is only different from the returned potential with
+    // Dirichlet boundary conditions.
+    arma::vec psi = phi_guess;
+    arma::vec phi;
+    arma::vec rho;
+    arma::vec drho_dphi;
+    arma::vec D;
+    arma::vec L;
+
+    for(unsigned int iter = 0; iter < _nl_max_iter; ++iter)
+    {
+        phi = dirichlet ? arma::vec(psi - psi(0)) : psi;
+        model.get_charge_density(phi, rho, drho_dphi);
+
+        // Residual of Poisson equation, A ψ - ρ(φ) - b
+        arma::vec F = _diag % psi - rho - b;
+        F.head(n-1) += _sub_diag % psi.tail(n-1);
+        F.tail(n-1) += _sub_diag % psi.head(n-1);
+
+        factorise_tridiag_LDL_T(arma::vec(_diag - drho_dphi), _sub_diag, D, L);
+        arma::vec delta = solve_tridiag_LDL_T(D, L, arma::vec(-F));
+
+        // The charge depends on ψ(0) through the reference point, which adds
+        // the column dρ/dφ to the first column of the Jacobian
+        if(dirichlet)
+        {
+            const arma::vec w = solve_tridiag_LDL_T(D, L, drho_dphi);
+            delta -= w * (delta(0) / (1.0 + w(0)));
+        }
+
+        const double delta_max = arma::max(arma::abs(delta));
+
+        // Damp large steps
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            if(fabs(delta(i)) > scale)
+            {
+                const double sign = (delta(i) < 0) ? -1.0 : 1.0;
+                delta(i) = sign * scale * (1.0 + log(fabs(delta(i))/scale));
+            }
+        }
+
+        psi += delta;
+
+        if(delta_max <= _nl_tol)
+            return dirichlet ? arma::vec(psi - psi(0)) : psi;
+    }
+
+    std::ostringstream oss;
+    oss << "Nonlinear Poisson equation did not converge within " << _nl_max_iter << " iterations.";
+    throw std::runtime_error(oss.str());
+}
 } // namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -33,6 +33,36 @@ enum PoissonBoundaryType
     ZERO_FIELD
 };
 
+/**
+ * \brief A charge density that depends on the electrostatic potential
+ *
+ * \details Used by PoissonSolver::solve_nonlinear().  The charge density and
+ *          its derivative are needed at every point to form the Newton step.
+ */
+class ChargeModel
+{
+public:
+    virtual ~ChargeModel() {}
+
+    /**
+     * \brief Find the charge density for a given potential
+     *
+     * \param[in]  phi       Electrostatic potential at each point [V]
+     * \param[out] rho       Charge density at each point [C m^{-3}]
+     * \param[out] drho_dphi Derivative of charge density with respect to potential [C V^{-1} m^{-3}]
+     */
+    virtual void get_charge_density(const arma::vec &phi,
+                                    arma::vec       &rho,
+                                    arma::vec       &drho_dphi) const = 0;
+
+    /**
+     * \brief Potential over which the charge density changes significantly [V]
+     *
+     * \details For thermal carrier distributions, this is kT/e
+     */
+    virtual double get_potential_scale() const = 0;
+};
+
 class PoissonSolver
 {
 private:
@@ -48,11 +78,22 @@ public:
                     const double     V_drop) const;
     arma::vec solve_laplace(const double V_drop) const;
 
+    arma::vec solve_nonlinear(const ChargeModel &model,
+                              const arma::vec   &phi_guess,
+                              const double       V_drop = 0.0) const;
+
+    /// Set the convergence tolerance for nonlinear solutions [V]
+    inline void set_nonlinear_tolerance(const double tol) {_nl_tol = tol;}
+
+    /// Set the maximum number of Newton iterations for nonlinear solutions
+    inline void set_max_iterations(const size_t max_iter) {_nl_max_iter = max_iter;}
+
 private:
     void factorise_dirichlet();
     void factorise_mixed();
     void factorise_zerofield();
     void compute_half_index_permittivity();
+    arma::vec get_bias_rhs(const double V_drop) const;
 
     arma::vec _eps_minus; ///< Permittivity half a point to left [F/m]
     arma::vec _eps_plus;  ///< Permittivity half a point to right [F/m]
@@ -69,6 +110,9 @@ private:
     arma::vec _L_sub;  ///< Subdiagonal of factorisation matrix, L
 
     PoissonBoundaryType _boundary_type; ///< Boundary condition type for Poisson solver
+
+    double _nl_tol;      ///< Convergence tolerance for nonlinear solutions [V]
+    size_t _nl_max_iter; ///< Maximum number of Newton iterations
 };
 } // namespace
 #endif //QWWAD_POISSON_SOLVER_H
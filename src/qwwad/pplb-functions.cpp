@@ -1,5 +1,15 @@
 #include "pplb-functions.h"
 
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "constants.h"
+
+using namespace QWWAD::constants;
+
 /** Writes the eigenvectors (a_nk(G)) to the files ank.r
  * \param[in] ank    Eigenvector coefficients
  * \param[in] ik     k point identifier
@@ -16,10 +26,10 @@ write_ank(arma::cx_mat &ank,
 {
     int	iG;		/* index over G vectors				*/
     int	in;		/* index over bands				*/
-    char	filename[9];	/* eigenfunction output filename		*/
+    char	filename[32];	/* eigenfunction output filename		*/
     FILE 	*Fank;		/* file pointer to eigenvectors file		*/
 
-    sprintf(filename,"ank%i.r",ik);
+    snprintf(filename,sizeof(filename),"ank%i.r",ik);
     Fank=fopen(filename,"w");
 
     for(iG=0;iG<N;iG++)
@@ -32,6 +42,67 @@ write_ank(arma::cx_mat &ank,
     fclose(Fank);
 }
 
+/**
+ * \brief Writes the results along an adaptively refined k path
+ *
+ * \param[in] path Refined path
+ * \param[in] A0   Lattice constant [m]
+ * \param[in] N    Number of rows to write for each eigenvector
+ * \param[in] ev   Write eigenvectors to file
+ *
+ * \details The files Ek?.r, and ank?.r if requested, are written for each
+ *          point in order along the path, in the same format as for a
+ *          uniform path.  The wave vectors are written to k-adaptive.r in
+ *          units of 2pi/A0, so that the file can be used as k.r by other
+ *          programs.  Ek-tracked.r contains the distance along the path
+ *          [2pi/A0] and the energy of each band [eV], where each column
+ *          follows a single band through any crossings.
+ */
+void write_adaptive_path(const QWWAD::AdaptiveKPath &path,
+                         const double                A0,
+                         const int                   N,
+                         const bool                  ev)
+{
+    const size_t n_points = path.get_n_points();
+    const double k_unit   = 2.0*pi/A0;
+
+    FILE *FEtracked = fopen("Ek-tracked.r","w");
+    FILE *Fk        = fopen("k-adaptive.r","w");
+
+    for(unsigned int ip = 0; ip < n_points; ++ip)
+    {
+        const arma::vec &k = path.get_k(ip);
+        fprintf(Fk,"%.10f %.10f %.10f\n",k(0)/k_unit,k(1)/k_unit,k(2)/k_unit);
+
+        char filename[32];
+        snprintf(filename,sizeof(filename),"Ek%u.r",ip);
+        FILE *FEk = fopen(filename,"w");
+        const arma::vec &E = path.get_E(ip);
+
+        for(unsigned int ib = 0; ib < E.size(); ++ib)
+            fprintf(FEk,"%10.6f\n",E(ib)/e);
+
+        fclose(FEk);
+
+        const arma::vec E_tracked = path.get_E_tracked(ip);
+        fprintf(FEtracked,"%.10f",path.get_s(ip)/k_unit);
+
+        for(unsigned int ib = 0; ib < E_tracked.size(); ++ib)
+            fprintf(FEtracked," %10.6f",E_tracked(ib)/e);
+
+        fprintf(FEtracked,"\n");
+
+        if(ev)
+        {
+            arma::cx_mat ank = path.get_eigenvectors(ip);
+            write_ank(ank, ip, N, 0, ank.n_cols-1);
+        }
+    }
+
+    fclose(Fk);
+    fclose(FEtracked);
+}
+
 /**
  * \brief Get potential component of H_GG
  *
@@ -60,3 +131,417 @@ std::complex<double> V(double                   A0,
 
     return v;
 }
+
+/**
+ * \brief Find the position of each reciprocal lattice vector on a rectangular lattice
+ *
+ * \param[in]  G  Reciprocal lattice vectors [1/m]
+ * \param[in]  A0 Lattice constant [m]
+ * \param[out] b  Lattice spacing in each direction [1/m]
+ *
+ * \returns The lattice index of each vector in each direction
+ *
+ * \details The spacing in each direction is the largest value, 2 pi/(n A0),
+ *          for which every vector lies on the lattice.
+ */
+arma::imat find_lattice_indices(const std::vector<arma::vec> &G,
+                                const double                  A0,
+                                arma::vec                    &b)
+{
+    if(G.empty())
+        throw std::invalid_argument("List of reciprocal lattice vectors is empty");
+
+    const unsigned int n_max = 1024; // Largest supercell, in units of A0
+    const double       tol   = 1e-6; // Tolerance on lattice index
+    arma::imat m(3, G.size());
+    b.set_size(3);
+
+    for(unsigned int dim = 0; dim < 3; ++dim)
+    {
+        unsigned int n_cell = 1;
+        bool found = false;
+
+        while(!found && n_cell <= n_max)
+        {
+            found = true;
+
+            for(unsigned int iG = 0; iG < G.size() && found; ++iG)
+            {
+                const double x = G[iG](dim)*A0/(2.0*pi)*n_cell;
+
+                if(std::abs(x - std::round(x)) > tol)
+                    found = false;
+            }
+
+            if(!found)
+                ++n_cell;
+        }
+
+        if(!found)
+        {
+            std::ostringstream oss;
+            oss << "Reciprocal lattice vectors do not lie on a rectangular reciprocal lattice in direction " << dim;
+            throw std::domain_error(oss.str());
+        }
+
+        b(dim) = 2.0*pi/(n_cell*A0);
+
+        for(unsigned int iG = 0; iG < G.size(); ++iG)
+            m(dim,iG) = std::llround(G[iG](dim)/b(dim));
+    }
+
+    return m;
+}
+
+/**
+ * \brief Group a set of atoms by species
+ *
+ * \param[in] A0       Lattice constant [m]
+ * \param[in] m_per_au Number of metres per a.u. of length
+ * \param[in] atoms    Atomic definitions
+ */
+CrystalPotential::CrystalPotential(const double             A0,
+                                   const double             m_per_au,
+                                   const std::vector<atom> &atoms) :
+    _A0(A0),
+    _m_per_au(m_per_au),
+    _n_atoms(atoms.size())
+{
+    if(atoms.empty())
+        throw std::invalid_argument("Cannot find crystal potential without any atoms");
+
+    std::vector<std::vector<arma::vec>> positions;
+
+    for(auto const &atom : atoms)
+    {
+        const std::string name(atom.type);
+        unsigned int is = 0;
+
+        while(is < _species.size() && _species[is] != name)
+            ++is;
+
+        if(is == _species.size())
+        {
+            _species.push_back(name);
+            positions.push_back(std::vector<arma::vec>());
+        }
+
+        positions[is].push_back(atom.r);
+    }
+
+    for(auto const &species_positions : positions)
+    {
+        arma::mat r(3, species_positions.size());
+
+        for(unsigned int ia = 0; ia < species_positions.size(); ++ia)
+            r.col(ia) = species_positions[ia];
+
+        _r.push_back(r);
+    }
+}
+
+/**
+ * \brief Group a set of wave vectors into shells of equal magnitude
+ *
+ * \param[in]  q_sqr       Squared magnitude of each wave vector [1/m^2]
+ * \param[in]  A0          Lattice constant [m]
+ * \param[out] shell_q_sqr Squared magnitude of each distinct shell [1/m^2]
+ *
+ * \returns The index of the shell that contains each vector
+ *
+ * \details Values are matched after rounding, in units of (2 pi/A0)^2, so
+ *          that rounding errors in the vectors do not split a shell.
+ */
+arma::umat find_q_sqr_shells(const arma::mat &q_sqr,
+                             const double     A0,
+                             arma::vec       &shell_q_sqr)
+{
+    const double q_unit_sqr = (2.0*pi/A0)*(2.0*pi/A0);
+    std::unordered_map<long long, unsigned int> shell_index;
+    std::vector<double> shell_list;
+    arma::umat shell(q_sqr.n_rows, q_sqr.n_cols);
+
+    for(unsigned int i = 0; i < q_sqr.n_elem; ++i)
+    {
+        const long long key = llround(q_sqr(i)/q_unit_sqr*1e8);
+        const auto it = shell_index.find(key);
+
+        if(it == shell_index.end())
+        {
+            shell(i) = shell_list.size();
+            shell_index[key] = shell_list.size();
+            shell_list.push_back(q_sqr(i));
+        }
+        else
+            shell(i) = it->second;
+    }
+
+    shell_q_sqr = arma::vec(shell_list);
+
+    return shell;
+}
+
+/**
+ * \brief Find the form factor of a species in each shell of wave vectors
+ *
+ * \param[in] A0          Lattice constant [m]
+ * \param[in] m_per_au    Number of metres per a.u. of length
+ * \param[in] shell_q_sqr Squared magnitude of each shell [1/m^2]
+ * \param[in] species     Name of atomic species
+ *
+ * \returns The form factor in each shell [J]
+ */
+arma::vec find_Vf_shells(const double       A0,
+                         const double       m_per_au,
+                         const arma::vec   &shell_q_sqr,
+                         const std::string &species)
+{
+    arma::vec Vf_shell(shell_q_sqr.size());
+
+    for(unsigned int ishell = 0; ishell < shell_q_sqr.size(); ++ishell)
+        Vf_shell(ishell) = Vf(A0, m_per_au, shell_q_sqr(ishell), species.c_str());
+
+    return Vf_shell;
+}
+
+/**
+ * \brief Find the matrix of crystal potential elements
+ *
+ * \param[in] G Reciprocal lattice vectors [1/m]
+ *
+ * \returns Matrix with element (i,j) equal to V(G_i - G_j) [J]
+ *
+ * \details For each species, the structure factor is
+ *          \f[
+ *            S(G_i - G_j) = \sum_a \mbox{e}^{-iG_i\cdot\tau_a}
+ *                                  \mbox{e}^{iG_j\cdot\tau_a},
+ *          \f]
+ *          which is the product of a matrix of phase factors with its own
+ *          Hermitian conjugate.  The form factor depends only on
+ *          |G_i - G_j|, so it is found once for each distinct magnitude.
+ *          The result is identical to V() for every pair of vectors.
+ */
+arma::cx_mat CrystalPotential::get_V_GG(const std::vector<arma::vec> &G) const
+{
+    const unsigned int N = G.size();
+
+    arma::mat G_mat(3, N);
+
+    for(unsigned int iG = 0; iG < N; ++iG)
+        G_mat.col(iG) = G[iG];
+
+    // Find the distinct shells of |G_i - G_j|^2
+    arma::mat q_sqr(N,N);
+
+    for(unsigned int j = 0; j < N; ++j)
+    {
+        for(unsigned int i = 0; i < N; ++i)
+        {
+            const arma::vec q = G_mat.col(i) - G_mat.col(j);
+            q_sqr(i,j) = dot(q,q);
+        }
+    }
+
+    arma::vec        shell_q_sqr;
+    const arma::umat shell = find_q_sqr_shells(q_sqr, _A0, shell_q_sqr);
+
+    arma::cx_mat V_GG = arma::zeros<arma::cx_mat>(N,N);
+
+    for(unsigned int is = 0; is < _species.size(); ++is)
+    {
+        // Form factor for this species in each shell
+        const arma::vec Vf_shell = find_Vf_shells(_A0, _m_per_au, shell_q_sqr, _species[is]);
+
+        // Phase factors, exp(-i G.tau), for each vector and atom
+        const arma::mat phase = G_mat.t() * _r[is];
+        arma::cx_mat E_phase(phase.n_rows, phase.n_cols);
+
+        for(unsigned int ia = 0; ia < phase.n_cols; ++ia)
+            for(unsigned int iG = 0; iG < N; ++iG)
+                E_phase(iG,ia) = exp(std::complex<double>(0.0, -phase(iG,ia)));
+
+        // Structure factor for each pair of vectors
+        const arma::cx_mat S = E_phase * E_phase.t();
+
+#pragma omp parallel for
+        for(unsigned int j = 0; j < N; ++j)
+        {
+            for(unsigned int i = 0; i < N; ++i)
+                V_GG(i,j) += Vf_shell(shell(i,j)) * S(i,j);
+        }
+    }
+
+    V_GG *= 2.0/_n_atoms;
+
+    return V_GG;
+}
+
+/**
+ * \brief Find the crystal potential for a list of wave vectors
+ *
+ * \param[in] q Wave vectors [1/m]
+ *
+ * \returns The Fourier component of the potential, V(q), for each vector [J]
+ *
+ * \details This gives the same values as V(), but the form factor of each
+ *          species is found only once for each distinct |q|.  The structure
+ *          factor for each vector is summed directly over the atoms.
+ */
+arma::cx_vec CrystalPotential::get_V_q(const std::vector<arma::vec> &q) const
+{
+    const unsigned int nq = q.size();
+
+    // Find the distinct shells of |q|^2
+    arma::vec q_sqr(nq);
+
+    for(unsigned int iq = 0; iq < nq; ++iq)
+        q_sqr(iq) = dot(q[iq], q[iq]);
+
+    arma::vec        shell_q_sqr;
+    const arma::uvec shell = find_q_sqr_shells(q_sqr, _A0, shell_q_sqr);
+
+    arma::cx_vec V_q = arma::zeros<arma::cx_vec>(nq);
+
+    for(unsigned int is = 0; is < _species.size(); ++is)
+    {
+        const arma::vec Vf_shell = find_Vf_shells(_A0, _m_per_au, shell_q_sqr, _species[is]);
+
+        const arma::mat &r = _r[is];
+
+#pragma omp parallel for schedule(static)
+        for(unsigned int iq = 0; iq < nq; ++iq)
+        {
+            const double vf = Vf_shell(shell(iq));
+
+            if(vf == 0.0)
+                continue;
+
+            std::complex<double> S = 0.0; // Structure factor
+
+            for(unsigned int ia = 0; ia < r.n_cols; ++ia)
+            {
+                const double q_dot_t = q[iq](0)*r(0,ia) + q[iq](1)*r(1,ia) + q[iq](2)*r(2,ia);
+                S += std::polar(1.0, -q_dot_t);
+            }
+
+            V_q(iq) += vf * S;
+        }
+    }
+
+    V_q *= 2.0/_n_atoms;
+
+    return V_q;
+}
+
+/**
+ * \brief Find the k-independent parts of the spin-orbit coupling
+ *
+ * \param[in] G     Reciprocal lattice vectors [1/m]
+ * \param[in] atoms Atomic definitions
+ *
+ * \details The structure factor for each pair of vectors is
+ *          \f[
+ *            \Lambda(G_i-G_j) = \frac{1}{n}\sum_a \lambda_a
+ *                     \mbox{e}^{-iG_i\cdot\tau_a}\mbox{e}^{iG_j\cdot\tau_a},
+ *          \f]
+ *          which is found as a product of a matrix of weighted phase
+ *          factors with the Hermitian conjugate of the unweighted one
+ *          [QWWAD3, 15.81].
+ */
+SpinOrbitPotential::SpinOrbitPotential(const std::vector<arma::vec> &G,
+                                       const std::vector<atom>      &atoms) :
+    _G(3, G.size())
+{
+    if(atoms.empty())
+        throw std::invalid_argument("Cannot find spin-orbit potential without any atoms");
+
+    const unsigned int N = G.size();
+
+    for(unsigned int iG = 0; iG < N; ++iG)
+        _G.col(iG) = G[iG];
+
+    arma::cx_mat E_phase(N, atoms.size());
+    arma::cx_mat E_weighted(N, atoms.size());
+
+    for(unsigned int ia = 0; ia < atoms.size(); ++ia)
+    {
+        const double lambda_a = lambda(atoms[ia].type);
+
+        for(unsigned int iG = 0; iG < N; ++iG)
+        {
+            E_phase(iG,ia)    = exp(std::complex<double>(0.0, -dot(G[iG], atoms[ia].r)));
+            E_weighted(iG,ia) = lambda_a * E_phase(iG,ia);
+        }
+    }
+
+    _L = E_weighted * E_phase.t();
+    _L *= std::complex<double>(0.0, -1.0/atoms.size());
+
+    for(unsigned int c = 0; c < 3; ++c)
+        _LC[c].set_size(N,N);
+
+    for(unsigned int j = 0; j < N; ++j)
+    {
+        for(unsigned int i = 0; i < N; ++i)
+        {
+            // G_i x G_j
+            const double C_x = _G(1,i)*_G(2,j) - _G(2,i)*_G(1,j);
+            const double C_y = _G(2,i)*_G(0,j) - _G(0,i)*_G(2,j);
+            const double C_z = _G(0,i)*_G(1,j) - _G(1,i)*_G(0,j);
+
+            _LC[0](i,j) = _L(i,j) * C_x;
+            _LC[1](i,j) = _L(i,j) * C_y;
+            _LC[2](i,j) = _L(i,j) * C_z;
+        }
+    }
+}
+
+/**
+ * \brief Add the spin-orbit coupling to a Hamiltonian matrix
+ *
+ * \param[in]     k Wave vector [1/m]
+ * \param[in,out] H Hamiltonian, of order 2N, with spin-up states first.
+ *                  Only the lower triangle is updated.
+ *
+ * \details The spin-up/spin-up block gets the z component of the coupling,
+ *          the spin-down/spin-down block gets the opposite, and the
+ *          spin-down/spin-up block gets the x + iy component.
+ */
+void SpinOrbitPotential::add_to_lower_triangle(const arma::vec &k,
+                                               arma::cx_mat    &H) const
+{
+    const unsigned int N = _G.n_cols;
+
+    if(H.n_rows != 2*N || H.n_cols != 2*N)
+        throw std::length_error("Hamiltonian has the wrong size for spin-orbit coupling");
+
+    // G_i x k for each vector
+    arma::mat u(3, N);
+
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        u(0,i) = _G(1,i)*k(2) - _G(2,i)*k(1);
+        u(1,i) = _G(2,i)*k(0) - _G(0,i)*k(2);
+        u(2,i) = _G(0,i)*k(1) - _G(1,i)*k(0);
+    }
+
+    for(unsigned int j = 0; j < N; ++j)
+    {
+        // Spin-up and spin-down diagonal blocks
+        for(unsigned int i = j; i < N; ++i)
+        {
+            const std::complex<double> v_z = _LC[2](i,j) + _L(i,j)*(u(2,i) - u(2,j));
+            H(i,j)     += v_z;
+            H(i+N,j+N) -= v_z;
+        }
+
+        // Spin-down/spin-up block lies entirely within the lower triangle
+        for(unsigned int i = 0; i < N; ++i)
+        {
+            const std::complex<double> v_x = _LC[0](i,j) + _L(i,j)*(u(0,i) - u(0,j));
+            const std::complex<double> v_y = _LC[1](i,j) + _L(i,j)*(u(1,i) - u(1,j));
+            H(i+N,j) += v_x + std::complex<double>(0.0, 1.0)*v_y;
+        }
+    }
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
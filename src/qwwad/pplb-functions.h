@@ -6,11 +6,14 @@
 #define QWWAD_PPLB_FUNCTIONS_H
 
 #include <complex>
+#include <string>
 #include <vector>
 
 #include <armadillo>
 
+#include "adaptive-k-path.h"
 #include "ppff.h"
+#include "ppsop.h"
 
 void
 write_ank(arma::cx_mat &ank,
@@ -19,9 +22,87 @@ write_ank(arma::cx_mat &ank,
           int           n_min,
           int           n_max);
 
+void write_adaptive_path(const QWWAD::AdaptiveKPath &path,
+                         const double                A0,
+                         const int                   N,
+                         const bool                  ev);
+
 std::complex<double> V(double                   A0,
                        double                   m_per_au,
                        std::vector<atom> const &atoms,
                        arma::vec const         &q);
+
+arma::imat find_lattice_indices(const std::vector<arma::vec> &G,
+                                const double                  A0,
+                                arma::vec                    &b);
+
+arma::umat find_q_sqr_shells(const arma::mat &q_sqr,
+                             const double     A0,
+                             arma::vec       &shell_q_sqr);
+
+arma::vec find_Vf_shells(const double       A0,
+                         const double       m_per_au,
+                         const arma::vec   &shell_q_sqr,
+                         const std::string &species);
+
+/**
+ * \brief Crystal potential for a set of atoms, with atoms grouped by species
+ *
+ * \details Each species is identified once, by its index in the list of
+ *          species.  The matrix of potential elements is then found by
+ *          evaluating each form factor only once for each distinct
+ *          |G-G'|, and by finding the structure factor of each species
+ *          as a matrix product.
+ */
+class CrystalPotential
+{
+private:
+    double _A0;       ///< Lattice constant [m]
+    double _m_per_au; ///< Number of metres per a.u. of length
+    size_t _n_atoms;  ///< Total number of atoms
+
+    std::vector<std::string> _species; ///< Name of each species
+    std::vector<arma::mat>   _r;       ///< Position of each atom of each species, one per column [m]
+
+public:
+    CrystalPotential(const double             A0,
+                     const double             m_per_au,
+                     const std::vector<atom> &atoms);
+
+    arma::cx_mat get_V_GG(const std::vector<arma::vec> &G) const;
+
+    arma::cx_vec get_V_q(const std::vector<arma::vec> &q) const;
+
+    /// Get the number of distinct atomic species
+    size_t get_n_species() const {return _species.size();}
+};
+
+/**
+ * \brief Spin-orbit coupling between plane waves with both spins
+ *
+ * \details The coupling between (G_i+k) and (G_j+k) is proportional to
+ *          \f[
+ *            \Lambda(G_i-G_j)(G_i+k)\times(G_j+k)\cdot\sigma,
+ *          \f]
+ *          where the cross product splits into a k-independent part,
+ *          G_i x G_j, and a part that is linear in k, (G_i x k) - (G_j x k).
+ *          The structure factor, Lambda, and the k-independent parts are
+ *          found once, so that only the terms in k are recalculated at each
+ *          wave vector.
+ */
+class SpinOrbitPotential
+{
+private:
+    arma::mat    _G;     ///< Reciprocal lattice vectors, one per column [1/m]
+    arma::cx_mat _L;     ///< -i Lambda(G_i-G_j) for each pair of vectors
+    arma::cx_mat _LC[3]; ///< -i Lambda(G_i-G_j) times each component of G_i x G_j
+
+public:
+    SpinOrbitPotential(const std::vector<arma::vec> &G,
+                       const std::vector<atom>      &atoms);
+
+    void add_to_lower_triangle(const arma::vec &k,
+                               arma::cx_mat    &H) const;
+};
 #endif
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,214 @@
+/**
+ * \file   rate-equation-solver.cpp
+ * \brief  Steady-state solver for subband population rate equations
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "rate-equation-solver.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace QWWAD
+{
+/**
+ * \brief Create a rate-equation solver
+ *
+ * \param[in] W Matrix of one-body scattering rates [1/s].  Element (i,f)
+ *              gives the rate of scattering from subband i to subband f.
+ */
+RateEquationSolver::RateEquationSolver(const arma::mat &W) :
+    _W(W),
+    _tol(1e-10),
+    _max_iter(100)
+{
+    if(_W.n_rows != _W.n_cols)
+        throw std::invalid_argument("Rate matrix must be square");
+
+    if(_W.n_rows == 0)
+        throw std::invalid_argument("Rate matrix is empty");
+}
+
+/**
+ * \brief Add a two-body (carrier-carrier) scattering process ij→fg
+ *
+ * \param[in] i Initial subband of first carrier (indexed from zero)
+ * \param[in] j Initial subband of second carrier
+ * \param[in] f Final subband of first carrier
+ * \param[in] g Final subband of second carrier
+ * \param[in] w Rate coefficient [m^2/s].  The rate of the process per
+ *              unit area is w n_i n_j.
+ */
+void RateEquationSolver::add_two_body_rate(const unsigned int i,
+                                           const unsigned int j,
+                                           const unsigned int f,
+                                           const unsigned int g,
+                                           const double       w)
+{
+    const auto nst = _W.n_rows;
+
+    if(i >= nst || j >= nst || f >= nst || g >= nst)
+    {
+        std::ostringstream oss;
+        oss << "Two-body process " << i+1 << j+1 << "→" << f+1 << g+1
+            << " refers to a subband outside the rate matrix (" << nst << " subbands).";
+        throw std::domain_error(oss.str());
+    }
+
+    _two_body.push_back({i, j, f, g, w});
+}
+
+/**
+ * \brief Find the rate of change of population in each subband [m^{-2}s^{-1}]
+ *
+ * \param[in] n Population of each subband [m^{-2}]
+ */
+arma::vec RateEquationSolver::get_dn_dt(const arma::vec &n) const
+{
+    // One-body terms: gain from all other subbands, less loss to all others
+    arma::vec dn_dt = _W.t()*n - n % arma::sum(_W, 1);
+
+    for(const auto &p : _two_body)
+    {
+        const double R = p.w * n[p.i] * n[p.j];
+        dn_dt[p.i] -= R;
+        dn_dt[p.j] -= R;
+        dn_dt[p.f] += R;
+        dn_dt[p.g] += R;
+    }
+
+    return dn_dt;
+}
+
+/**
+ * \brief Find the Jacobian matrix of the rate equations [1/s]
+ *
+ * \param[in] n Population of each subband [m^{-2}]
+ *
+ * \returns Matrix with element (k,l) = ∂(dn_k/dt)/∂n_l
+ */
+arma::mat RateEquationSolver::get_jacobian(const arma::vec &n) const
+{
+    arma::mat J = _W.t();
+    J.diag() -= arma::sum(_W, 1);
+
+    for(const auto &p : _two_body)
+    {
+        const double dR_dni = p.w * n[p.j];
+        const double dR_dnj = p.w * n[p.i];
+
+        for(const auto k : {p.i, p.j})
+        {
+            J(k, p.i) -= dR_dni;
+            J(k, p.j) -= dR_dnj;
+        }
+
+        for(const auto k : {p.f, p.g})
+        {
+            J(k, p.i) += dR_dni;
+            J(k, p.j) += dR_dnj;
+        }
+    }
+
+    return J;
+}
+
+/**
+ * \brief Solve the one-body rate equations for a given total population
+ *
+ * \param[in] N Total population [m^{-2}]
+ */
+arma::vec RateEquationSolver::solve_linear(const double N) const
+{
+    const auto nst = _W.n_rows;
+
+    // Replace the last equation with the population constraint
+    arma::mat A = get_jacobian(arma::zeros(nst));
+    A.row(nst-1).ones();
+
+    arma::vec b = arma::zeros(nst);
+    b[nst-1] = N;
+
+    arma::vec n;
+
+    if(!arma::solve(n, A, b))
+        throw std::runtime_error("Rate equations are singular. Check that all subbands are coupled by scattering.");
+
+    return n;
+}
+
+/**
+ * \brief Find the steady-state population of each subband [m^{-2}]
+ *
+ * \param[in] N Total population [m^{-2}]
+ *
+ * \details The solution of the one-body equations is used as the initial
+ *          guess for the Newton iteration.
+ */
+arma::vec RateEquationSolver::solve(const double N) const
+{
+    return solve(N, solve_linear(N));
+}
+
+/**
+ * \brief Find the steady-state population of each subband [m^{-2}]
+ *
+ * \param[in] N       Total population [m^{-2}]
+ * \param[in] n_guess Initial guess at populations [m^{-2}].  This is only
+ *                    used if two-body processes are present.
+ */
+arma::vec RateEquationSolver::solve(const double     N,
+                                    const arma::vec &n_guess) const
+{
+    const auto nst = _W.n_rows;
+
+    if(n_guess.size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Initial guess has " << n_guess.size() << " populations, but there are "
+            << nst << " subbands.";
+        throw std::length_error(oss.str());
+    }
+
+    if(_two_body.empty())
+        return solve_linear(N);
+
+    arma::vec n = n_guess;
+
+    for(unsigned int iter = 0; iter < _max_iter; ++iter)
+    {
+        // Residual and Jacobian, with the last equation replaced by the
+        // population constraint
+        arma::vec F = get_dn_dt(n);
+        F[nst-1] = arma::accu(n) - N;
+
+        arma::mat J = get_jacobian(n);
+        J.row(nst-1).ones();
+
+        arma::vec delta;
+
+        if(!arma::solve(delta, J, -F))
+            throw std::runtime_error("Jacobian of rate equations is singular.");
+
+        // Damp the step so that populations stay positive
+        double lambda = 1.0;
+
+        while(arma::any(n + lambda*delta < 0) && lambda > 1e-3)
+            lambda /= 2;
+
+        n += lambda*delta;
+        n.elem(arma::find(n < 0)).zeros();
+
+        // Only accept a full Newton step as converged, since a heavily
+        // damped step may be small even far from the solution
+        if(arma::max(arma::abs(delta)) <= _tol*fabs(N))
+            return n;
+    }
+
+    std::ostringstream oss;
+    oss << "Rate equations did not converge within " << _max_iter << " iterations.";
+    throw std::runtime_error(oss.str());
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,76 @@
+/**
+ * \file   rate-equation-solver.h
+ * \brief  Steady-state solver for subband population rate equations
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_RATE_EQUATION_SOLVER_H
+#define QWWAD_RATE_EQUATION_SOLVER_H
+
+#include <vector>
+#include <armadillo>
+
+namespace QWWAD
+{
+/**
+ * \brief Solver for the steady-state populations of a set of subbands
+ *
+ * \details The rate of change of population in subband f is
+ *
+ *           dn_f/dt = Σ_i n_i W_if - n_f Σ_i W_fi
+ *                   + Σ_{ij→fg} w n_i n_j - ...
+ *
+ *          where W_if is a one-body scattering rate [1/s] and w is a
+ *          two-body rate coefficient [m^2/s] for carrier-carrier
+ *          scattering.  The one-body terms give a linear system, which
+ *          is solved directly.  If any two-body terms are present, the
+ *          solution is refined by Newton iteration.  In each case, one
+ *          of the equations is replaced by the constraint that the total
+ *          population is fixed.
+ */
+class RateEquationSolver
+{
+private:
+    /// A two-body scattering process ij→fg
+    struct TwoBodyProcess {
+        unsigned int i; ///< Initial subband of first carrier
+        unsigned int j; ///< Initial subband of second carrier
+        unsigned int f; ///< Final subband of first carrier
+        unsigned int g; ///< Final subband of second carrier
+        double       w; ///< Rate coefficient [m^2/s]
+    };
+
+    arma::mat                   _W;         ///< One-body rates W(i,f) [1/s]
+    std::vector<TwoBodyProcess> _two_body;  ///< Two-body processes
+    double                      _tol;       ///< Relative tolerance for Newton iteration
+    unsigned int                _max_iter;  ///< Maximum number of Newton iterations
+
+    arma::vec solve_linear(const double N) const;
+
+public:
+    RateEquationSolver(const arma::mat &W);
+
+    void add_two_body_rate(const unsigned int i,
+                           const unsigned int j,
+                           const unsigned int f,
+                           const unsigned int g,
+                           const double       w);
+
+    arma::vec get_dn_dt(const arma::vec &n) const;
+    arma::mat get_jacobian(const arma::vec &n) const;
+
+    arma::vec solve(const double N) const;
+    arma::vec solve(const double N, const arma::vec &n_guess) const;
+
+    /// Set the relative tolerance for the Newton iteration
+    void set_tolerance(const double tol) {_tol = tol;}
+
+    /// Set the maximum number of Newton iterations
+    void set_max_iterations(const unsigned int max_iter) {_max_iter = max_iter;}
+
+    /// Get the number of subbands
+    size_t get_n_subbands() const {return _W.n_rows;}
+};
+} // namespace QWWAD
+#endif // QWWAD_RATE_EQUATION_SOLVER_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
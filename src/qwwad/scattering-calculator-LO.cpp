@@ -1,7 +1,7 @@
-#include <complex>
 #include "scattering-calculator-LO.h"
 #include "constants.h"
 #include "maths-helpers.h"
+#include "form-factor.h"
 
 namespace QWWAD {
 using namespace constants;
@@ -19,16 +19,16 @@ using namespace constants;
  * \param[in] Tl          Lattice temperature [K]
  * \param[in] is_emission True if this is an emission process
  */
-ScatteringCalculatorLO::ScatteringCalculatorLO(decltype(_subbands)    subbands,
-                                               decltype(_A0)          A0,
-                                               decltype(_Ephonon)     Ephonon,
-                                               decltype(_epss)        epss,
-                                               decltype(_epsinf)      epsinf,
-                                               decltype(_m)           m,
-                                               decltype(_Te)          Te,
-                                               decltype(_Tl)          Tl,
-                                               decltype(_is_emission) is_emission) :
-    _subbands(subbands),
+ScatteringCalculatorLO::ScatteringCalculatorLO(const std::vector<Subband> &subbands,
+                                               decltype(_A0)             A0,
+                                               decltype(_Ephonon)        Ephonon,
+                                               decltype(_epss)           epss,
+                                               decltype(_epsinf)         epsinf,
+                                               decltype(_m)              m,
+                                               decltype(_Te)             Te,
+                                               decltype(_Tl)             Tl,
+                                               decltype(_is_emission)    is_emission) :
+    ScatteringCalculator(subbands, 101),
     _A0(A0),
     _Ephonon(Ephonon),
     _epss(epss),
@@ -39,25 +39,57 @@ ScatteringCalculatorLO::ScatteringCalculatorLO(decltype(_subbands)    subbands,
     _is_emission(is_emission),
     _enable_screening(true),
     _enable_blocking(true),
-    _nki(101),
-    _omega_0(_Ephonon/hBar),
-    _N0(1.0/(exp(_Ephonon/(kB*_Tl))-1.0)),
-    _prefactor(pi*e*e*_omega_0/_epss*(_epss/_epsinf-1)*
-                (_N0 + (_is_emission?1:0))*
-                2.0 * _m/(hBar*hBar)*2/(8*pi*pi*pi))
+    _omega_0(_Ephonon/hBar)
 {
+    calculate_prefactor();
     set_phonon_samples(1001);
     calculate_screening_length();
 }
 
+/**
+ * \brief Compute the phonon occupation and the pre-factor for rates
+ */
+void ScatteringCalculatorLO::calculate_prefactor()
+{
+    _N0 = 1.0/(exp(_Ephonon/(kB*_Tl))-1.0);
+    _prefactor = pi*e*e*_omega_0/_epss*(_epss/_epsinf-1)*
+                 (_N0 + (_is_emission?1:0))*
+                 2.0 * _m/(hBar*hBar)*2/(8*pi*pi*pi);
+}
+
+/**
+ * \brief Change the carrier and lattice temperatures
+ *
+ * \param[in] Te Electron temperature [K]
+ * \param[in] Tl Lattice temperature [K]
+ *
+ * \details The carrier distribution in each subband is recalculated using
+ *          its existing quasi-Fermi energy.  The phonon occupation and
+ *          screening length are updated too.  The form-factor tables don't
+ *          depend on temperature, so they are kept.  This must not be
+ *          called while any other thread is using the calculator.
+ */
+void ScatteringCalculatorLO::set_temperatures(const double Te,
+                                              const double Tl)
+{
+    _Te = Te;
+    _Tl = Tl;
+
+    for(auto &sb : _subbands)
+        sb.set_distribution_from_Ef_Te(sb.get_Ef(), _Te);
+
+    calculate_prefactor();
+    calculate_screening_length();
+}
+
 /**
  * \brief Find the minimum initial kinetic energy that would allow scattering
  */
 double ScatteringCalculatorLO::get_Eki_min(const unsigned int i,
                                            const unsigned int f) const
 {
-    const auto isb = _subbands[i];
-    const auto fsb = _subbands[f];
+    const auto &isb = _subbands[i];
+    const auto &fsb = _subbands[f];
 
     // Subband minima
     const auto Ei = isb.get_E_min();
@@ -87,7 +119,7 @@ double ScatteringCalculatorLO::get_ki_min(const unsigned int i,
                                           const unsigned int f) const
 {
     const auto Eki_min = get_Eki_min(i,f);
-    const auto isb = _subbands[i];
+    const auto &isb = _subbands[i];
     const auto ki_min = isb.get_k_at_Ek(Eki_min);
     return ki_min;
 }
@@ -98,7 +130,7 @@ double ScatteringCalculatorLO::get_ki_min(const unsigned int i,
 double ScatteringCalculatorLO::get_ki_cutoff(const unsigned int i,
                                              const unsigned int f) const
 {
-    const auto isb = _subbands[i];
+    const auto &isb = _subbands[i];
 
     const auto Eki_min = get_Eki_min(i,f);
 
@@ -123,7 +155,8 @@ double ScatteringCalculatorLO::get_ki_cutoff(const unsigned int i,
  *          the array of samples is recalculated accordingly.
  *          The map of form-factors will also be cleared and will be
  *          automatically regenerated the next time a scattering rate
- *          is needed.
+ *          is needed.  This must not be called while any other thread
+ *          is using the calculator.
  */
 void ScatteringCalculatorLO::set_phonon_samples(const size_t nKz)
 {
@@ -135,7 +168,7 @@ void ScatteringCalculatorLO::set_phonon_samples(const size_t nKz)
         for(unsigned int iKz = 0; iKz < nKz; ++iKz)
             _Kz[iKz] = iKz * _dKz;
 
-        ff_table.clear();
+        clear_pair_data();
     }
 }
 
@@ -147,11 +180,55 @@ void ScatteringCalculatorLO::set_phonon_samples(const size_t nKz)
  * \param[in] ki  The initial wave vector
  *
  * \details The total scattering rate is computed for all possible
- *          transitions to any permitted state in the final subband
+ *          transitions to any permitted state in the final subband.
+ *          This is safe to call from several threads at once.
  */
 double ScatteringCalculatorLO::get_rate_ki(const unsigned int i,
                                            const unsigned int f,
-                                           const double       ki)
+                                           const double       ki) const
+{
+    return get_rates_ki(i, f, arma::vec({ki}))[0];
+}
+
+/**
+ * \brief Find the total scattering rate at a set of initial wave-vectors
+ *
+ * \param[in] i  The initial subband index
+ * \param[in] f  The final subband index
+ * \param[in] ki The initial wave vectors
+ *
+ * \details The form-factor table is looked up once for the whole set, and
+ *          the final-state blocking factors are found together.
+ */
+arma::vec ScatteringCalculatorLO::get_rates_ki(const unsigned int  i,
+                                               const unsigned int  f,
+                                               const arma::vec    &ki) const
+{
+    const auto &Gifsqr = get_ff_table(i,f);
+    arma::vec Wif(ki.size());
+
+    for(unsigned int iki = 0; iki < ki.size(); ++iki)
+        Wif[iki] = find_rate_ki(i, f, ki[iki], Gifsqr);
+
+    if(_enable_blocking)
+        apply_blocking(i, f, ki, Wif);
+
+    return Wif;
+}
+
+/**
+ * \brief Find the total scattering rate at a given initial wave-vector,
+ *        without final-state blocking
+ *
+ * \param[in] i      The initial subband index
+ * \param[in] f      The final subband index
+ * \param[in] ki     The initial wave vector
+ * \param[in] Gifsqr Table of squared form factors for the transition
+ */
+double ScatteringCalculatorLO::find_rate_ki(const unsigned int  i,
+                                            const unsigned int  f,
+                                            const double        ki,
+                                            const arma::vec    &Gifsqr) const
 {
     const auto ki_min = get_ki_min(i,f);
 
@@ -162,8 +239,8 @@ double ScatteringCalculatorLO::get_rate_ki(const unsigned int i,
         const auto nKz = _Kz.size();
         arma::vec Wif_integrand_dKz(nKz); // Integrand for scattering rate
 
-        const auto isb = _subbands[i];
-        const auto fsb = _subbands[f];
+        const auto &isb = _subbands[i];
+        const auto &fsb = _subbands[f];
         const auto Ei  = isb.get_E_min();
         const auto Ef  = fsb.get_E_min();
 
@@ -174,13 +251,6 @@ double ScatteringCalculatorLO::get_rate_ki(const unsigned int i,
         else
             Delta -= _Ephonon;
 
-        auto idx = std::make_pair(i,f);
-
-        if(ff_table.count(idx) == 0)
-            make_ff_table(i,f);
-
-        auto Gifsqr = ff_table[idx];
-
         // Integral over phonon wavevector Kz
         for(unsigned int iKz=0; iKz < nKz; ++iKz)
         {
@@ -198,33 +268,75 @@ double ScatteringCalculatorLO::get_rate_ki(const unsigned int i,
         } // end integral over Kz
 
         Wif_ki = _prefactor*pi*integral(Wif_integrand_dKz,_dKz);
-
-        if(_enable_blocking)
-        {
-            // Initial and final kinetic energy
-            const auto Eki = isb.get_Ek_at_k(ki);
-            const auto Ekf = Eki - Delta;
-
-            if(Ekf >= 0)
-            {
-                const auto kf   = fsb.get_k_at_Ek(Ekf);
-                const auto f_FD = fsb.get_occupation_at_k(kf);
-                Wif_ki *= (1.0 - f_FD);
-            }
-        }
     }
 
     return Wif_ki;
 }
 
 /**
- * \brief Returns the entire scattering table for an intersubband transition
+ * \brief Include the final-state blocking factor in a set of rates
+ *
+ * \param[in]     i   The initial subband index
+ * \param[in]     f   The final subband index
+ * \param[in]     ki  The initial wave vectors
+ * \param[in,out] Wif The scattering rate at each initial wave vector
+ *
+ * \details The final-state energies and occupations are found for the whole
+ *          set at once.
+ */
+void ScatteringCalculatorLO::apply_blocking(const unsigned int  i,
+                                            const unsigned int  f,
+                                            const arma::vec    &ki,
+                                            arma::vec          &Wif) const
+{
+    const auto &isb = _subbands[i];
+    const auto &fsb = _subbands[f];
+
+    auto Delta = fsb.get_E_min() - isb.get_E_min();
+
+    if(_is_emission)
+        Delta += _Ephonon;
+    else
+        Delta -= _Ephonon;
+
+    // Initial and final kinetic energy
+    arma::vec Eki;
+    isb.get_Ek_at_k(ki, Eki);
+    const arma::vec Ekf = Eki - Delta;
+
+    // Only states with a real final wave vector are blocked
+    const arma::uvec allowed = arma::find(Ekf >= 0);
+    const arma::vec  Ekf_allowed = Ekf.elem(allowed);
+
+    arma::vec kf;
+    arma::vec f_FD;
+    arma::vec Ekf_out;
+    fsb.get_k_at_Ek(Ekf_allowed, kf);
+    fsb.get_occupation_at_k(kf, f_FD, Ekf_out);
+
+    for(unsigned int n = 0; n < allowed.size(); ++n)
+        Wif[allowed[n]] *= 1.0 - f_FD[n];
+}
+
+/**
+ * \brief Find the initial wave-vector at which scattering switches on [1/m]
+ */
+arma::vec ScatteringCalculatorLO::get_ki_thresholds(const unsigned int i,
+                                                    const unsigned int f) const
+{
+    arma::vec ki_threshold(1);
+    ki_threshold[0] = get_ki_min(i,f);
+    return ki_threshold;
+}
+
+/**
+ * \brief Find a table of initial wave-vectors for a transition [1/m]
  *
  * \param[in] i Initial subband index
  * \param[in] f Final subband index
  */
-IntersubbandTransition ScatteringCalculatorLO::get_transition(const unsigned int i,
-                                                              const unsigned int f)
+arma::vec ScatteringCalculatorLO::make_ki_table(const unsigned int i,
+                                                const unsigned int f) const
 {
     // Get the minimum and cut-off initial wave-vectors for the transition
     const auto kimin  = get_ki_min(i, f);
@@ -232,20 +344,11 @@ IntersubbandTransition ScatteringCalculatorLO::get_transition(const unsigned int
     const auto dki    = (kimax - kimin)/((_nki-1)); // Step length for integration [1/m]
 
     arma::vec ki(_nki);  // Initial wave vectors [1/m]
-    arma::vec Wif(_nki); // Scattering rate at each wave-vector [1/s]
 
     for (unsigned int iki = 0; iki < _nki; ++iki)
-    {
-        ki[iki]  = kimin + dki * iki;
-        Wif[iki] = get_rate_ki(i, f, ki[iki]);
-    }
-
-    const auto isb = _subbands[i];
-    const auto fsb = _subbands[f];
+        ki[iki] = kimin + dki * iki;
 
-    IntersubbandTransition tx(isb, fsb, ki, Wif);
-
-    return tx;
+    return ki;
 }
 
 /**
@@ -260,7 +363,7 @@ void ScatteringCalculatorLO::calculate_screening_length()
     if(_enable_screening)
     {
         // Sum over all subbands
-        for(const auto jsb : _subbands)
+        for(const auto &jsb : _subbands)
         {
             const auto Ej   = jsb.get_E_min();
             const auto f_FD = jsb.get_occupation_at_E_total(Ej);
@@ -273,55 +376,40 @@ void ScatteringCalculatorLO::calculate_screening_length()
 
 /**
  * \brief Computes the formfactor at a range of phonon wave-vectors
+ *
+ * \details This is called automatically by the base class the first time
+ *          that the table is needed for a transition.
  */
-void ScatteringCalculatorLO::make_ff_table(const unsigned int i,
-                                           const unsigned int f)
+arma::vec ScatteringCalculatorLO::make_pair_data(const unsigned int i,
+                                                 const unsigned int f) const
 {
-    const auto isb = _subbands[i];
-    const auto fsb = _subbands[f];
-
-    const auto _nKz = _Kz.size();
-    const auto idx = std::make_pair(i,f);
-    ff_table[idx].resize(_nKz);
-
-    for(unsigned int iKz=0;iKz < _nKz;iKz++)
-    {
-        ff_table[idx][iKz] = Gsqr(_Kz[iKz], isb, fsb); // Squared form-factor
-    }
+    return find_Gsqr_table(_subbands[i].z_array(), get_psi_product(i,f), _Kz);
 }
 
 /**
- * \brief calculates the overlap integral squared between the two states
+ * \brief Ensures that the formfactor table exists for a transition
+ *
+ * \details The table is only computed if it doesn't already exist.
  */
-double ScatteringCalculatorLO::Gsqr(const double   Kz,
-                                    const Subband &isb,
-                                    const Subband &fsb)
+void ScatteringCalculatorLO::make_ff_table(const unsigned int i,
+                                           const unsigned int f) const
 {
-    const auto     z = isb.z_array();
-    const auto    dz = z[1] - z[0];
-    const auto    nz = z.size();
-    const auto psi_i = isb.psi_array();
-    const auto psi_f = fsb.psi_array();
-
-    std::complex<double> I(0,1); // Imaginary unit
-
-    // Find form-factor integral
-    arma::cx_vec G_integrand_dz(nz);
-
-    for(unsigned int iz=0; iz<nz; ++iz)
-        G_integrand_dz[iz] = exp(Kz*z[iz]*I) * psi_i[iz] * psi_f[iz];
-
-    auto G = integral(G_integrand_dz, dz);
-
-    return norm(G);
+    get_pair_data(i,f);
 }
 
-arma::vec ScatteringCalculatorLO::get_ff_table(const unsigned int i,
-                                               const unsigned int f) const
+/**
+ * \brief Get the table of squared form factors for a transition
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The table is generated if it doesn't already exist.  The returned
+ *          reference remains valid until the number of phonon samples is changed.
+ */
+const arma::vec & ScatteringCalculatorLO::get_ff_table(const unsigned int i,
+                                                       const unsigned int f) const
 {
-    const auto idx = std::make_pair(i,f);
-    const auto G = ff_table.at(idx);
-    return G;
+    return get_pair_data(i,f);
 }
 } // namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -7,19 +7,19 @@
 #ifndef QWWAD_SCATTERING_CALCULATOR_LO
 #define QWWAD_SCATTERING_CALCULATOR_LO
 
-#include <map>
-#include <utility>
-#include "subband.h"
-#include "intersubband-transition.h"
+#include "scattering-calculator.h"
 
 namespace QWWAD {
 /**
  * \brief A calculator for electron-phonon scattering rates
+ *
+ * \details All const member functions may be called concurrently from several
+ *          threads.  Form-factor tables are generated on first use and are
+ *          then shared by all threads.  The "set" and "enable" functions
+ *          must not be called while a calculation is running.
  */
-class ScatteringCalculatorLO {
+class ScatteringCalculatorLO : public ScatteringCalculator {
 private:
-    std::vector<Subband> _subbands; ///< The energy subbands in the system
-
     // Physical properties
     double _A0;      ///< Lattice constant [m]
     double _Ephonon; ///< Phonon energy [J]
@@ -33,9 +33,6 @@ private:
     bool _enable_screening; ///< Allow screening
     bool _enable_blocking;  ///< Allow final-state blocking
 
-    // Precision parameters
-    size_t _nki;     ///< Number of initial wave-vector samples
-
     // Derived properties
     decltype(_A0)      _dKz;         ///< Step size in phonon wave vector [1/m]
     decltype(_Ephonon) _omega_0;     ///< Phonon angular frequency [rad/s]
@@ -43,29 +40,41 @@ private:
     decltype(_Ephonon) _prefactor;   ///< Pre-factor for rates
     decltype(_A0)      _lambda_s_sq; ///< Squared screening length [m^2]
 
-    typedef std::pair<unsigned int, unsigned int> map_key;
     arma::vec _Kz; ///< Wave vector samples [1/m]
 
-    /**
-     * \brief Table of form factors
-     *
-     * \details The key refers to the initial and final subband indices
-     *          The map contains a table of \f$G_{if}^2(Kz)\f$
-     */
-    std::map<map_key, arma::vec> ff_table;
-
     void calculate_screening_length();
+    void calculate_prefactor();
+
+    double find_rate_ki(const unsigned int  i,
+                        const unsigned int  f,
+                        const double        ki,
+                        const arma::vec    &Gifsqr) const;
+
+    void apply_blocking(const unsigned int  i,
+                        const unsigned int  f,
+                        const arma::vec    &ki,
+                        arma::vec          &Wif) const;
+
+protected:
+    arma::vec make_pair_data(const unsigned int i,
+                             const unsigned int f) const;
+
+    arma::vec make_ki_table(const unsigned int i,
+                            const unsigned int f) const;
+
+    arma::vec get_ki_thresholds(const unsigned int i,
+                                const unsigned int f) const;
 
 public:
-    ScatteringCalculatorLO(decltype(_subbands)    subbands,
-                           decltype(_A0)          A0,
-                           decltype(_Ephonon)     Ephonon,
-                           decltype(_epss)        epss,
-                           decltype(_epsinf)      epsinf,
-                           decltype(_m)           m,
-                           decltype(_Te)          Te,
-                           decltype(_Tl)          Tl,
-                           decltype(_is_emission) is_emission);
+    ScatteringCalculatorLO(const std::vector<Subband> &subbands,
+                           decltype(_A0)             A0,
+                           decltype(_Ephonon)        Ephonon,
+                           decltype(_epss)           epss,
+                           decltype(_epsinf)         epsinf,
+                           decltype(_m)              m,
+                           decltype(_Te)             Te,
+                           decltype(_Tl)             Tl,
+                           decltype(_is_emission)    is_emission);
 
    double get_Eki_min (const unsigned int isb,
                        const unsigned int fsb) const;
@@ -78,31 +87,30 @@ public:
 
    double get_rate_ki(const unsigned int isb,
                       const unsigned int fsb,
-                      const double       ki);
+                      const double       ki) const;
 
-   IntersubbandTransition get_transition(const unsigned int isb,
-                                         const unsigned int fsb);
+   arma::vec get_rates_ki(const unsigned int  i,
+                          const unsigned int  f,
+                          const arma::vec    &ki) const;
 
    inline decltype(_lambda_s_sq) get_screening_length() const {return _lambda_s_sq;}
 
-   inline void set_ki_samples(const decltype(_nki) nki) {_nki = nki;}
    void set_phonon_samples(const size_t nKz);
 
    inline decltype(_dKz) get_dKz() {return _dKz;}
 
+   void set_temperatures(const double Te,
+                         const double Tl);
+
    inline void enable_screening(const bool enabled) {_enable_screening = enabled;}
    inline void enable_blocking (const bool enabled) {_enable_blocking  = enabled;}
 
    inline decltype(_prefactor) get_prefactor() const {return _prefactor;}
 
    void make_ff_table(const unsigned int i,
-                      const unsigned int f);
-
-   double Gsqr(const double   Kz,
-               const Subband &isb,
-               const Subband &fsb);
+                      const unsigned int f) const;
 
-   arma::vec get_ff_table(const unsigned int i, const unsigned int f) const;
+   const arma::vec & get_ff_table(const unsigned int i, const unsigned int f) const;
    inline decltype(_Kz)  get_Kz_table() const {return _Kz;}
 };
 } // namespace
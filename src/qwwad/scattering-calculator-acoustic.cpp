@@ -0,0 +1,366 @@
+/**
+ * \file   scattering-calculator-acoustic.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for scattering rates for electron-acoustic phonon interactions
+ */
+
+#include <stdexcept>
+#include "scattering-calculator-acoustic.h"
+#include "constants.h"
+#include "maths-helpers.h"
+#include "form-factor.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Initialise an acoustic-phonon scattering calculation for a 2D system
+ *
+ * \param[in] subbands    The energy subbands in the system
+ * \param[in] A0          Lattice constant for the crystal [m]
+ * \param[in] Ephonon     Phonon energy [J]
+ * \param[in] Da          Acoustic deformation potential [J]
+ * \param[in] rho         Mass density [kg/m^3]
+ * \param[in] Vs          Speed of sound [m/s]
+ * \param[in] m           Effective mass [kg]
+ * \param[in] Te          Electron temperature [K]
+ * \param[in] Tl          Lattice temperature [K]
+ * \param[in] is_emission True if this is an emission process
+ */
+ScatteringCalculatorAcoustic::ScatteringCalculatorAcoustic(const std::vector<Subband> &subbands,
+                                                           decltype(_A0)              A0,
+                                                           decltype(_Ephonon)         Ephonon,
+                                                           decltype(_Da)              Da,
+                                                           decltype(_rho)             rho,
+                                                           decltype(_Vs)              Vs,
+                                                           decltype(_m)               m,
+                                                           decltype(_Te)              Te,
+                                                           decltype(_Tl)              Tl,
+                                                           decltype(_is_emission)     is_emission) :
+    ScatteringCalculator(subbands, 301),
+    _A0(A0),
+    _Ephonon(Ephonon),
+    _Da(Da),
+    _rho(rho),
+    _Vs(Vs),
+    _m(m),
+    _Te(Te),
+    _Tl(Tl),
+    _is_emission(is_emission),
+    _enable_blocking(true),
+    _Eki_cutoff(0.0),
+    _ntheta(0),
+    _N0(1.0/(exp(_Ephonon/(kB*_Tl))-1.0)),
+    _prefactor(_Da*_Da*_m*(_N0 + (_is_emission?1:0))/(_rho*_Vs*4*pi*pi*hBar*hBar))
+{
+    set_phonon_samples(301);
+    set_theta_samples(101);
+}
+
+/**
+ * \brief Find the minimum initial kinetic energy that would allow scattering
+ */
+double ScatteringCalculatorAcoustic::get_Eki_min(const unsigned int i,
+                                                 const unsigned int f) const
+{
+    // Subband separation
+    const auto DeltaE = _subbands[f].get_E_min() - _subbands[i].get_E_min();
+
+    // The final kinetic energy must be positive
+    const auto Eki_min = DeltaE + (_is_emission ? _Ephonon : -_Ephonon);
+
+    return (Eki_min > 0.0) ? Eki_min : 0.0;
+}
+
+/**
+ * \brief Find a sensible cut-off value for the initial wave vector
+ *
+ * \details If a cut-off energy has been set by the user, it is used.
+ *          Otherwise a 5kT range is used.  In either case, the range is
+ *          extended if it wouldn't reach the final subband.
+ */
+double ScatteringCalculatorAcoustic::get_ki_cutoff(const unsigned int i,
+                                                   const unsigned int f) const
+{
+    const auto &isb = _subbands[i];
+    const auto Ei   = isb.get_E_min();
+    const auto Ef   = _subbands[f].get_E_min();
+
+    auto Ecutoff = _Eki_cutoff;
+
+    if(Ecutoff <= 0.0)
+    {
+        const auto kimax = isb.get_k_max(_Te);
+        Ecutoff = hBar*hBar*kimax*kimax/(2*_m);
+    }
+
+    if(Ecutoff + Ei < Ef)
+        Ecutoff += Ef;
+
+    return isb.get_k_at_Ek(Ecutoff);
+}
+
+/**
+ * \brief Sets the number of samples of the phonon wave vector to use
+ *
+ * \param[in] nKz Number of samples
+ *
+ * \details The phonon wave vector is integrated over the range 0 to 2/A0.
+ *          If the number of samples changes, the map of form-factors is
+ *          cleared.  This must not be called while any other thread is
+ *          using the calculator.
+ */
+void ScatteringCalculatorAcoustic::set_phonon_samples(const size_t nKz)
+{
+    if(nKz != _Kz.size())
+    {
+        _Kz.resize(nKz);
+        _dKz = 2.0/(_A0*nKz);
+
+        for(unsigned int iKz = 0; iKz < nKz; ++iKz)
+            _Kz[iKz] = iKz * _dKz;
+
+        _Kz_sqr = square(_Kz);
+
+        clear_pair_data();
+    }
+}
+
+/**
+ * \brief Sets the number of samples of the scattering angle to use
+ *
+ * \param[in] ntheta Number of samples over the range [0, pi]
+ */
+void ScatteringCalculatorAcoustic::set_theta_samples(const decltype(_ntheta) ntheta)
+{
+    if(ntheta < 2)
+        throw std::domain_error("At least two angle samples are needed");
+
+    _ntheta = ntheta;
+    _dtheta = pi/static_cast<double>(_ntheta-1);
+    _cos_theta.resize(_ntheta);
+
+    for(unsigned int itheta = 0; itheta < _ntheta; ++itheta)
+        _cos_theta[itheta] = cos(itheta*_dtheta);
+}
+
+/**
+ * \brief Find the total scattering rate at a given initial wave-vector
+ *
+ * \param[in] i  The initial subband index
+ * \param[in] f  The final subband index
+ * \param[in] ki The initial wave vector
+ *
+ * \details The total scattering rate is computed for all possible
+ *          transitions to any permitted state in the final subband.
+ *          This is safe to call from several threads at once.
+ */
+double ScatteringCalculatorAcoustic::get_rate_ki(const unsigned int i,
+                                                 const unsigned int f,
+                                                 const double       ki) const
+{
+    return get_rates_ki(i, f, arma::vec({ki}))[0];
+}
+
+/**
+ * \brief Find the total scattering rate at a set of initial wave-vectors
+ *
+ * \param[in] i  The initial subband index
+ * \param[in] f  The final subband index
+ * \param[in] ki The initial wave vectors
+ *
+ * \details The form-factor table is looked up once for the whole set.  The
+ *          initial kinetic energies and the final-state blocking factors
+ *          are found together.
+ */
+arma::vec ScatteringCalculatorAcoustic::get_rates_ki(const unsigned int  i,
+                                                     const unsigned int  f,
+                                                     const arma::vec    &ki) const
+{
+    const auto &Gifsqr = get_ff_table(i,f);
+
+    arma::vec Eki;
+    _subbands[i].get_Ek_at_k(ki, Eki);
+
+    arma::vec Wif(ki.size());
+
+    for(unsigned int iki = 0; iki < ki.size(); ++iki)
+        Wif[iki] = find_rate_ki(i, f, ki[iki], Eki[iki], Gifsqr);
+
+    // Include final-state blocking factor
+    if(_enable_blocking)
+    {
+        const auto DeltaE = _subbands[f].get_E_min() - _subbands[i].get_E_min();
+
+        arma::vec Ekf = Eki - DeltaE + (_is_emission ? -_Ephonon : _Ephonon);
+
+        // Rates are already zero wherever the final kinetic energy is negative
+        Ekf.elem(arma::find(Ekf < 0.0)).zeros();
+        const arma::vec kf = arma::sqrt(2*_m*Ekf)/hBar;
+
+        arma::vec f_FD;
+        arma::vec Ekf_out;
+        _subbands[f].get_occupation_at_k(kf, f_FD, Ekf_out);
+        Wif %= 1.0 - f_FD;
+    }
+
+    return Wif;
+}
+
+/**
+ * \brief Find the total scattering rate at a given initial wave-vector,
+ *        without final-state blocking
+ *
+ * \param[in] i      The initial subband index
+ * \param[in] f      The final subband index
+ * \param[in] ki     The initial wave vector [1/m]
+ * \param[in] Eki    The initial kinetic energy [J]
+ * \param[in] Gifsqr Table of squared form factors for the transition
+ */
+double ScatteringCalculatorAcoustic::find_rate_ki(const unsigned int  i,
+                                                  const unsigned int  f,
+                                                  const double        ki,
+                                                  const double        Eki,
+                                                  const arma::vec    &Gifsqr) const
+{
+    const auto DeltaE = _subbands[f].get_E_min() - _subbands[i].get_E_min();
+
+    // Check energy conservation before doing any integration
+    const auto Ekf = Eki - DeltaE + (_is_emission ? -_Ephonon : _Ephonon);
+
+    if(Ekf <= 0.0)
+        return 0.0;
+
+    const auto  nKz    = _Kz.size();
+    const auto  tmp    = 2*_m*DeltaE/(hBar*hBar);
+
+    // The in-plane phonon wave-vector is only real if (ki cos theta)^2 >= tmp.
+    // For upward scattering (tmp > 0), both roots are only positive when
+    // cos theta <= -sqrt(tmp)/ki, which fixes the lowest angle that can
+    // contribute.  For downward scattering, all angles are allowed.
+    unsigned int itheta_min = 0;
+
+    if(tmp > 0.0)
+    {
+        const auto cos_theta_max = -sqrt(tmp)/ki;
+
+        if(cos_theta_max < -1.0)
+            return 0.0;
+
+        itheta_min = static_cast<unsigned int>(floor(acos(cos_theta_max)/_dtheta));
+    }
+
+    arma::vec Wif_integrand_dtheta(_ntheta, arma::fill::zeros);
+    arma::vec Wif_integrand_dKz(nKz);
+
+    // Integral around angle theta
+    for(unsigned int itheta = itheta_min; itheta < _ntheta; ++itheta)
+    {
+        const auto ki_cos_theta = ki*_cos_theta[itheta];
+        const auto arg          = ki_cos_theta * ki_cos_theta - tmp; // sqrt argument
+
+        // Guard against rounding at the edge of the allowed range
+        if(arg <= 0.0)
+            continue;
+
+        const auto sqrt_arg = sqrt(arg);
+
+        // Solutions for the in-plane phonon wave-vector Kxy.  These must be
+        // positive, so only keep the positive roots
+        const auto alpha1 =  sqrt_arg - ki_cos_theta;
+        const auto alpha2 = -sqrt_arg - ki_cos_theta;
+        const auto alpha1_pos = (alpha1 > 0.0) ? alpha1 : 0.0;
+        const auto alpha2_pos = (alpha2 > 0.0) ? alpha2 : 0.0;
+
+        if(alpha1_pos == 0.0 && alpha2_pos == 0.0)
+            continue;
+
+        const auto alpha1_sqr = alpha1*alpha1;
+        const auto alpha2_sqr = alpha2*alpha2;
+        const auto denom      = alpha1 - alpha2;
+
+        // Integral over phonon wavevector Kz
+        for(unsigned int iKz = 0; iKz < nKz; ++iKz)
+        {
+            Wif_integrand_dKz[iKz] = Gifsqr[iKz]*
+                                     (alpha1_pos*sqrt(alpha1_sqr + _Kz_sqr[iKz]) +
+                                      alpha2_pos*sqrt(alpha2_sqr + _Kz_sqr[iKz]))/denom;
+        }
+
+        Wif_integrand_dtheta[itheta] = integral(Wif_integrand_dKz, _dKz);
+    }
+
+    return 2*_prefactor*integral(Wif_integrand_dtheta, _dtheta);
+}
+
+/**
+ * \brief Find the initial wave-vector at which scattering switches on [1/m]
+ */
+arma::vec ScatteringCalculatorAcoustic::get_ki_thresholds(const unsigned int i,
+                                                          const unsigned int f) const
+{
+    arma::vec ki_threshold(1);
+    ki_threshold[0] = _subbands[i].get_k_at_Ek(get_Eki_min(i,f));
+    return ki_threshold;
+}
+
+/**
+ * \brief Find a table of initial wave-vectors for a transition [1/m]
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The samples are offset slightly from zero to avoid the pole at ki = 0
+ */
+arma::vec ScatteringCalculatorAcoustic::make_ki_table(const unsigned int i,
+                                                      const unsigned int f) const
+{
+    const auto kimax = get_ki_cutoff(i, f);
+    const auto dki   = kimax/static_cast<double>(_nki);
+
+    arma::vec ki(_nki);
+
+    for(unsigned int iki = 0; iki < _nki; ++iki)
+        ki[iki] = dki*iki + dki/100;
+
+    return ki;
+}
+
+/**
+ * \brief Computes the formfactor at a range of phonon wave-vectors
+ *
+ * \details This is called automatically by the base class the first time
+ *          that the table is needed for a transition.
+ */
+arma::vec ScatteringCalculatorAcoustic::make_pair_data(const unsigned int i,
+                                                       const unsigned int f) const
+{
+    return find_Gsqr_table(_subbands[i].z_array(), get_psi_product(i,f), _Kz);
+}
+
+/**
+ * \brief Ensures that the formfactor table exists for a transition
+ *
+ * \details The table is only computed if it doesn't already exist.
+ */
+void ScatteringCalculatorAcoustic::make_ff_table(const unsigned int i,
+                                                 const unsigned int f) const
+{
+    get_pair_data(i,f);
+}
+
+/**
+ * \brief Get the table of squared form factors for a transition
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The table is generated if it doesn't already exist
+ */
+const arma::vec & ScatteringCalculatorAcoustic::get_ff_table(const unsigned int i,
+                                                             const unsigned int f) const
+{
+    return get_pair_data(i,f);
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,116 @@
+/**
+ * \file   scattering-calculator-acoustic.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for scattering rates for electron-acoustic phonon interactions
+ */
+
+#ifndef QWWAD_SCATTERING_CALCULATOR_ACOUSTIC
+#define QWWAD_SCATTERING_CALCULATOR_ACOUSTIC
+
+#include "scattering-calculator.h"
+
+namespace QWWAD {
+/**
+ * \brief A calculator for electron-acoustic phonon (deformation potential) scattering rates
+ *
+ * \details The interface mirrors ScatteringCalculatorLO.  All const member
+ *          functions may be called concurrently from several threads.
+ *
+ *          Energy conservation is checked before any integration takes
+ *          place, and the range of scattering angles that give a physical
+ *          in-plane phonon wave-vector is found analytically, so that
+ *          forbidden contributions are never computed.
+ */
+class ScatteringCalculatorAcoustic : public ScatteringCalculator {
+private:
+    // Physical properties
+    double _A0;      ///< Lattice constant [m]
+    double _Ephonon; ///< Phonon energy [J]
+    double _Da;      ///< Acoustic deformation potential [J]
+    double _rho;     ///< Mass density [kg/m^3]
+    double _Vs;      ///< Speed of sound [m/s]
+    double _m;       ///< Effective mass [kg]
+    double _Te;      ///< Electron temperature [K]
+    double _Tl;      ///< Lattice temperature [K]
+
+    bool _is_emission;     ///< True if this is an emission process
+    bool _enable_blocking; ///< Allow final-state blocking
+
+    double _Eki_cutoff; ///< User-specified cut-off kinetic energy [J] (zero if automatic)
+
+    // Precision parameters
+    size_t _ntheta;  ///< Number of scattering angle samples
+
+    // Derived properties
+    decltype(_A0)      _dKz;       ///< Step size in phonon wave vector [1/m]
+    decltype(_Ephonon) _N0;        ///< Bose-Einstein factor
+    decltype(_Ephonon) _prefactor; ///< Pre-factor for rates
+    double             _dtheta;    ///< Step size in scattering angle [rad]
+
+    arma::vec _Kz;        ///< Wave vector samples [1/m]
+    arma::vec _Kz_sqr;    ///< Squared wave vector samples [1/m^2]
+    arma::vec _cos_theta; ///< Cosine of each scattering angle sample
+
+    double find_rate_ki(const unsigned int  i,
+                        const unsigned int  f,
+                        const double        ki,
+                        const double        Eki,
+                        const arma::vec    &Gifsqr) const;
+
+protected:
+    arma::vec make_pair_data(const unsigned int i,
+                             const unsigned int f) const;
+
+    arma::vec make_ki_table(const unsigned int i,
+                            const unsigned int f) const;
+
+    arma::vec get_ki_thresholds(const unsigned int i,
+                                const unsigned int f) const;
+
+public:
+    ScatteringCalculatorAcoustic(const std::vector<Subband> &subbands,
+                                 decltype(_A0)              A0,
+                                 decltype(_Ephonon)         Ephonon,
+                                 decltype(_Da)              Da,
+                                 decltype(_rho)             rho,
+                                 decltype(_Vs)              Vs,
+                                 decltype(_m)               m,
+                                 decltype(_Te)              Te,
+                                 decltype(_Tl)              Tl,
+                                 decltype(_is_emission)     is_emission);
+
+    double get_Eki_min(const unsigned int isb,
+                       const unsigned int fsb) const;
+
+    double get_ki_cutoff(const unsigned int isb,
+                         const unsigned int fsb) const;
+
+    double get_rate_ki(const unsigned int isb,
+                       const unsigned int fsb,
+                       const double       ki) const;
+
+    arma::vec get_rates_ki(const unsigned int  i,
+                           const unsigned int  f,
+                           const arma::vec    &ki) const;
+
+    void        set_theta_samples(const decltype(_ntheta) ntheta);
+    void        set_phonon_samples(const size_t nKz);
+
+    /// Set the cut-off kinetic energy for the initial subband [J]. Zero gives an automatic choice.
+    inline void set_Eki_cutoff(const decltype(_Eki_cutoff) Eki_cutoff) {_Eki_cutoff = Eki_cutoff;}
+
+    inline decltype(_dKz) get_dKz() const {return _dKz;}
+
+    inline void enable_blocking(const bool enabled) {_enable_blocking = enabled;}
+
+    inline decltype(_prefactor) get_prefactor() const {return _prefactor;}
+
+    void make_ff_table(const unsigned int i,
+                       const unsigned int f) const;
+
+    const arma::vec & get_ff_table(const unsigned int i, const unsigned int f) const;
+    inline decltype(_Kz) get_Kz_table() const {return _Kz;}
+};
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
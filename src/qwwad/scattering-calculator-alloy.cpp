@@ -0,0 +1,76 @@
+/**
+ * \file   scattering-calculator-alloy.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for alloy-disorder scattering rates
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include "scattering-calculator-alloy.h"
+#include "constants.h"
+#include "maths-helpers.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Initialise an alloy-disorder scattering calculation for a 2D system
+ *
+ * \param[in] subbands The energy subbands in the system
+ * \param[in] x        Alloy fraction at each point in the structure
+ * \param[in] Vad      Alloy-disorder potential [J]
+ * \param[in] Omega    Volume occupied by each scatterer [m^3]
+ * \param[in] m        Effective mass [kg]
+ * \param[in] Te       Electron temperature [K]
+ */
+ScatteringCalculatorAlloy::ScatteringCalculatorAlloy(const std::vector<Subband> &subbands,
+                                                     const arma::vec            &x,
+                                                     const double                Vad,
+                                                     const double                Omega,
+                                                     const double                m,
+                                                     const double                Te) :
+    ScatteringCalculatorElastic(subbands, m, Te),
+    _x(x),
+    _Vad(Vad),
+    _Omega(Omega)
+{
+    if(!_subbands.empty() && _subbands[0].z_array().size() != _x.size())
+    {
+        std::ostringstream oss;
+        oss << "Alloy profile has " << _x.size() << " points, but wavefunctions have "
+            << _subbands[0].z_array().size() << ".";
+        throw std::length_error(oss.str());
+    }
+}
+
+/**
+ * \brief Find the alloy-disorder matrix element for a transition [1/s]
+ */
+arma::vec ScatteringCalculatorAlloy::make_pair_data(const unsigned int i,
+                                                    const unsigned int f) const
+{
+    const auto z  = _subbands[i].z_array();
+    const auto dz = z[1] - z[0];
+
+    const auto &psi_if = get_psi_product(i,f);
+    const arma::vec integrand_dz = psi_if%psi_if%_x%(1.0-_x);
+
+    arma::vec I(1);
+    I[0] = _m*_Omega*_Vad*_Vad/(hBar*hBar*hBar) * integral(integrand_dz, dz);
+    return I;
+}
+
+/**
+ * \brief Find the scattering rate between a pair of wave-vectors [1/s]
+ *
+ * \details The rate is the same at all wave-vectors
+ */
+double ScatteringCalculatorAlloy::get_rate_ki_kf(const unsigned int i,
+                                                 const unsigned int f,
+                                                 const double       /* ki */,
+                                                 const double       /* kf */) const
+{
+    return get_pair_data(i,f)[0];
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
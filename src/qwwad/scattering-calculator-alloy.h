@@ -0,0 +1,44 @@
+/**
+ * \file   scattering-calculator-alloy.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for alloy-disorder scattering rates
+ */
+
+#ifndef QWWAD_SCATTERING_CALCULATOR_ALLOY
+#define QWWAD_SCATTERING_CALCULATOR_ALLOY
+
+#include "scattering-calculator-elastic.h"
+
+namespace QWWAD {
+/**
+ * \brief A calculator for alloy-disorder scattering rates
+ *
+ * \details The scattering rate is independent of wave-vector, so the
+ *          matrix element for each transition is the only cached data.
+ */
+class ScatteringCalculatorAlloy : public ScatteringCalculatorElastic {
+private:
+    arma::vec _x;     ///< Alloy fraction at each point
+    double    _Vad;   ///< Alloy-disorder potential [J]
+    double    _Omega; ///< Volume occupied by each scatterer [m^3]
+
+protected:
+    arma::vec make_pair_data(const unsigned int i,
+                             const unsigned int f) const;
+
+    double get_rate_ki_kf(const unsigned int i,
+                          const unsigned int f,
+                          const double       ki,
+                          const double       kf) const;
+
+public:
+    ScatteringCalculatorAlloy(const std::vector<Subband> &subbands,
+                              const arma::vec            &x,
+                              const double                Vad,
+                              const double                Omega,
+                              const double                m,
+                              const double                Te);
+};
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,167 @@
+/**
+ * \file   scattering-calculator-elastic.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Base class for elastic scattering-rate calculators
+ */
+
+#include "scattering-calculator-elastic.h"
+#include "constants.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Initialise an elastic scattering calculation for a 2D system
+ *
+ * \param[in] subbands The energy subbands in the system
+ * \param[in] m        Effective mass [kg]
+ * \param[in] Te       Electron temperature [K]
+ */
+ScatteringCalculatorElastic::ScatteringCalculatorElastic(const std::vector<Subband> &subbands,
+                                                         const double                m,
+                                                         const double                Te) :
+    ScatteringCalculator(subbands, 101),
+    _enable_blocking(true),
+    _Eki_cutoff(0.0),
+    _m(m),
+    _Te(Te)
+{}
+
+/**
+ * \brief Find the minimum initial wave-vector that would allow scattering
+ *
+ * \details For upward scattering, the initial kinetic energy must be at least
+ *          as large as the subband separation.
+ */
+double ScatteringCalculatorElastic::get_ki_min(const unsigned int i,
+                                               const unsigned int f) const
+{
+    const auto Efi = _subbands[f].get_E_min() - _subbands[i].get_E_min();
+
+    double kimin = 0.0;
+
+    if(Efi > 0)
+        kimin = sqrt(2*_m*Efi)/hBar;
+
+    return kimin;
+}
+
+/**
+ * \brief Find the cut-off kinetic energy for the initial subband [J]
+ *
+ * \details If a cut-off energy has been set by the user, it is used.
+ *          Otherwise a 5kT range is used.  In either case, the range is
+ *          extended if it wouldn't reach the final subband.
+ */
+double ScatteringCalculatorElastic::get_Eki_cutoff(const unsigned int i,
+                                                   const unsigned int f) const
+{
+    const auto &isb = _subbands[i];
+    const auto Ei   = isb.get_E_min();
+    const auto Ef   = _subbands[f].get_E_min();
+
+    auto Ecutoff = _Eki_cutoff;
+
+    if(Ecutoff <= 0.0)
+    {
+        const auto kimax = isb.get_k_max(_Te);
+        Ecutoff = hBar*hBar*kimax*kimax/(2*_m);
+    }
+
+    if(Ecutoff + Ei < Ef)
+        Ecutoff += Ef;
+
+    return Ecutoff;
+}
+
+/**
+ * \brief Set the cut-off kinetic energy for the initial subband
+ *
+ * \param[in] Eki_cutoff Cut-off energy [J].  Zero gives an automatic choice.
+ *
+ * \details Any cached data is cleared, since some mechanisms tabulate their
+ *          form factors over the range of wave-vectors that is needed.
+ */
+void ScatteringCalculatorElastic::set_Eki_cutoff(const decltype(_Eki_cutoff) Eki_cutoff)
+{
+    _Eki_cutoff = Eki_cutoff;
+    clear_pair_data();
+}
+
+/**
+ * \brief Find a sensible cut-off value for the initial wave vector [1/m]
+ */
+double ScatteringCalculatorElastic::get_ki_cutoff(const unsigned int i,
+                                                  const unsigned int f) const
+{
+    return _subbands[i].get_k_at_Ek(get_Eki_cutoff(i,f));
+}
+
+/**
+ * \brief Find the initial wave-vector at which scattering switches on [1/m]
+ */
+arma::vec ScatteringCalculatorElastic::get_ki_thresholds(const unsigned int i,
+                                                         const unsigned int f) const
+{
+    arma::vec ki_threshold(1);
+    ki_threshold[0] = get_ki_min(i,f);
+    return ki_threshold;
+}
+
+/**
+ * \brief Find a table of initial wave-vectors for a transition [1/m]
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ */
+arma::vec ScatteringCalculatorElastic::make_ki_table(const unsigned int i,
+                                                     const unsigned int f) const
+{
+    const auto kimin = get_ki_min(i,f);
+    const auto kimax = get_ki_cutoff(i,f);
+    const auto dki   = (kimax-kimin)/((float)_nki - 1); // step length for loop over ki
+
+    arma::vec ki(_nki);
+
+    for(unsigned int iki = 0; iki < _nki; ++iki)
+        ki[iki] = kimin + dki*iki;
+
+    return ki;
+}
+
+/**
+ * \brief Find the total scattering rate at a given initial wave-vector
+ *
+ * \param[in] i  The initial subband index
+ * \param[in] f  The final subband index
+ * \param[in] ki The initial wave vector
+ *
+ * \details The rate is zero if no energy-conserving final state exists.
+ *          This is safe to call from several threads at once.
+ */
+double ScatteringCalculatorElastic::get_rate_ki(const unsigned int i,
+                                                const unsigned int f,
+                                                const double       ki) const
+{
+    const auto &fsb = _subbands[f];
+    const auto Ei   = _subbands[i].get_E_min();
+    const auto Ef   = fsb.get_E_min();
+
+    // Find energy-conserving final wave-vector
+    const auto kf_sqr = ki*ki + 2*_m*(Ei - Ef)/(hBar*hBar);
+
+    if(kf_sqr < 0.0)
+        return 0.0;
+
+    const auto kf = sqrt(kf_sqr);
+
+    auto Wif = get_rate_ki_kf(i, f, ki, kf);
+
+    // Include final-state blocking factor
+    if(_enable_blocking)
+        Wif *= (1 - fsb.get_occupation_at_k(kf));
+
+    return Wif;
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,77 @@
+/**
+ * \file   scattering-calculator-elastic.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Base class for elastic scattering-rate calculators
+ */
+
+#ifndef QWWAD_SCATTERING_CALCULATOR_ELASTIC
+#define QWWAD_SCATTERING_CALCULATOR_ELASTIC
+
+#include "scattering-calculator.h"
+
+namespace QWWAD {
+/**
+ * \brief A calculator for elastic scattering processes
+ *
+ * \details In an elastic process, the total energy of the carrier is
+ *          conserved, so the final wave-vector is fixed by the initial
+ *          wave-vector and the subband separation.  This class handles the
+ *          wave-vector sampling and final-state blocking, and subclasses
+ *          supply the rate for a given pair of wave-vectors.
+ */
+class ScatteringCalculatorElastic : public ScatteringCalculator {
+private:
+    bool   _enable_blocking; ///< Allow final-state blocking
+    double _Eki_cutoff;      ///< User-specified cut-off kinetic energy [J] (zero if automatic)
+
+protected:
+    double _m;  ///< Effective mass [kg]
+    double _Te; ///< Electron temperature [K]
+
+    arma::vec make_ki_table(const unsigned int i,
+                            const unsigned int f) const;
+
+    arma::vec get_ki_thresholds(const unsigned int i,
+                                const unsigned int f) const;
+
+    /**
+     * \brief Find the scattering rate between a given pair of wave-vectors [1/s]
+     *
+     * \param[in] i  Initial subband index
+     * \param[in] f  Final subband index
+     * \param[in] ki Initial wave vector [1/m]
+     * \param[in] kf Energy-conserving final wave vector [1/m]
+     *
+     * \details This excludes final-state blocking, which is applied by
+     *          get_rate_ki().
+     */
+    virtual double get_rate_ki_kf(const unsigned int i,
+                                  const unsigned int f,
+                                  const double       ki,
+                                  const double       kf) const = 0;
+
+public:
+    ScatteringCalculatorElastic(const std::vector<Subband> &subbands,
+                                const double                m,
+                                const double                Te);
+
+    double get_ki_min(const unsigned int i,
+                      const unsigned int f) const;
+
+    double get_Eki_cutoff(const unsigned int i,
+                          const unsigned int f) const;
+
+    double get_ki_cutoff(const unsigned int i,
+                         const unsigned int f) const;
+
+    double get_rate_ki(const unsigned int i,
+                       const unsigned int f,
+                       const double       ki) const;
+
+    void set_Eki_cutoff(const decltype(_Eki_cutoff) Eki_cutoff);
+
+    inline void enable_blocking(const bool enabled) {_enable_blocking = enabled;}
+};
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
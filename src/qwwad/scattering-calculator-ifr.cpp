@@ -0,0 +1,125 @@
+/**
+ * \file   scattering-calculator-ifr.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for interface-roughness scattering rates
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <gsl/gsl_sf.h>
+#include "scattering-calculator-ifr.h"
+#include "constants.h"
+#include "maths-helpers.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Initialise an interface-roughness scattering calculation for a 2D system
+ *
+ * \param[in] subbands The energy subbands in the system
+ * \param[in] V        Potential profile [J]
+ * \param[in] iz_I     Indices of the interface locations
+ * \param[in] Delta    Roughness height [m]
+ * \param[in] Lambda   Roughness correlation length [m]
+ * \param[in] m        Effective mass [kg]
+ * \param[in] Te       Electron temperature [K]
+ */
+ScatteringCalculatorIFR::ScatteringCalculatorIFR(const std::vector<Subband> &subbands,
+                                                 const arma::vec            &V,
+                                                 const arma::uvec           &iz_I,
+                                                 const double                Delta,
+                                                 const double                Lambda,
+                                                 const double                m,
+                                                 const double                Te) :
+    ScatteringCalculatorElastic(subbands, m, Te),
+    _iz_I(iz_I),
+    _Delta(Delta),
+    _Lambda(Lambda)
+{
+    if(_subbands.empty())
+        return;
+
+    const auto   z  = _subbands[0].z_array();
+    const size_t nz = z.size();
+
+    if(V.size() != nz)
+    {
+        std::ostringstream oss;
+        oss << "Potential profile has " << V.size() << " points, but wavefunctions have "
+            << nz << ".";
+        throw std::length_error(oss.str());
+    }
+
+    if(_iz_I.size() < 2)
+        throw std::invalid_argument("At least two interface locations are needed");
+
+    const double dz = z[1] - z[0];
+    _dV_dz.set_size(nz);
+
+    for (unsigned int iz = 1; iz < nz-1; ++iz)
+        _dV_dz[iz] = (V[iz+1] - V[iz-1])/dz;
+
+    // Assume periodic boundary conditions
+    _dV_dz[0]    = (V[1] - V[nz-1])/dz;
+    _dV_dz[nz-1] = (V[0] - V[nz-2])/dz;
+}
+
+/**
+ * \brief Find the squared interface-roughness matrix element at each interface [J^2]
+ *
+ * \details The roughness at each interface is assumed to be uncorrelated
+ *          with the others, so the rate is found from the sum of these
+ *          squared matrix elements.
+ */
+arma::vec ScatteringCalculatorIFR::make_pair_data(const unsigned int i,
+                                                  const unsigned int f) const
+{
+    const auto z  = _subbands[i].z_array();
+    const auto dz = z[1] - z[0];
+
+    const auto &psi_if = get_psi_product(i,f);
+    arma::vec F_if_sq(_iz_I.size()-1);
+
+    // Get contributions from each interface
+    // Note that we don't include the last one, since this is the edge of the system, where
+    // psi = 0
+    for (unsigned int I=0; I < _iz_I.size()-1; ++I)
+    {
+        unsigned int iz_L = 0; // Lower bound of interface
+        unsigned int iz_U = 0; // Upper bound of interface
+
+        if(I != 0)
+            iz_L = (_iz_I[I] + _iz_I[I-1])/2;
+        else
+            iz_L = _iz_I[0]/2;
+
+        iz_U = (_iz_I[I] + _iz_I[I+1])/2;
+
+        arma::vec F_integrand_dz(iz_U-iz_L);
+        for (unsigned int iz = iz_L; iz < iz_U; ++iz)
+            F_integrand_dz[iz-iz_L] = psi_if[iz]*_dV_dz[iz];
+
+        const double F_if = integral(F_integrand_dz, dz);
+        F_if_sq[I] = F_if*F_if;
+    }
+
+    return F_if_sq;
+}
+
+/**
+ * \brief Find the scattering rate between a pair of wave-vectors [1/s]
+ */
+double ScatteringCalculatorIFR::get_rate_ki_kf(const unsigned int i,
+                                               const unsigned int f,
+                                               const double       ki,
+                                               const double       kf) const
+{
+    const auto F_if_sq = arma::accu(get_pair_data(i,f));
+    const auto Lambda_sq = _Lambda*_Lambda;
+    const auto beta = exp(-(ki*ki + kf*kf)*Lambda_sq/4) * gsl_sf_bessel_I0(ki*kf*Lambda_sq/2);
+
+    return pi*_m*_Delta*_Delta*Lambda_sq/(hBar*hBar*hBar) * beta * F_if_sq;
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
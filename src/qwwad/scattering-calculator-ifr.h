@@ -0,0 +1,54 @@
+/**
+ * \file   scattering-calculator-ifr.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for interface-roughness scattering rates
+ */
+
+#ifndef QWWAD_SCATTERING_CALCULATOR_IFR
+#define QWWAD_SCATTERING_CALCULATOR_IFR
+
+#include "scattering-calculator-elastic.h"
+
+namespace QWWAD {
+/**
+ * \brief A calculator for interface-roughness scattering rates
+ *
+ * \details The squared matrix element for each transition depends only on
+ *          the potential profile and the wavefunctions, so it is cached.
+ *          The roughness parameters may therefore be changed without
+ *          recomputing it.
+ */
+class ScatteringCalculatorIFR : public ScatteringCalculatorElastic {
+private:
+    arma::vec  _dV_dz; ///< Derivative of potential profile [J/m]
+    arma::uvec _iz_I;  ///< Indices of interface locations
+    double     _Delta;  ///< Roughness height [m]
+    double     _Lambda; ///< Roughness correlation length [m]
+
+protected:
+    arma::vec make_pair_data(const unsigned int i,
+                             const unsigned int f) const;
+
+    double get_rate_ki_kf(const unsigned int i,
+                          const unsigned int f,
+                          const double       ki,
+                          const double       kf) const;
+
+public:
+    ScatteringCalculatorIFR(const std::vector<Subband> &subbands,
+                            const arma::vec            &V,
+                            const arma::uvec           &iz_I,
+                            const double                Delta,
+                            const double                Lambda,
+                            const double                m,
+                            const double                Te);
+
+    /// Set the roughness height [m]
+    inline void set_Delta (const decltype(_Delta)  Delta)  {_Delta  = Delta;}
+
+    /// Set the roughness correlation length [m]
+    inline void set_Lambda(const decltype(_Lambda) Lambda) {_Lambda = Lambda;}
+};
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
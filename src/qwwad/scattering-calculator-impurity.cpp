@@ -0,0 +1,431 @@
+/**
+ * \file   scattering-calculator-impurity.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for ionised-impurity scattering rates
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <gsl/gsl_interp.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_spline.h>
+#include "scattering-calculator-impurity.h"
+#include "constants.h"
+#include "maths-helpers.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Initialise an impurity scattering calculation for a 2D system
+ *
+ * \param[in] subbands The energy subbands in the system
+ * \param[in] d        Volume doping density at each point [m^{-3}]
+ * \param[in] epsilon  Low-frequency permittivity [F/m]
+ * \param[in] m        Effective mass [kg]
+ * \param[in] Te       Electron temperature [K]
+ */
+ScatteringCalculatorImpurity::ScatteringCalculatorImpurity(const std::vector<Subband> &subbands,
+                                                           const arma::vec            &d,
+                                                           const double                epsilon,
+                                                           const double                m,
+                                                           const double                Te) :
+    ScatteringCalculatorElastic(subbands, m, Te),
+    _d(d),
+    _epsilon(epsilon),
+    _enable_screening(true),
+    _enable_sheet_model(false),
+    _nq(101),
+    _ntheta(0),
+    _prefactor(m*e*e*e*e / (4*pi*hBar*hBar*hBar*epsilon*epsilon)),
+    _splines(std::make_shared<SplineTable>())
+{
+    if(!_subbands.empty() && _subbands[0].z_array().size() != _d.size())
+    {
+        std::ostringstream oss;
+        oss << "Doping profile has " << _d.size() << " points, but wavefunctions have "
+            << _subbands[0].z_array().size() << ".";
+        throw std::length_error(oss.str());
+    }
+
+    set_theta_samples(101);
+
+    if(_subbands.empty())
+        return;
+
+    const auto z  = _subbands[0].z_array();
+    const auto nz = z.size();
+
+    if(nz < 2)
+        throw std::length_error("Need at least two points in the doping profile.");
+
+    _wd = quadrature_weights(nz, z[1] - z[0]) % _d;
+
+    // Compress the doping profile into runs of doped points.  In modulation-
+    // or delta-doped structures, these cover only a small part of the mesh
+    for(unsigned int iz = 0; iz < nz; ++iz)
+    {
+        if(_d[iz] == 0.0)
+            continue;
+
+        if(!_segments.empty() && _segments.back().iz_stop == iz-1)
+            _segments.back().iz_stop = iz;
+        else
+            _segments.push_back({iz, iz});
+    }
+
+    // Find the equivalent sheet of charge for each segment
+    for(const auto &seg : _segments)
+    {
+        double Ns  = 0.0;
+        double zNs = 0.0;
+
+        for(unsigned int iz = seg.iz_start; iz <= seg.iz_stop; ++iz)
+        {
+            Ns  += _wd[iz];
+            zNs += _wd[iz]*z[iz];
+        }
+
+        // Fall back to the middle of the segment if there's no net charge
+        const double z_sheet = (Ns != 0.0) ? zNs/Ns : (z[seg.iz_start] + z[seg.iz_stop])/2;
+        _sheets.push_back({z_sheet, Ns});
+    }
+}
+
+/**
+ * \brief Sets the number of samples of the scattering vector to use
+ *
+ * \param[in] nq Number of samples
+ *
+ * \details The form-factor tables are cleared if the number changes
+ */
+void ScatteringCalculatorImpurity::set_q_samples(const decltype(_nq) nq)
+{
+    if(nq < 4)
+        throw std::domain_error("At least four scattering vector samples are needed");
+
+    if(nq != _nq)
+    {
+        _nq = nq;
+        clear_pair_data();
+        clear_splines();
+    }
+}
+
+/**
+ * \brief Sets the number of samples of the scattering angle to use
+ *
+ * \param[in] ntheta Number of samples over the range [0, 2 pi]
+ */
+void ScatteringCalculatorImpurity::set_theta_samples(const decltype(_ntheta) ntheta)
+{
+    if(ntheta < 2)
+        throw std::domain_error("At least two angle samples are needed");
+
+    _ntheta = ntheta;
+    _dtheta = 2*pi/((float)_ntheta - 1);
+    _cos_theta.resize(_ntheta);
+
+    // Can save a bit of time by calculating cosines in advance
+    for(unsigned int itheta = 0; itheta < _ntheta; ++itheta)
+        _cos_theta[itheta] = cos(itheta*_dtheta);
+}
+
+/**
+ * \brief Enable or disable screening of the Coulomb interaction
+ *
+ * \details The form-factor tables are cleared if the setting changes
+ */
+void ScatteringCalculatorImpurity::enable_screening(const bool enabled)
+{
+    if(enabled != _enable_screening)
+    {
+        _enable_screening = enabled;
+        clear_pair_data();
+        clear_splines();
+    }
+}
+
+/**
+ * \brief Treat each doped segment as a delta-doped sheet of charge
+ *
+ * \details The form factor tables are cleared if the setting changes
+ */
+void ScatteringCalculatorImpurity::enable_sheet_model(const bool enabled)
+{
+    if(enabled != _enable_sheet_model)
+    {
+        _enable_sheet_model = enabled;
+        clear_pair_data();
+        clear_splines();
+    }
+}
+
+/**
+ * \brief Find the overlap integral for impurity scattering
+ *
+ * \param[in] q Scattering vector [1/m]
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The matrix element at each dopant location z' is
+ *           I_if(q,z') = ∫dz ψ_i(z) ψ_f(z) exp(-q|z-z'|),
+ *          where z is the carrier location.
+ *
+ *          By default, the doping profile is integrated over its doped
+ *          segments.  If the sheet model is enabled, each segment is instead
+ *          replaced by a sheet of density N_s at its centroid z_s, so that
+ *
+ *           J_if(q) = Σ N_s I_if(q,z_s)²
+ *
+ * \returns J_if(q) = ∫dz' I_if(q,z')² d(z')
+ */
+double ScatteringCalculatorImpurity::get_J(const double       q,
+                                           const unsigned int i,
+                                           const unsigned int f) const
+{
+    if(_segments.empty())
+        return 0.0;
+
+    return _enable_sheet_model ? get_J_sheets(q,i,f) : get_J_segments(q,i,f);
+}
+
+/**
+ * \brief Find the overlap integral over the doped segments of the structure
+ *
+ * \details The numerical solution can be speeded up by replacing the modulus
+ *          function with the sum of two integrals.  We can say that
+ *
+ *           I_if(q,z') = C_if⁻(q,z')/exp(qz') + C_if⁺(q,z') exp(qz')',
+ *
+ *          where
+ *
+ *           C_if⁺(q,z') = ∫_{z'}^∞ dz ψ_i(z) ψ_f(z)/exp(qz)
+ *           C_if⁻(q,z') = ∫_{-∞}^{z'} dz ψ_i(z) ψ_f(z) exp(qz)
+ *
+ *          Note that the upper limit of C_if⁻ is the point just BEFORE each
+ *          z' so that we don't double count.
+ *
+ *          Therefore, we have separated the z' dependence from the
+ *          z dependence of the matrix element.  The cumulative integrals
+ *          only need to run as far as the outermost doped points, and the
+ *          matrix element is only evaluated within the doped segments.
+ */
+double ScatteringCalculatorImpurity::get_J_segments(const double       q,
+                                                    const unsigned int i,
+                                                    const unsigned int f) const
+{
+    const auto z  = _subbands[i].z_array();
+    const auto nz = z.size();
+    const auto dz = z[1] - z[0];
+
+    const auto &psi_if = get_psi_product(i,f);
+
+    const auto iz_first = _segments.front().iz_start;
+    const auto iz_last  = _segments.back().iz_stop;
+
+    // Use the first point as the origin, so as to minimise the
+    // magnitude of the exponential terms
+    const arma::vec expTerm = exp(q * (z - z[0]));
+
+    // C_if⁺ is only needed from the first doped point onwards
+    arma::vec Cif_plus(nz);
+    double Cp = 0.0;
+
+    for(int iz = nz-1; iz >= (int)iz_first; --iz)
+    {
+        Cp += psi_if[iz] / expTerm[iz] * dz;
+        Cif_plus[iz] = Cp;
+    }
+
+    // C_if⁻ is only needed up to the last doped point
+    double Cif_minus = 0.0;
+    unsigned int iz  = 0;
+    double J = 0.0;
+
+    for(const auto &seg : _segments)
+    {
+        for(; iz < seg.iz_start; ++iz)
+            Cif_minus += psi_if[iz] * expTerm[iz] * dz;
+
+        for(; iz <= seg.iz_stop; ++iz)
+        {
+            const double Iif = Cif_minus/expTerm[iz] + Cif_plus[iz]*expTerm[iz];
+            J += Iif * Iif * _wd[iz];
+
+            if(iz < iz_last)
+                Cif_minus += psi_if[iz] * expTerm[iz] * dz;
+        }
+    }
+
+    return J;
+}
+
+/**
+ * \brief Find the overlap integral for a set of delta-doped sheets
+ */
+double ScatteringCalculatorImpurity::get_J_sheets(const double       q,
+                                                  const unsigned int i,
+                                                  const unsigned int f) const
+{
+    const auto z  = _subbands[i].z_array();
+    const auto dz = z[1] - z[0];
+
+    const auto &psi_if = get_psi_product(i,f);
+
+    double J = 0.0;
+
+    for(const auto &sheet : _sheets)
+    {
+        const double Iif = arma::accu(psi_if % exp(-q * abs(z - sheet.z))) * dz;
+        J += sheet.Ns * Iif * Iif;
+    }
+
+    return J;
+}
+
+/**
+ * \brief Find the largest scattering vector needed for a transition [1/m]
+ */
+double ScatteringCalculatorImpurity::get_q_max(const unsigned int i,
+                                               const unsigned int f) const
+{
+    const auto &isb = _subbands[i];
+    const double kimax = isb.get_k_at_Ek(get_Eki_cutoff(i,f)*1.1); // Max value of ki [1/m]
+    const double Ei = isb.get_E_min();
+    const double Ef = _subbands[f].get_E_min();
+    const double kfmax_sqr = kimax*kimax + 2*_m*(Ei - Ef)/(hBar*hBar);
+    const double kfmax = (kfmax_sqr > 0.0) ? sqrt(kfmax_sqr) : 0.0;
+
+    return kimax + kfmax;
+}
+
+/**
+ * \brief Compute the screened form factor Jif/(q+q_TF)^2 on a uniform grid of q
+ */
+arma::vec ScatteringCalculatorImpurity::make_pair_data(const unsigned int i,
+                                                       const unsigned int f) const
+{
+    const double dq = get_q_max(i,f)/((float)(_nq-1)); // interval in q_perp
+
+    // Thomas--Fermi screening wave-vector
+    double q_TF = 0.0;
+
+    // Allow screening to be turned off
+    if(_enable_screening)
+        q_TF = _m*e*e/(2*pi*_epsilon*hBar*hBar);
+
+    arma::vec FF(_nq);
+
+    for(unsigned int iq=0;iq<_nq;iq++)
+    {
+        const double q   = iq*dq;
+        const double Jif = get_J(q, i, f);
+
+        // Note that the pole at q_perp=0 is avoided as long as screening is included
+        FF[iq] = Jif / (q*q + q_TF*q_TF + 2*q*q_TF);
+    }
+
+    // Fix singularity by "clipping" the top off it:
+    if(!_enable_screening)
+        FF[0] = FF[1];
+
+    return FF;
+}
+
+/**
+ * \brief Get the cubic spline through the form-factor table for a transition
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The spline is built the first time that it is needed, and is then
+ *          shared by all threads.  The spline holds its own copy of the
+ *          table, so the returned pointer remains valid until the splines
+ *          are cleared.
+ */
+const gsl_spline * ScatteringCalculatorImpurity::get_spline(const unsigned int i,
+                                                            const unsigned int f) const
+{
+    const auto idx = std::make_pair(i,f);
+
+    {
+        std::lock_guard<std::mutex> lock(_splines->mutex);
+        const auto it = _splines->table.find(idx);
+
+        if(it != _splines->table.end())
+            return it->second.get();
+    }
+
+    const auto &FF = get_pair_data(i,f);
+    const arma::vec q = arma::linspace(0, get_q_max(i,f), _nq);
+
+    std::shared_ptr<gsl_spline> spline(gsl_spline_alloc(gsl_interp_cspline, _nq), gsl_spline_free);
+    gsl_spline_init(spline.get(), q.memptr(), FF.memptr(), _nq);
+
+    // If another thread has built the same spline in the meantime,
+    // this just returns the existing one
+    std::lock_guard<std::mutex> lock(_splines->mutex);
+    return _splines->table.insert(std::make_pair(idx, spline)).first->second.get();
+}
+
+/**
+ * \brief Remove all form-factor splines
+ *
+ * \details This must be called whenever the form-factor tables are cleared
+ */
+void ScatteringCalculatorImpurity::clear_splines()
+{
+    std::lock_guard<std::mutex> lock(_splines->mutex);
+    _splines->table.clear();
+}
+
+/**
+ * \brief Find the scattering rate between a pair of wave-vectors [1/s]
+ *
+ * \details The form factor is interpolated using the cached spline for the
+ *          transition.  Each thread uses its own lookup accelerator, so that
+ *          this is safe to call from several threads at once.
+ */
+double ScatteringCalculatorImpurity::get_rate_ki_kf(const unsigned int i,
+                                                    const unsigned int f,
+                                                    const double       ki,
+                                                    const double       kf) const
+{
+    const auto q_max = get_q_max(i,f);
+
+    if(ki + kf > q_max)
+    {
+        std::ostringstream oss;
+        oss << "Initial wave-vector " << ki << " m^{-1} lies beyond the tabulated form factor.";
+        throw std::domain_error(oss.str());
+    }
+
+    const gsl_spline *spline = get_spline(i,f);
+
+    // The accelerator only caches the last interval that was found, so it
+    // can be reused between splines once it has been reset
+    static thread_local std::unique_ptr<gsl_interp_accel, void (*)(gsl_interp_accel *)>
+        acc(gsl_interp_accel_alloc(), gsl_interp_accel_free);
+    gsl_interp_accel_reset(acc.get());
+
+    const double ki_sqr_plus_kf_sqr = ki*ki + kf*kf;
+    const double two_kif            = 2*ki*kf;
+
+    arma::vec Wif_integrand_theta(_ntheta);
+
+    for(unsigned int itheta=0;itheta<_ntheta;itheta++)
+    {
+        // Calculate scattering vector
+        const double q_sqr = ki_sqr_plus_kf_sqr + two_kif * _cos_theta[itheta];
+        const double q_theta = (q_sqr > 0.0) ? sqrt(q_sqr) : 0.0;
+
+        // Find the form-factor at this wave-vector by looking it up in the
+        // spline
+        Wif_integrand_theta[itheta] = gsl_spline_eval(spline, q_theta, acc.get());
+    }
+
+    return _prefactor*integral(Wif_integrand_theta, _dtheta);
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
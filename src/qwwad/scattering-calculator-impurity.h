@@ -0,0 +1,119 @@
+/**
+ * \file   scattering-calculator-impurity.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Calculator for ionised-impurity scattering rates
+ */
+
+#ifndef QWWAD_SCATTERING_CALCULATOR_IMPURITY
+#define QWWAD_SCATTERING_CALCULATOR_IMPURITY
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <gsl/gsl_spline.h>
+#include "scattering-calculator-elastic.h"
+
+namespace QWWAD {
+/**
+ * \brief A calculator for ionised-impurity scattering rates
+ *
+ * \details The screened form factor \f$J_{if}(q)/(q+q_{TF})^2\f$ for each
+ *          transition is tabulated on a uniform grid of scattering vectors
+ *          and cached.  A cubic spline through this table is built once for
+ *          each transition, and the rate at each wave-vector is then found by
+ *          interpolation.
+ *
+ *          The doping profile is compressed into contiguous doped segments
+ *          when the calculator is created, so that the form factor is only
+ *          evaluated at doped points.  Alternatively, each segment may be
+ *          treated as a delta-doped sheet of charge at its centroid.
+ */
+class ScatteringCalculatorImpurity : public ScatteringCalculatorElastic {
+private:
+    /// A contiguous range of doped points
+    struct DopedSegment {
+        unsigned int iz_start; ///< Index of first doped point
+        unsigned int iz_stop;  ///< Index of last doped point
+    };
+
+    /// A delta-doped sheet of charge
+    struct DopingSheet {
+        double z;  ///< Location of sheet [m]
+        double Ns; ///< Sheet doping density [m^{-2}]
+    };
+
+    /// A thread-safe table of form-factor splines for each pair of subbands
+    struct SplineTable {
+        std::map<std::pair<unsigned int, unsigned int>, std::shared_ptr<gsl_spline>> table;
+        std::mutex mutex; ///< Guards insertion into the table
+    };
+
+    arma::vec _d;       ///< Volume doping density at each point [m^{-3}]
+    double    _epsilon; ///< Low-frequency permittivity [F/m]
+
+    bool _enable_screening;   ///< Allow screening
+    bool _enable_sheet_model; ///< Treat each doped segment as a sheet
+
+    // Precision parameters
+    size_t _nq;     ///< Number of scattering vector samples
+    size_t _ntheta; ///< Number of scattering angle samples
+
+    // Derived properties
+    double    _prefactor; ///< Pre-factor for rates
+    double    _dtheta;    ///< Step size in scattering angle [rad]
+    arma::vec _cos_theta; ///< Cosine of each scattering angle sample
+
+    arma::vec                 _wd;       ///< Quadrature weight times doping at each point [m^{-2}]
+    std::vector<DopedSegment> _segments; ///< Doped segments of the structure
+    std::vector<DopingSheet>  _sheets;   ///< Equivalent sheet for each segment
+
+    std::shared_ptr<SplineTable> _splines; ///< Interpolated form factor for each transition
+
+    double get_J_segments(const double       q,
+                          const unsigned int i,
+                          const unsigned int f) const;
+
+    double get_J_sheets(const double       q,
+                        const unsigned int i,
+                        const unsigned int f) const;
+
+    double get_q_max(const unsigned int i,
+                     const unsigned int f) const;
+
+    const gsl_spline * get_spline(const unsigned int i,
+                                  const unsigned int f) const;
+
+    void clear_splines();
+
+protected:
+    arma::vec make_pair_data(const unsigned int i,
+                             const unsigned int f) const;
+
+    double get_rate_ki_kf(const unsigned int i,
+                          const unsigned int f,
+                          const double       ki,
+                          const double       kf) const;
+
+public:
+    ScatteringCalculatorImpurity(const std::vector<Subband> &subbands,
+                                 const arma::vec            &d,
+                                 const double                epsilon,
+                                 const double                m,
+                                 const double                Te);
+
+    double get_J(const double       q,
+                 const unsigned int i,
+                 const unsigned int f) const;
+
+    void set_q_samples    (const decltype(_nq)     nq);
+    void set_theta_samples(const decltype(_ntheta) ntheta);
+    void enable_screening (const bool enabled);
+    void enable_sheet_model(const bool enabled);
+
+    /// Get the number of contiguous doped segments in the structure
+    size_t get_n_doped_segments() const {return _segments.size();}
+};
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
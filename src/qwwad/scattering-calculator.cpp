@@ -0,0 +1,524 @@
+/**
+ * \file   scattering-calculator.cpp
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Base class for intersubband scattering-rate calculators
+ */
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "scattering-calculator.h"
+#include "constants.h"
+#include "maths-helpers.h"
+
+namespace QWWAD {
+/**
+ * \brief Initialise a scattering calculation for a 2D system
+ *
+ * \param[in] subbands The energy subbands in the system
+ * \param[in] nki      Number of initial wave-vector samples for each transition
+ */
+ScatteringCalculator::ScatteringCalculator(const std::vector<Subband> &subbands,
+                                           const size_t                nki) :
+    _pair_data(std::make_shared<PairTable>()),
+    _psi_products(std::make_shared<PairTable>()),
+    _subbands(subbands),
+    _nki(nki)
+{}
+
+/**
+ * \brief Get the cached data for a transition
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The data is generated if it doesn't already exist.  The
+ *          calculation itself is done outside the lock, so that data for
+ *          different transitions can be generated concurrently.  The
+ *          returned reference remains valid until the cache is cleared.
+ */
+const arma::vec & ScatteringCalculator::get_pair_data(const unsigned int i,
+                                                      const unsigned int f) const
+{
+    const auto idx = std::make_pair(i,f);
+
+    {
+        std::lock_guard<std::mutex> lock(_pair_data->mutex);
+        const auto it = _pair_data->table.find(idx);
+
+        if(it != _pair_data->table.end())
+            return it->second;
+    }
+
+    const auto data = make_pair_data(i,f);
+
+    // If another thread has inserted the same data in the meantime,
+    // this just returns the existing entry
+    std::lock_guard<std::mutex> lock(_pair_data->mutex);
+    return _pair_data->table.insert(std::make_pair(idx, data)).first->second;
+}
+
+/**
+ * \brief Supply precomputed data for a transition
+ *
+ * \param[in] i    Initial subband index
+ * \param[in] f    Final subband index
+ * \param[in] data The data to store
+ *
+ * \details Any existing data for the transition is replaced
+ */
+void ScatteringCalculator::set_pair_data(const unsigned int  i,
+                                         const unsigned int  f,
+                                         const arma::vec    &data)
+{
+    std::lock_guard<std::mutex> lock(_pair_data->mutex);
+    _pair_data->table[std::make_pair(i,f)] = data;
+}
+
+/**
+ * \brief Remove all cached data for transitions
+ *
+ * \details This should be called whenever a parameter changes that would
+ *          affect the output of make_pair_data().
+ */
+void ScatteringCalculator::clear_pair_data()
+{
+    std::lock_guard<std::mutex> lock(_pair_data->mutex);
+    _pair_data->table.clear();
+}
+
+/**
+ * \brief Get the product of the wavefunctions for a pair of subbands [1/m]
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ */
+const arma::vec & ScatteringCalculator::get_psi_product(const unsigned int i,
+                                                        const unsigned int f) const
+{
+    // The product is symmetric, so only store one ordering
+    const auto idx = (i <= f) ? std::make_pair(i,f) : std::make_pair(f,i);
+
+    {
+        std::lock_guard<std::mutex> lock(_psi_products->mutex);
+        const auto it = _psi_products->table.find(idx);
+
+        if(it != _psi_products->table.end())
+            return it->second;
+    }
+
+    const arma::vec psi_if = _subbands[i].psi_array() % _subbands[f].psi_array();
+
+    std::lock_guard<std::mutex> lock(_psi_products->mutex);
+    return _psi_products->table.insert(std::make_pair(idx, psi_if)).first->second;
+}
+
+/**
+ * \brief Use the same table of wavefunction products as another calculator
+ *
+ * \param[in] other The calculator whose table should be shared
+ *
+ * \details Both calculators must have been created with the same set of subbands
+ */
+void ScatteringCalculator::share_psi_products(const ScatteringCalculator &other)
+{
+    if(other._subbands.size() != _subbands.size())
+        throw std::invalid_argument("Cannot share wavefunction products between different systems");
+
+    _psi_products = other._psi_products;
+}
+
+/**
+ * \brief Use the same table of cached transition data as another calculator
+ *
+ * \param[in] other The calculator whose table should be shared
+ *
+ * \details This is only valid if both calculators would generate identical
+ *          data for each transition, e.g., emission and absorption
+ *          calculators for the same phonon mode.  Clearing the cache in
+ *          either calculator clears it for both.
+ */
+void ScatteringCalculator::share_pair_data(const ScatteringCalculator &other)
+{
+    if(other._subbands.size() != _subbands.size())
+        throw std::invalid_argument("Cannot share transition data between different systems");
+
+    _pair_data = other._pair_data;
+}
+
+/**
+ * \brief Find the initial wave-vector at which a transition first becomes allowed [1/m]
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details This is the lowest threshold given by get_ki_thresholds(), or zero
+ *          if the mechanism has no threshold.
+ */
+double ScatteringCalculator::get_ki_onset(const unsigned int i,
+                                          const unsigned int f) const
+{
+    const auto ki_thresholds = get_ki_thresholds(i,f);
+
+    if(ki_thresholds.empty())
+        return 0.0;
+
+    return std::max(0.0, ki_thresholds.min());
+}
+
+/**
+ * \brief Find the scattering rates at a set of initial wave-vectors [1/s]
+ *
+ * \param[in] i  Initial subband index
+ * \param[in] f  Final subband index
+ * \param[in] ki Initial wave vectors [1/m]
+ *
+ * \details The default simply calls get_rate_ki() for each wave-vector.
+ *          Subclasses may override this to look up their cached data once
+ *          for the whole set, rather than once per wave-vector.
+ */
+arma::vec ScatteringCalculator::get_rates_ki(const unsigned int  i,
+                                             const unsigned int  f,
+                                             const arma::vec    &ki) const
+{
+    arma::vec Wif(ki.size());
+
+    for(unsigned int iki = 0; iki < ki.size(); ++iki)
+        Wif[iki] = get_rate_ki(i, f, ki[iki]);
+
+    return Wif;
+}
+
+/**
+ * \brief Generate the cached data for a set of transitions
+ *
+ * \param[in] i_indices Initial subband index for each transition
+ * \param[in] f_indices Final subband index for each transition
+ *
+ * \details The transitions are shared between all available threads
+ */
+void ScatteringCalculator::prepare(const arma::uvec &i_indices,
+                                   const arma::uvec &f_indices) const
+{
+    const size_t ntx = i_indices.size();
+
+    if(f_indices.size() != ntx)
+        throw std::length_error("Initial and final subband index lists have different lengths");
+
+    std::exception_ptr error; // Stores any exception thrown inside the parallel region
+
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        try
+        {
+            get_pair_data(i_indices[itx], f_indices[itx]);
+        }
+        catch(...)
+        {
+#pragma omp critical
+            error = std::current_exception();
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+/**
+ * \brief Find the scattering rates for a set of transitions at given wave-vectors
+ *
+ * \param[in] i_indices Initial subband index for each transition
+ * \param[in] f_indices Final subband index for each transition
+ * \param[in] ki        Initial wave-vectors [1/m].  Each column contains the
+ *                      samples for one transition
+ *
+ * \details Every transition, and every block of wave-vectors within it, is
+ *          shared out between all available threads.
+ *
+ * \returns The scattering rate at each wave-vector [1/s], with the same layout as ki
+ */
+arma::mat ScatteringCalculator::get_rate_tables(const arma::uvec &i_indices,
+                                                const arma::uvec &f_indices,
+                                                const arma::mat  &ki) const
+{
+    const size_t ntx = i_indices.size();
+    const size_t nki = ki.n_rows;
+
+    if(ki.n_cols != ntx)
+    {
+        std::ostringstream oss;
+        oss << "Wave-vector table has " << ki.n_cols << " columns, but "
+            << ntx << " transitions were requested.";
+        throw std::length_error(oss.str());
+    }
+
+    prepare(i_indices, f_indices);
+
+    arma::mat Wif(nki, ntx); // Scattering rate at each wave-vector [1/s]
+    std::exception_ptr error;
+
+    // Each task handles a short block of wave-vectors, so that the cached
+    // data for a transition is looked up once per block
+    const size_t block_size = 16;
+    const size_t nblocks    = (nki + block_size - 1)/block_size;
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        for(unsigned int iblock = 0; iblock < nblocks; ++iblock)
+        {
+            try
+            {
+                const size_t first = iblock*block_size;
+                const size_t last  = std::min(first + block_size, nki) - 1;
+                const arma::vec ki_block = ki(arma::span(first, last), itx);
+                Wif(arma::span(first, last), itx) = get_rates_ki(i_indices[itx], f_indices[itx],
+                                                                 ki_block);
+            }
+            catch(...)
+            {
+#pragma omp critical
+                error = std::current_exception();
+            }
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+
+    return Wif;
+}
+
+/**
+ * \brief Returns the entire scattering table for an intersubband transition
+ *
+ * \param[in] i Initial subband index
+ * \param[in] f Final subband index
+ *
+ * \details The rates at each initial wave-vector are computed in parallel
+ */
+IntersubbandTransition ScatteringCalculator::get_transition(const unsigned int i,
+                                                            const unsigned int f) const
+{
+    arma::uvec i_indices(1);
+    arma::uvec f_indices(1);
+    i_indices[0] = i;
+    f_indices[0] = f;
+
+    return get_transitions(i_indices, f_indices)[0];
+}
+
+/**
+ * \brief Returns the scattering tables for a set of intersubband transitions
+ *
+ * \param[in] i_indices Initial subband index for each transition
+ * \param[in] f_indices Final subband index for each transition
+ *
+ * \details Subbands are indexed from zero.  The cached data for all
+ *          transitions are generated first, and then the rates for every
+ *          (transition, wave-vector) pair are shared out between all
+ *          available threads.
+ *
+ * \returns The transitions, in the same order as the indices
+ */
+std::vector<IntersubbandTransition>
+ScatteringCalculator::get_transitions(const arma::uvec &i_indices,
+                                      const arma::uvec &f_indices) const
+{
+    const size_t ntx = i_indices.size();
+
+    if(f_indices.size() != ntx)
+        throw std::length_error("Initial and final subband index lists have different lengths");
+
+    arma::mat ki(_nki, ntx); // Initial wave vectors [1/m]
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+        ki.col(itx) = make_ki_table(i_indices[itx], f_indices[itx]);
+
+    const auto Wif = get_rate_tables(i_indices, f_indices, ki);
+
+    std::vector<IntersubbandTransition> transitions;
+    transitions.reserve(ntx);
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        const auto &isb = _subbands[i_indices[itx]];
+        const auto &fsb = _subbands[f_indices[itx]];
+        const arma::vec ki_tx  = ki.col(itx);
+        const arma::vec Wif_tx = Wif.col(itx);
+        transitions.push_back(IntersubbandTransition(isb, fsb, ki_tx, Wif_tx));
+    }
+
+    return transitions;
+}
+
+/**
+ * \brief Find the thermally-averaged scattering rate using adaptive quadrature
+ *
+ * \param[in] i         Initial subband index
+ * \param[in] f         Final subband index
+ * \param[in] ki_min    Lower limit of initial wave-vector [1/m]
+ * \param[in] ki_max    Upper limit of initial wave-vector [1/m]
+ * \param[in] tolerance Relative tolerance for the integral
+ *
+ * \details The rate is weighted by the occupation of the initial states, as in
+ *          IntersubbandTransition::get_average_rate.  Rather than using a
+ *          fixed grid of wave-vectors, the integral is refined automatically
+ *          until it reaches the desired tolerance.  Any thresholds within the
+ *          range are used as breakpoints, so that the onset of scattering
+ *          doesn't need to be found by refinement.
+ *
+ *          A warning is written if the integral does not reach the
+ *          tolerance, e.g., because of an unresolved discontinuity.
+ *
+ * \returns The average scattering rate [1/s]
+ */
+double ScatteringCalculator::get_average_rate(const unsigned int i,
+                                              const unsigned int f,
+                                              const double       ki_min,
+                                              const double       ki_max,
+                                              const double       tolerance) const
+{
+    const auto &isb = _subbands[i];
+
+    // Breakpoints for the integral, including any thresholds within the range
+    std::vector<double> breakpoints = {ki_min};
+
+    for(const auto ki_threshold : get_ki_thresholds(i,f))
+    {
+        if(ki_threshold > ki_min && ki_threshold < ki_max)
+            breakpoints.push_back(ki_threshold);
+    }
+
+    breakpoints.push_back(ki_max);
+    std::sort(breakpoints.begin(), breakpoints.end());
+
+    const auto Wbar_integrand_ki = [this, i, f, &isb](const double ki) -> double {
+        return get_rate_ki(i, f, ki)*ki*isb.get_occupation_at_k(ki);
+    };
+
+    bool converged = true;
+    const auto N = isb.get_total_population();
+    const auto Wbar = integral_adaptive(Wbar_integrand_ki, arma::vec(breakpoints), tolerance,
+                                        30, 100000, &converged)/(constants::pi*N);
+
+    // Write the warning in one go, since this may be called from several threads
+    if(!converged)
+    {
+        std::ostringstream oss;
+        oss << "Warning: average rate for transition " << i+1 << " -> " << f+1
+            << " did not reach relative tolerance " << tolerance << std::endl;
+        std::cerr << oss.str();
+    }
+
+    return Wbar;
+}
+
+/**
+ * \brief Find the thermally-averaged scattering rate using adaptive quadrature
+ *
+ * \param[in] i         Initial subband index
+ * \param[in] f         Final subband index
+ * \param[in] tolerance Relative tolerance for the integral
+ *
+ * \details The range of initial wave-vectors is the same as that used in
+ *          get_transition()
+ *
+ * \returns The average scattering rate [1/s]
+ */
+double ScatteringCalculator::get_average_rate(const unsigned int i,
+                                              const unsigned int f,
+                                              const double       tolerance) const
+{
+    const auto ki = make_ki_table(i,f);
+    return get_average_rate(i, f, ki[0], ki[ki.size()-1], tolerance);
+}
+
+/**
+ * \brief Find the thermally-averaged scattering rates for a set of transitions
+ *
+ * \param[in] i_indices Initial subband index for each transition
+ * \param[in] f_indices Final subband index for each transition
+ * \param[in] ki_min    Lower limit of initial wave-vector for each transition [1/m]
+ * \param[in] ki_max    Upper limit of initial wave-vector for each transition [1/m]
+ * \param[in] tolerance Relative tolerance for each integral
+ *
+ * \details The transitions are shared between all available threads
+ *
+ * \returns The average scattering rate for each transition [1/s]
+ */
+arma::vec ScatteringCalculator::get_average_rates(const arma::uvec &i_indices,
+                                                  const arma::uvec &f_indices,
+                                                  const arma::vec  &ki_min,
+                                                  const arma::vec  &ki_max,
+                                                  const double      tolerance) const
+{
+    const size_t ntx = i_indices.size();
+
+    if(ki_min.size() != ntx || ki_max.size() != ntx)
+        throw std::length_error("Wave-vector limits must be given for every transition");
+
+    prepare(i_indices, f_indices);
+
+    arma::vec Wbar(ntx);
+    std::exception_ptr error;
+
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        try
+        {
+            Wbar[itx] = get_average_rate(i_indices[itx], f_indices[itx],
+                                         ki_min[itx], ki_max[itx], tolerance);
+        }
+        catch(...)
+        {
+#pragma omp critical
+            error = std::current_exception();
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+
+    return Wbar;
+}
+
+/**
+ * \brief Find the thermally-averaged scattering rates for a set of transitions
+ *
+ * \param[in] i_indices Initial subband index for each transition
+ * \param[in] f_indices Final subband index for each transition
+ * \param[in] tolerance Relative tolerance for each integral
+ *
+ * \details The range of initial wave-vectors for each transition is the same
+ *          as that used in get_transitions()
+ *
+ * \returns The average scattering rate for each transition [1/s]
+ */
+arma::vec ScatteringCalculator::get_average_rates(const arma::uvec &i_indices,
+                                                  const arma::uvec &f_indices,
+                                                  const double      tolerance) const
+{
+    const size_t ntx = i_indices.size();
+
+    if(f_indices.size() != ntx)
+        throw std::length_error("Initial and final subband index lists have different lengths");
+
+    arma::vec ki_min(ntx);
+    arma::vec ki_max(ntx);
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        const auto ki = make_ki_table(i_indices[itx], f_indices[itx]);
+        ki_min[itx] = ki[0];
+        ki_max[itx] = ki[ki.size()-1];
+    }
+
+    return get_average_rates(i_indices, f_indices, ki_min, ki_max, tolerance);
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
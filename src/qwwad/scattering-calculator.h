@@ -0,0 +1,163 @@
+/**
+ * \file   scattering-calculator.h
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ * \brief  Base class for intersubband scattering-rate calculators
+ */
+
+#ifndef QWWAD_SCATTERING_CALCULATOR
+#define QWWAD_SCATTERING_CALCULATOR
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "subband.h"
+#include "intersubband-transition.h"
+
+namespace QWWAD {
+/**
+ * \brief A generic calculator for scattering rates between pairs of subbands
+ *
+ * \details Each scattering mechanism is implemented as a subclass, which
+ *          supplies the rate at a given initial wave-vector and a sensible
+ *          table of initial wave-vectors for each transition.  This class
+ *          provides the shared machinery for evaluating whole transitions in
+ *          parallel.
+ *
+ *          Any data that depends only on the pair of subbands (e.g., form
+ *          factors) is generated on demand by make_pair_data(), and cached so
+ *          that it is computed only once.  Products of wavefunctions are
+ *          cached too, and the cache can be shared between calculators for
+ *          different mechanisms.
+ *
+ *          All const member functions may be called concurrently from
+ *          several threads.  Non-const functions must not be called while a
+ *          calculation is running.
+ */
+class ScatteringCalculator {
+private:
+    typedef std::pair<unsigned int, unsigned int> map_key;
+
+    /// A thread-safe table of data for each pair of subbands
+    struct PairTable {
+        std::map<map_key, arma::vec> table; ///< Data for each (initial, final) subband pair
+        std::mutex                   mutex; ///< Guards insertion into the table
+    };
+
+    std::shared_ptr<PairTable> _pair_data;    ///< Mechanism-specific data for each transition
+    std::shared_ptr<PairTable> _psi_products; ///< Products of wavefunctions for each transition
+
+protected:
+    std::vector<Subband> _subbands; ///< The energy subbands in the system
+    size_t               _nki;      ///< Number of initial wave-vector samples
+
+    /**
+     * \brief Generate the cached data for a transition
+     *
+     * \details Subclasses override this to compute anything that is needed
+     *          repeatedly for a given pair of subbands, such as form factors.
+     *          The default is an empty table.
+     */
+    virtual arma::vec make_pair_data(const unsigned int /* i */,
+                                     const unsigned int /* f */) const {return arma::vec();}
+
+    /**
+     * \brief Generate a table of initial wave-vectors for a transition [1/m]
+     */
+    virtual arma::vec make_ki_table(const unsigned int i,
+                                    const unsigned int f) const = 0;
+
+    /**
+     * \brief Find the initial wave-vectors at which scattering switches on [1/m]
+     *
+     * \details These are used as breakpoints for adaptive integration over
+     *          the initial wave-vector, so that the sharp onset of each
+     *          process is resolved properly.  The default is an empty list.
+     */
+    virtual arma::vec get_ki_thresholds(const unsigned int /* i */,
+                                        const unsigned int /* f */) const {return arma::vec();}
+
+    const arma::vec & get_pair_data(const unsigned int i,
+                                    const unsigned int f) const;
+
+    void set_pair_data(const unsigned int  i,
+                       const unsigned int  f,
+                       const arma::vec    &data);
+
+    void clear_pair_data();
+
+public:
+    ScatteringCalculator(const std::vector<Subband> &subbands,
+                         const size_t                nki);
+
+    virtual ~ScatteringCalculator() {}
+
+    /**
+     * \brief Find the total scattering rate at a given initial wave-vector [1/s]
+     *
+     * \param[in] i  Initial subband index
+     * \param[in] f  Final subband index
+     * \param[in] ki Initial wave vector [1/m]
+     *
+     * \details Implementations must return zero for any wave-vector at which
+     *          scattering is forbidden, and must be safe to call from several
+     *          threads at once.
+     */
+    virtual double get_rate_ki(const unsigned int i,
+                               const unsigned int f,
+                               const double       ki) const = 0;
+
+    double get_ki_onset(const unsigned int i,
+                        const unsigned int f) const;
+
+    virtual arma::vec get_rates_ki(const unsigned int  i,
+                                   const unsigned int  f,
+                                   const arma::vec    &ki) const;
+
+    void prepare(const arma::uvec &i_indices,
+                 const arma::uvec &f_indices) const;
+
+    arma::mat get_rate_tables(const arma::uvec &i_indices,
+                              const arma::uvec &f_indices,
+                              const arma::mat  &ki) const;
+
+    IntersubbandTransition get_transition(const unsigned int i,
+                                          const unsigned int f) const;
+
+    std::vector<IntersubbandTransition> get_transitions(const arma::uvec &i_indices,
+                                                        const arma::uvec &f_indices) const;
+
+    double get_average_rate(const unsigned int i,
+                            const unsigned int f,
+                            const double       ki_min,
+                            const double       ki_max,
+                            const double       tolerance) const;
+
+    double get_average_rate(const unsigned int i,
+                            const unsigned int f,
+                            const double       tolerance) const;
+
+    arma::vec get_average_rates(const arma::uvec &i_indices,
+                                const arma::uvec &f_indices,
+                                const arma::vec  &ki_min,
+                                const arma::vec  &ki_max,
+                                const double      tolerance) const;
+
+    arma::vec get_average_rates(const arma::uvec &i_indices,
+                                const arma::uvec &f_indices,
+                                const double      tolerance) const;
+
+    const arma::vec & get_psi_product(const unsigned int i,
+                                      const unsigned int f) const;
+
+    void share_psi_products(const ScatteringCalculator &other);
+    void share_pair_data   (const ScatteringCalculator &other);
+
+    inline void set_ki_samples(const decltype(_nki) nki) {_nki = nki;}
+
+    inline const decltype(_subbands) & get_subbands() const {return _subbands;}
+};
+} // namespace
+#endif
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
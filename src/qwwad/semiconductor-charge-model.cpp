@@ -0,0 +1,164 @@
+/**
+ * \file   semiconductor-charge-model.cpp
+ * \brief  Charge density in a doped semiconductor as a function of potential
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "semiconductor-charge-model.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <gsl/gsl_sf_fermi_dirac.h>
+#include "constants.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Initialise the charge model
+ *
+ * \param[in] V   Band-edge potential at each point, without space charge [J]
+ * \param[in] N_D Donor density at each point [m^{-3}]
+ * \param[in] m   Effective mass in conduction band [kg]
+ * \param[in] T   Temperature [K]
+ * \param[in] E_F Electron quasi-Fermi energy [J]
+ *
+ * \details By default, Fermi-Dirac statistics are used and all donors are
+ *          ionised.  The donor degeneracy is 2.
+ */
+SemiconductorChargeModel::SemiconductorChargeModel(const arma::vec &V,
+                                                   const arma::vec &N_D,
+                                                   const double     m,
+                                                   const double     T,
+                                                   const double     E_F) :
+    _V(V),
+    _N_D(N_D),
+    _N_c(2.0*pow(m*kB*T/(2.0*pi*hBar*hBar), 1.5)),
+    _T(T),
+    _E_F(E_F),
+    _E_b(0.0),
+    _g_D(2.0),
+    _fermi_dirac(true)
+{
+    if(_V.size() != _N_D.size())
+        throw std::length_error("Band-edge and doping profiles have different sizes");
+
+    if(_T <= 0)
+        throw std::domain_error("Temperature must be positive");
+}
+
+/**
+ * \brief Find the carrier densities at a point, and their derivatives
+ *
+ * \param[in]  iz             Index of point
+ * \param[in]  eta            Quasi-Fermi energy relative to band edge, divided by kT
+ * \param[out] n              Electron density [m^{-3}]
+ * \param[out] dn_deta        Derivative of electron density with respect to eta [m^{-3}]
+ * \param[out] N_D_plus       Ionised donor density [m^{-3}]
+ * \param[out] dN_D_plus_deta Derivative of ionised donor density with respect to eta [m^{-3}]
+ */
+void SemiconductorChargeModel::get_densities_at_point(const unsigned int  iz,
+                                                      const double        eta,
+                                                      double             &n,
+                                                      double             &dn_deta,
+                                                      double             &N_D_plus,
+                                                      double             &dN_D_plus_deta) const
+{
+    if(_fermi_dirac)
+    {
+        n       = _N_c*gsl_sf_fermi_dirac_half(eta);
+        dn_deta = _N_c*gsl_sf_fermi_dirac_mhalf(eta);
+    }
+    else
+    {
+        n       = _N_c*exp(eta);
+        dn_deta = n;
+    }
+
+    N_D_plus       = _N_D(iz);
+    dN_D_plus_deta = 0.0;
+
+    if(_E_b > 0.0 && _N_D(iz) != 0.0)
+    {
+        // Ionised fraction, written so that it stays finite in deep freeze-out
+        const double f = 1.0/(1.0 + _g_D*exp(eta + _E_b/(kB*_T)));
+        N_D_plus       = _N_D(iz)*f;
+        dN_D_plus_deta = -_N_D(iz)*f*(1.0 - f);
+    }
+}
+
+/**
+ * \brief Find the electron and ionised donor densities
+ *
+ * \param[in]  phi      Electrostatic potential at each point [V]
+ * \param[out] n        Electron density [m^{-3}]
+ * \param[out] N_D_plus Ionised donor density [m^{-3}]
+ */
+void SemiconductorChargeModel::get_densities(const arma::vec &phi,
+                                             arma::vec       &n,
+                                             arma::vec       &N_D_plus) const
+{
+    const auto nz = _V.size();
+
+    if(phi.size() != nz)
+        throw std::length_error("Potential and band-edge profiles have different sizes");
+
+    n.set_size(nz);
+    N_D_plus.set_size(nz);
+
+    for(unsigned int iz = 0; iz < nz; ++iz)
+    {
+        const double eta = (_E_F - (_V(iz) - e*phi(iz)))/(kB*_T);
+        double dn_deta;
+        double dN_D_plus_deta;
+        get_densities_at_point(iz, eta, n(iz), dn_deta, N_D_plus(iz), dN_D_plus_deta);
+    }
+}
+
+/**
+ * \brief Find the charge density for a given potential
+ *
+ * \param[in]  phi       Electrostatic potential at each point [V]
+ * \param[out] rho       Charge density at each point [C m^{-3}]
+ * \param[out] drho_dphi Derivative of charge density with respect to potential [C V^{-1} m^{-3}]
+ */
+void SemiconductorChargeModel::get_charge_density(const arma::vec &phi,
+                                                  arma::vec       &rho,
+                                                  arma::vec       &drho_dphi) const
+{
+    const auto nz = _V.size();
+
+    if(phi.size() != nz)
+        throw std::length_error("Potential and band-edge profiles have different sizes");
+
+    const double kT = kB*_T;
+    rho.set_size(nz);
+    drho_dphi.set_size(nz);
+
+    for(unsigned int iz = 0; iz < nz; ++iz)
+    {
+        // Reduced Fermi energy relative to local band edge
+        const double eta = (_E_F - (_V(iz) - e*phi(iz)))/kT;
+
+        double n;
+        double dn_deta;
+        double N_D_plus;
+        double dN_D_plus_deta;
+        get_densities_at_point(iz, eta, n, dn_deta, N_D_plus, dN_D_plus_deta);
+
+        // Note that d(eta)/d(phi) = e/kT
+        rho(iz)       = e*(N_D_plus - n);
+        drho_dphi(iz) = e*(dN_D_plus_deta - dn_deta)*e/kT;
+    }
+}
+
+/**
+ * \brief Potential over which the charge density changes significantly [V]
+ */
+double SemiconductorChargeModel::get_potential_scale() const
+{
+    return kB*_T/e;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,78 @@
+/**
+ * \file   semiconductor-charge-model.h
+ * \brief  Charge density in a doped semiconductor as a function of potential
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_SEMICONDUCTOR_CHARGE_MODEL_H
+#define QWWAD_SEMICONDUCTOR_CHARGE_MODEL_H
+
+#include <armadillo>
+#include "poisson-solver.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Charge density due to free electrons and ionised donors
+ *
+ * \details The conduction-band edge at each point is V_b - eφ, where V_b is
+ *          the band-edge potential without space charge.  Electrons fill
+ *          the 3D conduction band up to a fixed quasi-Fermi energy, using
+ *          either Fermi-Dirac or Boltzmann statistics.
+ *
+ *          Donors with binding energy E_b are ionised with probability
+ *
+ *            1/(1 + g exp[(E_F - E_c + E_b)/kT]),
+ *
+ *          where g is the ground-state degeneracy.  This describes freeze-out
+ *          at low temperature and in heavily doped regions.  If the binding
+ *          energy is zero, all donors are taken to be ionised.
+ */
+class SemiconductorChargeModel : public ChargeModel
+{
+private:
+    arma::vec _V;      ///< Band-edge potential without space charge [J]
+    arma::vec _N_D;    ///< Donor density [m^{-3}]
+    double    _N_c;    ///< Effective density of states in conduction band [m^{-3}]
+    double    _T;      ///< Temperature [K]
+    double    _E_F;    ///< Quasi-Fermi energy [J]
+    double    _E_b;    ///< Donor binding energy [J]
+    double    _g_D;    ///< Degeneracy of donor ground state
+    bool      _fermi_dirac; ///< Use Fermi-Dirac statistics for electrons
+
+    void get_densities_at_point(const unsigned int  iz,
+                                const double        eta,
+                                double             &n,
+                                double             &dn_deta,
+                                double             &N_D_plus,
+                                double             &dN_D_plus_deta) const;
+
+public:
+    SemiconductorChargeModel(const arma::vec &V,
+                             const arma::vec &N_D,
+                             const double     m,
+                             const double     T,
+                             const double     E_F);
+
+    void get_charge_density(const arma::vec &phi,
+                            arma::vec       &rho,
+                            arma::vec       &drho_dphi) const;
+
+    double get_potential_scale() const;
+
+    void get_densities(const arma::vec &phi,
+                       arma::vec       &n,
+                       arma::vec       &N_D_plus) const;
+
+    /// Set the binding energy of donors [J].  Zero gives complete ionisation
+    inline void set_donor_binding_energy(const double E_b) {_E_b = E_b;}
+
+    /// Set the degeneracy of the donor ground state
+    inline void set_donor_degeneracy(const double g_D) {_g_D = g_D;}
+
+    /// Use Fermi-Dirac statistics for electrons.  Otherwise, Boltzmann statistics are used
+    inline void enable_fermi_dirac(const bool enabled) {_fermi_dirac = enabled;}
+};
+} // namespace QWWAD
+#endif // QWWAD_SEMICONDUCTOR_CHARGE_MODEL_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -329,6 +329,39 @@ double Subband::get_Ek_at_k(double k) const
     return Ek;
 }
 
+/**
+ * \brief Find the kinetic energy at each of a set of wave-vectors
+ *
+ * \param[in]  k  In-plane wave vectors [1/m]
+ * \param[out] Ek Kinetic energy at each wave vector [J]
+ *
+ * \details The output array is resized only if needed, so a buffer can be
+ *          reused between calls.  The dispersion relation only fails above
+ *          some critical wave-vector, so its validity is checked once at the
+ *          largest wave-vector and the loop over samples has no branches.
+ */
+void Subband::get_Ek_at_k(const arma::vec &k,
+                          arma::vec       &Ek) const
+{
+    Ek.set_size(k.size());
+
+    if(k.is_empty())
+        return;
+
+    // Throws an exception if any sample has no valid solution
+    get_Ek_at_k(arma::abs(k).max());
+
+    const auto c = hBar*hBar/(2.0*_m);
+
+    if(_alpha == 0.0)
+        Ek = c*(k%k);
+    else
+    {
+        const auto b = 1.0 + _alpha*(get_E_min() - _V);
+        Ek = (arma::sqrt(b*b + 4.0*_alpha*c*(k%k)) - b)/(2.0*_alpha);
+    }
+}
+
 /**
  * Return the wavevector at some energy above subband minima
  *
@@ -354,6 +387,31 @@ double Subband::get_k_at_Ek(const double Ek) const
     return k;
 } 
 
+/**
+ * \brief Find the wave-vector at each of a set of kinetic energies
+ *
+ * \param[in]  Ek Kinetic energies above the subband minimum [J]
+ * \param[out] k  Wave vector at each energy [1/m]
+ *
+ * \details The output array is resized only if needed, so a buffer can be
+ *          reused between calls.
+ */
+void Subband::get_k_at_Ek(const arma::vec &Ek,
+                          arma::vec       &k) const
+{
+    k.set_size(Ek.size());
+
+    if(Ek.is_empty())
+        return;
+
+    // Throws an exception if any energy is negative
+    get_k_at_Ek(Ek.min());
+
+    // Energy-dependent effective mass, as in get_effective_mass()
+    const arma::vec m = _m*(1.0 + _alpha*(Ek + (get_E_min() - _V)));
+    k = arma::sqrt(2.0*Ek%m)/hBar;
+}
+
 /**
  * \brief Return 2D density of states for subband
  *
@@ -406,6 +464,30 @@ double Subband::get_occupation_at_k(const double k) const
     return get_occupation_at_E_total(E);
 }
 
+/**
+ * \brief Find the occupation probability at each of a set of wave vectors
+ *
+ * \param[in]  k    In-plane wave vectors [1/m]
+ * \param[out] f_FD Occupation probability at each wave vector
+ * \param[out] Ek   Kinetic energy at each wave vector [J]
+ *
+ * \details This gives the same result as calling the scalar version for
+ *          each sample, but the validity checks are done once for the
+ *          whole array.  The output arrays are resized only if needed.
+ */
+void Subband::get_occupation_at_k(const arma::vec &k,
+                                  arma::vec       &f_FD,
+                                  arma::vec       &Ek) const
+{
+    if(!_dist_known)
+        throw std::runtime_error("Distribution has not been set");
+
+    get_Ek_at_k(k, Ek);
+
+    f_FD.set_size(k.size());
+    f_FD = 1.0/(arma::exp((Ek + (get_E_min() - _Ef))/(kB*_Te)) + 1.0);
+}
+
 /**
  * \brief Get the total population of the subband
  *
@@ -54,6 +54,7 @@ public:
     inline double                      get_z_av_0() const {return _ground_state.get_expectation_position();}
 
     inline double                      get_Ef()     const {return _Ef;}
+    inline double                      get_Te()     const {return _Te;}
 
     /**
      * \brief Find energy of subband edge
@@ -97,7 +98,11 @@ public:
                                                const double       V);
 
     double get_Ek_at_k(const double k) const;
+    void   get_Ek_at_k(const arma::vec &k,
+                       arma::vec       &Ek) const;
     double get_k_at_Ek(const double Ek) const;
+    void   get_k_at_Ek(const arma::vec &Ek,
+                       arma::vec       &k) const;
     double get_k_max(const double Te) const;
 
     /// Return total energy of carrier at a given wave-vector
@@ -115,6 +120,10 @@ public:
        
     double get_occupation_at_k(const double k) const;
 
+    void get_occupation_at_k(const arma::vec &k,
+                             arma::vec       &f_FD,
+                             arma::vec       &Ek) const;
+
     double get_population_at_k(const double k) const;
 };
 } // namespace
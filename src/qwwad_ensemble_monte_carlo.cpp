@@ -0,0 +1,228 @@
+/**
+ * \file   qwwad_ensemble_monte_carlo.cpp
+ * \brief  Ensemble Monte Carlo simulation of in-plane carrier transport
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "qwwad/constants.h"
+#include "qwwad/ensemble-monte-carlo.h"
+#include "qwwad/file-io.h"
+#include "qwwad/options.h"
+#include "qwwad/subband.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+static Options configure_options(int argc, char* argv[])
+{
+    Options opt;
+
+    std::string doc("Simulate in-plane transport in a set of subbands using the ensemble Monte Carlo "
+                    "method.  Scattering rates are read from the per-transition tables written by "
+                    "the qwwad_sr_* programs (e.g., LOe01.r), which give the rate as a function of "
+                    "the total initial energy.");
+
+    opt.add_option<std::string>("mechanisms", "LOe:-36:0,LOa:36:0",
+                                                                "Comma-separated list of rate tables to use, each given as "
+                                                                "<prefix>:<energy gain [meV]>[:<first index>].  The rates "
+                                                                "for transition i→f are read from <prefix><i><f>.r, and "
+                                                                "any missing files are skipped.  Subbands are indexed "
+                                                                "from 1 unless another first index is given (e.g., 0 for "
+                                                                "the output of qwwad_sr_lo_phonon).");
+    opt.add_option<double>     ("mass,m",                0.067, "Band-edge effective mass (relative to free electron)");
+    opt.add_option<char>       ("particle,p",              'e', "ID of particle to be used: 'e', 'h' or 'l', for "
+                                                                "electrons, heavy holes or light holes respectively.");
+    opt.add_option<std::string>("populationfile",        "N.r", "File from which initial subband populations are read [m^{-2}]");
+    opt.add_option<double>     ("field,F",                 0.0, "In-plane electric field [kV/cm]");
+    opt.add_option<double>     ("Te",                      300, "Temperature of initial carrier distribution [K]");
+    opt.add_option<size_t>     ("nparticles,N",         100000, "Number of simulated carriers");
+    opt.add_option<double>     ("time,t",                   50, "Total simulation time [ps]");
+    opt.add_option<size_t>     ("nsamples",                500, "Number of sampling times.  Steady-state results are "
+                                                                "averaged over the second half.");
+    opt.add_option<double>     ("Emax",                         "Largest kinetic energy in rate tables [meV].  If not "
+                                                                "specified, the largest energy in any table is used.");
+    opt.add_option<size_t>     ("nE",                     1001, "Number of kinetic-energy samples in rate tables");
+    opt.add_option<size_t>     ("nhist",                   100, "Number of bins in kinetic-energy distribution");
+    opt.add_option<size_t>     ("seed",                         "Seed for random-number generator.  If given, the results "
+                                                                "are reproducible regardless of the number of threads.");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, doc);
+
+    return opt;
+}
+
+/// A table of scattering rates read from file
+struct RateFile {
+    unsigned int i;  ///< Initial subband index
+    unsigned int f;  ///< Final subband index
+    double       dE; ///< Energy gained by carrier [J]
+    arma::vec    Ek; ///< Initial kinetic energy [J]
+    arma::vec    W;  ///< Scattering rate [1/s]
+};
+
+int main(int argc, char* argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    const auto m = opt.get_option<double>("mass")*me;
+    const auto p = opt.get_option<char>("particle");
+
+    std::ostringstream E_filename; // Energy filename string
+    E_filename << "E" << p << ".r";
+    std::ostringstream wf_prefix;  // Wavefunction filename prefix
+    wf_prefix << "wf_" << p;
+
+    const auto subbands = Subband::read_from_file(E_filename.str(),
+                                                  wf_prefix.str(),
+                                                  ".r",
+                                                  m);
+    const auto nst = subbands.size();
+
+    // Initial populations [m^{-2}]
+    arma::vec pop0;
+    read_table(opt.get_option<std::string>("populationfile"), pop0);
+
+    if(pop0.size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Population file contains " << pop0.size() << " subbands, but " << E_filename.str()
+            << " contains " << nst << ".";
+        throw std::length_error(oss.str());
+    }
+
+    // Read all of the available rate tables
+    std::vector<RateFile> rate_files;
+    double Ek_max_tables = 0.0;
+    std::istringstream mechanism_list(opt.get_option<std::string>("mechanisms"));
+    std::string mechanism;
+
+    while(std::getline(mechanism_list, mechanism, ','))
+    {
+        const auto colon = mechanism.find(':');
+
+        if(colon == std::string::npos)
+        {
+            std::ostringstream oss;
+            oss << "Mechanism '" << mechanism << "' should be given as <prefix>:<energy gain>";
+            throw std::invalid_argument(oss.str());
+        }
+
+        const auto prefix = mechanism.substr(0, colon);
+        const auto colon2 = mechanism.find(':', colon+1);
+        const auto dE     = std::stod(mechanism.substr(colon+1, colon2-colon-1))*e/1000;
+
+        // Index of the first subband in filenames
+        unsigned int i0 = 1;
+
+        if(colon2 != std::string::npos)
+            i0 = std::stoul(mechanism.substr(colon2+1));
+
+        for(unsigned int i = 0; i < nst; ++i)
+        {
+            for(unsigned int f = 0; f < nst; ++f)
+            {
+                std::ostringstream filename;
+                filename << prefix << i+i0 << f+i0 << ".r";
+
+                if(!std::ifstream(filename.str()).good())
+                    continue;
+
+                arma::vec Ei_t; // Total initial energy [meV]
+                arma::vec W;    // Rate [1/s]
+                read_table(filename.str(), Ei_t, W);
+
+                const arma::vec Ek = Ei_t*e/1000 - subbands[i].get_E_min();
+                Ek_max_tables = std::max(Ek_max_tables, Ek.max());
+
+                rate_files.push_back({i, f, dE, Ek, W});
+
+                if(opt.get_verbose())
+                    std::cout << "Read rates for " << i+1 << "→" << f+1 << " from " << filename.str() << std::endl;
+            }
+        }
+    }
+
+    if(rate_files.empty())
+        std::cerr << "Warning: no rate tables were found. Carriers will drift without scattering." << std::endl;
+
+    double Ek_max = Ek_max_tables;
+
+    if(opt.get_argument_known("Emax"))
+        Ek_max = opt.get_option<double>("Emax")*e/1000;
+
+    if(Ek_max <= 0)
+        throw std::domain_error("Cannot find range of kinetic energy for rate tables. Use --Emax.");
+
+    EnsembleMonteCarlo mc(subbands, Ek_max, opt.get_option<size_t>("nE"));
+    mc.set_field(opt.get_option<double>("field")*1e5); // Rescale to V/m
+    mc.set_charge((p == 'e') ? -e : e);
+    mc.set_initial_temperature(opt.get_option<double>("Te"));
+    mc.set_histogram_bins(opt.get_option<size_t>("nhist"));
+
+    for(const auto &rf : rate_files)
+        mc.add_rate_table(rf.i, rf.f, rf.dE, rf.Ek, rf.W);
+
+    unsigned long seed = 0;
+
+    if(opt.get_argument_known("seed"))
+        seed = opt.get_option<size_t>("seed");
+    else
+    {
+        std::random_device rd;
+        seed = rd();
+    }
+
+    const auto result = mc.run(pop0,
+                               opt.get_option<size_t>("nparticles"),
+                               opt.get_option<double>("time")*1e-12,
+                               opt.get_option<size_t>("nsamples"),
+                               seed);
+
+    // Transient drift velocity and mean energy
+    write_table("mc-transient.r", arma::vec(result.t*1e12), result.v_drift_t, arma::vec(result.Ek_mean_t*1000/e));
+
+    // Steady-state subband populations [m^{-2}] and drift velocities
+    const double N_total = arma::accu(pop0);
+    const arma::vec pop = result.population*N_total;
+    write_table("mc-population.r", pop);
+    write_table("mc-drift-velocity.r", result.v_drift, true);
+
+    // Steady-state energy distribution in each subband
+    std::ofstream dist_stream("mc-distribution.r");
+    dist_stream << std::scientific << std::setprecision(12);
+
+    for(unsigned int ibin = 0; ibin < result.Ek_bins.size(); ++ibin)
+    {
+        dist_stream << result.Ek_bins[ibin]*1000/e;
+
+        for(unsigned int isb = 0; isb < nst; ++isb)
+            dist_stream << "\t" << result.distribution(ibin, isb);
+
+        dist_stream << std::endl;
+    }
+
+    // Sheet current density in direction of field [A/m]
+    const double q = (p == 'e') ? -e : e;
+    const double J = q*N_total*result.v_drift_total;
+
+    std::cout << "Drift velocity: " << result.v_drift_total << " m/s" << std::endl
+              << "Mean kinetic energy: " << result.Ek_mean*1000/e << " meV" << std::endl
+              << "Sheet current density: " << J << " A/m" << std::endl;
+
+    if(opt.get_verbose())
+    {
+        std::cout << "Random-number seed: " << seed << std::endl;
+        std::cout << "Real scattering events: " << arma::accu(result.n_scatter) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
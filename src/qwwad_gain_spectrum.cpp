@@ -0,0 +1,179 @@
+/**
+ * \file   qwwad_gain_spectrum.cpp
+ * \brief  Intersubband optical gain and absorption spectrum
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "qwwad/constants.h"
+#include "qwwad/file-io.h"
+#include "qwwad/gain-spectrum.h"
+#include "qwwad/options.h"
+#include "qwwad/subband.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+static Options configure_options(int argc, char* argv[])
+{
+    Options opt;
+
+    std::string doc("Find the optical gain spectrum for intersubband transitions.  Each transition "
+                    "contributes a Lorentzian line, weighted by its dipole matrix element and the "
+                    "population inversion.  Negative gain indicates absorption.");
+
+    opt.add_option<double>     ("mass,m",            0.067, "Band-edge effective mass (relative to free electron)");
+    opt.add_option<double>     ("alpha",               0.0, "In-plane non-parabolicity parameter [1/eV].");
+    opt.add_option<double>     ("vcb",                 0.0, "Conduction band edge [eV].");
+    opt.add_option<char>       ("particle,p",          'e', "ID of particle to be used: 'e', 'h' or 'l', for "
+                                                            "electrons, heavy holes or light holes respectively.");
+    opt.add_option<double>     ("Te",                  300, "Carrier temperature [K].");
+    opt.add_option<double>     ("refractiveindex,n",   3.3, "Refractive index");
+    opt.add_option<double>     ("length,L",                 "Length of the structure, e.g., one period of a cascade "
+                                                            "laser [angstrom].  If not specified, the length of the "
+                                                            "spatial grid is used.");
+    opt.add_option<double>     ("linewidth",            10, "Full-width at half-maximum linewidth of all transitions [meV]");
+    opt.add_option<std::string>("ratefile",                 "File from which scattering rates are read, with the initial "
+                                                            "and final subband indices in the first two columns and "
+                                                            "the rate [1/s] in the last.  If given, the linewidth of "
+                                                            "each transition is found from the lifetimes of its "
+                                                            "subbands.");
+    opt.add_option<double>     ("Emin",                  1, "Lowest photon energy [meV]");
+    opt.add_option<double>     ("Emax",                300, "Highest photon energy [meV]");
+    opt.add_option<size_t>     ("nE",                 1000, "Number of photon energy samples");
+    opt.add_option<bool>       ("dispersion",               "Sum over vertical transitions at each in-plane wave-vector, "
+                                                            "rather than using the separation of the subband minima.");
+    opt.add_option<size_t>     ("nk",                  101, "Number of in-plane wave-vector samples, if --dispersion is used");
+    opt.add_option<std::string>("outputfile", "gain-spectrum.r",
+                                                            "File to which the photon energy [meV] and gain [cm^{-1}] "
+                                                            "are written");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, doc);
+
+    return opt;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    const auto p = opt.get_option<char>("particle");
+
+    std::ostringstream E_filename; // Energy filename string
+    E_filename << "E" << p << ".r";
+    std::ostringstream wf_prefix;  // Wavefunction filename prefix
+    wf_prefix << "wf_" << p;
+
+    auto subbands = Subband::read_from_file(E_filename.str(),
+                                            wf_prefix.str(),
+                                            ".r",
+                                            opt.get_option<double>("mass") * me,
+                                            opt.get_option<double>("alpha") / e,
+                                            opt.get_option<double>("vcb") * e);
+    const auto nst = subbands.size();
+
+    // Read and set carrier distributions within each subband
+    arma::vec  Ef;      // Fermi energies [J]
+    arma::uvec indices; // Subband indices (garbage)
+    read_table("Ef.r", indices, Ef);
+    Ef *= e/1000.0; // Rescale to J
+
+    if(Ef.size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Ef.r contains " << Ef.size() << " subbands, but " << E_filename.str()
+            << " contains " << nst << ".";
+        throw std::length_error(oss.str());
+    }
+
+    const auto Te = opt.get_option<double>("Te");
+
+    for(unsigned int isb = 0; isb < nst; ++isb)
+        subbands[isb].set_distribution_from_Ef_Te(Ef[isb], Te);
+
+    // Dipole matrix elements for all pairs of states
+    std::vector<Eigenstate> states;
+
+    for(const auto &sb : subbands)
+        states.push_back(sb.get_ground());
+
+    const auto z = Eigenstate::get_position_matrix(states);
+
+    double L = subbands[0].get_length();
+
+    if(opt.get_argument_known("length"))
+        L = opt.get_option<double>("length")*1e-10;
+
+    GainSpectrum spectrum(subbands, z, opt.get_option<double>("refractiveindex"), L);
+    spectrum.set_linewidth(opt.get_option<double>("linewidth")*e/1000);
+    spectrum.enable_dispersion(opt.get_option<bool>("dispersion"));
+    spectrum.set_k_samples(opt.get_option<size_t>("nk"));
+
+    // Find the linewidths from the subband lifetimes if wanted
+    if(opt.get_argument_known("ratefile"))
+    {
+        const auto fname = opt.get_option<std::string>("ratefile");
+        std::ifstream stream(fname);
+
+        if(!stream.is_open())
+        {
+            std::ostringstream oss;
+            oss << "Could not open " << fname;
+            throw std::runtime_error(oss.str());
+        }
+
+        arma::mat W(nst, nst, arma::fill::zeros);
+        std::string line;
+
+        while(std::getline(stream, line))
+        {
+            std::istringstream line_stream(line);
+            std::vector<double> row;
+            double value;
+
+            while(line_stream >> value)
+                row.push_back(value);
+
+            if(row.empty())
+                continue;
+
+            // Check the number of columns before reading the indices
+            const bool valid = row.size() >= 3;
+
+            const int i = valid ? (int)row[0] : 0;
+            const int f = valid ? (int)row[1] : 0;
+
+            if(!valid || i < 1 || f < 1 || (size_t)i > nst || (size_t)f > nst)
+            {
+                std::ostringstream oss;
+                oss << "Invalid rate in " << fname << " on line: '" << line << "'";
+                throw std::runtime_error(oss.str());
+            }
+
+            W(i-1, f-1) += row.back();
+        }
+
+        spectrum.set_linewidths(GainSpectrum::get_linewidths_from_rates(W));
+    }
+
+    const arma::vec E = arma::linspace(opt.get_option<double>("Emin"),
+                                       opt.get_option<double>("Emax"),
+                                       opt.get_option<size_t>("nE"))*e/1000;
+
+    const arma::vec gain = spectrum.get_gain(E);
+
+    if(opt.get_verbose())
+        std::cout << "Found spectrum for " << spectrum.get_n_transitions() << " transitions." << std::endl;
+
+    // Write photon energy [meV] and gain [1/cm]
+    write_table(opt.get_option<std::string>("outputfile"), arma::vec(E*1000/e), arma::vec(gain/100));
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,100 @@
+/**
+ * \file   qwwad_matrix_elements.cpp
+ * \brief  Position and momentum matrix elements between all pairs of states
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ *
+ * \details This program finds the matrix elements for every pair of states
+ *          together, which is much faster than finding each one separately
+ *          when there are many states.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "qwwad/constants.h"
+#include "qwwad/eigenstate.h"
+#include "qwwad/wf_options.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Configure command-line options for the program
+ */
+WfOptions configure_options(int argc, char* argv[])
+{
+    WfOptions opt;
+
+    std::string summary("Find the position and momentum matrix elements between all pairs of states.  "
+                        "Each output file contains a square matrix, where row i and column j give "
+                        "the element for states i and j.");
+
+    opt.add_option<std::string>("dipolefile",   "dipole-matrix.r",   "File to which dipole matrix elements <i|z|j> are written [m]. "
+                                                                     "The diagonal gives the expectation position of each state.");
+    opt.add_option<std::string>("zsquaredfile", "z2-matrix.r",       "File to which matrix elements <i|z^2|j> are written [m^2]");
+    opt.add_option<std::string>("momentumfile", "momentum-matrix.r", "File to which momentum matrix elements <i|p|j> are written, "
+                                                                     "relative to -i hbar [1/m]");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, summary);
+
+    return opt;
+}
+
+/**
+ * \brief Write a square matrix to file
+ */
+static void write_matrix(const std::string &fname,
+                         const arma::mat   &M)
+{
+    std::ofstream stream(fname);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << fname;
+        throw std::runtime_error(oss.str());
+    }
+
+    stream << std::scientific << std::setprecision(12);
+
+    for(unsigned int i = 0; i < M.n_rows; ++i)
+    {
+        for(unsigned int j = 0; j < M.n_cols; ++j)
+        {
+            if(j > 0)
+                stream << "\t";
+
+            stream << M(i,j);
+        }
+
+        stream << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    const auto states = Eigenstate::read_from_file(opt.get_energy_filename(),
+                                                   opt.get_wf_prefix(),
+                                                   opt.get_wf_ext(),
+                                                   1000.0/e,
+                                                   true);
+
+    const auto z_ij    = Eigenstate::get_position_matrix(states);
+    const auto zsqr_ij = Eigenstate::get_position_squared_matrix(states);
+    const auto d_ij    = Eigenstate::get_momentum_matrix(states);
+
+    write_matrix(opt.get_option<std::string>("dipolefile"),   z_ij);
+    write_matrix(opt.get_option<std::string>("zsquaredfile"), zsqr_ij);
+    write_matrix(opt.get_option<std::string>("momentumfile"), d_ij);
+
+    if(opt.get_verbose())
+        std::cout << "Found matrix elements for " << states.size() << " states." << std::endl;
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
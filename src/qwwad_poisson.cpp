@@ -14,6 +14,7 @@
 
 #include "qwwad/options.h"
 #include "qwwad/poisson-solver.h"
+#include "qwwad/semiconductor-charge-model.h"
 #include "qwwad/constants.h"
 #include "qwwad/file-io.h"
 
@@ -51,7 +52,20 @@ Options get_options(int argc, char* argv[])
                                                                      "equal to inbuilt potential from zero-field Poisson solution.");
     opt.add_option<double>     ("offset",                 0 ,        "Set potential at spatial point closest to origin [meV].");
     opt.add_option<bool>       ("ptype",                             "Dopants are to be treated as acceptors, and wavefunctions "
-                                                                     "treated as hole states");
+                                                                     "treated as hole states (not available in nonlinear mode)");
+    opt.add_option<bool>       ("nonlinear",                         "Find the electron and ionised donor densities from the "
+                                                                     "potential self-consistently, instead of reading a fixed "
+                                                                     "charge profile.  The electrons are treated as a 3D gas "
+                                                                     "with a uniform quasi-Fermi energy.");
+    opt.add_option<std::string>("dopingfile",            "d.r",      "File containing the donor density [m^{-3}] (nonlinear mode only)");
+    opt.add_option<double>     ("Ef",                    0.0,        "Electron quasi-Fermi energy [meV] (nonlinear mode only)");
+    opt.add_option<double>     ("Te",                    300,        "Temperature [K] (nonlinear mode only)");
+    opt.add_option<double>     ("mass,m",                0.067,      "Conduction-band effective mass (relative to free electron) "
+                                                                     "(nonlinear mode only)");
+    opt.add_option<double>     ("donorenergy",           0.0,        "Binding energy of donors [meV].  If nonzero, donors are "
+                                                                     "only partially ionised (nonlinear mode only).");
+    opt.add_option<bool>       ("boltzmann",                         "Use Boltzmann statistics for electrons instead of "
+                                                                     "Fermi-Dirac statistics (nonlinear mode only)");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -72,8 +86,10 @@ int main(int argc, char* argv[])
     arma::vec z2  = arma::zeros(nz);
     arma::vec rho = arma::zeros(nz); // Charge-profile [C/m^2]
 
+    const auto nonlinear = opt.get_option<bool>("nonlinear");
+
     // Read space-charge profile, or just leave it as zero if desired
-    if(!opt.get_option<bool>("uncharged"))
+    if(!opt.get_option<bool>("uncharged") && !nonlinear)
     {
         read_table(opt.get_option<std::string>("chargefile").c_str(), z2, rho);
 
@@ -103,8 +119,75 @@ int main(int argc, char* argv[])
     // Calculate Poisson potential due to charge within structure
     arma::vec phi = arma::zeros(nz);   // Poisson potential
 
+    // Baseline potential (assume zero unless provided by user):
+    arma::vec Vbase = arma::zeros(nz);
+
+    if (opt.get_argument_known("bandedgepotentialfile"))
+    {
+        arma::vec zbase(nz);
+        read_table(opt.get_option<std::string>("bandedgepotentialfile"), zbase, Vbase);
+
+        // TODO: Add more robust checking of z, zbase identicality here
+        if(zbase.size() != z.size())
+        {
+            std::ostringstream oss;
+            oss << "Baseline and Poisson potential profiles have different lengths "
+                   "(" << zbase.size() << ") and (" << z.size() << ") "
+                   "respectively";
+
+            throw std::runtime_error(oss.str());
+        }
+    }
+
+    if(nonlinear)
+    {
+        if(opt.get_option<bool>("mixed"))
+            throw std::runtime_error("Mixed boundary conditions cannot be used in nonlinear mode");
+
+        // The charge model only describes electrons and donors
+        if(opt.get_option<bool>("ptype"))
+            throw std::runtime_error("p-type systems cannot be used in nonlinear mode");
+
+        arma::vec zd;
+        arma::vec N_D; // Donor density [m^{-3}]
+        read_table(opt.get_option<std::string>("dopingfile"), zd, N_D);
+
+        if(N_D.size() != nz)
+        {
+            std::ostringstream oss;
+            oss << "Doping profile has " << N_D.size() << " points, but permittivity profile has "
+                << nz << ".";
+            throw std::runtime_error(oss.str());
+        }
+
+        SemiconductorChargeModel model(Vbase,
+                                       N_D,
+                                       opt.get_option<double>("mass")*me,
+                                       opt.get_option<double>("Te"),
+                                       opt.get_option<double>("Ef")*e/1000);
+        model.set_donor_binding_energy(opt.get_option<double>("donorenergy")*e/1000);
+        model.enable_fermi_dirac(!opt.get_option<bool>("boltzmann"));
+
+        const auto bt = opt.get_argument_known("field") ? DIRICHLET : ZERO_FIELD;
+        PoissonSolver poisson(_eps, dz, bt);
+
+        // The solver works with the electrostatic potential in volts.  Convert
+        // to the same energy scale as the linear solution
+        const arma::vec phi_V = poisson.solve_nonlinear(model, arma::zeros(nz), V_drop/e);
+        phi = phi_V*e;
+
+        if(opt.get_verbose())
+        {
+            arma::vec n;
+            arma::vec N_D_plus;
+            model.get_densities(phi_V, n, N_D_plus);
+
+            std::cout << "Electron sheet density: " << arma::accu(n)*dz/1e14 << " x1e10 cm^{-2}" << std::endl
+                      << "Ionised donor sheet density: " << arma::accu(N_D_plus)*dz/1e14 << " x1e10 cm^{-2}" << std::endl;
+        }
+    }
     // Pin the potential at the start, and make the field identical at either end
-    if(opt.get_option<bool>("mixed"))
+    else if(opt.get_option<bool>("mixed"))
     {
         // Solve the Poisson equation with zero field at the edges first
         PoissonSolver poisson(_eps, dz, MIXED);
@@ -179,26 +262,6 @@ int main(int argc, char* argv[])
 
     write_table("field.r", z, F);
 
-    // Baseline potential (assume zero unless provided by user):
-    arma::vec Vbase = arma::zeros(phi.size());
-
-    if (opt.get_argument_known("bandedgepotentialfile"))
-    {
-        arma::vec zbase(phi.size());
-        read_table(opt.get_option<std::string>("bandedgepotentialfile"), zbase, Vbase);
-
-        // TODO: Add more robust checking of z, zbase identicality here
-        if(zbase.size() != z.size())
-        {
-            std::ostringstream oss;
-            oss << "Baseline and Poisson potential profiles have different lengths "
-                   "(" << zbase.size() << ") and (" << z.size() << ") "
-                   "respectively";
-
-            throw std::runtime_error(oss.str());
-        }
-    }
-
     arma::vec Vtotal = phi + Vbase; // Total potential
 
     write_table(opt.get_option<std::string>("totalpotentialfile"), z, Vtotal);
@@ -0,0 +1,259 @@
+/**
+ * \file   qwwad_poisson_2d.cpp
+ * \brief  Electrostatic potential in a 2D device cross-section
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "qwwad/constants.h"
+#include "qwwad/file-io.h"
+#include "qwwad/material.h"
+#include "qwwad/material-library.h"
+#include "qwwad/options.h"
+#include "qwwad/poisson-solver-2d.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+static Options configure_options(int argc, char* argv[])
+{
+    Options opt;
+
+    std::string doc("Find the electrostatic potential in a rectangular cross-section through a "
+                    "device, such as a ridge waveguide or a gated structure.  The cross-section "
+                    "is built from rectangular regions of material, and the dopants are assumed "
+                    "to be fully ionised.");
+
+    opt.add_option<std::string>("regionfile",  "regions.r", "File containing the list of regions.  Each line gives "
+                                                            "x_min, x_max, y_min, y_max [nm], material name, alloy "
+                                                            "fraction and donor density [m^{-3}].  Later regions "
+                                                            "overwrite earlier ones.");
+    opt.add_option<std::string>("background",  "air",       "Material in cells that lie outside all regions");
+    opt.add_option<std::string>("materialfile", "",         "Material library file.  If not given, the default "
+                                                            "library is used.");
+    opt.add_option<double>     ("width",        1000,       "Width of domain in x direction [nm]");
+    opt.add_option<double>     ("height",       1000,       "Height of domain in y direction [nm]");
+    opt.add_option<double>     ("dx",           10,         "Cell width in x direction [nm]");
+    opt.add_option<double>     ("dy",           10,         "Cell width in y direction [nm]");
+    opt.add_option<std::string>("contacts",     "",         "Comma-separated list of contacts with fixed potential, "
+                                                            "each given as <edge>:<V>[:<start>:<end>], where <edge> "
+                                                            "is xmin, xmax, ymin or ymax, <V> is the potential [V] "
+                                                            "and <start>, <end> give the extent of the contact along "
+                                                            "the edge [nm].  All other parts of the edges have zero "
+                                                            "normal field.");
+    opt.add_option<double>     ("tolerance",    1e-10,      "Tolerance on residual, relative to the charge");
+    opt.add_option<size_t>     ("maxiter",      200,        "Maximum number of iterations");
+    opt.add_option<std::string>("potentialfile", "phi-2d.r", "File to which potential is written [V]");
+    opt.add_option<std::string>("fieldfile",    "field-2d.r", "File to which electric field is written [V/m]");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, doc);
+
+    return opt;
+}
+
+/**
+ * \brief Find the static relative permittivity of a material
+ */
+static double get_relative_permittivity(const Material &mat,
+                                        const double    x)
+{
+    try
+    {
+        return mat.get_property_value("eps_dc", x);
+    }
+    catch(std::exception &ex)
+    {
+        return mat.get_property_value("eps", x);
+    }
+}
+
+/**
+ * \brief Convert a name of an edge into its identifier
+ */
+static PoissonEdge get_edge(const std::string &name)
+{
+    if(name == "xmin") return EDGE_X_MIN;
+    if(name == "xmax") return EDGE_X_MAX;
+    if(name == "ymin") return EDGE_Y_MIN;
+    if(name == "ymax") return EDGE_Y_MAX;
+
+    std::ostringstream oss;
+    oss << "Unrecognised edge: " << name << ".  Use xmin, xmax, ymin or ymax.";
+    throw std::invalid_argument(oss.str());
+}
+
+int main(int argc, char* argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    const auto dx = opt.get_option<double>("dx")*1e-9;
+    const auto dy = opt.get_option<double>("dy")*1e-9;
+    const unsigned int nx = round(opt.get_option<double>("width")*1e-9/dx);
+    const unsigned int ny = round(opt.get_option<double>("height")*1e-9/dy);
+
+    if(nx == 0 || ny == 0)
+        throw std::domain_error("Domain must contain at least one cell in each direction");
+
+    // Cell-centre coordinates [m]
+    const arma::vec x = arma::linspace(0.5*dx, (nx-0.5)*dx, nx);
+    const arma::vec y = arma::linspace(0.5*dy, (ny-0.5)*dy, ny);
+
+    MaterialLibrary lib(opt.get_option<std::string>("materialfile"));
+
+    const auto background = lib.get_material(opt.get_option<std::string>("background"));
+    arma::mat eps(nx, ny);
+    eps.fill(get_relative_permittivity(*background, 0)*eps0);
+    arma::mat rho = arma::zeros(nx, ny); // Charge density [C/m^3]
+
+    // Paint each region into the grid
+    const auto region_fname = opt.get_option<std::string>("regionfile");
+    std::ifstream region_stream(region_fname);
+
+    if(!region_stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << region_fname;
+        throw std::runtime_error(oss.str());
+    }
+
+    size_t nregions = 0;
+
+    while(!region_stream.eof())
+    {
+        double x_min, x_max, y_min, y_max; // Extent of region [nm]
+        std::string name;                  // Name of material
+        double alloy;                      // Alloy fraction
+        double N_D;                        // Donor density [m^{-3}]
+
+        if(read_line(region_stream, x_min, x_max, y_min, y_max, name, alloy, N_D))
+            continue;
+
+        const auto mat     = lib.get_material(name);
+        const double eps_r = get_relative_permittivity(*mat, alloy);
+        ++nregions;
+
+        for(unsigned int j = 0; j < ny; ++j)
+        {
+            for(unsigned int i = 0; i < nx; ++i)
+            {
+                if(x[i] >= x_min*1e-9 && x[i] < x_max*1e-9 &&
+                   y[j] >= y_min*1e-9 && y[j] < y_max*1e-9)
+                {
+                    eps(i,j) = eps_r*eps0;
+                    rho(i,j) = e*N_D;
+                }
+            }
+        }
+    }
+
+    if(opt.get_verbose())
+        std::cout << "Read " << nregions << " regions from " << region_fname << std::endl
+                  << "Grid contains " << nx << "x" << ny << " cells." << std::endl;
+
+    PoissonSolver2D poisson(eps, dx, dy);
+    poisson.set_tolerance(opt.get_option<double>("tolerance"));
+    poisson.set_max_iterations(opt.get_option<size_t>("maxiter"));
+
+    // Set up the contacts
+    std::istringstream contact_list(opt.get_option<std::string>("contacts"));
+    std::string contact;
+
+    while(std::getline(contact_list, contact, ','))
+    {
+        std::istringstream contact_stream(contact);
+        std::vector<std::string> fields;
+        std::string field;
+
+        while(std::getline(contact_stream, field, ':'))
+            fields.push_back(field);
+
+        if(fields.size() != 2 && fields.size() != 4)
+        {
+            std::ostringstream oss;
+            oss << "Contact '" << contact << "' should be given as <edge>:<V>[:<start>:<end>]";
+            throw std::invalid_argument(oss.str());
+        }
+
+        const auto edge = get_edge(fields[0]);
+        const auto V    = std::stod(fields[1]);
+
+        if(fields.size() == 2)
+            poisson.set_dirichlet(edge, V);
+        else
+        {
+            // Coordinates of the cells along the edge
+            const bool along_y = (edge == EDGE_X_MIN || edge == EDGE_X_MAX);
+            const arma::vec &s = along_y ? y : x;
+            const double s_start = std::stod(fields[2])*1e-9;
+            const double s_end   = std::stod(fields[3])*1e-9;
+            std::vector<unsigned int> in_contact;
+
+            for(unsigned int k = 0; k < s.size(); ++k)
+            {
+                if(s[k] >= s_start && s[k] < s_end)
+                    in_contact.push_back(k);
+            }
+
+            if(in_contact.empty())
+            {
+                std::ostringstream oss;
+                oss << "Contact '" << contact << "' does not contain any cells";
+                throw std::domain_error(oss.str());
+            }
+
+            poisson.set_dirichlet(edge, in_contact.front(), in_contact.back(), V);
+        }
+    }
+
+    const arma::mat phi = poisson.solve(rho);
+
+    if(opt.get_verbose())
+        std::cout << "Converged in " << poisson.get_iterations() << " iterations using "
+                  << poisson.get_n_levels() << " multigrid levels." << std::endl;
+
+    // Electric field at each cell centre, using one-sided differences at the
+    // edges [V/m]
+    arma::mat Ex(nx, ny);
+    arma::mat Ey(nx, ny);
+
+    for(unsigned int j = 0; j < ny; ++j)
+    {
+        for(unsigned int i = 0; i < nx; ++i)
+        {
+            const unsigned int i_lo = (i > 0)    ? i-1 : i;
+            const unsigned int i_hi = (i < nx-1) ? i+1 : i;
+            const unsigned int j_lo = (j > 0)    ? j-1 : j;
+            const unsigned int j_hi = (j < ny-1) ? j+1 : j;
+
+            Ex(i,j) = (i_hi > i_lo) ? -(phi(i_hi,j) - phi(i_lo,j))/((i_hi-i_lo)*dx) : 0.0;
+            Ey(i,j) = (j_hi > j_lo) ? -(phi(i,j_hi) - phi(i,j_lo))/((j_hi-j_lo)*dy) : 0.0;
+        }
+    }
+
+    // Write maps in blocks of constant x, for plotting with gnuplot
+    std::ofstream phi_stream(opt.get_option<std::string>("potentialfile"));
+    std::ofstream field_stream(opt.get_option<std::string>("fieldfile"));
+
+    for(unsigned int i = 0; i < nx; ++i)
+    {
+        for(unsigned int j = 0; j < ny; ++j)
+        {
+            phi_stream   << x[i]*1e9 << "\t" << y[j]*1e9 << "\t" << phi(i,j) << std::endl;
+            field_stream << x[i]*1e9 << "\t" << y[j]*1e9 << "\t" << Ex(i,j) << "\t" << Ey(i,j) << std::endl;
+        }
+
+        phi_stream   << std::endl;
+        field_stream << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -122,7 +122,7 @@ int main(int argc, char *argv[])
         case DIST_FERMI:
             {
                 const auto _md = opt.get_option<double>("mass") * me; // Density-of-states mass [kg]
-                const auto T   = opt.get_option<double>("temperature");
+                const auto T   = opt.get_option<double>("Te");
 
                 // Fermi energy for entire system [J]
                 double Ef = find_fermi_global(E, _md, n2D, T);
@@ -0,0 +1,201 @@
+/**
+ * \file   qwwad_population_rate_equations.cpp
+ * \brief  Find steady-state subband populations from scattering rates
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "qwwad/file-io.h"
+#include "qwwad/options.h"
+#include "qwwad/rate-equation-solver.h"
+
+using namespace QWWAD;
+
+Options configure_options(int argc, char* argv[])
+{
+    Options opt;
+
+    std::string doc("Find the steady-state population of each subband by solving the "
+                    "scattering rate equations.  The one-body rates are read from files with "
+                    "one transition per line, giving the initial and final subband indices "
+                    "in the first two columns and the rate [1/s] in the last column.  This "
+                    "matches the output of qwwad_sr_rate_matrix and the *-avg.dat files from "
+                    "the other scattering programs.");
+
+    opt.add_option<std::string>("ratefiles",       "rate-matrix.dat", "Comma-separated list of files from which one-body scattering "
+                                                                      "rates are read.  Rates for the same transition are summed.");
+    opt.add_option<std::string>("ccfile",                             "File from which carrier-carrier rates are read, in the format "
+                                                                      "of ccABCD.r.  If given, the populations are found by Newton "
+                                                                      "iteration.");
+    opt.add_option<std::string>("populationfile",  "N.r",             "File from which initial subband populations are read [m^{-2}]. "
+                                                                      "Carrier-carrier rates are assumed to have been calculated "
+                                                                      "using these populations.");
+    opt.add_option<double>     ("totalpopulation",                    "Total population of all subbands [x1e10 cm^{-2}].  If not "
+                                                                      "specified, the total of the initial populations is used.");
+    opt.add_option<std::string>("outputfile",      "N-steady.r",      "File to which steady-state populations are written [m^{-2}]");
+    opt.add_option<double>     ("tolerance",       1e-10,             "Relative tolerance for Newton iteration");
+    opt.add_option<size_t>     ("maxiter",         100,               "Maximum number of Newton iterations");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, doc);
+
+    return opt;
+}
+
+/**
+ * \brief Read all numerical rows from a file
+ *
+ * \param[in] fname     Name of file
+ * \param[in] min_cols  Minimum number of columns needed on each line
+ *
+ * \details Blank lines are skipped.  Lines may contain different numbers
+ *          of columns, as long as there are at least min_cols.
+ */
+static std::vector<std::vector<double>> read_rows(const std::string &fname,
+                                                  const size_t       min_cols)
+{
+    std::ifstream stream(fname);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << fname;
+        throw std::runtime_error(oss.str());
+    }
+
+    std::vector<std::vector<double>> rows;
+    std::string line;
+
+    while(std::getline(stream, line))
+    {
+        std::istringstream line_stream(line);
+        std::vector<double> row;
+        double value;
+
+        while(line_stream >> value)
+            row.push_back(value);
+
+        if(row.empty())
+            continue;
+
+        if(row.size() < min_cols)
+        {
+            std::ostringstream oss;
+            oss << "Data missing in " << fname << " on line: '" << line << "'";
+            throw std::runtime_error(oss.str());
+        }
+
+        rows.push_back(row);
+    }
+
+    return rows;
+}
+
+/**
+ * \brief Convert a subband index from file (indexed from 1) to an array index
+ */
+static unsigned int get_index(const double       value,
+                              const size_t       nst,
+                              const std::string &fname)
+{
+    const int idx = (int)value;
+
+    if(idx < 1 || (size_t)idx > nst)
+    {
+        std::ostringstream oss;
+        oss << "Subband index " << idx << " in " << fname << " is outside the range 1.." << nst;
+        throw std::domain_error(oss.str());
+    }
+
+    return idx - 1;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    // Initial populations [m^{-2}]
+    arma::vec n0;
+    read_table(opt.get_option<std::string>("populationfile"), n0);
+    const size_t nst = n0.size();
+
+    if(nst == 0)
+        throw std::runtime_error("No subband populations were found");
+
+    // Sum the one-body rates from all files
+    arma::mat W(nst, nst, arma::fill::zeros);
+    std::istringstream file_list(opt.get_option<std::string>("ratefiles"));
+    std::string fname;
+
+    while(std::getline(file_list, fname, ','))
+    {
+        for(const auto &row : read_rows(fname, 3))
+        {
+            const auto i = get_index(row[0], nst, fname);
+            const auto f = get_index(row[1], nst, fname);
+            W(i,f) += row.back();
+        }
+    }
+
+    RateEquationSolver solver(W);
+    solver.set_tolerance(opt.get_option<double>("tolerance"));
+    solver.set_max_iterations(opt.get_option<size_t>("maxiter"));
+
+    // The averaged carrier-carrier rate for ij→fg is the rate per carrier in
+    // subband i, for the population of subband j that was used in the
+    // calculation.  Dividing by that population gives a two-body rate coefficient
+    if(opt.get_argument_known("ccfile"))
+    {
+        const auto cc_fname = opt.get_option<std::string>("ccfile");
+
+        for(const auto &row : read_rows(cc_fname, 5))
+        {
+            const auto i = get_index(row[0], nst, cc_fname);
+            const auto j = get_index(row[1], nst, cc_fname);
+            const auto f = get_index(row[2], nst, cc_fname);
+            const auto g = get_index(row[3], nst, cc_fname);
+
+            if(n0[j] <= 0)
+            {
+                std::ostringstream oss;
+                oss << "Cannot find carrier-carrier rate coefficient for subband " << j+1
+                    << " with zero population.";
+                throw std::domain_error(oss.str());
+            }
+
+            solver.add_two_body_rate(i, j, f, g, row.back()/n0[j]);
+        }
+    }
+
+    double N = arma::accu(n0);
+
+    if(opt.get_argument_known("totalpopulation"))
+        N = opt.get_option<double>("totalpopulation")*1e14; // Rescale to m^{-2}
+
+    // Start from the given populations, scaled to the right total
+    arma::vec n_guess = arma::ones(nst)*N/nst;
+
+    if(arma::accu(n0) > 0)
+        n_guess = n0*N/arma::accu(n0);
+
+    const arma::vec n = solver.solve(N, n_guess);
+
+    if(opt.get_verbose())
+    {
+        const arma::vec dn_dt = solver.get_dn_dt(n);
+
+        for(unsigned int i = 0; i < nst; ++i)
+            std::cout << "Subband " << i+1 << ": n = " << n[i]/1e14 << " x1e10 cm^{-2}, "
+                      << "dn/dt = " << dn_dt[i] << " m^{-2}s^{-1}" << std::endl;
+    }
+
+    write_table(opt.get_option<std::string>("outputfile"), n);
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -7,12 +7,21 @@
    from the eigenvectors generated by pplb.c.  Written only for the 
    zone center (k=0) at present.
 
+   The wave functions are found on a grid covering one period of the
+   lattice by fast Fourier transform, and the cuboid is then sampled from
+   this grid.
+
    Input files:
                a_nk.r       expansion coefficients of eigenvectors
                   G.r       reciprocal lattice vectors
 
    Output files:
-                cd.r		charge density grid
+                cd.vtk		charge density grid, as binary legacy VTK
+				structured points (default)
+                cd.r		charge density grid, as text (with -t)
+		cd-x.r		x coordinates of grid, as text (with -t)
+		cd-y.r		y coordinates of grid, as text (with -t)
+		cd-z.r		z coordinates of grid, as text (with -t)
 
 
    Paul Harrison, March 1995  
@@ -23,22 +32,35 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <gsl/gsl_math.h>
 #include "qwwad/maths-helpers.h"
 #include "qwwad/constants.h"
+#include "qwwad/fft.h"
 #include "qwwad/ppff.h"
+#include "qwwad/pplb-functions.h"
+
+using namespace QWWAD;
+using namespace constants;
 
 static arma::cx_vec read_ank(const int  N,
                              int       *Nn);
 
+static void write_vtk(const arma::vec &cd,
+                      const int        n_x,
+                      const int        n_y,
+                      const int        n_z,
+                      const double     x_min,
+                      const double     y_min,
+                      const double     z_min,
+                      const int        n_xyz);
+
 int main(int argc,char *argv[])
 {
-std::complex<double> psi;    	/* the wave function psi_nk(r)			*/
 double A0;		/* Lattice constant			       	*/
-double Gdotr;		/* G.r						*/
 double Omega;           /* normalisation constant                       */
-double psi_sqr;         /* charge density                               */
 double x_min;           /*             -+                               */
 double x_max;           /*              |                               */
 double y_min;           /*               \    spatial extent            */
@@ -54,11 +76,11 @@ int	Nn;		/* number of bands in eigenvector file		*/
 int	n_min;          /* lowest band in summation			*/
 int	n_max;		/* highest band in summation		 	*/
 int	n_xyz;          /* number of points per lattice constant        */
+bool	text;		/* write text output instead of binary		*/
 FILE	*Fcd;           /* pointer to charge density file, cd.r         */
 FILE	*Fcdx;          /* pointer to x coordinates file, cdx.r         */
 FILE	*Fcdy;          /* pointer to y coordinates file, cdy.r         */
 FILE	*Fcdz;		/* pointer to z coordinates file, cdz.r         */
-arma::vec r;		/* position                                     */
 
 /* default values	*/
 
@@ -72,6 +94,7 @@ y_min=0;
 y_max=0;
 z_min=0;
 z_max=1;
+text=false;
 
 while((argc>1)&&(argv[1][0]=='-'))
 {
@@ -89,6 +112,11 @@ while((argc>1)&&(argv[1][0]=='-'))
   case 'm':
            n_max=atoi(argv[2])-1;         /* Note -1=>top VB=4, CB=5 */
            break;
+  case 't':
+	   text=true;
+	   argv--;
+	   argc++;
+	   break;
   case 'x':
 	   x_min=atof(argv[2]);
 	   break;
@@ -114,6 +142,7 @@ while((argc>1)&&(argv[1][0]=='-'))
 	   printf("            [-N # points per A0 \033[1m20\033[0m]\n");
 	   printf("            [-n # lowest band \033[1m1\033[0m][-m highest band \033[1m4\033[0m], lowest band in ank file=1\n");
 	   printf("            [-A Lattice constant (\033[1m5.65\033[0mAngstrom)]\n");
+	   printf("            [-t write text files cd.r, cd-x.r, cd-y.r, cd-z.r instead of cd.vtk]\n");
 	   exit(0);
  }
  argv++;
@@ -137,61 +166,115 @@ if((n_max-n_min+1)>Nn)
 	exit(EXIT_FAILURE);
 }
 
-/* Open file for charge density */
+/* Number of points in the cuboid along each axis	*/
 
-Fcd=fopen("cd.r","w");
+const int n_x = (int)floor((x_max-x_min)*n_xyz+1e-6)+1;
+const int n_y = (int)floor((y_max-y_min)*n_xyz+1e-6)+1;
+const int n_z = (int)floor((z_max-z_min)*n_xyz+1e-6)+1;
+
+/* The wave functions are periodic over n_cell lattice constants in each
+   direction, so one period is sampled by n_cell*n_xyz points.  Each G
+   vector has an integer index m on this grid.				*/
+
+arma::vec b;	/* reciprocal lattice spacing in each direction	*/
+const arma::imat m = find_lattice_indices(G, A0, b);
+size_t n_grid[3];
 
-for(ix=0;ix<=(x_max-x_min)*n_xyz;ix++)		/* index along x-axis */
+for(unsigned int dim=0;dim<3;dim++)
+ n_grid[dim] = (size_t)llround(2*pi/(b(dim)*A0))*n_xyz;
+
+const FFT3D fft(n_grid[0], n_grid[1], n_grid[2]);
+
+/* Position of the grid point at the corner of the cuboid	*/
+
+arma::vec r0(3);
+r0(0) = x_min*A0;
+r0(1) = y_min*A0;
+r0(2) = z_min*A0;
+
+/* Index of each G vector on the grid, and phase factor exp(iG.r0) that
+   shifts the origin of the grid to the corner of the cuboid	*/
+
+arma::uvec grid_index(N);
+arma::cx_vec phase(N);
+
+for(iG=0;iG<N;iG++)
 {
- r(0) = (x_min+(float)ix/(float)n_xyz)*A0;
- for(iy=0;iy<=(y_max-y_min)*n_xyz;iy++)		/* index along y-axis */
+ size_t i[3];
+
+ for(unsigned int dim=0;dim<3;dim++)
  {
-  r(1) =(y_min+(float)iy/(float)n_xyz)*A0;
-  for(iz=0;iz<=(z_max-z_min)*n_xyz;iz++)	/* index along z-axis */
-  {
-   r(2) =(z_min+(float)iz/(float)n_xyz)*A0;
-   psi_sqr=0;
-   for(in=n_min;in<=n_max;in++)			/* sum over bands */
-   {
-    /* Calculate psi_nk(r)	*/
-    psi=0;
-    for(iG=0;iG<N;iG++)				/* sum over G */
-    {
-     Gdotr = dot(G[iG], r);
-     psi += ank[iG*Nn+in] * exp(std::complex<double>(0.0, Gdotr));
-    }
-    const double psi_abs = abs(psi);
-    psi_sqr += psi_abs*psi_abs / Omega;
-   }
-   fprintf(Fcd,"%le\n",psi_sqr);
-  }
+  const long long n_dim = (long long)n_grid[dim];
+  i[dim] = (size_t)(((m(dim,iG) % n_dim) + n_dim) % n_dim);
  }
+
+ grid_index(iG) = i[0] + n_grid[0]*(i[1] + n_grid[1]*i[2]);
+ phase(iG) = exp(std::complex<double>(0.0, dot(G[iG], r0)));
 }
 
-fclose(Fcd);	/* Close charge density file	*/
+/* Sum charge density over bands on one period of the grid.  Coefficients
+   that fall on the same grid point are added, which gives the exact value
+   of psi at each point even when the grid is coarse.	*/
 
-/* now regenerate positions r for writing to file */
+arma::vec cd_grid = arma::zeros(fft.get_n_total());
+arma::cx_vec psi(fft.get_n_total());
 
-/* Open files for spatial co-ordinates */
+for(in=n_min;in<=n_max;in++)			/* sum over bands */
+{
+ psi.zeros();
 
-Fcdx=fopen("cd-x.r","w");Fcdy=fopen("cd-y.r","w");Fcdz=fopen("cd-z.r","w");
+ for(iG=0;iG<N;iG++)				/* sum over G */
+  psi(grid_index(iG)) += ank[iG*Nn+in]*phase(iG);
 
-for(ix=0;ix<=(x_max-x_min)*n_xyz;ix++)      /* index along x-axis */
-{
- r(0) = (x_min+(float)ix/(float)n_xyz);        /* this time in units of A0 */
- fprintf(Fcdx,"%6.3f\n",r(0));
-}
-for(iy=0;iy<=(y_max-y_min)*n_xyz;iy++)      /* index along x-axis */
-{
- r(1) = (y_min+(float)iy/(float)n_xyz);        /* this time in units of A0 */
- fprintf(Fcdy,"%6.3f\n",r(1));
+ /* psi_nk(r) = sum_G a_nk(G) exp(iG.r)	*/
+ fft.backward(psi);
+
+ for(size_t ir=0;ir<fft.get_n_total();ir++)
+ {
+  const double psi_abs = abs(psi(ir));
+  cd_grid(ir) += psi_abs*psi_abs / Omega;
+ }
 }
-for(iz=0;iz<=(z_max-z_min)*n_xyz;iz++)      /* index along x-axis */
+
+/* Sample the cuboid from the periodic grid, with x varying fastest	*/
+
+arma::vec cd(n_x*n_y*n_z);
+
+for(iz=0;iz<n_z;iz++)
+ for(iy=0;iy<n_y;iy++)
+  for(ix=0;ix<n_x;ix++)
+   cd(ix + n_x*(iy + n_y*iz)) = cd_grid((ix % n_grid[0]) +
+                                        n_grid[0]*((iy % n_grid[1]) +
+                                                   n_grid[1]*(iz % n_grid[2])));
+
+if(!text)
 {
- r(2) =(z_min+(float)iz/(float)n_xyz);        /* this time in units of A0 */
- fprintf(Fcdz,"%6.3f\n",r(2));
+ write_vtk(cd, n_x, n_y, n_z, x_min, y_min, z_min, n_xyz);
+ return EXIT_SUCCESS;
 }
 
+/* Open file for charge density */
+
+Fcd=fopen("cd.r","w");
+
+for(ix=0;ix<n_x;ix++)		/* index along x-axis */
+ for(iy=0;iy<n_y;iy++)		/* index along y-axis */
+  for(iz=0;iz<n_z;iz++)		/* index along z-axis */
+   fprintf(Fcd,"%le\n",cd(ix + n_x*(iy + n_y*iz)));
+
+fclose(Fcd);	/* Close charge density file	*/
+
+/* Open files for spatial co-ordinates, in units of A0 */
+
+Fcdx=fopen("cd-x.r","w");Fcdy=fopen("cd-y.r","w");Fcdz=fopen("cd-z.r","w");
+
+for(ix=0;ix<n_x;ix++)
+ fprintf(Fcdx,"%6.3f\n",x_min+(float)ix/(float)n_xyz);
+for(iy=0;iy<n_y;iy++)
+ fprintf(Fcdy,"%6.3f\n",y_min+(float)iy/(float)n_xyz);
+for(iz=0;iz<n_z;iz++)
+ fprintf(Fcdz,"%6.3f\n",z_min+(float)iz/(float)n_xyz);
+
 fclose(Fcdx);fclose(Fcdy);fclose(Fcdz);
 
 return EXIT_SUCCESS;
@@ -259,4 +342,72 @@ fclose(Fank);
 
 return(ank);
 }
+
+/**
+ * \brief Writes the charge density to cd.vtk, in the binary legacy VTK
+ *        format for structured points
+ *
+ * \param[in] cd    Charge density, with x varying fastest
+ * \param[in] n_x   Number of points along x-axis
+ * \param[in] n_y   Number of points along y-axis
+ * \param[in] n_z   Number of points along z-axis
+ * \param[in] x_min x coordinate of first point [A0]
+ * \param[in] y_min y coordinate of first point [A0]
+ * \param[in] z_min z coordinate of first point [A0]
+ * \param[in] n_xyz Number of points per lattice constant
+ *
+ * \details Values are stored as big-endian 32-bit floats, as required by
+ *          the format.  The file can be read directly by most volumetric
+ *          visualisation tools.
+ */
+static void write_vtk(const arma::vec &cd,
+                      const int        n_x,
+                      const int        n_y,
+                      const int        n_z,
+                      const double     x_min,
+                      const double     y_min,
+                      const double     z_min,
+                      const int        n_xyz)
+{
+ FILE *Fcd=fopen("cd.vtk","wb");
+
+ if(Fcd==0)
+ {
+  fprintf(stderr,"Cannot open output file 'cd.vtk'!\n");
+  exit(EXIT_FAILURE);
+ }
+
+ fprintf(Fcd,"# vtk DataFile Version 3.0\n");
+ fprintf(Fcd,"Pseudopotential charge density\n");
+ fprintf(Fcd,"BINARY\n");
+ fprintf(Fcd,"DATASET STRUCTURED_POINTS\n");
+ fprintf(Fcd,"DIMENSIONS %i %i %i\n",n_x,n_y,n_z);
+ fprintf(Fcd,"ORIGIN %le %le %le\n",x_min,y_min,z_min);
+ fprintf(Fcd,"SPACING %le %le %le\n",1.0/n_xyz,1.0/n_xyz,1.0/n_xyz);
+ fprintf(Fcd,"POINT_DATA %i\n",n_x*n_y*n_z);
+ fprintf(Fcd,"SCALARS charge_density float 1\n");
+ fprintf(Fcd,"LOOKUP_TABLE default\n");
+
+ /* Find whether bytes need to be swapped to give big-endian data	*/
+ const uint32_t one = 1;
+ unsigned char first_byte;
+ memcpy(&first_byte, &one, 1);
+ const bool swap = (first_byte == 1);
+
+ std::vector<unsigned char> buffer(4*cd.size());
+
+ for(size_t i=0;i<cd.size();i++)
+ {
+  const float value = (float)cd(i);
+  unsigned char bytes[4];
+  memcpy(bytes, &value, 4);
+
+  for(unsigned int ib=0;ib<4;ib++)
+   buffer[4*i+ib] = swap ? bytes[3-ib] : bytes[ib];
+ }
+
+ fwrite(buffer.data(), 1, buffer.size(), Fcd);
+ fprintf(Fcd,"\n");
+ fclose(Fcd);
+}
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
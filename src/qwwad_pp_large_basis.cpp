@@ -19,23 +19,39 @@
  *          Output files:
  *		ank.r		eigenvectors	
  *		Ek?.r		eigenenergies for each k
+ *
+ *          With --adaptive, the points in k.r are treated as a coarse path,
+ *          which is refined where the bands change rapidly.  The refined
+ *          path is written to k-adaptive.r, with Ek?.r and ank?.r for each
+ *          point in order along the path, and the band energies are written
+ *          to Ek-tracked.r with each band followed through crossings.
  */
 
 #if HAVE_CONFIG_H
 # include <config.h>
 #endif
 
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
 #include <complex>
 #include <valarray>
+#include <vector>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <sstream>
 #include <gsl/gsl_math.h>
 
 #include <armadillo>
 
 #include "struct.h"
 #include "maths.h"
+#include "qwwad/adaptive-k-path.h"
 #include "qwwad/constants.h"
 #include "qwwad/linear-algebra.h"
 #include "qwwad/options.h"
@@ -56,6 +72,16 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<size_t>("nmin,n",            4, "Lowest output band index (VB = 4, CB = 5)");
     opt.add_option<size_t>("nmax,m",            5, "Highest output band index (VB = 4, CB = 5)");
     opt.add_option<bool>  ("printev,w",            "Print eigenvectors to file");
+    opt.add_option<size_t>("threads",           0, "Number of threads used to process k points in parallel. "
+                                                   "If zero, the OpenMP default is used.");
+    opt.add_option<bool>  ("adaptive",             "Refine the path given in k.r where the output bands change "
+                                                   "rapidly, and write the refined path to k-adaptive.r");
+    opt.add_option<double>("energytol",         5, "Tolerance on the error in linear interpolation of band "
+                                                   "energies, in adaptive mode [meV]");
+    opt.add_option<double>("overlaptol",      0.9, "Smallest allowed overlap between eigenvectors at "
+                                                   "neighbouring k points, in adaptive mode");
+    opt.add_option<double>("minspacing",    0.005, "Smallest interval that is split, in adaptive mode [2pi/A0]");
+    opt.add_option<size_t>("maxpoints",      1000, "Largest number of k points, in adaptive mode");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -71,6 +97,11 @@ int main(int argc,char *argv[])
     const auto n_max = opt.get_option<size_t>("nmax")-1;               // Highest output band
     const auto ev    = opt.get_option<bool>  ("printev");              // Print eigenvectors?
 
+#ifdef _OPENMP
+    if(opt.get_option<size_t>("threads") > 0)
+        omp_set_num_threads(opt.get_option<size_t>("threads"));
+#endif
+
     // Read desired wave vector points from file
     std::valarray<double> kx;
     std::valarray<double> ky;
@@ -99,62 +130,136 @@ int main(int argc,char *argv[])
 
     // Compute crystal potential matrix. Note that this is independent of wave-vector
     // so we only need to do this once.
-    arma::cx_mat V_GG(N,N);
-
-    for(unsigned int i=0;i<N;i++)        /* index down rows */
+    const CrystalPotential potential(A0, m_per_au, atoms);
+    const arma::cx_mat V_GG = potential.get_V_GG(G);
+
+    if(opt.get_verbose())
+        std::cout << "Found crystal potential for " << atoms.size() << " atoms of "
+                  << potential.get_n_species() << " species." << std::endl;
+
+    // Find the energies and eigenvectors at a given wave vector.  The
+    // eigenvectors overwrite the Hamiltonian
+    auto find_bands = [&](const arma::vec        &k_point,
+                          arma::cx_mat           &H_GG,
+                          arma::vec              &E,
+                          HermitianEigenSolver   &eigensolver)
     {
-        // Fill in the upper triangle of the matrix
-        for(unsigned int j=i;j<N;j++)
-        {
-            const auto q = G[i] - G[j];
-            V_GG(i,j) = V(A0,m_per_au,atoms,q);
-
-            // Fill in the lower triangle by taking the Hermitian transpose of the elements
-            V_GG(j,i) = conj(V_GG(i,j));
-        }
-    }
-
-    /* Add diagonal elements to matrix H_GG' */
-    for(unsigned int ik = 0; ik < nk; ++ik)
-    {
-        if(opt.get_verbose())
-            std::cout << "Calculating energy at k = " << std::endl
-                << k[ik] << " (" << ik + 1 << "/" << nk << ")" << std::endl;
-
         // Construct the complete Hamiltonian matrix now, using crystal potential and
         // kinetic energy on the diagonals
-        auto H_GG = V_GG;
+        H_GG = V_GG;
 
         for(unsigned int i=0;i<N;i++)
         {
             // kinetic energy component of H_GG [QWWAD3, 15.77]
-            arma::vec G_plus_k = G[i] + k[ik];
+            arma::vec G_plus_k = G[i] + k_point;
             const double G_plus_k_sq = dot(G_plus_k, G_plus_k);
             std::complex<double> T_GG=hBar*hBar/(2*me) * G_plus_k_sq;
             H_GG(i,i) += T_GG;
         }
 
-        // Find the eigenvalues & eigenvectors of the Hamiltonian matrix
-        arma::vec E(N); // Energy eigenvalues
-        arma::cx_mat ank(N,N); // coefficients of eigenvectors
-        arma::eig_sym(E, ank, H_GG);
+        eigensolver.solve(H_GG, E);
+    };
 
-        /* Output eigenvalues in a separate file for each k point */
-        char	filenameE[9];	/* character string for Energy output filename	*/
-        sprintf(filenameE,"Ek%i.r",ik);
-        FILE *FEk=fopen(filenameE,"w");
+    if(opt.get_option<bool>("adaptive"))
+    {
+        // Storage for each thread, reused for every k point.  The path is
+        // refined in parallel, so the solver picks the storage for the
+        // thread that calls it.
+#ifdef _OPENMP
+        const size_t n_threads = omp_get_max_threads();
+#else
+        const size_t n_threads = 1;
+#endif
+        std::vector<arma::cx_mat>         H_GG_thread(n_threads, arma::cx_mat(N,N));
+        std::vector<arma::vec>            E_thread(n_threads, arma::vec(N));
+        std::vector<HermitianEigenSolver> eigensolver_thread(n_threads, HermitianEigenSolver(N));
+
+        // Only the output bands are used to refine the path, but the
+        // neighbouring bands show whether a degenerate set is cut off
+        const double inf = std::numeric_limits<double>::infinity();
+
+        AdaptiveKPath path(k, [&](const arma::vec &k_point, arma::vec &E_bands, arma::cx_mat &X,
+                                  double &E_below, double &E_above)
+        {
+#ifdef _OPENMP
+            const size_t ithread = omp_get_thread_num();
+#else
+            const size_t ithread = 0;
+#endif
+            auto &H_GG = H_GG_thread[ithread];
+            auto &E    = E_thread[ithread];
+            find_bands(k_point, H_GG, E, eigensolver_thread[ithread]);
+            E_bands = E.subvec(n_min, n_max);
+            X       = H_GG.cols(n_min, n_max);
+            E_below = (n_min > 0)            ? E(n_min-1) : -inf;
+            E_above = (n_max + 1 < E.size()) ? E(n_max+1) :  inf;
+        });
+
+        path.set_energy_tolerance(opt.get_option<double>("energytol")*1e-3*e);
+        path.set_overlap_tolerance(opt.get_option<double>("overlaptol"));
+        path.set_min_spacing(opt.get_option<double>("minspacing")*2.0*pi/A0);
+        path.set_max_points(opt.get_option<size_t>("maxpoints"));
+        path.refine();
+
+        if(opt.get_verbose())
+            std::cout << "Refined path from " << nk << " to " << path.get_n_points() << " k points."
+                      << std::endl;
+
+        write_adaptive_path(path, A0, N, ev);
 
-        for(auto iE=n_min; iE<=n_max; iE++)
-            fprintf(FEk,"%10.6f\n",E(iE)/e);
+        return EXIT_SUCCESS;
+    }
 
-        fclose(FEk);
+    // Each k point is independent, so they are shared between threads.  Every
+    // k point is written to its own files, so the output does not depend on
+    // the order in which they are processed.
+    std::exception_ptr error;
 
-        /* Output eigenvectors */
+#pragma omp parallel
+    {
+        // Storage for each thread, reused for every k point
+        arma::cx_mat H_GG(N,N);             // Hamiltonian, then eigenvectors
+        arma::vec    E(N);                  // Energy eigenvalues
+        HermitianEigenSolver eigensolver(N);
 
-        if(ev){
-            write_ank(ank,ik,N,n_min,n_max);
+#pragma omp for schedule(dynamic)
+        for(unsigned int ik = 0; ik < nk; ++ik)
+        {
+            try
+            {
+                if(opt.get_verbose())
+                {
+#pragma omp critical
+                    std::cout << "Calculating energy at k = " << std::endl
+                        << k[ik] << " (" << ik + 1 << "/" << nk << ")" << std::endl;
+                }
+
+                find_bands(k[ik], H_GG, E, eigensolver);
+
+                // Output eigenvalues in a separate file for each k point
+                std::ostringstream filenameE;
+                filenameE << "Ek" << ik << ".r";
+                FILE *FEk=fopen(filenameE.str().c_str(),"w");
+
+                for(auto iE=n_min; iE<=n_max; iE++)
+                    fprintf(FEk,"%10.6f\n",E(iE)/e);
+
+                fclose(FEk);
+
+                // Output eigenvectors
+                if(ev)
+                    write_ank(H_GG,ik,N,n_min,n_max);
+            }
+            catch(...)
+            {
+#pragma omp critical
+                error = std::current_exception();
+            }
         }
-    }/* end while*/
+    }
+
+    if(error)
+        std::rethrow_exception(error);
 
     return EXIT_SUCCESS;
 }/* end main */
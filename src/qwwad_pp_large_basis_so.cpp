@@ -17,6 +17,12 @@
 		ank.r		eigenvectors	
 		Ek?.r		eigenenergies for each k
 
+   With --adaptive, the points in k.r are treated as a coarse path,
+   which is refined where the bands change rapidly.  The refined path
+   is written to k-adaptive.r, with Ek?.r and ank?.r for each point in
+   order along the path, and the band energies are written to
+   Ek-tracked.r with each band followed through crossings.
+
 
    Paul Harrison, April 2000                                
  
@@ -26,14 +32,25 @@
 # include <config.h>
 #endif
 
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <sstream>
 #include <complex>
+#include <vector>
 #include "struct.h"
 #include "maths.h"
+#include "qwwad/adaptive-k-path.h"
 #include "qwwad/constants.h"
 #include "qwwad/file-io.h"
+#include "qwwad/linear-algebra.h"
 #include "qwwad/options.h"
 #include "qwwad/ppff.h"	/* the PseudoPotential Form Factors	*/
 #include "qwwad/pplb-functions.h"
@@ -42,14 +59,6 @@
 using namespace QWWAD;
 using namespace constants;
 
-std::complex<double>
-Vso(const std::vector<atom>      &atoms,
-    const std::vector<arma::vec> &G,
-    arma::vec const              &k,
-    const unsigned int            i,
-    const unsigned int            j,
-    const size_t                  N);
-
 Options configure_options(int argc, char* argv[])
 {
     Options opt;
@@ -60,6 +69,16 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<size_t>("nmin,n",            4, "Lowest output band index (VB = 4, CB = 5)");
     opt.add_option<size_t>("nmax,m",            5, "Highest output band index (VB = 4, CB = 5)");
     opt.add_option<bool>  ("printev,w",            "Print eigenvectors to file");
+    opt.add_option<size_t>("threads",           0, "Number of threads used to process k points in parallel. "
+                                                   "If zero, the OpenMP default is used.");
+    opt.add_option<bool>  ("adaptive",             "Refine the path given in k.r where the output bands change "
+                                                   "rapidly, and write the refined path to k-adaptive.r");
+    opt.add_option<double>("energytol",         5, "Tolerance on the error in linear interpolation of band "
+                                                   "energies, in adaptive mode [meV]");
+    opt.add_option<double>("overlaptol",      0.9, "Smallest allowed overlap between eigenvectors at "
+                                                   "neighbouring k points, in adaptive mode");
+    opt.add_option<double>("minspacing",    0.005, "Smallest interval that is split, in adaptive mode [2pi/A0]");
+    opt.add_option<size_t>("maxpoints",      1000, "Largest number of k points, in adaptive mode");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -75,6 +94,11 @@ int main(int argc,char *argv[])
     const auto n_max = opt.get_option<size_t>("nmax")-1;               // Highest output band
     const auto ev    = opt.get_option<bool>  ("printev");              // Print eigenvectors?
 
+#ifdef _OPENMP
+    if(opt.get_option<size_t>("threads") > 0)
+        omp_set_num_threads(opt.get_option<size_t>("threads"));
+#endif
+
     // Read desired wave vector points from file
     std::valarray<double> kx;
     std::valarray<double> ky;
@@ -103,138 +127,149 @@ int main(int argc,char *argv[])
     const auto m_per_au = 4.0*pi*eps0*hBar*hBar/(e*e*me); // Unit conversion factor, m/a.u
 
     // Compute crystal potential matrix. Note that this is independent of wave-vector
-    // so we only need to do this once.
-    arma::cx_mat V_GG(Ns,Ns);
-
-    for(unsigned int i=0;i<N;i++) // index down rows within Block 1 and 2 of matrix
-    {
-        // Create upper triangle of Block 1
-        for(unsigned int j=i; j<N; j++)
-        {
-            const auto q = G[i] - G[j];
-            V_GG(i,j) = V(A0,m_per_au,atoms,q);
-
-            // Copy elements to upper triangle of all other blocks
-            V_GG(i+N, j) = V_GG(i, j+N) = V_GG(i+N, j+N) = V_GG(i,j);
-
-            // Since matrix is Hermitian, fill in the lower triangles in all 4 blocks
-            V_GG(j, i) = V_GG(j+N, i) = V_GG(j, i+N) = V_GG(j+N, i+N) = conj(V_GG(i,j));
-        }
-    }
-
-    /* Add k-dependent elements to matrix H_GG' */
-    for(unsigned int ik = 0; ik < nk; ++ik)
+    // and of spin, so we only need to do this once for a single spin block.
+    const CrystalPotential potential(A0, m_per_au, atoms);
+    const arma::cx_mat V_GG = potential.get_V_GG(G);
+
+    if(opt.get_verbose())
+        std::cout << "Found crystal potential for " << atoms.size() << " atoms of "
+                  << potential.get_n_species() << " species." << std::endl;
+
+    // The k-independent parts of the spin-orbit coupling
+    const SpinOrbitPotential spin_orbit(G, atoms);
+
+    // Find the energies and eigenvectors at a given wave vector, using the
+    // lower triangle of the Hamiltonian.  The eigenvectors overwrite the
+    // Hamiltonian
+    auto find_bands = [&](const arma::vec        &k_point,
+                          arma::cx_mat           &H_GG,
+                          arma::vec              &E,
+                          HermitianEigenSolver   &eigensolver)
     {
-        if(opt.get_verbose())
-            std::cout << "Calculating energy at k = " << std::endl
-                << k[ik] << " (" << ik + 1 << "/" << nk << ")" << std::endl;
-
-        auto H_GG = V_GG; // Complete Hamiltonian matrix
+        // The crystal potential does not couple opposite spins, so it
+        // only appears in the two diagonal blocks
+        H_GG.zeros();
+        H_GG.submat(0, 0, N-1,  N-1)  = V_GG; // Block 1
+        H_GG.submat(N, N, Ns-1, Ns-1) = V_GG; // Block 4
 
         for(unsigned int i=0;i<N;i++)        /* add kinetic energy to diagonal elements */
         {
             // kinetic energy component of H_GG [QWWAD3, 15.77]
-            arma::vec G_plus_k = G[i] + k[ik];
+            arma::vec G_plus_k = G[i] + k_point;
             const double G_plus_k_sq = dot(G_plus_k, G_plus_k);
             std::complex<double> T_GG=hBar*hBar/(2*me) * G_plus_k_sq;
             H_GG(i, i) += T_GG; // Block 1
             H_GG(i+N, i+N) += T_GG; // Block 4
         }
 
-        /* Add spin-orbit components to lower triangle	*/
-        for(unsigned int i=0;i<Ns;i++)
-        {
-            for(unsigned int j=0;j<=i;j++)	
-            {
-                H_GG(i,j) += Vso(atoms,G,k[ik],i,j,N);
-            }
-        }
+        // Add spin-orbit components to lower triangle
+        spin_orbit.add_to_lower_triangle(k_point, H_GG);
 
-        // Find the eigenvalues & eigenvectors of the Hamiltonian matrix
-        arma::vec E(N); // Energy eigenvalues
-        arma::cx_mat ank(Ns,Ns); // coefficients of eigenvectors
-        arma::eig_sym(E, ank, H_GG);
+        eigensolver.solve(H_GG, E);
+    };
 
-        /* Output eigenvalues in a separate file for each k point */
-        char	filenameE[9];	/* character string for Energy output filename	*/
-        sprintf(filenameE,"Ek%i.r",ik);
-        FILE *FEk=fopen(filenameE,"w");
+    if(opt.get_option<bool>("adaptive"))
+    {
+        // Storage for each thread, reused for every k point.  The path is
+        // refined in parallel, so the solver picks the storage for the
+        // thread that calls it.
+#ifdef _OPENMP
+        const size_t n_threads = omp_get_max_threads();
+#else
+        const size_t n_threads = 1;
+#endif
+        std::vector<arma::cx_mat>         H_GG_thread(n_threads, arma::cx_mat(Ns,Ns));
+        std::vector<arma::vec>            E_thread(n_threads, arma::vec(Ns));
+        std::vector<HermitianEigenSolver> eigensolver_thread(n_threads, HermitianEigenSolver(Ns));
 
-        for(auto iE=n_min; iE<=n_max; iE++)
-            fprintf(FEk,"%10.6f\n",E(iE)/e);
+        // Only the output bands are used to refine the path, but the
+        // neighbouring bands show whether a degenerate set is cut off
+        const double inf = std::numeric_limits<double>::infinity();
 
-        fclose(FEk);
+        AdaptiveKPath path(k, [&](const arma::vec &k_point, arma::vec &E_bands, arma::cx_mat &X,
+                                  double &E_below, double &E_above)
+        {
+#ifdef _OPENMP
+            const size_t ithread = omp_get_thread_num();
+#else
+            const size_t ithread = 0;
+#endif
+            auto &H_GG = H_GG_thread[ithread];
+            auto &E    = E_thread[ithread];
+            find_bands(k_point, H_GG, E, eigensolver_thread[ithread]);
+            E_bands = E.subvec(n_min, n_max);
+            X       = H_GG.cols(n_min, n_max);
+            E_below = (n_min > 0)            ? E(n_min-1) : -inf;
+            E_above = (n_max + 1 < E.size()) ? E(n_max+1) :  inf;
+        });
+
+        path.set_energy_tolerance(opt.get_option<double>("energytol")*1e-3*e);
+        path.set_overlap_tolerance(opt.get_option<double>("overlaptol"));
+        path.set_min_spacing(opt.get_option<double>("minspacing")*2.0*pi/A0);
+        path.set_max_points(opt.get_option<size_t>("maxpoints"));
+        path.refine();
 
-        /* Output eigenvectors */
+        if(opt.get_verbose())
+            std::cout << "Refined path from " << nk << " to " << path.get_n_points() << " k points."
+                      << std::endl;
 
-        if(ev){
-            write_ank(ank,ik,N,n_min,n_max);
-        }
+        write_adaptive_path(path, A0, N, ev);
+
+        return EXIT_SUCCESS;
     }
 
-    return EXIT_SUCCESS;
-}/* end main */
+    // Each k point is independent, so they are shared between threads.  Every
+    // k point is written to its own files, so the output does not depend on
+    // the order in which they are processed.
+    std::exception_ptr error;
 
-/**
- * \brief Spin-orbit component of H_GG
- *
- * \param[in] atoms   atomic definitions
- * \param[in] G	      reciprocal lattice vectors
- * \param[in] k       the electron momentum
- * \param[in] i	      index
- * \param[in] j       index
- * \param[in] N       number of reciprocal lattice vectors
- */
-std::complex<double>
-Vso(const std::vector<atom>      &atoms,
-    const std::vector<arma::vec> &G,
-    arma::vec const              &k,
-    const unsigned int            i,
-    const unsigned int            j,
-    const size_t                  N)
-{
-    std::complex<double> vso = 0; // intermediate value of spin-orbit interaction
-    arma::vec q;	/* a reciprocal lattice vector, G'-G 		*/
-
-    if((i<N)&&(j<N))	/* Block 1	*/
-    {   
-        const arma::vec A = cross(G[i] + k, G[j] + k);
-        vso = A(2);
-        q = G[i] - G[j];
-    }
-    if((i<N)&&(j>=N))	/* Block 2	*/
+#pragma omp parallel
     {
-        const arma::vec A = cross(G[i] + k, G[j-N] + k);
-        vso = std::complex<double>(A(0), -A(1));
-        q = G[i] - G[j-N];
-    }
-    if((i>=N)&&(j<N))	/* Block 3	*/
-    {
-        const arma::vec A = cross(G[i-N] + k, G[j] + k);
-        vso = std::complex<double>(A(0), A(1));
-        q = G[i-N] - G[j];
-    }
-    if((i>=N)&&(j>=N))	/* Block 4	*/
-    {
-        const arma::vec A = cross(G[i-N] + k, G[j-N] + k);
-        vso = -A(2);
-        q = G[i-N] - G[j-N];
-    }	
-    vso *= std::complex<double>(0,-1); /* -i(G'+k)x(G+k).sigma	*/
+        // Storage for each thread, reused for every k point
+        arma::cx_mat H_GG(Ns,Ns);            // Hamiltonian, then eigenvectors
+        arma::vec    E(Ns);                  // Energy eigenvalues
+        HermitianEigenSolver eigensolver(Ns);
 
-    // Potential term
-    std::complex<double> v=0;				/* Initialise for sum	*/
+#pragma omp for schedule(dynamic)
+        for(unsigned int ik = 0; ik < nk; ++ik)
+        {
+            try
+            {
+                if(opt.get_verbose())
+                {
+#pragma omp critical
+                    std::cout << "Calculating energy at k = " << std::endl
+                        << k[ik] << " (" << ik + 1 << "/" << nk << ")" << std::endl;
+                }
 
-    for(auto const atom : atoms)
-    {
-        const double q_dot_t = dot(q, atom.r);
-        const auto Lambda = lambda(atom.type);
-        v += Lambda * exp(std::complex<double>(0.0,-q_dot_t)); // [QWWAD3, 15.81]
+                find_bands(k[ik], H_GG, E, eigensolver);
+
+                // Output eigenvalues in a separate file for each k point
+                std::ostringstream filenameE;
+                filenameE << "Ek" << ik << ".r";
+                FILE *FEk=fopen(filenameE.str().c_str(),"w");
+
+                for(auto iE=n_min; iE<=n_max; iE++)
+                    fprintf(FEk,"%10.6f\n",E(iE)/e);
+
+                fclose(FEk);
+
+                // Output eigenvectors
+                if(ev)
+                    write_ank(H_GG,ik,N,n_min,n_max);
+            }
+            catch(...)
+            {
+#pragma omp critical
+                error = std::current_exception();
+            }
+        }
     }
 
-    v *= vso;
-    v/=atoms.size();
+    if(error)
+        std::rethrow_exception(error);
+
+    return EXIT_SUCCESS;
+}/* end main */
 
-    return v;
-}
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
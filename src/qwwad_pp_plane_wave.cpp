@@ -0,0 +1,142 @@
+/**
+ * \file   qwwad_pp_plane_wave.cpp
+ * \brief  Iterative plane-wave pseudopotential calculation
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ *
+ * \details This program finds the lowest bands of a user-defined cell, using
+ *          the same input and output files as qwwad_pp_large_basis.  The
+ *          Hamiltonian matrix is never stored, so much larger basis sets and
+ *          supercells can be used.
+ *
+ *          Input files:
+ *		atoms.xyz	atomic species and positions
+ *		G.r		reciprocal lattice vectors
+ *		k.r		electron wave vectors (k)
+ *
+ *          Output files:
+ *		ank.r		eigenvectors
+ *		Ek?.r		eigenenergies for each k
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <valarray>
+
+#include <armadillo>
+
+#include "qwwad/constants.h"
+#include "qwwad/options.h"
+#include "qwwad/ppff.h"
+#include "qwwad/file-io.h"
+#include "qwwad/plane-wave-solver.h"
+#include "qwwad/pplb-functions.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+Options configure_options(int argc, char* argv[])
+{
+    Options opt;
+
+    std::string doc("Iterative plane-wave pseudopotential calculation for user-defined cell.  Only "
+                    "the lowest bands, up to nmax, are found.");
+
+    opt.add_option<double>("latticeconst,A", 5.65, "Lattice constant [angstrom]");
+    opt.add_option<size_t>("nmin,n",            4, "Lowest output band index (VB = 4, CB = 5)");
+    opt.add_option<size_t>("nmax,m",            5, "Highest output band index (VB = 4, CB = 5)");
+    opt.add_option<bool>  ("printev,w",            "Print eigenvectors to file");
+    opt.add_option<double>("tolerance",      1e-6, "Tolerance on the residual of each band [eV]");
+    opt.add_option<size_t>("maxiter",         200, "Maximum number of iterations at each k point");
+    opt.add_option<size_t>("threads",           0, "Number of threads used to apply the Hamiltonian. "
+                                                   "If zero, the OpenMP default is used.");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, doc);
+
+    return opt;
+}
+
+int main(int argc,char *argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    const auto A0    = opt.get_option<double>("latticeconst") * 1e-10; // Lattice constant [m]
+    const auto n_min = opt.get_option<size_t>("nmin")-1;               // Lowest output band
+    const auto n_max = opt.get_option<size_t>("nmax")-1;               // Highest output band
+    const auto ev    = opt.get_option<bool>  ("printev");              // Print eigenvectors?
+
+#ifdef _OPENMP
+    if(opt.get_option<size_t>("threads") > 0)
+        omp_set_num_threads(opt.get_option<size_t>("threads"));
+#endif
+
+    // Read desired wave vector points from file
+    std::valarray<double> kx;
+    std::valarray<double> ky;
+    std::valarray<double> kz;
+    read_table("k.r", kx, ky, kz);
+    size_t nk = kx.size(); // Number of wave vector samples to compute
+
+    std::string filename("atoms.xyz");
+    auto const atoms = read_atoms(filename.c_str());
+
+    const auto G = read_rlv(A0); // read in reciprocal lattice vectors
+    const auto N = G.size(); // number of reciprocal lattice vectors
+
+    const auto m_per_au = 4.0*pi*eps0*hBar*hBar/(e*e*me); // Unit conversion factor, m/a.u
+
+    const CrystalPotential potential(A0, m_per_au, atoms);
+    PlaneWaveSolver solver(G, A0, potential, me);
+    solver.set_tolerance(opt.get_option<double>("tolerance")*e);
+    solver.set_max_iterations(opt.get_option<size_t>("maxiter"));
+
+    if(opt.get_verbose())
+        std::cout << "Using " << N << " plane waves and a " << solver.get_grid_size(0) << "x"
+                  << solver.get_grid_size(1) << "x" << solver.get_grid_size(2)
+                  << " real-space grid." << std::endl;
+
+    // The bands at each k point are used as the initial guess at the next
+    arma::vec    E;
+    arma::cx_mat ank;
+
+    for(unsigned int ik = 0; ik < nk; ++ik)
+    {
+        arma::vec k(3);
+        k(0) = kx[ik];
+        k(1) = ky[ik];
+        k(2) = kz[ik];
+        k *= 2.0*pi/A0;
+
+        solver.solve(k, n_max+1, E, ank);
+
+        if(opt.get_verbose())
+            std::cout << "k = (" << kx[ik] << ", " << ky[ik] << ", " << kz[ik] << ") converged in "
+                      << solver.get_iterations() << " iterations (" << ik + 1 << "/" << nk << ")"
+                      << std::endl;
+
+        // Output eigenvalues in a separate file for each k point
+        std::ostringstream filenameE;
+        filenameE << "Ek" << ik << ".r";
+        FILE *FEk=fopen(filenameE.str().c_str(),"w");
+
+        for(auto iE=n_min; iE<=n_max; iE++)
+            fprintf(FEk,"%10.6f\n",E(iE)/e);
+
+        fclose(FEk);
+
+        if(ev)
+            write_ank(ank,ik,N,n_min,n_max);
+    }
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -30,25 +30,21 @@
 #include <cmath>
 #include <cstdlib>
 #include <complex>
+#include <string>
+#include <vector>
 #include "struct.h"
 #include "maths.h"
 #include "qwwad/constants.h"
 #include "qwwad/file-io.h"
 #include "qwwad/linear-algebra.h"
 #include "qwwad/ppff.h"
+#include "qwwad/pplb-functions.h"
 
 using namespace QWWAD;
 using namespace constants;
 
 static std::complex<double> i1(0,1);
 
-static std::complex<double>
-V(double           A0,
-  double           m_per_au,
-  std::vector<atom> const &atoms,
-  std::vector<atom> const &atomsp,
-  arma::vec const &g);
-
 static std::complex<double>
 VF(double           A0,
    double           F,
@@ -56,6 +52,16 @@ VF(double           A0,
    std::vector<atom> const &atoms,
    arma::vec const &g);
 
+static arma::cx_mat
+W_GG(double                         A0,
+     double                         m_per_au,
+     double                         F,
+     double                         q,
+     std::vector<atom> const       &atoms,
+     std::vector<atom> const       &atomsp,
+     std::vector<arma::vec> const  &G,
+     arma::vec const               &dk);
+
 static std::valarray<std::complex<double>> read_ank(int N,
                                                     int Nn,
                                                     int Nkxi);
@@ -152,54 +158,40 @@ int main(int argc,char *argv[])
 
     if(o) write_VF(A0,F,q,atoms);
 
+    // Copy the bulk eigenvectors at each kxi into an N x Nn matrix
+    std::vector<arma::cx_mat> A(Nkxi, arma::cx_mat(N, Nn));
+
+    for(unsigned int ikxi=0; ikxi<Nkxi; ikxi++)
+        for(unsigned int iG=0; iG<N; iG++)
+            for(int in=0; in<Nn; in++)
+                A[ikxi](iG, in) = ank[ikxi*N*Nn+iG*Nn+in];
+
     arma::cx_mat Hdash(Nn*Nkxi, Nn*Nkxi);
 
-    /* Create H' matrix elements	*/
-    for(unsigned int i=0;i<Nn*Nkxi;i++)	/* index down rows, recall order of Hdash is Nn*Nkxi */
+    /* Create H' matrix elements.  Each block of Nn x Nn elements couples the
+       bands at a pair of bulk k points, and is found as a product of the
+       bulk eigenvectors with the matrix of the perturbing potential between
+       all pairs of plane waves [QWWAD4, 16.38].  The matrix is Hermitian, so
+       only the upper triangle of blocks is computed */
+    for(unsigned int ikxidash=0; ikxidash<Nkxi; ikxidash++)
     {
-        // TODO: Just fill in the upper triangle 
-        for(unsigned int j=0; j<N;j++)
+        for(unsigned int ikxi=ikxidash; ikxi<Nkxi; ikxi++)
         {
-            /* Deduce the indices of of the bulk eigenvectors for each H' element	*/
-            auto const ikxidash=i/Nn;
-            auto const ikxi=j/Nn;
+            const arma::vec    dk   = kxi[ikxidash] - kxi[ikxi];
+            const arma::cx_mat W    = W_GG(A0, m_per_au, F, q, atoms, atomsp, G, dk);
+            const arma::cx_mat Wank = W * A[ikxi];
+            const arma::cx_mat block = A[ikxidash].t() * Wank;
 
-            auto const indash=i%Nn;
-            auto const in=j%Nn;
+            Hdash.submat(ikxidash*Nn, ikxi*Nn, (ikxidash+1)*Nn-1, (ikxi+1)*Nn-1) = block;
 
-            /* Initialise the matrix element before the sum and add energy
-               eigenvalues as specified by delta functions 	*/
-            if((indash==in)&&(ikxidash==ikxi))
-                Hdash(i, j) = Enk[ikxi*Nn+in];
-            else
-                Hdash(i, j) = 0;
+            if(ikxi != ikxidash)
+                Hdash.submat(ikxi*Nn, ikxidash*Nn, (ikxi+1)*Nn-1, (ikxidash+1)*Nn-1) = block.t();
+        }
+    }
 
-            for(unsigned int iGdash=0;iGdash<N;iGdash++)	/* sum over G'	*/
-            {
-                for(unsigned int iG=0;iG<N;iG++)			/* sum over G	*/
-                {
-                    // Calculate appropriate g vector [QWWAD4, 16.38]
-                    auto g = G[iGdash] - G[iG] + kxi[ikxidash] - kxi[ikxi];
-
-                    // Add on potential term
-                    Hdash(i, j) +=
-                        (
-                         ( conj(   ank[ikxidash*N*Nn+iGdash*Nn+indash]   )
-
-                           *
-
-                           ank[ikxi*N*Nn+iG*Nn+in]
-                         )
-                         *
-                         (
-                          V(A0,m_per_au,atoms,atomsp,g) +
-                          VF(A0,F,q,atoms,g)
-                         )
-                        );
-                } /* end iG */
-            } /* end iGdash */
-        } /* end j */
-    } /* end i */
+    // Add bulk energy eigenvalues on the diagonal
+    for(unsigned int i=0; i<Nn*Nkxi; i++)
+        Hdash(i, i) += Enk[i];
 
     // Clean up matrix H'
     clean_Hdash(Hdash);
@@ -422,45 +414,139 @@ static std::vector<arma::vec> read_kxi(double  A0)
 }
 
 /**
- * \brief Potential component of Hdash
+ * \brief Perturbing potential between every pair of plane waves
  *
- * \param A0	   Lattice constant
+ * \param A0       Lattice constant
  * \param m_per_au conversion factor from SI to a.u.
+ * \param F        the electric field strength
+ * \param q        the carrier charge
  * \param atoms    atomic definitions
  * \param atomsp   atomic definitions
- * \param g        the vector, g=G'-G+kxi'-kxi
+ * \param G        reciprocal lattice vectors
+ * \param dk       difference between bulk wave vectors, kxi'-kxi
+ *
+ * \returns Matrix with element (G',G) equal to V(g) + VF(g), where
+ *          g = G'-G+kxi'-kxi
+ *
+ * \details The atoms are grouped by their species in the unperturbed and
+ *          perturbed lattices.  Groups whose species are unchanged do not
+ *          contribute.  For each other group, the form factors are found
+ *          once for each distinct |g| and the structure factor is found as
+ *          a product of matrices of phase factors.
  */
-static std::complex<double>
-V(double           A0,
-  double           m_per_au,
-  std::vector<atom> const &atoms,
-  std::vector<atom> const &atomsp,
-  arma::vec const &g)
+static arma::cx_mat
+W_GG(double                         A0,
+     double                         m_per_au,
+     double                         F,
+     double                         q,
+     std::vector<atom> const       &atoms,
+     std::vector<atom> const       &atomsp,
+     std::vector<arma::vec> const  &G,
+     arma::vec const               &dk)
 {
- std::complex<double> v;     /* potential					*/
- double	vf;	/* storage for returned data from Vf()		*/
- double	vfdash;	/* storage for returned data from Vf()		*/
- v=0;
-
- // Sum over atoms [QWWAD4, 16.50]
- auto const n_atoms = atoms.size();
- for(unsigned int ia=0;ia<n_atoms;ia++)
- {
-     // general vector representing atom within cell
-     auto const t = atoms[ia].r;
-     auto const g_dot_g = arma::dot(g,g);
-     auto const g_dot_t = arma::dot(g,t);
-
-     vf=Vf(A0, m_per_au,   g_dot_g, atoms[ia].type);
-     vfdash=Vf(A0,m_per_au,g_dot_g, atomsp[ia].type);
-     v += exp(-i1*g_dot_t)*(vfdash-vf);
- }
+    auto const N = G.size();
+    auto const n_atoms = atoms.size();
+
+    if(atomsp.size() != n_atoms)
+    {
+        fprintf(stderr, "Error: atoms.xyz and atomsp.xyz contain different numbers of atoms!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Find the distinct shells of |g|^2
+    arma::mat g_sqr(N, N);
+
+    for(unsigned int iG=0; iG<N; iG++)
+    {
+        for(unsigned int iGdash=0; iGdash<N; iGdash++)
+        {
+            arma::vec const g = G[iGdash] - G[iG] + dk;
+            g_sqr(iGdash, iG) = arma::dot(g,g);
+        }
+    }
+
+    arma::vec        shell_g_sqr;
+    arma::umat const shell = find_q_sqr_shells(g_sqr, A0, shell_g_sqr);
+
+    // Group the atoms whose species is changed by the perturbation
+    std::vector<std::string>            type;
+    std::vector<std::string>            typep;
+    std::vector<std::vector<arma::vec>> positions;
+
+    for(unsigned int ia=0; ia<n_atoms; ia++)
+    {
+        const std::string name(atoms[ia].type);
+        const std::string namep(atomsp[ia].type);
 
- /* These last divisions represent Omega_c/Omega_sl included here for
-    convenience	*/
- v/=(double)(n_atoms/2);
+        if(name == namep)
+            continue;
+
+        unsigned int igroup = 0;
+
+        while(igroup < type.size() && (type[igroup] != name || typep[igroup] != namep))
+            igroup++;
+
+        if(igroup == type.size())
+        {
+            type.push_back(name);
+            typep.push_back(namep);
+            positions.push_back(std::vector<arma::vec>());
+        }
+
+        positions[igroup].push_back(atoms[ia].r);
+    }
+
+    arma::cx_mat W = arma::zeros<arma::cx_mat>(N, N);
+
+    for(unsigned int igroup=0; igroup<type.size(); igroup++)
+    {
+        // Change in form factor in each shell
+        arma::vec const dVf = find_Vf_shells(A0, m_per_au, shell_g_sqr, typep[igroup])
+                            - find_Vf_shells(A0, m_per_au, shell_g_sqr, type[igroup]);
+
+        // Phase factors exp(-i(G'+dk).t) and exp(-iG.t) for each atom, so
+        // that their product gives exp(-ig.t) [QWWAD4, 16.50]
+        auto const n_group = positions[igroup].size();
+        arma::cx_mat E_left(N, n_group);
+        arma::cx_mat E_right(N, n_group);
+
+        for(unsigned int ia=0; ia<n_group; ia++)
+        {
+            auto const &t = positions[igroup][ia];
+
+            for(unsigned int iG=0; iG<N; iG++)
+            {
+                E_left(iG, ia)  = exp(-i1*arma::dot(G[iG] + dk, t));
+                E_right(iG, ia) = exp(-i1*arma::dot(G[iG], t));
+            }
+        }
+
+        arma::cx_mat const S = E_left * E_right.t();
+
+        for(unsigned int iG=0; iG<N; iG++)
+            for(unsigned int iGdash=0; iGdash<N; iGdash++)
+                W(iGdash, iG) += dVf(shell(iGdash, iG)) * S(iGdash, iG);
+    }
+
+    /* This last division represents Omega_c/Omega_sl included here for
+       convenience	*/
+    W /= (double)(n_atoms/2);
+
+    // The field only couples plane waves with equal in-plane components, so
+    // VF is cheap to evaluate
+    if(F != 0.0)
+    {
+        for(unsigned int iG=0; iG<N; iG++)
+        {
+            for(unsigned int iGdash=0; iGdash<N; iGdash++)
+            {
+                arma::vec const g = G[iGdash] - G[iG] + dk;
+                W(iGdash, iG) += VF(A0, F, q, atoms, g);
+            }
+        }
+    }
 
- return(v);
+    return W;
 }
 
 /**
@@ -25,6 +25,7 @@
 #include <complex>
 #include "qwwad/options.h"
 #include "qwwad/file-io.h"
+#include "qwwad/scattering-calculator-acoustic.h"
 #include "qwwad/subband.h"
 #include "qwwad/constants.h"
 #include "qwwad/maths-helpers.h"
@@ -32,13 +33,6 @@
 using namespace QWWAD;
 using namespace constants;
 
-static void ff_table(const double   dKz,
-                     const Subband &isb,
-                     const Subband &fsb,
-                     unsigned int   nKz,
-                     arma::vec     &Kz,
-                     arma::vec     &Gifsqr);
-
 /* This function outputs the formfactors into files	*/
 static void ff_output(const arma::vec &Kz,
                       const arma::vec &Gifsqr,
@@ -72,6 +66,9 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<size_t>("nki",               301,  "Number of initial wave-vector samples.");
     opt.add_option<size_t>("nkz",               301,  "Number of phonon wave-vector samples.");
     opt.add_option<size_t>("ntheta",            101,  "Number of strips in theta angle integration");
+    opt.add_option<double>("tolerance",               "Relative tolerance for average rates. If specified, the "
+                                                      "averages are found by adaptive integration rather than "
+                                                      "from the table of rates.");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -97,28 +94,6 @@ int main(int argc,char *argv[])
     const auto nKz     =  opt.get_option<size_t>("nkz");                  // number of Kz calculations
     const auto ntheta  =  opt.get_option<size_t>("ntheta");               // number of samples over angle
 
-    char	filename[9];	/* character string for output filename		*/
-    FILE	*FACa;		/* pointer to absorption output file		*/
-    FILE	*FACe;		/* pointer to emission   output file		*/
-
-    // calculate step length in phonon wave-vector
-    const double dKz=2/(A0*nKz); // Taken range of phonon integration as 2/A0
-
-    const double dtheta=pi/static_cast<double>(ntheta-1); // theta integration from 0 to pi
-
-    // Can save a bit of time by calculating cosines in advance
-    arma::vec cos_theta(ntheta);
-
-    for(unsigned int itheta = 0; itheta < ntheta; ++itheta)
-        cos_theta[itheta]     = cos(itheta*dtheta);
-
-    // calculate often used constants
-    const double N0=1/(exp(Ephonon/(kB*Tl))-1); // Bose-Einstein factor
-
-    // Find pre-factors for scattering rates
-    const double Upsilon_a = Da*Da*m*N0/(rho*Vs*4*pi*pi*hBar*hBar);
-    const double Upsilon_e = Da*Da*m*(N0+1)/(rho*Vs*4*pi*pi*hBar*hBar);
-
     std::ostringstream E_filename; // Energy filename string
     E_filename << "E" << p << ".r";
     std::ostringstream wf_prefix;  // Wavefunction filename prefix
@@ -139,217 +114,103 @@ int main(int argc,char *argv[])
     for(unsigned int isb = 0; isb < subbands.size(); ++isb)
         subbands[isb].set_distribution_from_Ef_Te(Ef[isb], Te);
 
+    // Initialise scattering calculators and set parameters
+    ScatteringCalculatorAcoustic em_calculator(subbands, A0, Ephonon, Da, rho, Vs, m, Te, Tl, true);
+    ScatteringCalculatorAcoustic ab_calculator(subbands, A0, Ephonon, Da, rho, Vs, m, Te, Tl, false);
+    em_calculator.enable_blocking(b_flag);
+    ab_calculator.enable_blocking(b_flag);
+    em_calculator.set_phonon_samples(nKz);
+    ab_calculator.set_phonon_samples(nKz);
+    em_calculator.set_theta_samples(ntheta);
+    ab_calculator.set_theta_samples(ntheta);
+    em_calculator.set_ki_samples(nki);
+    ab_calculator.set_ki_samples(nki);
+
     // Read list of wanted transitions
     arma::uvec i_indices;
     arma::uvec f_indices;
 
     read_table("rrp.r", i_indices, f_indices);
     const size_t ntx = i_indices.size();
-    arma::vec Wabar(ntx);
-    arma::vec Webar(ntx);
 
-    // Loop over all desired transitions
-    for(unsigned int itx = 0; itx < ntx; ++itx)
-    {
-        // State indices for this transition (NB., these are indexed from 1)
-        unsigned int i = i_indices[itx];
-        unsigned int f = f_indices[itx];
+    // Note that the -1 is needed because the input file indexes subbands from 1 upward
+    const arma::uvec i_indices_0 = i_indices - 1;
+    const arma::uvec f_indices_0 = f_indices - 1;
 
-        // Convenience labels for each subband (NB., these are indexed from 0)
-        const Subband isb = subbands[i-1];
-        const Subband fsb = subbands[f-1];
-
-        // Subband minima
-        const double Ei = isb.get_E_min();
-        const double Ef = fsb.get_E_min();
-
-        arma::vec Kz(nKz);
-        arma::vec Gifsqr(nKz);
-        ff_table(dKz,isb,fsb,nKz,Kz,Gifsqr);		/* generates formfactor table	*/
-        arma::vec Kz_sqr(nKz);
-
-        for(unsigned int iKz = 0; iKz < nKz; ++iKz)
-            Kz_sqr[iKz] = Kz[iKz]*Kz[iKz];
-
-        // Output formfactors if desired
-        if(ff_flag)
-            ff_output(Kz, Gifsqr, i, f);
-
-        /* Generate filename for particular mechanism and open file	*/
-        sprintf(filename,"ACa%i%i.r", i, f); // absorption
-        FACa=fopen(filename,"w");			
-        sprintf(filename,"ACe%i%i.r", i, f); // emission
-        FACe=fopen(filename,"w");			
-
-        // As a zero energy phonon is assumed, no need to 
-        // consider emission and absorption processes as in e-LO scattering
-        double kimax = 0;
-        double Ecutoff = 0.0; // Maximum kinetic energy in initial subband
-        const double DeltaE = Ef - Ei;
+    // Use user-specified cut-off energy if given.  Otherwise, a fixed 5kT range is used
+    if(opt.get_argument_known("Ecutoff"))
+    {
+        const auto Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
 
-        // Use user-specified value if given
-        if(opt.get_argument_known("Ecutoff"))
+        for(unsigned int itx = 0; itx < ntx; ++itx)
         {
-            Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+            const auto Ei = subbands[i_indices_0[itx]].get_E_min();
+            const auto Ef = subbands[f_indices_0[itx]].get_E_min();
 
             if(Ecutoff+Ei < Ef)
             {
-                std::cerr << "No scattering permitted from state " << i << "->" << f << " within the specified cut-off energy." << std::endl;
+                std::cerr << "No scattering permitted from state " << i_indices[itx] << "->" << f_indices[itx]
+                          << " within the specified cut-off energy." << std::endl;
                 std::cerr << "Extending range automatically" << std::endl;
-                Ecutoff += Ef;
             }
         }
-        // Otherwise, use a fixed, 5kT range
-        else
-        {
-            kimax   = isb.get_k_max(Te);
-            Ecutoff = hBar*hBar*kimax*kimax/(2*m);
 
-            if(Ecutoff+Ei < Ef)
-                Ecutoff += Ef;
-        }
+        em_calculator.set_Eki_cutoff(Ecutoff);
+        ab_calculator.set_Eki_cutoff(Ecutoff);
+    }
 
-        kimax = isb.get_k_at_Ek(Ecutoff);
+    // The form factors are the same for emission and absorption, so
+    // only compute them once
+    ab_calculator.share_pair_data(em_calculator);
+    em_calculator.prepare(i_indices_0, f_indices_0);
 
-        const double dki=kimax/((float)nki);
-        arma::vec Waif(nki); // Absorption scattering rate at this wave-vector [1/s]
-        arma::vec Weif(nki); // Emission scattering rate at this wave-vector [1/s]
-        arma::vec Wabar_integrand_ki(nki); // Average scattering rate [1/s]
-        arma::vec Webar_integrand_ki(nki); // Average scattering rate [1/s]
-        const double tmp = 2*m*DeltaE/(hBar*hBar);
+    const auto tx_em_list = em_calculator.get_transitions(i_indices_0, f_indices_0);
+    const auto tx_ab_list = ab_calculator.get_transitions(i_indices_0, f_indices_0);
 
-        for(unsigned int iki=0;iki<nki;iki++)       /* calculate e-AC rate for all ki	*/
-        {
-            const double ki=dki*(float)iki+dki/100;	/* second term avoids ki=0 pole	*/
+    arma::vec Wabar(ntx);
+    arma::vec Webar(ntx);
 
-            arma::vec Wif_integrand_dtheta(ntheta);
+    // Loop over all desired transitions
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        // State indices for this transition (NB., these are indexed from 1)
+        unsigned int i = i_indices[itx];
+        unsigned int f = f_indices[itx];
 
-            /* Integral around angle theta	*/
-            for(unsigned int itheta=0;itheta<ntheta;itheta++)
-            {
-                arma::vec Wif_integrand_dKz(nKz);
-
-                /* Integral over phonon wavevector Kz	*/
-                for(unsigned int iKz=0;iKz<nKz;iKz++)
-                {
-                    const double ki_cos_theta = ki*cos_theta[itheta];
-                    const double arg = ki_cos_theta * ki_cos_theta - tmp;	// sqrt argument
-                    if(arg>=0)
-                    {
-                        const double sqrt_arg = sqrt(arg);
-
-                        // solutions for phonon wavevector Kz
-                        const double alpha1 =  sqrt_arg - ki_cos_theta;
-                        const double alpha2 = -sqrt_arg - ki_cos_theta;
-
-                        const double alpha1_sqr = alpha1*alpha1;
-                        const double alpha2_sqr = alpha2*alpha2;
-
-                        /* alpha1 and alpha2 represent solutions for the in-plane polar
-                           coordinate Kxy of the carrier momentum---they must be positive, hence
-                           use Heaviside unit step function to ignore other contributions	*/
-                        Wif_integrand_dKz[iKz] = Gifsqr[iKz]*
-                            (alpha1*Theta(alpha1)*sqrt(alpha1_sqr + Kz_sqr[iKz])+
-                             alpha2*Theta(alpha2)*sqrt(alpha2_sqr + Kz_sqr[iKz]))/
-                            (alpha1-alpha2);
-                    }
-                } /* end integral over Kz	*/
-
-                Wif_integrand_dtheta[itheta] = integral(Wif_integrand_dKz, dKz);
-            } /* end integral over theta	*/
-
-            const double Wif = integral(Wif_integrand_dtheta, dtheta);
-            Waif[iki]=2*Upsilon_a*Wif;
-            Weif[iki]=2*Upsilon_e*Wif;
-
-            /* Now check for energy conservation!, would be faster with a nasty `if'
-               statement just after the beginning of the ki loop!                 */
-            const double Eki = isb.get_Ek_at_k(ki);
-            const double Ef_em = Eki - DeltaE - Ephonon;
-            const double Ef_ab = Eki - DeltaE + Ephonon;
-            Weif[iki] *= Theta(Ef_em);
-            Waif[iki] *= Theta(Ef_ab);
-
-            // Include final-state blocking factor
-            if (b_flag)
-            {
-                // Final wave-vector
-                if(Ef_em >= 0)
-                {
-                    const double kf_em = sqrt(Ef_em*2*m)/hBar;
-                    Weif[iki] *= (1.0 - fsb.get_occupation_at_k(kf_em));
-                }
-
-                if(Ef_ab >= 0)
-                {
-                    const double kf_ab = sqrt(Ef_ab*2*m)/hBar;
-                    Waif[iki] *= (1.0 - fsb.get_occupation_at_k(kf_ab));
-                }
-            }
+        // Output formfactors if desired
+        if(ff_flag)
+            ff_output(em_calculator.get_Kz_table(), em_calculator.get_ff_table(i-1, f-1), i, f);
 
-            Wabar_integrand_ki[iki] = Waif[iki]*ki*isb.get_occupation_at_k(ki);
-            Webar_integrand_ki[iki] = Weif[iki]*ki*isb.get_occupation_at_k(ki);
+        const auto &tx_em = tx_em_list[itx];
+        const auto &tx_ab = tx_ab_list[itx];
+        const auto Weif   = tx_em.get_rate_table(); // Emission scattering rate at this wave-vector [1/s]
+        const auto Waif   = tx_ab.get_rate_table(); // Absorption scattering rate at this wave-vector [1/s]
 
-            /* output scattering rate versus carrier energy=subband minima+in-plane
-               kinetic energy						*/
-            fprintf(FACa,"%20.17le %20.17le\n",(Ei + gsl_pow_2(hBar*ki)/(2*m))/
-                    (1e-3*e),Waif[iki]);
+        // Output scattering rate versus carrier energy=subband minima+in-plane kinetic energy
+        arma::vec Ei_total = tx_em.get_Ei_total_table();
+        Ei_total *= 1000.0/e; // Rescale to meV
 
-            fprintf(FACe,"%20.17le %20.17le\n",(Ei + gsl_pow_2(hBar*ki)/(2*m))/
-                    (1e-3*e),Weif[iki]);
-        }
-        Wabar[itx] = integral(Wabar_integrand_ki, dki)/(pi*isb.get_total_population());
-        Webar[itx] = integral(Webar_integrand_ki, dki)/(pi*isb.get_total_population());
+        char filename[9]; /* character string for output filename */
+        sprintf(filename,"ACa%i%i.r", i, f); // absorption
+        write_table(filename, Ei_total, Waif);
+        sprintf(filename,"ACe%i%i.r", i, f); // emission
+        write_table(filename, Ei_total, Weif);
 
-        fclose(FACa);	/* close output file for this mechanism	*/
-        fclose(FACe);	/* close output file for this mechanism	*/
+        // Average rates over entire subband
+        Wabar[itx] = tx_ab.get_average_rate();
+        Webar[itx] = tx_em.get_average_rate();
     } /* end while over states */
 
+    // Replace the averages with error-controlled values if wanted
+    if(opt.get_argument_known("tolerance"))
+    {
+        const auto tolerance = opt.get_option<double>("tolerance");
+        Wabar = ab_calculator.get_average_rates(i_indices_0, f_indices_0, tolerance);
+        Webar = em_calculator.get_average_rates(i_indices_0, f_indices_0, tolerance);
+    }
+
     write_table("ACa-if.r", i_indices, f_indices, Wabar);
     write_table("ACe-if.r", i_indices, f_indices, Webar);
     return EXIT_SUCCESS;
 } /* end main */
-
-/**
- * \brief calculates the overlap integral squared between the two states
- */
-static double Gsqr(const double   Kz,
-                   const Subband &isb,
-                   const Subband &fsb)
-{
- const auto z = isb.z_array();
- const double dz = z[1] - z[0];
- const double nz = z.size();
- const auto psi_i = isb.psi_array();
- const auto psi_f = fsb.psi_array();
-
- std::complex<double> I(0,1); // Imaginary unit
-
- // Find form-factor integral
- arma::cx_vec G_integrand_dz(nz);
-
- for(unsigned int iz=0; iz<nz; ++iz)
-     G_integrand_dz[iz] = exp(Kz*z[iz]*I) * psi_i[iz] * psi_f[iz];
-
- auto G = integral(G_integrand_dz, dz);
-
- return norm(G);
-}
-
-/**
- * \brief Computes the formfactor at a range of phonon wave-vectors
- */
-static void ff_table(const double   dKz,
-                     const Subband &isb,
-                     const Subband &fsb,
-                     unsigned int   nKz,
-                     arma::vec     &Kz,
-                     arma::vec     &Gifsqr)
-{
-    for(unsigned int iKz=0;iKz<nKz;iKz++)
-    {
-        Kz[iKz]     = iKz*dKz;                 // Magnitude of phonon wave vector
-        Gifsqr[iKz] = Gsqr(Kz[iKz], isb, fsb); // Squared form-factor
-    }
-}
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -14,7 +14,7 @@
 #include "qwwad/subband.h"
 #include "qwwad/options.h"
 #include "qwwad/file-io.h"
-#include "qwwad/maths-helpers.h"
+#include "qwwad/scattering-calculator-alloy.h"
 
 using namespace QWWAD;
 using namespace constants;
@@ -35,6 +35,9 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<double>("temperature,T",   300, "Temperature of carrier distribution.");
     opt.add_option<double>("Ecutoff",              "Cut-off energy for carrier distribution [meV]. If not specified, then 5kT above band-edge.");
     opt.add_option<size_t>("nki",             101, "Number of initial wave-vector samples.");
+    opt.add_option<double>("tolerance",            "Relative tolerance for average rates. If specified, the "
+                                                   "averages are found by adaptive integration rather than "
+                                                   "from the table of rates.");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -85,114 +88,69 @@ int main(int argc,char *argv[])
 
     read_table("rrp.r", i_indices, f_indices);
 
-    FILE *Favg=fopen("ado-avg.dat","w"); // open file for output of weighted means
-
-    // Loop over all desired transitions
-    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
-    {
-        // State indices for this transition (NB., these are indexed from 1)
-        unsigned int i = i_indices[itx];
-        unsigned int f = f_indices[itx];
-
-        // Convenience labels for each subband (NB., these are indexed from 0)
-        const Subband isb = subbands[i-1];
-        const Subband fsb = subbands[f-1];
+    const double Omega = alatt*alatt*alatt/Ncell; // Volume occupied by each scatterer [m^3]
 
-        // Subband minima
-        const double Ei = isb.get_E_min();
-        const double Ef = fsb.get_E_min();
+    ScatteringCalculatorAlloy calc(subbands, x, Vad, Omega, m, T);
+    calc.enable_blocking(b_flag);
+    calc.set_ki_samples(nki);
 
-        // Find minimum initial wave-vector that allows scattering
-        const double Efi = Ef - Ei;
-        double kimin = 0.0;
-        if(Efi > 0)
-            kimin = sqrt(2*m*Efi)/hBar;
-
-        double kimax = 0;
-        double Ecutoff = 0.0; // Maximum kinetic energy in initial subband
+    // Use user-specified cut-off energy if given
+    if(opt.get_argument_known("Ecutoff"))
+    {
+        const auto Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+        calc.set_Eki_cutoff(Ecutoff);
 
-        // Use user-specified value if given
-        if(opt.get_argument_known("Ecutoff"))
+        for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
         {
-            Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+            const auto i = i_indices[itx];
+            const auto f = f_indices[itx];
 
-            if(Ecutoff+Ei < Ef)
+            if(Ecutoff + subbands[i-1].get_E_min() < subbands[f-1].get_E_min())
             {
                 std::cerr << "No scattering permitted from state " << i << "->" << f << " within the specified cut-off energy." << std::endl;
                 std::cerr << "Extending range automatically" << std::endl;
-                Ecutoff += Ef;
             }
         }
-        // Otherwise, use a fixed, 5kT range
-        else
-        {
-            kimax   = isb.get_k_max(T);
-            Ecutoff = hBar*hBar*kimax*kimax/(2*m);
-
-            if(Ecutoff+Ei < Ef)
-                Ecutoff += Ef;
-        }
-
-        kimax = isb.get_k_at_Ek(Ecutoff);
-
-        const double dki=(kimax-kimin)/((float)nki - 1); // step length for loop over ki
+    }
 
-        arma::vec Wbar_integrand_ki(nki); // initialise integral for average scattering rate
-        arma::vec Wif(nki);               // Scattering rate for a given initial wave vector
-        arma::vec Ei_t(nki);              // Total energy of initial state (for output file) [meV]
+    // Subbands are indexed from zero in the calculator
+    const arma::uvec i_idx0 = i_indices - 1;
+    const arma::uvec f_idx0 = f_indices - 1;
+    const auto transitions = calc.get_transitions(i_idx0, f_idx0);
 
-        // Find alloy-disorder matrix element
-        const auto psi_i = isb.psi_array();
-        const auto psi_f = fsb.psi_array();
-        const arma::vec integrand_dz = psi_i%psi_i%psi_f%psi_f%x%(1.0-x);
-        const double dz = z[1] - z[0];
-        const double Omega = alatt*alatt*alatt/Ncell;
-        const double I = m*Omega*Vad*Vad/(hBar*hBar*hBar) * integral(integrand_dz, dz);
+    // Average rates for each transition
+    arma::vec Wbar(i_indices.size());
 
-        // calculate scattering rate for all ki
-        for(unsigned int iki=0;iki<nki;iki++)
-        {
-            const double ki=kimin+dki*iki; // carrier momentum
-            const double ki_sqr = ki*ki;
-
-            // Find energy-conserving final wave-vector
-            // This should be positive if the kimin value is correct
-            const double kf_sqr = ki_sqr + 2*m*(Ei - Ef)/(hBar*hBar);
-            assert(kf_sqr >= 0.0);
-            const double kf = sqrt(kf_sqr);
-            assert(!std::isnan(kf));
-
-            Wif[iki] = I; // Scattering rate is same at all wave-vectors
-
-            // Include final-state blocking factor
-            if (b_flag)
-            {
-                const auto f_FD = fsb.get_occupation_at_k(kf);
-                Wif[iki] *= (1 - f_FD);
-            }
+    if(opt.get_argument_known("tolerance"))
+        Wbar = calc.get_average_rates(i_idx0, f_idx0, opt.get_option<double>("tolerance"));
+    else
+    {
+        for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+            Wbar[itx] = transitions[itx].get_average_rate();
+    }
 
-            Ei_t[iki] = isb.get_E_total_at_k(ki) * 1000/e;
+    FILE *Favg=fopen("ado-avg.dat","w"); // open file for output of weighted means
 
-            /* calculate Fermi-Dirac weighted mean of scattering rates over the 
-               initial carrier states, note that the integral step length 
-               dE=2*sqr(hBar)*ki*dki/(2m)					*/
-            const auto f_FD_i = isb.get_occupation_at_k(ki);
-            Wbar_integrand_ki[iki] = Wif[iki]*ki*f_FD_i;
-        } /* end ki	*/
+    // Loop over all desired transitions
+    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+    {
+        // State indices for this transition (NB., these are indexed from 1)
+        const unsigned int i = i_indices[itx];
+        const unsigned int f = f_indices[itx];
+        const auto &tx = transitions[itx];
 
         /* output scattering rate versus carrier energy=subband minima+in-plane
            kinetic energy						*/
         char	filename[9];	/* character string for output filename		*/
         sprintf(filename,"ado%i%i.r",i,f);
-        write_table(filename, Ei_t, Wif);
-
-        const double Wbar = integral(Wbar_integrand_ki, dki)/(pi*isb.get_total_population());
+        const arma::vec Ei_t = tx.get_Ei_total_table() * 1000/e;
+        write_table(filename, Ei_t, tx.get_rate_table());
 
-        fprintf(Favg,"%i %i %20.17le\n", i,f,Wbar);
-} /* end while over states */
+        fprintf(Favg,"%i %i %20.17le\n", i,f,Wbar[itx]);
+    }
 
-fclose(Favg);	/* close weighted mean output file	*/
+    fclose(Favg);	/* close weighted mean output file	*/
 
-return EXIT_SUCCESS;
+    return EXIT_SUCCESS;
 } /* end main */
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -5,14 +5,19 @@
  * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <tuple>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_interp.h>
 #include <gsl/gsl_spline.h>
+#include "qwwad/carrier-carrier-form-factors.h"
 #include "qwwad/constants.h"
 #include "qwwad/subband.h"
 #include "qwwad/file-io.h"
@@ -29,20 +34,13 @@ static void output_ff(const double       W,
                       const unsigned int f,
                       const unsigned int g);
 
-gsl_spline * FF_table(const double                 Deltak0sqr,
-                      const double                 epsilon,
-                      const Subband               &isb,
-                      const Subband               &jsb,
-                      const Subband               &fsb,
-                      const Subband               &gsb,
-                      const double                 T,
-                      const size_t                 nq,
+gsl_spline * FF_table(const double                 epsilon,
+                      const unsigned int           i,
+                      const unsigned int           j,
+                      const unsigned int           f,
+                      const unsigned int           g,
                       const bool                   S_flag,
-                      const double                 E_cutoff = -1);
-
-double PI(const Subband &isb,
-          const size_t   q_perp,
-          const double   T);
+                      CarrierCarrierFormFactors   &ff_cache);
 
 Options configure_options(int argc, char* argv[])
 {
@@ -64,12 +62,90 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<size_t>("nq",              101, "Number of strips in scattering vector integration");
     opt.add_option<size_t>("ntheta",          101, "Number of strips in alpha angle integration");
     opt.add_option<size_t>("nalpha",          101, "Number of strips in theta angle integration");
+    opt.add_option<double>("overlapthreshold",     "Skip any transition ij→fg for which the product of the overlaps "
+                                                   "∫|ψ_i ψ_f|dz ∫|ψ_j ψ_g|dz is below this value.  The skipped "
+                                                   "transitions are given a zero rate in ccABCD.r, and are listed "
+                                                   "in cc-pruned.r with a rough estimate of their rates.");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
     return opt;
 }
 
+/**
+ * \brief Find the overlap between a pair of wavefunctions
+ *
+ * \details The overlap is defined as ∫|ψ_a ψ_b|dz.  The magnitude of the
+ *          matrix element A_ijfg at any scattering vector is bounded by the
+ *          product of the overlaps for the pairs if and jg.
+ */
+static double find_overlap(const Subband &asb,
+                           const Subband &bsb)
+{
+    const auto z  = asb.z_array();
+    const auto dz = z[1] - z[0];
+    const arma::vec psi_ab = arma::abs(asb.psi_array() % bsb.psi_array());
+    return integral(psi_ab, dz);
+}
+
+/**
+ * \brief Find twice the change in kinetic energy, expressed as Δk0² [1/m²]
+ *
+ * \details See [QWWAD3, Eq. 10.228] and Smet (55).  Indices are from 0.
+ */
+static double find_Deltak0sqr(const std::vector<Subband> &subbands,
+                              const unsigned int          i,
+                              const unsigned int          j,
+                              const unsigned int          f,
+                              const unsigned int          g,
+                              const double                m)
+{
+    double Deltak0sqr = 0;
+
+    if(i+j != f+g)
+    {
+        Deltak0sqr = 4*m*(subbands[i].get_E_min() + subbands[j].get_E_min()
+                          - subbands[f].get_E_min() - subbands[g].get_E_min())/(hBar*hBar);
+    }
+
+    return Deltak0sqr;
+}
+
+/**
+ * \brief Find the largest scattering vector needed for a transition [1/m]
+ *
+ * \param[in] Deltak0sqr Twice the change in kinetic energy, as Δk0² [1/m²]
+ * \param[in] isb        Initial subband for first carrier
+ * \param[in] jsb        Initial subband for second carrier
+ * \param[in] T          Carrier temperature [K]
+ * \param[in] E_cutoff   Cut-off kinetic energy [J], or negative for a 5kT range
+ */
+static double find_q_perp_max(const double   Deltak0sqr,
+                              const Subband &isb,
+                              const Subband &jsb,
+                              const double   T,
+                              const double   E_cutoff)
+{
+    // Find maximum wave-vectors for calculation, with a margin
+    double kimax = 0.0; // Max value of ki [1/m]
+    double kjmax = 0.0; // Max value of kj [1/m]
+
+    if(E_cutoff > 0)
+    {
+        kimax = isb.get_k_at_Ek(E_cutoff*1.1);
+        kjmax = jsb.get_k_at_Ek(E_cutoff*1.1);
+    }
+    else
+    {
+        kimax = isb.get_k_max(T*1.1);
+        kjmax = jsb.get_k_max(T*1.1);
+    }
+
+    // maximum in-plane wave vector
+    return sqrt(2*gsl_pow_2(kimax+kjmax)+Deltak0sqr+2*(kimax+kjmax)*
+                sqrt(gsl_pow_2(kimax+kjmax)+Deltak0sqr))/2;
+}
+
 int main(int argc,char *argv[])
 {
     const auto opt = configure_options(argc, argv);
@@ -125,11 +201,115 @@ int main(int argc,char *argv[])
 
     read_table("rr.r", i_indices, j_indices, f_indices, g_indices);
 
-    FILE *FccABCD=fopen("ccABCD.r","w");	/* open file for output of weighted means */
+    const size_t ntx = i_indices.size();
+
+    // Pre-screen the transitions using the overlaps between wavefunctions.
+    // Skipped transitions are given a zero rate in ccABCD.r, so that the
+    // table still lists every requested transition
+    const auto prune = opt.get_argument_known("overlapthreshold");
+    arma::vec S_ijfg(ntx, arma::fill::ones); // Bound on |A_ijfg|
+    std::vector<bool> skip(ntx, false);
+
+    if(prune)
+    {
+        const auto threshold = opt.get_option<double>("overlapthreshold");
+        const size_t nst = subbands.size();
+        arma::mat overlap(nst, nst);
+
+        for(unsigned int a = 0; a < nst; ++a)
+        {
+            for(unsigned int b = a; b < nst; ++b)
+            {
+                overlap(a,b) = find_overlap(subbands[a], subbands[b]);
+                overlap(b,a) = overlap(a,b);
+            }
+        }
+
+        for(unsigned int itx = 0; itx < ntx; ++itx)
+        {
+            S_ijfg[itx] = overlap(i_indices[itx]-1, f_indices[itx]-1) *
+                          overlap(j_indices[itx]-1, g_indices[itx]-1);
+            skip[itx]   = S_ijfg[itx] < threshold;
+        }
+    }
+
+    // Largest value of Wbar/S_ijfg² for any computed transition.  This is
+    // used to estimate the rates of the skipped transitions, since the form
+    // factor scales as |A_ijfg|².  Note that this is only a heuristic: the
+    // screening and the wave-vector dependence of A_ijfg differ between
+    // transitions, so it is not a strict upper bound on the skipped rates.
+    double W_per_S2_max = 0.0;
+
+    const auto E_cutoff = opt.get_argument_known("Ecutoff") ?
+                          opt.get_option<double>("Ecutoff")*e/1000 : -1.0; // Cut-off energy [J]
+
+    // Form-factor data are shared between all transitions.  They all use the
+    // same grid of scattering vectors, which covers the largest scattering
+    // vector needed by any of them, so that the tables can be reused
+    double q_perp_max = 0.0;
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        if(skip[itx])
+            continue;
+
+        const unsigned int i = i_indices[itx] - 1;
+        const unsigned int j = j_indices[itx] - 1;
+        const unsigned int f = f_indices[itx] - 1;
+        const unsigned int g = g_indices[itx] - 1;
+        const double Deltak0sqr = find_Deltak0sqr(subbands, i, j, f, g, m);
+        q_perp_max = std::max(q_perp_max, find_q_perp_max(Deltak0sqr, subbands[i], subbands[j], T, E_cutoff));
+    }
+
+    CarrierCarrierFormFactors ff_cache(subbands, arma::linspace(0, q_perp_max, nq), T);
+
+    // Find the exchange partner ji→gf of each transition, if it was
+    // requested too.  The pair have the same form-factor table and
+    // wave-vector grids, as long as the screening is the same for both, so
+    // the angular integrals only need to be computed once
+    std::vector<int> partner(ntx, -1);
+
+    if(nki == nkj)
+    {
+        std::map<std::tuple<unsigned int, unsigned int, unsigned int, unsigned int>, unsigned int> tx_index;
+
+        for(unsigned int itx = 0; itx < ntx; ++itx)
+        {
+            const unsigned int i = i_indices[itx];
+            const unsigned int j = j_indices[itx];
+            const unsigned int f = f_indices[itx];
+            const unsigned int g = g_indices[itx];
+
+            if(skip[itx] || (S_flag && i != j))
+                continue;
+
+            const auto it = tx_index.find(std::make_tuple(j, i, g, f));
+
+            if(it != tx_index.end() && partner[it->second] < 0)
+            {
+                partner[it->second] = itx;
+                partner[itx]        = it->second;
+            }
+            else
+                tx_index.insert(std::make_pair(std::make_tuple(i, j, f, g), itx));
+        }
+    }
+
+    // Results for each transition
+    std::vector<arma::vec> Ei_t_tables(ntx); // Total initial energy [meV]
+    std::vector<arma::vec> W_tables(ntx);    // Scattering rate at each initial energy [1/s]
+    arma::vec              Wbar_list(ntx);   // Average scattering rate [1/s]
+    std::vector<bool>      done(ntx, false);
+
+    // Pre-factor for rates [QWWAD3, 10.233]
+    const double prefactor = m*e*e*e*e / (4*pi*hBar*hBar*hBar*(4*4*pi*pi*epsilon*epsilon));
 
     // Loop over all desired transitions
-    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+    for(unsigned int itx = 0; itx < ntx; ++itx)
     {
+        if(skip[itx] || done[itx])
+            continue;
+
         // State indices for this transition (NB., these are indexed from 1)
         unsigned int i = i_indices[itx];
         unsigned int j = j_indices[itx];
@@ -139,14 +319,10 @@ int main(int argc,char *argv[])
         // Convenience labels for each subband (NB., these are indexed from 0)
         const Subband isb = subbands[i-1];
         const Subband jsb = subbands[j-1];
-        const Subband fsb = subbands[f-1];
-        const Subband gsb = subbands[g-1];
 
         // Subband minima
         const double Ei = isb.get_E_min();
         const double Ej = jsb.get_E_min();
-        const double Ef = fsb.get_E_min();
-        const double Eg = gsb.get_E_min();
 
         // Output form-factors if desired
         if(ff_flag)
@@ -154,24 +330,19 @@ int main(int argc,char *argv[])
 
         // Calculate Delta k0^2 [QWWAD3, Eq. 10.228]
         //   twice the change in KE, see Smet (55)
-        double Deltak0sqr = 0;
-        if(i+j != f+g)
-            Deltak0sqr=4*m*(Ei + Ej - Ef - Eg)/(hBar*hBar);	
+        const double Deltak0sqr = find_Deltak0sqr(subbands, i-1, j-1, f-1, g-1, m);
 
-        gsl_spline *FF = 0;
+        gsl_spline *FF = FF_table(epsilon, i-1, j-1, f-1, g-1, S_flag, ff_cache); // Form factor table
         double kimax = 0;
         double kjmax = 0;
 
-        if(opt.get_argument_known("Ecutoff"))
+        if(E_cutoff > 0)
         {
-            const auto Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
-            FF = FF_table(Deltak0sqr, epsilon, isb, jsb, fsb, gsb, T,nq,S_flag,Ecutoff); // Form factor table
-            kimax = isb.get_k_at_Ek(Ecutoff);
-            kjmax = jsb.get_k_at_Ek(Ecutoff);
+            kimax = isb.get_k_at_Ek(E_cutoff);
+            kjmax = jsb.get_k_at_Ek(E_cutoff);
         }
         else
         {
-            FF = FF_table(Deltak0sqr, epsilon, isb, jsb, fsb, gsb, T,nq,S_flag); // Form factor table
             kimax=isb.get_k_max(T);
             kjmax=jsb.get_k_max(T);
         }
@@ -182,24 +353,29 @@ int main(int argc,char *argv[])
         const double dki=kimax/((float)nki - 1); // step length for loop over ki
         const double dkj=kjmax/((float)nkj - 1); // step length for kj integration
 
-        arma::vec Wbar_integrand_ki(nki); // initialise integral for average scattering rate
-        arma::vec Wijfg(nki);             // Scattering rate for a given initial wave vector
-        arma::vec Ei_t(nki);              // Total energy of initial state (for output file) [meV]
+        // Find Fermi-Dirac occupation at each ki and kj in advance, since these
+        // don't depend on the angles
+        const arma::vec ki_array = arma::linspace(0, dki*(nki-1), nki);
+        const arma::vec kj_array = arma::linspace(0, dkj*(nkj-1), nkj);
+        arma::vec P_ki;  // Occupation of initial state of first carrier
+        arma::vec Eki;   // Kinetic energy of first carrier [J]
+        arma::vec P_kj;  // Occupation of initial state of second carrier
+        arma::vec Ekj;   // Kinetic energy of second carrier [J]
+        isb.get_occupation_at_k(ki_array, P_ki, Eki);
+        jsb.get_occupation_at_k(kj_array, P_kj, Ekj);
+
+        // Angular integral of the form factor for each pair of initial
+        // wave-vectors.  This is symmetric under exchange of the carriers,
+        // so it gives the rates for the partner transition too.
+        arma::mat FF_angular(nki, nkj);
 
-        // calculate c-c rate for all ki
         for(unsigned int iki=0;iki<nki;iki++)
         {
-            const double ki=dki*(float)iki; // carrier momentum
-
-            // integrate over |kj|
-            arma::vec Wijfg_integrand_kj(nkj);
+            const double ki=ki_array[iki]; // carrier momentum
 
             for(unsigned int ikj=0;ikj<nkj;ikj++)
             {
-                const double kj=dkj*(float)ikj; // carrier momentum
-
-                // Find Fermi-Dirac occupation at kj
-                const double P=jsb.get_occupation_at_k(kj);
+                const double kj=kj_array[ikj]; // carrier momentum
 
                 // Integral over alpha
                 arma::vec Wijfg_integrand_alpha(nalpha);
@@ -246,127 +422,130 @@ int main(int argc,char *argv[])
                     Wijfg_integrand_alpha[ialpha] = integral(Wijfg_integrand_theta, dtheta);
                 } /* end alpha */
 
-                Wijfg_integrand_kj[ikj] = integral(Wijfg_integrand_alpha, dalpha) * P * kj;
+                FF_angular(iki, ikj) = integral(Wijfg_integrand_alpha, dalpha);
             } /* end kj   */
+        } /* end ki	*/
 
-            Wijfg[iki] = integral(Wijfg_integrand_kj,dkj);
+        // calculate c-c rate for all ki by integrating over |kj|
+        arma::vec Wijfg(nki); // Scattering rate for a given initial wave vector
 
-            // Multiply by pre-factor [QWWAD3, 10.233]
-            Wijfg[iki] *= m*e*e*e*e / (4*pi*hBar*hBar*hBar*(4*4*pi*pi*epsilon*epsilon));
-            Ei_t[iki] = isb.get_E_total_at_k(ki) * 1000/e;
+        for(unsigned int iki=0;iki<nki;iki++)
+        {
+            const arma::vec Wijfg_integrand_kj = FF_angular.row(iki).t() % P_kj % kj_array;
+            Wijfg[iki] = integral(Wijfg_integrand_kj, dkj) * prefactor;
+        }
 
-            /* calculate Fermi-Dirac weighted mean of scattering rates over the 
-               initial carrier states, note that the integral step length 
-               dE=2*sqr(hBar)*ki*dki/(2m)					*/
-            Wbar_integrand_ki[iki] = Wijfg[iki]*ki*isb.get_occupation_at_k(ki);
-        } /* end ki	*/
+        /* calculate Fermi-Dirac weighted mean of scattering rates over the 
+           initial carrier states, note that the integral step length 
+           dE=2*sqr(hBar)*ki*dki/(2m)					*/
+        const arma::vec Wbar_integrand_ki = Wijfg % ki_array % P_ki;
 
-        /* output scattering rate versus carrier energy=subband minima+in-plane
-           kinetic energy						*/
-        char	filename[9];	/* character string for output filename		*/
-        sprintf(filename,"cc%i%i%i%i.r",i,j,f,g);
-        write_table(filename, Ei_t, Wijfg);
+        Ei_t_tables[itx] = (Eki + Ei) * 1000/e;
+        W_tables[itx]    = Wijfg;
+        Wbar_list[itx]   = integral(Wbar_integrand_ki, dki)/(pi*isb.get_total_population());
+        done[itx]        = true;
+
+        // The partner transition ji→gf swaps the roles of the carriers, so
+        // its rate for each kj is found by integrating over |ki| instead
+        if(partner[itx] >= 0)
+        {
+            const auto ptx = partner[itx];
+            arma::vec Wjigf(nkj);
+
+            if(ff_flag)
+                output_ff(W,subbands,j,i,g,f);
+
+            for(unsigned int ikj=0;ikj<nkj;ikj++)
+            {
+                const arma::vec Wjigf_integrand_ki = FF_angular.col(ikj) % P_ki % ki_array;
+                Wjigf[ikj] = integral(Wjigf_integrand_ki, dki) * prefactor;
+            }
+
+            const arma::vec Wbar_integrand_kj = Wjigf % kj_array % P_kj;
 
-        const double Wbar = integral(Wbar_integrand_ki, dki)/(pi*isb.get_total_population());
+            Ei_t_tables[ptx] = (Ekj + Ej) * 1000/e;
+            W_tables[ptx]    = Wjigf;
+            Wbar_list[ptx]   = integral(Wbar_integrand_kj, dkj)/(pi*jsb.get_total_population());
+            done[ptx]        = true;
 
-        fprintf(FccABCD,"%i %i %i %i %20.17le\n", i,j,f,g,Wbar);
+            if(opt.get_verbose())
+                std::cout << "Found rates for " << i << j << "→" << f << g << " and " << j << i << "→" << g << f << std::endl;
+        }
+        else if(opt.get_verbose())
+            std::cout << "Found rates for " << i << j << "→" << f << g << std::endl;
 
         gsl_spline_free(FF);
         gsl_interp_accel_free(acc);
 } /* end while over states */
 
-fclose(FccABCD);	/* close weighted mean output file	*/
+    FILE *FccABCD=fopen("ccABCD.r","w");	/* open file for output of weighted means */
 
-return EXIT_SUCCESS;
-} /* end main */
+    // Write the results in the order that they were requested
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        const unsigned int i = i_indices[itx];
+        const unsigned int j = j_indices[itx];
+        const unsigned int f = f_indices[itx];
+        const unsigned int g = g_indices[itx];
+
+        // Skipped transitions are written with a zero rate, since the
+        // rate-equation solver expects an entry for every transition
+        if(skip[itx])
+        {
+            fprintf(FccABCD,"%i %i %i %i %20.17le\n", i,j,f,g,0.0);
+            continue;
+        }
 
-/** Tabulate the matrix element defined as 
- *    C_if⁺(q,z') = ∫_{z'}^∞ dz ψ_i(z) ψ_f(z)/exp(qz)]
- *  for a given wavevector, with respect to position
- */
-arma::vec find_Cif_p(const arma::vec &psi_if, 
-                     const arma::vec &exp_qz,
-                     const arma::vec &z)
-{
-    const size_t nz = z.size();
-    arma::vec Cif_p(nz);
-    const double dz=z[1]-z[0];
+        /* output scattering rate versus carrier energy=subband minima+in-plane
+           kinetic energy						*/
+        std::ostringstream filename;
+        filename << "cc" << i << j << f << g << ".r";
+        write_table(filename.str(), Ei_t_tables[itx], W_tables[itx]);
 
-    Cif_p[nz-1] = psi_if[nz-1] / exp_qz[nz-1] * dz;
+        fprintf(FccABCD,"%i %i %i %i %20.17le\n", i,j,f,g,Wbar_list[itx]);
 
-    for(int iz = nz-2; iz >=0; iz--)
-        Cif_p[iz] = Cif_p[iz+1] + psi_if[iz] / exp_qz[iz] * dz;
+        if(prune && S_ijfg[itx] > 0)
+            W_per_S2_max = std::max(W_per_S2_max, Wbar_list[itx]/(S_ijfg[itx]*S_ijfg[itx]));
+    }
 
-    return Cif_p;
-}
+fclose(FccABCD);	/* close weighted mean output file	*/
 
-/** 
- * \brief Tabulate scattering matrix element component.
- *
- * \details defined as:
- *    C_if⁻(q,z') = ∫_{-∞}^{z'} dz ψ_i(z) ψ_f(z) exp(qz)
- *  for a given wavevector, with respect to position
- *
- * Note that the upper limit has to be the point just BEFORE each z'
- * value so that we don't double count
- */
-arma::vec find_Cif_m(const arma::vec &psi_if, 
-                     const arma::vec &exp_qz,
-                     const arma::vec &z)
-{
-    const size_t nz = z.size();
-    arma::vec Cif_m(nz);
-    const double dz = z[1]-z[0];
+    // Report the skipped transitions, with an estimate of their rates
+    if(prune)
+    {
+        std::ofstream pruned_stream("cc-pruned.r");
+        size_t n_skipped = 0;
+        double W_skipped_total = 0.0;
 
-    // Seed the first value as zero
-    Cif_m[0] = 0;
+        for(unsigned int itx = 0; itx < ntx; ++itx)
+        {
+            if(!skip[itx])
+                continue;
 
-    // Now, perform a block integration by summing on top of the previous
-    // value in the array
-    for(unsigned int iz = 1; iz < nz; iz++)
-        Cif_m[iz] = Cif_m[iz-1] + psi_if[iz-1] * exp_qz[iz-1] * dz;
+            const double W_estimate = W_per_S2_max * S_ijfg[itx] * S_ijfg[itx];
+            pruned_stream << i_indices[itx] << " " << j_indices[itx] << " "
+                          << f_indices[itx] << " " << g_indices[itx] << " "
+                          << S_ijfg[itx] << " " << W_estimate << std::endl;
 
-    return Cif_m;
-}
+            ++n_skipped;
+            W_skipped_total += W_estimate;
+        }
 
-/** 
- * \brief Create an array of exp(qz) with respect to position
- *
- * \param q[in]       Scattering vector [1/m]
- * \param exp_qz[out] Output array (should be initialised before calling)
- * \param z[in]       Spatial positions [m]
- *
- * \todo  This is also useful for e-e scattering. Push into library
- */
-arma::vec find_exp_qz(const double q, const arma::vec &z)
-{
-    //const double Lp = z.max() - z.min();
+        std::cout << "Skipped " << n_skipped << " of " << ntx << " transitions." << std::endl;
 
-    // Use the midpoint of the z array as the origin, so as to minimise the
-    // magnitude of the exponential terms
-    return exp(q * (z - z[0]));
-}
+        if(n_skipped > 0)
+        {
+            if(n_skipped < ntx)
+                std::cout << "Estimated total rate of skipped transitions (heuristic, not a bound): "
+                          << W_skipped_total << " s^{-1}" << std::endl;
+            else
+                std::cout << "Cannot estimate rates of skipped transitions, since none were computed."
+                          << std::endl;
+        }
+    }
 
-/** Find the matrix element Iif at a given dopant location z'.
- *
- * The matrix element is defined as
- *  I_if(q,z') = ∫dz ψ_i(z) ψ_f(z) exp(-q|z-z'|),
- * where z is the carrier location.  The numerical solution
- * can however be speeded up by replacing the modulus function
- * with the sum of two integrals.  We can say that
- *
- *  I_if(q,z') = C_if⁻(q,z')/exp(qz') + C_if⁺(q,z') exp(qz')',
- *
- * Therefore, we have separated the z' dependence from the
- * z dependence of the matrix element.
- */
-double Iif(const unsigned int  iz0,
-           const arma::vec    &Cif_p,
-           const arma::vec    &Cif_m, 
-           const arma::vec    &exp_qz)
-{
-    return Cif_m[iz0]/exp_qz[iz0] + Cif_p[iz0]*exp_qz[iz0];
-}
+return EXIT_SUCCESS;
+} /* end main */
 
 /* This function calculates the overlap integral over all four carrier
    states		*/
@@ -377,134 +556,57 @@ double A(const double   q_perp,
          const Subband &gsb)
 {
  const auto z = isb.z_array();
- const size_t nz = z.size();
  const double dz = z[1] - z[0];
 
- // Convenience labels for wave-functions in each subband
- const auto psi_i = isb.psi_array();
- const auto psi_j = jsb.psi_array();
- const auto psi_f = fsb.psi_array();
- const auto psi_g = gsb.psi_array();
-
  // Products of wavefunctions can be computed in advance
- const auto psi_if = psi_i % psi_f;
- const auto psi_jg = psi_j % psi_g;
-
- const auto expTerm   = find_exp_qz(q_perp, z);
- const auto Cjg_plus  = find_Cif_p(psi_jg, expTerm, z);
- const auto Cjg_minus = find_Cif_m(psi_jg, expTerm, z);
-
- arma::vec Aijfg_integrand(nz);
+ const arma::vec psi_if = isb.psi_array() % fsb.psi_array();
+ const arma::vec psi_jg = jsb.psi_array() % gsb.psi_array();
 
  // Integral of i(=0) and f(=2) over z
- for(unsigned int iz=0;iz<nz;iz++)
- {
-     const double Ijg = Iif(iz, Cjg_plus, Cjg_minus, expTerm);
-     Aijfg_integrand[iz] = psi_if[iz] * Ijg;
- }
+ const arma::vec Aijfg_integrand = psi_if % CarrierCarrierFormFactors::find_Ijg(q_perp, psi_jg, z);
 
  const double Aijfg = integral(Aijfg_integrand, dz);
 
  return Aijfg;
 }
 
-/**
- * \brief returns the screening factor, referred to by Smet as e_sc
- */
-double PI(const Subband &isb,
-          const double   q_perp,
-          const double   T)
-{
-    const double m = isb.get_effective_mass();    // Effective mass at band-edge [kg]
-
-    // Now perform the integration, equation 44 of Smet [QWWAD3, 10.238]
-    const double Ek_max = isb.get_Ek_at_k(isb.get_k_max(T));
-    const size_t nE = 101;
-    const double dE = Ek_max/(nE-1);
-
-    arma::vec PI_integrand_dE(nE);
-
-    // Integrate from bottom of subband up to Ek_max (Ef + 5kT)
-    for(unsigned int iE = 0; iE < nE; ++iE)
-    {
-        const double Ek = iE*dE; // Kinetic energy
-        const double ki = isb.get_k_at_Ek(Ek);
-        const double Et = isb.get_E_total_at_k(ki);
-
-        // Find low-temperature polarizability *at this wave-vector*
-        // Equation 43 of Smet, QWWAD3, 10.236
-        double P0 = m/(pi*hBar*hBar);
-
-        if(q_perp>2*ki)
-            P0 -= m/(pi*hBar*hBar)*sqrt(1-4*ki*ki/(q_perp*q_perp));
-
-        const double cosh_term = cosh((Et - isb.get_Ef())/(2*kB*T));
-        PI_integrand_dE[iE] = P0/(4*kB*T*cosh_term*cosh_term);
-    }
-
-    const double result = integral(PI_integrand_dE, dE);
-    return result;
-}
-
 /**
  *  \brief Compute the form factor [Aijfg/(esc q)]^2
+ *
+ *  \details The table uses the scattering vectors of the form-factor cache
  */
-gsl_spline * FF_table(const double                 Deltak0sqr,
-                      const double                 epsilon,
-                      const Subband               &isb,
-                      const Subband               &jsb,
-                      const Subband               &fsb,
-                      const Subband               &gsb,
-                      const double                 T,
-                      const size_t                 nq,
+gsl_spline * FF_table(const double                 epsilon,
+                      const unsigned int           i,
+                      const unsigned int           j,
+                      const unsigned int           f,
+                      const unsigned int           g,
                       const bool                   S_flag,
-                      const double                 E_cutoff)
+                      CarrierCarrierFormFactors   &ff_cache)
 {
-    // Find maximum wave-vectors for calculation if not specified
-    double kimax = 0.0; // Max value of ki [1/m]
-    double kjmax = 0.0; // Max value of kj [1/m]
-
-    if(E_cutoff > 0)
-    {
-        kimax = isb.get_k_at_Ek(E_cutoff*1.1);
-        kjmax = jsb.get_k_at_Ek(E_cutoff*1.1);
-    }
-    else
-    {
-        kimax = isb.get_k_max(T*1.1);
-        kjmax = jsb.get_k_max(T*1.1);
-    }
+    const auto &q_perp = ff_cache.get_q_perp();
+    const size_t nq = q_perp.size();
+    arma::vec FF(nq);
 
-    // maximum in-plane wave vector
-    const double q_perp_max=sqrt(2*gsl_pow_2(kimax+kjmax)+Deltak0sqr+2*(kimax+kjmax)*
-                 sqrt(gsl_pow_2(kimax+kjmax)+Deltak0sqr))/2;
+    // Scattering matrix element (all 4 states)
+    const auto &Aijfg = ff_cache.get_A_table(i, j, f, g);
 
-    const double dq=q_perp_max/((float)(nq-1));	// interval in q_perp
+    // Polarizability and matrix element for lowest subband.  These are only
+    // needed if screening is included
+    arma::vec PI_table    = arma::zeros(nq);
+    arma::vec Aiiii_table = arma::zeros(nq);
 
-    arma::vec q_perp(nq);
-    arma::vec FF(nq);
+    if(S_flag)
+    {
+        PI_table    = ff_cache.get_PI_table(i);
+        Aiiii_table = ff_cache.get_A_table(i, i, i, i);
+    }
 
     for(unsigned int iq=0;iq<nq;iq++)
     {
-        q_perp[iq] = iq*dq;
-
-        // Scattering matrix element (all 4 states)
-        const double _Aijfg = A(q_perp[iq], isb, jsb, fsb, gsb);
-
-        double _PI    = 0.0; // Polarizability
-        double _Aiiii = 0.0; // Matrix element for lowest subband
-
-        // Allow screening to be turned off
-        if(S_flag)
-        {
-            _PI    = PI(isb, q_perp[iq], T);
-            _Aiiii = A(q_perp[iq], isb, isb, isb, isb);
-        }
-
         // Screening permittivity * wave vector
         // Note that the pole at q_perp=0 is avoided as long as screening is included
-        const double esc_q = q_perp[iq] + 2*pi*e*e/(4*pi*epsilon) * _PI * _Aiiii;
-        FF[iq] = _Aijfg*_Aijfg / (esc_q * esc_q);
+        const double esc_q = q_perp[iq] + 2*pi*e*e/(4*pi*epsilon) * PI_table[iq] * Aiiii_table[iq];
+        FF[iq] = Aijfg[iq]*Aijfg[iq] / (esc_q * esc_q);
     }
 
     // Fix singularity by "clipping" the top off it:
@@ -10,30 +10,19 @@
 #include <sstream>
 #include <iostream>
 #include <gsl/gsl_math.h>
-#include <gsl/gsl_interp.h>
-#include <gsl/gsl_spline.h>
 #include "qwwad/constants.h"
 #include "qwwad/subband.h"
 #include "qwwad/file-io.h"
-#include "qwwad/maths-helpers.h"
+#include "qwwad/scattering-calculator-impurity.h"
 #include "qwwad/options.h"
 
 using namespace QWWAD;
 using namespace constants;
 
-static void output_ff(const double        W, // Arbitrary well width to generate q
-                      const std::vector<Subband> &subbands,
-                      const unsigned int  i,
-                      const unsigned int  f,
-                      const arma::vec    &d);
-
-gsl_spline * FF_table(const double     epsilon,
-                      const Subband   &isb,
-                      const Subband   &fsb,
-                      const arma::vec &d,
-                      const size_t     nq,
-                      const bool       S_flag,
-                      const double     E_cutoff);
+static void output_ff(const double                        W, // Arbitrary well width to generate q
+                      const ScatteringCalculatorImpurity &calc,
+                      const unsigned int                  i,
+                      const unsigned int                  f);
 
 Options configure_options(int argc, char* argv[])
 {
@@ -44,6 +33,7 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<bool>  ("outputff,a",           "Output form-factors to file.");
     opt.add_option<bool>  ("noscreening,S",        "Disable screening of the Coulomb interaction.");
     opt.add_option<bool>  ("noblocking,b",         "Disable final-state blocking.");
+    opt.add_option<bool>  ("sheetmodel",           "Treat each doped region as a delta-doped sheet of charge at its centroid.");
     opt.add_option<double>("epsilon,e",     13.18, "Low-frequency dielectric constant");
     opt.add_option<double>("mass,m",        0.067, "Band-edge effective mass (relative to free electron)");
     opt.add_option<char>  ("particle,p",      'e', "ID of particle to be used: 'e', 'h' or 'l', for "
@@ -52,6 +42,9 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<double>("width,w",         250, "Width of quantum well [angstrom]. (Solely for output).");
     opt.add_option<double>("Ecutoff",              "Cut-off energy for carrier distribution [meV]. If not specified, then 5kT above band-edge.");
     opt.add_option<size_t>("nki",             101, "Number of initial wave-vector samples.");
+    opt.add_option<double>("tolerance",            "Relative tolerance for average rates. If specified, the "
+                                                   "averages are found by adaptive integration rather than "
+                                                   "from the table of rates.");
     opt.add_option<size_t>("nq",              101, "Number of strips in scattering vector integration");
     opt.add_option<size_t>("ntheta",          101, "Number of strips in theta angle integration");
 
@@ -72,19 +65,11 @@ int main(int argc,char *argv[])
     const auto W       =  opt.get_option<double>("width")*1e-10;  // a well width, same as Smet [angstrom]
     const auto S_flag  = !opt.get_option<bool>  ("noscreening");  // Include screening by default
     const auto b_flag  = !opt.get_option<bool>  ("noblocking");   // Include final-state blocking by default
+    const auto sheets  =  opt.get_option<bool>  ("sheetmodel");   // Use delta-sheet doping model
     const auto nki     =  opt.get_option<size_t>("nki");          // number of ki calculations
     const auto ntheta  =  opt.get_option<size_t>("ntheta");       // number of strips in theta integration
     const auto nq      =  opt.get_option<size_t>("nq");           // number of q_perp values for lookup table
 
-    /* calculate step lengths	*/
-    const double dtheta=2*pi/((float)ntheta - 1); // step length for theta integration
-
-    // Can save a bit of time by calculating cosines in advance
-    arma::vec cos_theta(ntheta);
-
-    for(unsigned int itheta = 0; itheta < ntheta; ++itheta)
-        cos_theta[itheta] = cos(itheta*dtheta);
-
     std::ostringstream E_filename; // Energy filename string
     E_filename << "E" << p << ".r";
     std::ostringstream wf_prefix;  // Wavefunction filename prefix
@@ -116,324 +101,86 @@ int main(int argc,char *argv[])
 
     read_table("rrp.r", i_indices, f_indices);
 
-    auto Favg=fopen("imp-avg.dat","w");	/* open file for output of weighted means */
-
-    // Loop over all desired transitions
-    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
-    {
-        // State indices for this transition (NB., these are indexed from 1)
-        unsigned int i = i_indices[itx];
-        unsigned int f = f_indices[itx];
-
-        // Convenience labels for each subband (NB., these are indexed from 0)
-        const Subband isb = subbands[i-1];
-        const Subband fsb = subbands[f-1];
-
-        // Subband minima
-        const double Ei = isb.get_E_min();
-        const double Ef = fsb.get_E_min();
-
-        // Output form-factors if desired
-        if(ff_flag)
-            output_ff(W,subbands,i,f,d);
+    ScatteringCalculatorImpurity calc(subbands, d, epsilon, m, T);
+    calc.enable_screening(S_flag);
+    calc.enable_sheet_model(sheets);
+    calc.set_q_samples(nq);
+    calc.set_theta_samples(ntheta);
+    calc.enable_blocking(b_flag);
+    calc.set_ki_samples(nki);
 
-        // Find minimum initial wave-vector that allows scattering
-        const double Efi = Ef - Ei;
-        double kimin = 0.0;
-        if(Efi > 0)
-            kimin = sqrt(2*m*Efi)/hBar;
+    if(opt.get_verbose())
+        std::cout << "Doping profile contains " << calc.get_n_doped_segments() << " doped region(s)." << std::endl;
 
-        double kimax = 0;
-        double Ecutoff = 0.0; // Maximum kinetic energy in initial subband
+    // Use user-specified cut-off energy if given
+    if(opt.get_argument_known("Ecutoff"))
+    {
+        const auto Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+        calc.set_Eki_cutoff(Ecutoff);
 
-        // Use user-specified value if given
-        if(opt.get_argument_known("Ecutoff"))
+        for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
         {
-            Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+            const auto i = i_indices[itx];
+            const auto f = f_indices[itx];
 
-            if(Ecutoff+Ei < Ef)
+            if(Ecutoff + subbands[i-1].get_E_min() < subbands[f-1].get_E_min())
             {
                 std::cerr << "No scattering permitted from state " << i << "->" << f << " within the specified cut-off energy." << std::endl;
                 std::cerr << "Extending range automatically" << std::endl;
-                Ecutoff += Ef;
             }
         }
-        // Otherwise, use a fixed, 5kT range
-        else
-        {
-            kimax   = isb.get_k_max(T);
-            Ecutoff = hBar*hBar*kimax*kimax/(2*m);
-
-            if(Ecutoff+Ei < Ef)
-                Ecutoff += Ef;
-        }
-
-        kimax = isb.get_k_at_Ek(Ecutoff);
-
-        gsl_spline *FF = FF_table(epsilon, isb, fsb, d,nq,S_flag,Ecutoff); // Form factor table
-
-        gsl_interp_accel *acc = gsl_interp_accel_alloc(); // Creates accelerator for interpolation of FF
-
-        /* calculate maximum value of ki & kj and hence kj step length	*/
-        const double dki=(kimax-kimin)/((float)nki - 1); // step length for loop over ki
-
-        arma::vec Wbar_integrand_ki(nki); // initialise integral for average scattering rate
-        arma::vec Wif(nki);               // Scattering rate for a given initial wave vector
-        arma::vec Ei_t(nki);              // Total energy of initial state (for output file) [meV]
-
-        // calculate scattering rate for all ki
-        for(unsigned int iki=0;iki<nki;iki++)
-        {
-            const double ki=kimin+dki*iki; // carrier momentum
-            const double ki_sqr = ki*ki;
-
-            // Find energy-conserving final wave-vector
-            // This should be positive if the kimin value is correct
-            const double kf_sqr = ki_sqr + 2*m*(Ei - Ef)/(hBar*hBar);
-            assert(kf_sqr >= 0.0);
-            const double kf = sqrt(kf_sqr);
-            assert(!std::isnan(kf));
-            const double two_kif = 2*ki*kf;
-            const double ki_sqr_plus_kf_sqr = ki_sqr + kf_sqr;
-
-            // Now perform innermost integral (over theta)
-            arma::vec Wif_integrand_theta(ntheta);
-
-            for(unsigned int itheta=0;itheta<ntheta;itheta++)
-            {
-                // Calculate scattering vector
-                // Note that most of the terms here are computed before the loop, so we
-                // only need to look up the cos(theta)
-                const double q_sqr = ki_sqr_plus_kf_sqr + two_kif * cos_theta[itheta];
-                const double q = sqrt(q_sqr);
-                assert(!std::isnan(q));
+    }
 
-                // Find the form-factor at this wave-vector by looking it up in the
-                // spline we created earlier
-                Wif_integrand_theta[itheta] = gsl_spline_eval(FF, q, acc);
-            } /* end theta */
+    // Subbands are indexed from zero in the calculator
+    const arma::uvec i_idx0 = i_indices - 1;
+    const arma::uvec f_idx0 = f_indices - 1;
+    const auto transitions = calc.get_transitions(i_idx0, f_idx0);
 
-            Wif[iki] = integral(Wif_integrand_theta, dtheta);
+    // Average rates for each transition
+    arma::vec Wbar(i_indices.size());
 
-            // Multiply by pre-factor
-            Wif[iki] *= m*e*e*e*e / (4*pi*hBar*hBar*hBar*epsilon*epsilon);
+    if(opt.get_argument_known("tolerance"))
+        Wbar = calc.get_average_rates(i_idx0, f_idx0, opt.get_option<double>("tolerance"));
+    else
+    {
+        for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+            Wbar[itx] = transitions[itx].get_average_rate();
+    }
 
-            // Include final-state blocking factor
-            if (b_flag)
-                Wif[iki] *= (1 - fsb.get_occupation_at_k(kf));
+    FILE *Favg=fopen("imp-avg.dat","w"); // open file for output of weighted means
 
-            Ei_t[iki] = isb.get_E_total_at_k(ki) * 1000/e;
+    // Loop over all desired transitions
+    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+    {
+        // State indices for this transition (NB., these are indexed from 1)
+        const unsigned int i = i_indices[itx];
+        const unsigned int f = f_indices[itx];
+        const auto &tx = transitions[itx];
 
-            /* calculate Fermi-Dirac weighted mean of scattering rates over the 
-               initial carrier states, note that the integral step length 
-               dE=2*sqr(hBar)*ki*dki/(2m)					*/
-            Wbar_integrand_ki[iki] = Wif[iki]*ki*isb.get_occupation_at_k(ki);
-        } /* end ki	*/
+        // Output form-factors if desired
+        if(ff_flag)
+            output_ff(W, calc, i, f);
 
         /* output scattering rate versus carrier energy=subband minima+in-plane
            kinetic energy						*/
         char	filename[9];	/* character string for output filename		*/
         sprintf(filename,"imp%i%i.r",i,f);
-        write_table(filename, Ei_t, Wif);
-
-        const double Wbar = integral(Wbar_integrand_ki, dki)/(pi*isb.get_total_population());
+        const arma::vec Ei_t = tx.get_Ei_total_table() * 1000/e;
+        write_table(filename, Ei_t, tx.get_rate_table());
 
-        fprintf(Favg,"%i %i %20.17le\n", i,f,Wbar);
-
-        gsl_spline_free(FF);
-        gsl_interp_accel_free(acc);
-} /* end while over states */
-
-fclose(Favg);	/* close weighted mean output file	*/
-
-return EXIT_SUCCESS;
-} /* end main */
-
-/** Tabulate the matrix element defined as 
- *    C_if⁺(q,z') = ∫_{z'}^∞ dz ψ_i(z) ψ_f(z)/exp(qz)]
- *  for a given wavevector, with respect to position
- */
-arma::vec find_Cif_p(const arma::vec &psi_if, 
-                     const arma::vec &exp_qz,
-                     const arma::vec &z)
-{
-    const size_t nz = z.size();
-    arma::vec Cif_p(nz);
-    const double dz=z[1]-z[0];
-
-    Cif_p[nz-1] = psi_if[nz-1] / exp_qz[nz-1] * dz;
-
-    for(int iz = nz-2; iz >=0; iz--)
-        Cif_p[iz] = Cif_p[iz+1] + psi_if[iz] / exp_qz[iz] * dz;
-
-    return Cif_p;
-}
-
-/** 
- * \brief Tabulate scattering matrix element component.
- *
- * \details defined as:
- *    C_if⁻(q,z') = ∫_{-∞}^{z'} dz ψ_i(z) ψ_f(z) exp(qz)
- *  for a given wavevector, with respect to position
- *
- * Note that the upper limit has to be the point just BEFORE each z'
- * value so that we don't double count
- */
-arma::vec find_Cif_m(const arma::vec &psi_if, 
-                     const arma::vec &exp_qz,
-                     const arma::vec &z)
-{
-    const size_t nz = z.size();
-    arma::vec Cif_m(nz);
-    const double dz = z[1]-z[0];
-
-    // Seed the first value as zero
-    Cif_m[0] = 0;
-
-    // Now, perform a block integration by summing on top of the previous
-    // value in the array
-    for(unsigned int iz = 1; iz < nz; iz++)
-        Cif_m[iz] = Cif_m[iz-1] + psi_if[iz-1] * exp_qz[iz-1] * dz;
-
-    return Cif_m;
-}
-
-/** 
- * \brief Create an array of exp(qz) with respect to position
- *
- * \param q[in]       Scattering vector [1/m]
- * \param exp_qz[out] Output array (should be initialised before calling)
- * \param z[in]       Spatial positions [m]
- *
- * \todo  This is also useful for e-e scattering. Push into library
- */
-arma::vec find_exp_qz(const double q, const arma::vec &z)
-{
-    //const double Lp = z.max() - z.min();
-
-    // Use the midpoint of the z array as the origin, so as to minimise the
-    // magnitude of the exponential terms
-    return exp(q * (z - z[0]));
-}
-
-/** Find the matrix element Iif at a given dopant location z'.
- *
- * The matrix element is defined as
- *  I_if(q,z') = ∫dz ψ_i(z) ψ_f(z) exp(-q|z-z'|),
- * where z is the carrier location.  The numerical solution
- * can however be speeded up by replacing the modulus function
- * with the sum of two integrals.  We can say that
- *
- *  I_if(q,z') = C_if⁻(q,z')/exp(qz') + C_if⁺(q,z') exp(qz')',
- *
- * Therefore, we have separated the z' dependence from the
- * z dependence of the matrix element.
- */
-double Iif(const unsigned int iz0,
-           const arma::vec &Cif_p,
-           const arma::vec &Cif_m, 
-           const arma::vec &exp_qz)
-{
-    return Cif_m[iz0]/exp_qz[iz0] + Cif_p[iz0]*exp_qz[iz0];
-}
-
-/* This function calculates the overlap integral
- */
-double J(const double     q_perp,
-         const Subband   &isb,
-         const Subband   &fsb,
-         const arma::vec &d)
-{
- const auto z = isb.z_array();
- const auto nz = z.size();
- const auto dz = z[1] - z[0];
-
- // Convenience labels for wave-functions in each subband
- const auto psi_i = isb.psi_array();
- const auto psi_f = fsb.psi_array();
-
- // Products of wavefunctions can be computed in advance
- const auto psi_if = psi_i % psi_f;
-
- const auto expTerm   = find_exp_qz(q_perp, z);
- const auto Cif_plus  = find_Cif_p(psi_if, expTerm, z);
- const auto Cif_minus = find_Cif_m(psi_if, expTerm, z);
-
- arma::vec Jif_integrand(nz);
-
- // Integral of i(=0) and f(=2) over z
- for(unsigned int iz=0;iz<nz;iz++)
- {
-     const double _Iif = Iif(iz, Cif_plus, Cif_minus, expTerm);
-     Jif_integrand[iz] = _Iif * _Iif * d[iz];
- }
-
- const double Jif = integral(Jif_integrand, dz);
-
- return Jif;
-}
-
-/**
- *  \brief Compute the form factor Jif/q^2
- */
-gsl_spline * FF_table(const double     epsilon,
-                      const Subband   &isb,
-                      const Subband   &fsb,
-                      const arma::vec &d,
-                      const size_t     nq,
-                      const bool       S_flag,
-                      const double     E_cutoff)
-{
-    const double kimax = isb.get_k_at_Ek(E_cutoff*1.1); // Max value of ki [1/m]
-    const double Ei = isb.get_E_min();
-    const double Ef = fsb.get_E_min();
-    const double m  = isb.get_effective_mass();
-    const double kfmax = sqrt(kimax*kimax + 2*m*(Ei - Ef)/(hBar*hBar));
-
-    // maximum in-plane wave vector
-    const double q_max = sqrt(kimax*kimax + kfmax*kfmax + 2*kimax*kfmax);
-
-    const double dq=q_max/((float)(nq-1));	// interval in q_perp
-
-    arma::vec q(nq);
-    arma::vec FF(nq);
-
-    for(unsigned int iq=0;iq<nq;iq++)
-    {
-        q[iq] = iq*dq;
-
-        // Scattering matrix element
-        const double Jif = J(q[iq], isb, fsb, d);
-
-        // Thomas--Fermi screening wave-vector
-        double q_TF = 0.0;
-
-        // Allow screening to be turned off
-        if(S_flag)
-            q_TF = m*e*e/(2*pi*epsilon*hBar*hBar);
-
-        // Screening permittivity * wave vector
-        // Note that the pole at q_perp=0 is avoided as long as screening is included
-        FF[iq] = Jif / (q[iq]*q[iq] + q_TF*q_TF + 2*q[iq]*q_TF);
+        fprintf(Favg,"%i %i %20.17le\n", i,f,Wbar[itx]);
     }
 
-    // Fix singularity by "clipping" the top off it:
-    if(!S_flag)
-        FF[0] = FF[1];
-
-    // Pack the table of FF vs q into a cubic spline
-    gsl_spline *q_FF = gsl_spline_alloc(gsl_interp_cspline, nq);
-    gsl_spline_init(q_FF, &(q[0]), &(FF[0]), nq);
+    fclose(Favg);	/* close weighted mean output file	*/
 
-    return q_FF;
-}
+    return EXIT_SUCCESS;
+} /* end main */
 
 /* This function outputs the formfactors into files	*/
-static void output_ff(const double        W, // Arbitrary well width to generate q
-                      const std::vector<Subband> &subbands,
-                      const unsigned int  i,
-                      const unsigned int  f,
-                      const arma::vec    &d)
+static void output_ff(const double                        W, // Arbitrary well width to generate q
+                      const ScatteringCalculatorImpurity &calc,
+                      const unsigned int                  i,
+                      const unsigned int                  f)
 {
  char	filename[9];	/* output filename				*/
  FILE	*FA;		/* output file for form factors versus q_perp	*/
@@ -447,14 +194,10 @@ static void output_ff(const double        W, // Arbitrary well width to generate
      exit(EXIT_FAILURE);
  }
 
- // Convenience labels for each subband (NB., these are indexed from 0)
- const Subband isb = subbands[i-1];
- const Subband fsb = subbands[f-1];
-
  for(unsigned int iq=0;iq<100;iq++)
  {
   const double q_perp=6*iq/(100*W); // In-plane scattering vector
-  const double Jif = J(q_perp, isb, fsb, d);
+  const double Jif = calc.get_J(q_perp, i-1, f-1);
   fprintf(FA,"%le %le\n",q_perp*W,gsl_pow_2(Jif));
  }
 
@@ -8,18 +8,119 @@
 #include <cstdlib>
 #include <cmath>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <iostream>
 #include <gsl/gsl_math.h>
-#include <gsl/gsl_sf.h>
 #include "qwwad/constants.h"
 #include "qwwad/file-io.h"
-#include "qwwad/maths-helpers.h"
+#include "qwwad/scattering-calculator-ifr.h"
 #include "qwwad/subband.h"
 #include "qwwad/options.h"
 
 using namespace QWWAD;
 using namespace constants;
 
+/**
+ * \brief Read a comma-separated list of numbers
+ *
+ * \param[in] list The list
+ *
+ * \returns The numbers in the list
+ */
+static arma::vec read_parameter_list(const std::string &list)
+{
+    std::istringstream list_stream(list);
+    std::vector<double> values;
+    std::string item;
+
+    while(std::getline(list_stream, item, ','))
+    {
+        std::istringstream item_stream(item);
+        double value;
+
+        if(!(item_stream >> value))
+        {
+            std::ostringstream oss;
+            oss << "Can't read parameter value '" << item << "'";
+            throw std::invalid_argument(oss.str());
+        }
+
+        values.push_back(value);
+    }
+
+    if(values.empty())
+        throw std::invalid_argument("Empty parameter list");
+
+    return arma::vec(values);
+}
+
+/**
+ * \brief Find average rates for each combination of roughness parameters
+ *
+ * \param[in] calc      Scattering calculator
+ * \param[in] i_idx     Initial subband indices (from zero)
+ * \param[in] f_idx     Final subband indices (from zero)
+ * \param[in] Delta     Roughness heights [m]
+ * \param[in] Lambda    Correlation lengths [m]
+ * \param[in] use_tol   True if adaptive integration is wanted
+ * \param[in] tol       Relative tolerance for adaptive integration
+ *
+ * \details The squared matrix elements are cached in the calculator, so
+ *          they are found only once for all parameters.  The rate is
+ *          proportional to Delta^2, so only one calculation is needed for
+ *          each correlation length.
+ */
+static void write_sweep(ScatteringCalculatorIFR &calc,
+                        const arma::uvec        &i_idx,
+                        const arma::uvec        &f_idx,
+                        const arma::vec         &Delta,
+                        const arma::vec         &Lambda,
+                        const bool               use_tol,
+                        const double             tol)
+{
+    const size_t ntx = i_idx.size();
+
+    // Average rates for each transition (columns) and correlation length (rows),
+    // with unit roughness height
+    arma::mat Wbar_unit(Lambda.size(), ntx);
+    calc.set_Delta(1.0);
+
+    for(unsigned int iLambda = 0; iLambda < Lambda.size(); ++iLambda)
+    {
+        calc.set_Lambda(Lambda[iLambda]);
+
+        if(use_tol)
+            Wbar_unit.row(iLambda) = calc.get_average_rates(i_idx, f_idx, tol).t();
+        else
+        {
+            const auto transitions = calc.get_transitions(i_idx, f_idx);
+
+            for(unsigned int itx = 0; itx < ntx; ++itx)
+                Wbar_unit(iLambda, itx) = transitions[itx].get_average_rate();
+        }
+    }
+
+    FILE *Fsweep=fopen("ifr-sweep.dat","w");
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        for(unsigned int iDelta = 0; iDelta < Delta.size(); ++iDelta)
+        {
+            for(unsigned int iLambda = 0; iLambda < Lambda.size(); ++iLambda)
+            {
+                fprintf(Fsweep,"%i %i %g %g %20.17le\n",
+                        (int)i_idx[itx]+1, (int)f_idx[itx]+1,
+                        Delta[iDelta]*1e10, Lambda[iLambda]*1e10,
+                        Wbar_unit(iLambda, itx)*Delta[iDelta]*Delta[iDelta]);
+            }
+        }
+    }
+
+    fclose(Fsweep);
+}
+
 Options configure_options(int argc, char* argv[])
 {
     Options opt;
@@ -35,6 +136,13 @@ Options configure_options(int argc, char* argv[])
     opt.add_option<double>("temperature,T",   300, "Temperature of carrier distribution.");
     opt.add_option<double>("Ecutoff",              "Cut-off energy for carrier distribution [meV]. If not specified, then 5kT above band-edge.");
     opt.add_option<size_t>("nki",             101, "Number of initial wave-vector samples.");
+    opt.add_option<double>("tolerance",            "Relative tolerance for average rates. If specified, the "
+                                                   "averages are found by adaptive integration rather than "
+                                                   "from the table of rates.");
+    opt.add_option<std::string>("deltasweep",      "Comma-separated list of roughness heights [angstrom]. If "
+                                                   "this or lambdasweep is given, the average rates for every "
+                                                   "combination of parameters are written to ifr-sweep.dat.");
+    opt.add_option<std::string>("lambdasweep",     "Comma-separated list of roughness correlation lengths [angstrom].");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -88,143 +196,88 @@ int main(int argc,char *argv[])
 
     read_table("rrp.r", i_indices, f_indices);
 
-    FILE *Favg=fopen("ifr-avg.dat","w"); // open file for output of weighted means
+    ScatteringCalculatorIFR calc(subbands, V, iz_I, Delta, Lambda, m, T);
+    calc.enable_blocking(b_flag);
+    calc.set_ki_samples(nki);
 
-    // Loop over all desired transitions
-    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+    // Use user-specified cut-off energy if given
+    if(opt.get_argument_known("Ecutoff"))
     {
-        // State indices for this transition (NB., these are indexed from 1)
-        unsigned int i = i_indices[itx];
-        unsigned int f = f_indices[itx];
-
-        // Convenience labels for each subband (NB., these are indexed from 0)
-        const Subband isb = subbands[i-1];
-        const Subband fsb = subbands[f-1];
-
-        // Subband minima
-        const double Ei = isb.get_E_min();
-        const double Ef = fsb.get_E_min();
+        const auto Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+        calc.set_Eki_cutoff(Ecutoff);
 
-        // Find minimum initial wave-vector that allows scattering
-        const double Efi = Ef - Ei;
-        double kimin = 0.0;
-        if(Efi > 0)
-            kimin = sqrt(2*m*Efi)/hBar;
-
-        double kimax = 0;
-        double Ecutoff = 0.0; // Maximum kinetic energy in initial subband
-
-        // Use user-specified value if given
-        if(opt.get_argument_known("Ecutoff"))
+        for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
         {
-            Ecutoff = opt.get_option<double>("Ecutoff")*e/1000;
+            const auto i = i_indices[itx];
+            const auto f = f_indices[itx];
 
-            if(Ecutoff+Ei < Ef)
+            if(Ecutoff + subbands[i-1].get_E_min() < subbands[f-1].get_E_min())
             {
                 std::cerr << "No scattering permitted from state " << i << "->" << f << " within the specified cut-off energy." << std::endl;
                 std::cerr << "Extending range automatically" << std::endl;
-                Ecutoff += Ef;
             }
         }
-        // Otherwise, use a fixed, 5kT range
-        else
-        {
-            kimax   = isb.get_k_max(T);
-            Ecutoff = hBar*hBar*kimax*kimax/(2*m);
-
-            if(Ecutoff+Ei < Ef)
-                Ecutoff += Ef;
-        }
-
-        kimax = isb.get_k_at_Ek(Ecutoff);
-
-        const double dki=(kimax-kimin)/((float)nki - 1); // step length for loop over ki
+    }
 
-        arma::vec Wbar_integrand_ki(nki); // initialise integral for average scattering rate
-        arma::vec Wif(nki);               // Scattering rate for a given initial wave vector
-        arma::vec Ei_t(nki);              // Total energy of initial state (for output file) [meV]
+    // Subbands are indexed from zero in the calculator
+    const arma::uvec i_idx0 = i_indices - 1;
+    const arma::uvec f_idx0 = f_indices - 1;
 
-        // Find interface-roughness scattering matrix element
-        const double dz = z[1] - z[0];
-        const size_t nz = z.size();
-        arma::vec dV_dz(nz); // Derivative of potential profile [J/m]
-
-        for (unsigned int iz = 1; iz < nz-1; ++iz)
-            dV_dz[iz] = (V[iz+1] - V[iz-1])/dz;
-
-        // Assume periodic boundary conditions
-        dV_dz[0]    = (V[1] - V[nz-1])/dz;
-        dV_dz[nz-1] = (V[0] - V[nz-2])/dz;
-
-        const auto psi_i  = isb.psi_array();
-        const auto psi_f  = fsb.psi_array();
-        const arma::vec psi_if = psi_i%psi_f;
-        double F_if_sq = 0.0;
-
-        // Get contributions from each interface
-        // Note that we don't include the last one, since this is the edge of the system, where
-        // psi = 0
-        for (unsigned int I=0; I < iz_I.size()-1; ++I)
-        {
-            unsigned int iz_L = 0; // Lower bound of interface
-            unsigned int iz_U = 0; // Upper bound of interface
+    // In sweep mode, only the average rates are written
+    if(opt.get_argument_known("deltasweep") || opt.get_argument_known("lambdasweep"))
+    {
+        arma::vec Delta_list  = {Delta};
+        arma::vec Lambda_list = {Lambda};
 
-            if(I != 0)
-                iz_L = (iz_I[I] + iz_I[I-1])/2;
-            else
-                iz_L = iz_I[0]/2;
+        if(opt.get_argument_known("deltasweep"))
+            Delta_list = read_parameter_list(opt.get_option<std::string>("deltasweep"))*1e-10;
 
-            iz_U = (iz_I[I] + iz_I[I+1])/2;
+        if(opt.get_argument_known("lambdasweep"))
+            Lambda_list = read_parameter_list(opt.get_option<std::string>("lambdasweep"))*1e-10;
 
-            arma::vec F_integrand_dz(iz_U-iz_L);
-            for (unsigned int iz = iz_L; iz < iz_U; ++iz)
-                F_integrand_dz[iz-iz_L] = psi_if[iz]*dV_dz[iz];
+        const bool use_tol = opt.get_argument_known("tolerance");
+        const double tol   = use_tol ? opt.get_option<double>("tolerance") : 0.0;
 
-            const double F_if = integral(F_integrand_dz, dz);
-            F_if_sq = F_if*F_if;
-        }
+        write_sweep(calc, i_idx0, f_idx0, Delta_list, Lambda_list, use_tol, tol);
 
-        // calculate scattering rate for all ki
-        for(unsigned int iki=0;iki<nki;iki++)
-        {
-            const double ki=kimin+dki*iki; // carrier momentum
-            const double ki_sqr = ki*ki;
+        return EXIT_SUCCESS;
+    }
 
-            // Find energy-conserving final wave-vector
-            // This should be positive if the kimin value is correct
-            const double kf_sqr = ki_sqr + 2*m*(Ei - Ef)/(hBar*hBar);
-            assert(kf_sqr >= 0.0);
-            const double kf = sqrt(kf_sqr);
-            assert(!std::isnan(kf));
-            const double beta = exp(-(ki_sqr + kf_sqr)*Lambda*Lambda/4) * gsl_sf_bessel_I0(ki*kf*Lambda*Lambda/2);
+    const auto transitions = calc.get_transitions(i_idx0, f_idx0);
 
-            Wif[iki] = pi*m*Delta*Delta*Lambda*Lambda/(hBar*hBar*hBar) * beta * F_if_sq;
+    // Average rates for each transition
+    arma::vec Wbar(i_indices.size());
 
-            // Include final-state blocking factor
-            if (b_flag)
-                Wif[iki] *= (1 - fsb.get_occupation_at_k(kf));
+    if(opt.get_argument_known("tolerance"))
+        Wbar = calc.get_average_rates(i_idx0, f_idx0, opt.get_option<double>("tolerance"));
+    else
+    {
+        for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+            Wbar[itx] = transitions[itx].get_average_rate();
+    }
 
-            Ei_t[iki] = isb.get_E_total_at_k(ki) * 1000/e;
+    FILE *Favg=fopen("ifr-avg.dat","w"); // open file for output of weighted means
 
-            /* calculate Fermi-Dirac weighted mean of scattering rates over the 
-               initial carrier states, note that the integral step length 
-               dE=2*sqr(hBar)*ki*dki/(2m)					*/
-            Wbar_integrand_ki[iki] = Wif[iki]*ki*isb.get_occupation_at_k(ki);
-        } /* end ki	*/
+    // Loop over all desired transitions
+    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+    {
+        // State indices for this transition (NB., these are indexed from 1)
+        const unsigned int i = i_indices[itx];
+        const unsigned int f = f_indices[itx];
+        const auto &tx = transitions[itx];
 
         /* output scattering rate versus carrier energy=subband minima+in-plane
            kinetic energy						*/
         char	filename[9];	/* character string for output filename		*/
         sprintf(filename,"ifr%i%i.r",i,f);
-        write_table(filename, Ei_t, Wif);
-
-        const double Wbar = integral(Wbar_integrand_ki, dki)/(pi*isb.get_total_population());
+        const arma::vec Ei_t = tx.get_Ei_total_table() * 1000/e;
+        write_table(filename, Ei_t, tx.get_rate_table());
 
-        fprintf(Favg,"%i %i %20.17le\n", i,f,Wbar);
-} /* end while over states */
+        fprintf(Favg,"%i %i %20.17le\n", i,f,Wbar[itx]);
+    }
 
-fclose(Favg);	/* close weighted mean output file	*/
+    fclose(Favg);	/* close weighted mean output file	*/
 
-return EXIT_SUCCESS;
+    return EXIT_SUCCESS;
 } /* end main */
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -9,7 +9,11 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <vector>
 #include "qwwad/constants.h"
 #include "qwwad/scattering-calculator-LO.h"
 #include "qwwad/file-io.h"
@@ -44,12 +48,52 @@ static Options configure_options(int argc, char* argv[])
     opt.add_option<double>("Tl",               300, "Lattice temperature [K].");
     opt.add_option<size_t>("nki",              101, "Number of initial wave-vector samples.");
     opt.add_option<size_t>("nKz",              101, "Number of phonon wave-vector samples.");
+    opt.add_option<double>("tolerance",             "Relative tolerance for average rates. If specified, the "
+                                                    "averages are found by adaptive integration rather than "
+                                                    "from the table of rates.");
+    opt.add_option<std::string>("Tllist",           "Comma-separated list of lattice temperatures [K]. If "
+                                                    "specified, the rates are found at each temperature in "
+                                                    "turn, reusing the form factors.  The rate tables are "
+                                                    "written to LOe<i><f>-<Tl>K-<Te>K.r etc., and the average "
+                                                    "rates for each temperature are written as extra columns in "
+                                                    "LOa-if.r and LOe-if.r.");
+    opt.add_option<std::string>("Telist",           "Comma-separated list of carrier temperatures [K], one for "
+                                                    "each lattice temperature in --Tllist.  If not specified, "
+                                                    "the carrier temperature is fixed at --Te.");
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
     return opt;
 }
 
+/**
+ * \brief Read a comma-separated list of temperatures [K]
+ */
+static std::vector<double> read_temperature_list(const std::string &list)
+{
+    std::vector<double> values;
+    std::istringstream stream(list);
+    std::string item;
+
+    while(std::getline(stream, item, ','))
+        values.push_back(std::stod(item));
+
+    if(values.empty())
+        throw std::invalid_argument("Temperature list is empty");
+
+    for(const auto T : values)
+    {
+        if(T <= 0)
+        {
+            std::ostringstream oss;
+            oss << "Temperature " << T << " K must be positive";
+            throw std::domain_error(oss.str());
+        }
+    }
+
+    return values;
+}
+
 int main(int argc,char *argv[])
 {
     const auto opt = configure_options(argc, argv);
@@ -107,49 +151,147 @@ int main(int argc,char *argv[])
     read_table("rrp.r", i_indices, f_indices);
     const size_t ntx = i_indices.size();
 
-    arma::vec Wabar(ntx);
-    arma::vec Webar(ntx);
+    // Note that the -1 is needed because the input file indexes subbands from 1 upward
+    const arma::uvec i_indices_0 = i_indices - 1;
+    const arma::uvec f_indices_0 = f_indices - 1;
+
+    // The form factors are the same for emission and absorption, so
+    // only compute them once
+    ab_calculator.share_pair_data(em_calculator);
+    em_calculator.prepare(i_indices_0, f_indices_0);
+
+    // Temperatures to use.  By default, there is just the one given by --Te and --Tl
+    const auto sweep = opt.get_argument_known("Tllist");
+    std::vector<double> Tl_list(1, Tl);
+    std::vector<double> Te_list(1, Te);
 
-    // Loop over all desired transitions
-    for(unsigned int itx = 0; itx < i_indices.size(); ++itx)
+    if(sweep)
     {
-        // Get subband indices.  Note that the -1 is needed because the
-        // input file indexes subbands from 1 upward
-        unsigned int i = i_indices[itx] - 1;
-        unsigned int f = f_indices[itx] - 1;
+        Tl_list = read_temperature_list(opt.get_option<std::string>("Tllist"));
+        Te_list = std::vector<double>(Tl_list.size(), Te);
 
-        // Output form-factors if desired
-        if(ff_flag)
+        if(opt.get_argument_known("Telist"))
         {
-            const auto Kz     = em_calculator.get_Kz_table();
-            const auto Gifsqr = em_calculator.get_ff_table(i,f);
-            ff_output(Kz, Gifsqr, i,f);
+            Te_list = read_temperature_list(opt.get_option<std::string>("Telist"));
+
+            if(Te_list.size() != Tl_list.size())
+            {
+                std::ostringstream oss;
+                oss << "Telist contains " << Te_list.size() << " temperatures, but Tllist contains "
+                    << Tl_list.size() << ".";
+                throw std::length_error(oss.str());
+            }
         }
+    }
+
+    const auto nT = Tl_list.size();
+    arma::mat Wabar(ntx, nT);
+    arma::mat Webar(ntx, nT);
+
+    // The form factors don't depend on temperature, so only the rates are
+    // recalculated for each temperature
+    for(unsigned int iT = 0; iT < nT; ++iT)
+    {
+        if(sweep)
+        {
+            em_calculator.set_temperatures(Te_list[iT], Tl_list[iT]);
+            ab_calculator.set_temperatures(Te_list[iT], Tl_list[iT]);
+        }
+
+        // Compute all transitions in one batch, so that the work is shared
+        // between all available threads
+        const auto tx_em_list = em_calculator.get_transitions(i_indices_0, f_indices_0);
+        const auto tx_ab_list = ab_calculator.get_transitions(i_indices_0, f_indices_0);
+
+        // Suffix for rate-table filenames in a temperature sweep
+        std::ostringstream T_suffix;
 
-        const auto tx_em  = em_calculator.get_transition(i, f);
-        const auto tx_ab  = ab_calculator.get_transition(i, f);
-        const auto Weif   = tx_em.get_rate_table(); // Emission scattering rate at this wave-vector [1/s]
-        const auto Waif   = tx_ab.get_rate_table(); // Absorption scattering rate at this wave-vector [1/s]
-        auto Ei_em  = tx_em.get_Ei_total_table();  // Initial TOTAL energies [J]
-        auto Ei_ab  = tx_ab.get_Ei_total_table();  // Initial TOTAL energies [J]
-        Ei_em *= 1000.0/e; // Rescale to meV
-        Ei_ab *= 1000.0/e; // Rescale to meV
-
-        // output scattering rates versus TOTAL carrier energy
-        char	filename_em[9];
-        sprintf(filename_em, "LOe%i%i.r",i,f);	/* emission	*/
-        char	filename_ab[9];
-        sprintf(filename_ab,"LOa%i%i.r",i,f);	/* absorption	*/
-        write_table(filename_em, Ei_em, Weif);
-        write_table(filename_ab, Ei_ab, Waif);
-
-        // Average rates over entire subband
-        Wabar[itx] = tx_ab.get_average_rate();
-        Webar[itx] = tx_em.get_average_rate();
-    } /* end while over states */
-
-    write_table("LOa-if.r", i_indices, f_indices, Wabar);
-    write_table("LOe-if.r", i_indices, f_indices, Webar);
+        if(sweep)
+            T_suffix << "-" << Tl_list[iT] << "K-" << Te_list[iT] << "K";
+
+        // Loop over all desired transitions
+        for(unsigned int itx = 0; itx < ntx; ++itx)
+        {
+            // Get subband indices
+            unsigned int i = i_indices_0[itx];
+            unsigned int f = f_indices_0[itx];
+
+            // Output form-factors if desired.  These don't depend on temperature
+            if(ff_flag && iT == 0)
+            {
+                const auto Kz     = em_calculator.get_Kz_table();
+                const auto Gifsqr = em_calculator.get_ff_table(i,f);
+                ff_output(Kz, Gifsqr, i,f);
+            }
+
+            const auto &tx_em = tx_em_list[itx];
+            const auto &tx_ab = tx_ab_list[itx];
+            const auto Weif   = tx_em.get_rate_table(); // Emission scattering rate at this wave-vector [1/s]
+            const auto Waif   = tx_ab.get_rate_table(); // Absorption scattering rate at this wave-vector [1/s]
+            auto Ei_em  = tx_em.get_Ei_total_table();  // Initial TOTAL energies [J]
+            auto Ei_ab  = tx_ab.get_Ei_total_table();  // Initial TOTAL energies [J]
+            Ei_em *= 1000.0/e; // Rescale to meV
+            Ei_ab *= 1000.0/e; // Rescale to meV
+
+            // output scattering rates versus TOTAL carrier energy
+            std::ostringstream filename_em; // emission
+            filename_em << "LOe" << i << f << T_suffix.str() << ".r";
+            std::ostringstream filename_ab; // absorption
+            filename_ab << "LOa" << i << f << T_suffix.str() << ".r";
+            write_table(filename_em.str(), Ei_em, Weif);
+            write_table(filename_ab.str(), Ei_ab, Waif);
+
+            // Average rates over entire subband
+            Wabar(itx, iT) = tx_ab.get_average_rate();
+            Webar(itx, iT) = tx_em.get_average_rate();
+        }
+
+        // Replace the averages with error-controlled values if wanted
+        if(opt.get_argument_known("tolerance"))
+        {
+            const auto tolerance = opt.get_option<double>("tolerance");
+            Wabar.col(iT) = ab_calculator.get_average_rates(i_indices_0, f_indices_0, tolerance);
+            Webar.col(iT) = em_calculator.get_average_rates(i_indices_0, f_indices_0, tolerance);
+        }
+
+        if(opt.get_verbose() && sweep)
+            std::cout << "Found rates for Tl = " << Tl_list[iT] << " K, Te = " << Te_list[iT] << " K" << std::endl;
+    }
+
+    if(sweep)
+    {
+        // One column of average rates for each temperature
+        std::ofstream ab_stream("LOa-if.r");
+        std::ofstream em_stream("LOe-if.r");
+        ab_stream << std::scientific << std::setprecision(12);
+        em_stream << std::scientific << std::setprecision(12);
+
+        for(unsigned int itx = 0; itx < ntx; ++itx)
+        {
+            ab_stream << i_indices[itx] << "\t" << f_indices[itx];
+            em_stream << i_indices[itx] << "\t" << f_indices[itx];
+
+            for(unsigned int iT = 0; iT < nT; ++iT)
+            {
+                ab_stream << "\t" << Wabar(itx, iT);
+                em_stream << "\t" << Webar(itx, iT);
+            }
+
+            ab_stream << std::endl;
+            em_stream << std::endl;
+        }
+
+        // Record which temperature is in each column
+        std::ofstream T_stream("LO-temperatures.r");
+
+        for(unsigned int iT = 0; iT < nT; ++iT)
+            T_stream << Tl_list[iT] << "\t" << Te_list[iT] << std::endl;
+    }
+    else
+    {
+        write_table("LOa-if.r", i_indices, f_indices, arma::vec(Wabar.col(0)));
+        write_table("LOe-if.r", i_indices, f_indices, arma::vec(Webar.col(0)));
+    }
 
     return EXIT_SUCCESS;
 }
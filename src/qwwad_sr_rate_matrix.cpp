@@ -0,0 +1,380 @@
+/**
+ * \file   qwwad_sr_rate_matrix.cpp
+ * \brief  Find the average scattering rates between all pairs of subbands
+ *         for a set of scattering mechanisms
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include "qwwad/constants.h"
+#include "qwwad/file-io.h"
+#include "qwwad/options.h"
+#include "qwwad/scattering-calculator-acoustic.h"
+#include "qwwad/scattering-calculator-alloy.h"
+#include "qwwad/scattering-calculator-ifr.h"
+#include "qwwad/scattering-calculator-impurity.h"
+#include "qwwad/scattering-calculator-LO.h"
+#include "qwwad/subband.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+static Options configure_options(int argc, char* argv[])
+{
+    Options opt;
+
+    std::string doc("Find the average scattering rate between every pair of subbands, for a set "
+                    "of scattering mechanisms.  The output file contains one line per transition, "
+                    "giving the initial and final subband indices, the rate for each selected "
+                    "mechanism in the order given, and the total rate [1/s].  Phonon mechanisms "
+                    "give separate emission and absorption columns.");
+
+    opt.add_option<std::string>("mechanisms",      "LO,AC", "Comma-separated list of scattering mechanisms. "
+                                                            "Choose from: LO (polar LO phonon), AC (acoustic "
+                                                            "phonon), IFR (interface roughness), ADO (alloy "
+                                                            "disorder), IMP (ionised impurity).");
+    opt.add_option<std::string>("outfile",  "rate-matrix.dat", "File to which the rates will be written");
+    opt.add_option<bool>       ("noblocking,b",                "Disable final-state blocking.");
+    opt.add_option<double>     ("mass,m",               0.067, "Band-edge effective mass (relative to free electron)");
+    opt.add_option<char>       ("particle,p",             'e', "ID of particle to be used: 'e', 'h' or 'l', for "
+                                                               "electrons, heavy holes or light holes respectively.");
+    opt.add_option<double>     ("Te",                     300, "Carrier temperature [K].");
+    opt.add_option<double>     ("Tl",                     300, "Lattice temperature [K].");
+    opt.add_option<double>     ("Ecutoff",                     "Cut-off energy for carrier distribution [meV]. If not specified, then 5kT above band-edge.");
+    opt.add_option<size_t>     ("nki",                    301, "Number of initial wave-vector samples.");
+    opt.add_option<double>     ("tolerance",                   "Relative tolerance for average rates. If specified, the "
+                                                               "averages are found by adaptive integration rather than "
+                                                               "on a fixed grid of wave-vectors.");
+
+    // Phonon parameters
+    opt.add_option<double>     ("latticeconst,A",        5.65, "Lattice constant in growth direction [angstrom]");
+    opt.add_option<size_t>     ("nKz",                    301, "Number of phonon wave-vector samples.");
+    opt.add_option<double>     ("ELO",                   36.0, "Energy of LO phonon [meV]");
+    opt.add_option<double>     ("epss",                 13.18, "Static dielectric constant");
+    opt.add_option<double>     ("epsinf",               10.89, "High-frequency dielectric constant");
+    opt.add_option<bool>       ("noLOscreening",               "Disable screening of LO-phonon scattering.");
+    opt.add_option<double>     ("Eacoustic",              2.0, "Energy of acoustic phonon [meV]");
+    opt.add_option<double>     ("vs",                  5117.0, "Speed of sound [m/s]");
+    opt.add_option<double>     ("density",             5317.5, "Mass density [kg/m^3]");
+    opt.add_option<double>     ("Da",                     7.0, "Acoustic deformation potential [eV]");
+    opt.add_option<size_t>     ("ntheta",                 101, "Number of strips in theta angle integration");
+
+    // Elastic scattering parameters
+    opt.add_option<double>     ("delta",                    3, "Interface roughness height [angstrom]");
+    opt.add_option<double>     ("lambda",                  50, "Interface roughness correlation length [angstrom]");
+    opt.add_option<double>     ("Vad",                    600, "Alloy disorder potential [meV]");
+    opt.add_option<double>     ("cellfraction",             4, "Fraction of unit cell occupied by each alloy scatterer");
+    opt.add_option<bool>       ("noimpscreening",              "Disable screening of impurity scattering.");
+    opt.add_option<size_t>     ("nq",                     101, "Number of strips in impurity scattering vector integration");
+
+    opt.add_prog_specific_options_and_parse(argc, argv, doc);
+
+    return opt;
+}
+
+/**
+ * \brief A column of the rate matrix, computed by a single calculator
+ */
+struct RateColumn {
+    std::string                           name; ///< Label for the column
+    std::shared_ptr<ScatteringCalculator> calc; ///< Calculator for the mechanism
+};
+
+int main(int argc,char *argv[])
+{
+    const auto opt = configure_options(argc, argv);
+
+    const auto m      =  opt.get_option<double>("mass")*me;              // Band-edge effective mass [kg]
+    const auto p      =  opt.get_option<char>  ("particle");             // Particle ID
+    const auto Te     =  opt.get_option<double>("Te");                   // Carrier temperature [K]
+    const auto Tl     =  opt.get_option<double>("Tl");                   // Lattice temperature [K]
+    const auto b_flag = !opt.get_option<bool>  ("noblocking");           // Include final-state blocking by default
+    const auto nki    =  opt.get_option<size_t>("nki");                  // number of ki calculations
+    const auto A0     =  opt.get_option<double>("latticeconst") * 1e-10; // Lattice constant [m]
+    const auto nKz    =  opt.get_option<size_t>("nKz");                  // number of Kz calculations
+
+    std::ostringstream E_filename; // Energy filename string
+    E_filename << "E" << p << ".r";
+    std::ostringstream wf_prefix;  // Wavefunction filename prefix
+    wf_prefix << "wf_" << p;
+
+    // Read data for all subbands from file.  This is done once, and shared by
+    // all mechanisms
+    auto subbands = Subband::read_from_file(E_filename.str(),
+                                            wf_prefix.str(),
+                                            ".r",
+                                            m);
+
+    // Read and set carrier distributions within each subband
+    arma::vec  Ef;      // Fermi energies [J]
+    arma::uvec indices; // Subband indices (garbage)
+    read_table("Ef.r", indices, Ef);
+    Ef *= e/1000.0; // Rescale to J
+
+    const size_t nst = subbands.size();
+
+    for(unsigned int isb = 0; isb < nst; ++isb)
+        subbands[isb].set_distribution_from_Ef_Te(Ef[isb], Te);
+
+    // Set up a calculator for each requested mechanism
+    std::vector<RateColumn> columns;
+    double Ephonon_max = 0.0; // Largest phonon energy in use [J]
+
+    std::istringstream mechanism_list(opt.get_option<std::string>("mechanisms"));
+    std::string mechanism;
+
+    while(std::getline(mechanism_list, mechanism, ','))
+    {
+        // Allow spaces around each name, e.g., "LO, AC"
+        const auto first = mechanism.find_first_not_of(" \t");
+        const auto last  = mechanism.find_last_not_of(" \t");
+        mechanism = (first == std::string::npos) ? "" : mechanism.substr(first, last - first + 1);
+
+        if(mechanism == "LO")
+        {
+            const auto ELO    = opt.get_option<double>("ELO") * e/1000;
+            const auto epss   = opt.get_option<double>("epss")   * eps0;
+            const auto epsinf = opt.get_option<double>("epsinf") * eps0;
+            const auto S_flag = !opt.get_option<bool>("noLOscreening");
+
+            auto em = std::make_shared<ScatteringCalculatorLO>(subbands, A0, ELO, epss, epsinf, m, Te, Tl, true);
+            auto ab = std::make_shared<ScatteringCalculatorLO>(subbands, A0, ELO, epss, epsinf, m, Te, Tl, false);
+
+            for(auto calc : {em, ab})
+            {
+                calc->enable_screening(S_flag);
+                calc->enable_blocking(b_flag);
+                calc->set_phonon_samples(nKz);
+            }
+
+            // Form factors are the same for emission and absorption
+            ab->share_pair_data(*em);
+
+            columns.push_back({"LOe", em});
+            columns.push_back({"LOa", ab});
+            Ephonon_max = std::max(Ephonon_max, ELO);
+        }
+        else if(mechanism == "AC")
+        {
+            const auto Eac = opt.get_option<double>("Eacoustic") * e/1000;
+            const auto Vs  = opt.get_option<double>("vs");
+            const auto rho = opt.get_option<double>("density");
+            const auto Da  = opt.get_option<double>("Da") * e;
+
+            auto em = std::make_shared<ScatteringCalculatorAcoustic>(subbands, A0, Eac, Da, rho, Vs, m, Te, Tl, true);
+            auto ab = std::make_shared<ScatteringCalculatorAcoustic>(subbands, A0, Eac, Da, rho, Vs, m, Te, Tl, false);
+
+            for(auto calc : {em, ab})
+            {
+                calc->enable_blocking(b_flag);
+                calc->set_phonon_samples(nKz);
+                calc->set_theta_samples(opt.get_option<size_t>("ntheta"));
+            }
+
+            ab->share_pair_data(*em);
+
+            columns.push_back({"ACe", em});
+            columns.push_back({"ACa", ab});
+            Ephonon_max = std::max(Ephonon_max, Eac);
+        }
+        else if(mechanism == "IFR")
+        {
+            arma::vec z;
+            arma::vec V;
+            read_table("v.r", z, V);
+
+            arma::uvec iz_I;
+            read_table("interfaces.r", iz_I);
+
+            const auto Delta  = opt.get_option<double>("delta")*1e-10;
+            const auto Lambda = opt.get_option<double>("lambda")*1e-10;
+
+            auto calc = std::make_shared<ScatteringCalculatorIFR>(subbands, V, iz_I, Delta, Lambda, m, Te);
+            calc->enable_blocking(b_flag);
+            columns.push_back({"IFR", calc});
+        }
+        else if(mechanism == "ADO")
+        {
+            arma::vec z;
+            arma::vec x;
+            read_table("x.r", z, x);
+
+            const auto Vad   = opt.get_option<double>("Vad")*e/1000;
+            const auto Ncell = opt.get_option<double>("cellfraction");
+            const auto Omega = A0*A0*A0/Ncell;
+
+            auto calc = std::make_shared<ScatteringCalculatorAlloy>(subbands, x, Vad, Omega, m, Te);
+            calc->enable_blocking(b_flag);
+            columns.push_back({"ADO", calc});
+        }
+        else if(mechanism == "IMP")
+        {
+            arma::vec z;
+            arma::vec d;
+            read_table("d.r", z, d);
+
+            const auto epsilon = opt.get_option<double>("epss")*eps0;
+
+            auto calc = std::make_shared<ScatteringCalculatorImpurity>(subbands, d, epsilon, m, Te);
+            calc->enable_blocking(b_flag);
+            calc->enable_screening(!opt.get_option<bool>("noimpscreening"));
+            calc->set_q_samples(opt.get_option<size_t>("nq"));
+            calc->set_theta_samples(opt.get_option<size_t>("ntheta"));
+            columns.push_back({"IMP", calc});
+        }
+        else
+        {
+            std::cerr << "Unknown scattering mechanism: \"" << mechanism << "\" in \""
+                      << opt.get_option<std::string>("mechanisms") << "\"." << std::endl
+                      << "Valid mechanisms are LO, AC, IFR, ADO and IMP." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(columns.empty())
+    {
+        std::cerr << "No scattering mechanisms were selected" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Wavefunction products are computed once for all mechanisms
+    for(unsigned int icol = 1; icol < columns.size(); ++icol)
+        columns[icol].calc->share_psi_products(*columns[0].calc);
+
+    // List all transitions
+    const size_t ntx = nst*nst;
+    arma::uvec i_indices(ntx);
+    arma::uvec f_indices(ntx);
+
+    for(unsigned int i = 0; i < nst; ++i)
+    {
+        for(unsigned int f = 0; f < nst; ++f)
+        {
+            i_indices[i*nst + f] = i;
+            f_indices[i*nst + f] = f;
+        }
+    }
+
+    // Find the range of initial wave-vectors for each transition.  This
+    // covers the thermal distribution in the initial subband, and is extended
+    // if needed so that it reaches the threshold for every mechanism.
+    const auto Ecutoff_user = opt.get_argument_known("Ecutoff") ?
+                              opt.get_option<double>("Ecutoff")*e/1000 : 0.0;
+
+    arma::vec ki_cutoff(ntx);  // Largest initial wave-vector for each transition [1/m]
+    double Ecutoff_max = 0.0; // Largest cut-off energy for any transition [J]
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        const auto &isb = subbands[i_indices[itx]];
+        const auto &fsb = subbands[f_indices[itx]];
+        const auto Ei   = isb.get_E_min();
+
+        auto Ecutoff = Ecutoff_user;
+
+        if(Ecutoff <= 0.0)
+            Ecutoff = isb.get_Ek_at_k(isb.get_k_max(Te));
+
+        const auto Ethreshold = fsb.get_E_min() - Ei + Ephonon_max;
+
+        if(Ecutoff < Ethreshold)
+            Ecutoff += Ethreshold;
+
+        Ecutoff_max    = std::max(Ecutoff_max, Ecutoff);
+        ki_cutoff[itx] = isb.get_k_at_Ek(Ecutoff);
+    }
+
+    // Make sure that any tabulated form factors cover the whole range
+    for(const auto &column : columns)
+    {
+        auto elastic = std::dynamic_pointer_cast<ScatteringCalculatorElastic>(column.calc);
+
+        if(elastic)
+            elastic->set_Eki_cutoff(Ecutoff_max);
+    }
+
+    // Find the average rate for each mechanism.  The initial wave-vectors
+    // for each mechanism start at its own threshold, so that none of the
+    // samples are wasted where scattering is forbidden.
+    const size_t ncol = columns.size();
+    arma::mat Wbar(ntx, ncol);
+
+    for(unsigned int icol = 0; icol < ncol; ++icol)
+    {
+        const auto &calc = columns[icol].calc;
+
+        arma::vec ki_onset(ntx); // Initial wave-vector at which scattering switches on [1/m]
+
+        for(unsigned int itx = 0; itx < ntx; ++itx)
+            ki_onset[itx] = std::min(calc->get_ki_onset(i_indices[itx], f_indices[itx]),
+                                     ki_cutoff[itx]);
+
+        if(opt.get_argument_known("tolerance"))
+        {
+            const auto tolerance = opt.get_option<double>("tolerance");
+            Wbar.col(icol) = calc->get_average_rates(i_indices, f_indices, ki_onset, ki_cutoff, tolerance);
+        }
+        else
+        {
+            arma::mat ki(nki, ntx);
+
+            for(unsigned int itx = 0; itx < ntx; ++itx)
+                ki.col(itx) = arma::linspace(ki_onset[itx], ki_cutoff[itx], nki);
+
+            const auto Wif = calc->get_rate_tables(i_indices, f_indices, ki);
+
+            for(unsigned int itx = 0; itx < ntx; ++itx)
+            {
+                const arma::vec ki_tx  = ki.col(itx);
+                const arma::vec Wif_tx = Wif.col(itx);
+                const IntersubbandTransition tx(subbands[i_indices[itx]],
+                                                subbands[f_indices[itx]],
+                                                ki_tx,
+                                                Wif_tx);
+
+                Wbar(itx, icol) = tx.get_average_rate();
+            }
+        }
+    }
+
+    // Write the whole matrix in one pass
+    std::ofstream stream(opt.get_option<std::string>("outfile"));
+
+    if(!stream.is_open())
+    {
+        std::cerr << "Cannot open output file: " << opt.get_option<std::string>("outfile") << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    stream << std::scientific << std::setprecision(12);
+
+    for(unsigned int itx = 0; itx < ntx; ++itx)
+    {
+        // Note that subbands are indexed from 1 in the output file
+        stream << i_indices[itx] + 1 << "\t" << f_indices[itx] + 1;
+
+        for(unsigned int icol = 0; icol < ncol; ++icol)
+            stream << "\t" << Wbar(itx, icol);
+
+        stream << "\t" << arma::accu(Wbar.row(itx)) << std::endl;
+    }
+
+    if(opt.get_verbose())
+    {
+        std::cout << "Columns: i f";
+
+        for(const auto &column : columns)
+            std::cout << " " << column.name;
+
+        std::cout << " total" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
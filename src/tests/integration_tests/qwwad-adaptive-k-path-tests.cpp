@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include "qwwad/adaptive-k-path.h"
+
+using namespace QWWAD;
+
+static const double inf = std::numeric_limits<double>::infinity();
+
+/// Create a list of one-dimensional wave vectors
+static std::vector<arma::vec> make_path(const arma::vec &k_list)
+{
+    std::vector<arma::vec> k;
+
+    for(unsigned int ik = 0; ik < k_list.size(); ++ik)
+        k.push_back(k_list(ik)*arma::ones(1));
+
+    return k;
+}
+
+/**
+ * Two bands with an avoided crossing at k = 0,
+ *   H = [k δ; δ -k]
+ */
+static void solve_anticrossing(const arma::vec &k,
+                               arma::vec       &E,
+                               arma::cx_mat    &X,
+                               double          &E_below,
+                               double          &E_above)
+{
+    const double delta = 0.1;
+
+    arma::mat H(2,2);
+    H(0,0) =  k(0);
+    H(1,1) = -k(0);
+    H(0,1) = delta;
+    H(1,0) = delta;
+
+    arma::mat X_real;
+    arma::eig_sym(E, X_real, H);
+    X = arma::cx_mat(X_real, arma::zeros(2,2));
+
+    E_below = -inf;
+    E_above =  inf;
+}
+
+/**
+ * A band with linear dispersion below a pair of degenerate bands.  The
+ * solver returns the lowest two bands only, so the degenerate set is cut.
+ * The returned band from the degenerate set is an arbitrary mixture that
+ * changes rapidly along the path.
+ */
+static void solve_cut_degenerate(const arma::vec &k,
+                                 arma::vec       &E,
+                                 arma::cx_mat    &X,
+                                 double          &E_below,
+                                 double          &E_above,
+                                 const bool       report_cut)
+{
+    const double theta = 10.0*k(0); // Mixing angle within degenerate set
+
+    E.set_size(2);
+    E(0) = 0.01*k(0);
+    E(1) = 0.1;
+
+    X = arma::zeros<arma::cx_mat>(3,2);
+    X(0,0) = 1.0;
+    X(1,1) = cos(theta);
+    X(2,1) = sin(theta);
+
+    E_below = -inf;
+    E_above = report_cut ? 0.1 : inf;
+}
+
+TEST(AdaptiveKPath, refinesNearAnticrossing)
+{
+    AdaptiveKPath path(make_path(arma::linspace(-1, 1, 3)), solve_anticrossing);
+    path.set_energy_tolerance(1e-3);
+    path.refine();
+
+    ASSERT_GT(path.get_n_points(), 3);
+
+    // Points are in order along the path
+    for(unsigned int ip = 1; ip < path.get_n_points(); ++ip)
+        EXPECT_GT(path.get_s(ip), path.get_s(ip-1));
+
+    // The spacing is finest around the anticrossing
+    double min_spacing_centre = inf;
+    double min_spacing_edge   = inf;
+
+    for(unsigned int ip = 1; ip < path.get_n_points(); ++ip)
+    {
+        const double k_mid = 0.5*(path.get_k(ip)(0) + path.get_k(ip-1)(0));
+        const double dk    = path.get_k(ip)(0) - path.get_k(ip-1)(0);
+
+        if(std::abs(k_mid) < 0.2)
+            min_spacing_centre = std::min(min_spacing_centre, dk);
+        else if(std::abs(k_mid) > 0.5)
+            min_spacing_edge = std::min(min_spacing_edge, dk);
+    }
+
+    EXPECT_LT(min_spacing_centre, min_spacing_edge);
+}
+
+TEST(AdaptiveKPath, maxPointsKeepsLargestErrors)
+{
+    // The anticrossing is near the end of the path, so the intervals with
+    // the largest errors come last
+    AdaptiveKPath path(make_path(arma::linspace(-3, 1, 5)), solve_anticrossing);
+    path.set_energy_tolerance(1e-5);
+
+    // Allow all of the first level of refinement, and four more points
+    path.set_max_points(13);
+    path.refine();
+
+    ASSERT_EQ(13, path.get_n_points());
+
+    // Only the coarse points and first-level midpoints lie far from the
+    // anticrossing: k = -3, -2.5, -2, -1.5
+    unsigned int n_far = 0;
+
+    for(unsigned int ip = 0; ip < path.get_n_points(); ++ip)
+    {
+        if(path.get_k(ip)(0) < -1.0 - 1e-12)
+            ++n_far;
+    }
+
+    EXPECT_EQ(4, n_far);
+}
+
+TEST(AdaptiveKPath, cutDegenerateSetDoesNotCauseRefinement)
+{
+    const auto k = make_path(arma::linspace(0, 1, 2));
+
+    // If the solver does not report the cut, the arbitrary mixing looks
+    // like a change in the band
+    AdaptiveKPath path_uncut(k, [](const arma::vec &kp, arma::vec &E, arma::cx_mat &X,
+                                   double &E_below, double &E_above)
+                                {solve_cut_degenerate(kp, E, X, E_below, E_above, false);});
+    path_uncut.refine();
+    EXPECT_GT(path_uncut.get_n_points(), 3);
+
+    AdaptiveKPath path_cut(k, [](const arma::vec &kp, arma::vec &E, arma::cx_mat &X,
+                                 double &E_below, double &E_above)
+                              {solve_cut_degenerate(kp, E, X, E_below, E_above, true);});
+    path_cut.refine();
+    EXPECT_EQ(3, path_cut.get_n_points());
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "qwwad/carrier-carrier-form-factors.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Create the lowest few states of an infinite well
+ */
+static std::vector<Subband> make_subbands(const unsigned int nst)
+{
+    const double    L = 20e-9;
+    const arma::vec z = arma::linspace(0, L, 201);
+
+    std::vector<Subband> subbands;
+
+    for(unsigned int ist = 0; ist < nst; ++ist)
+    {
+        const arma::vec psi = sqrt(2.0/L)*arma::sin((ist+1)*pi*z/L);
+        subbands.push_back(Subband(Eigenstate(ist*50e-3*e, z, psi), 0.067*me));
+        subbands[ist].set_distribution_from_Ef_Te(0.0, 77);
+    }
+
+    return subbands;
+}
+
+TEST(CarrierCarrierFormFactors, exchangePartnerReusesTable)
+{
+    const auto subbands = make_subbands(3);
+    CarrierCarrierFormFactors ff(subbands, arma::linspace(0, 5e8, 51), 77);
+
+    // The transition 32→12 and its partner 23→21 share a matrix element
+    const arma::vec A_3212 = ff.get_A_table(2, 1, 0, 1);
+    EXPECT_EQ(0, ff.get_n_A_hits());
+    EXPECT_EQ(1, ff.get_n_A_misses());
+
+    const arma::vec A_2321 = ff.get_A_table(1, 2, 1, 0);
+    EXPECT_EQ(1, ff.get_n_A_hits());
+    EXPECT_EQ(1, ff.get_n_A_misses());
+
+    for(unsigned int iq = 0; iq < A_3212.size(); ++iq)
+        EXPECT_DOUBLE_EQ(A_3212[iq], A_2321[iq]);
+
+    // Swapping the initial and final states within each pair is the same too
+    ff.get_A_table(0, 1, 2, 1);
+    EXPECT_EQ(2, ff.get_n_A_hits());
+    EXPECT_EQ(1, ff.get_n_A_misses());
+
+    // ...but a different pair of subbands needs a new table
+    ff.get_A_table(0, 0, 1, 1);
+    EXPECT_EQ(2, ff.get_n_A_hits());
+    EXPECT_EQ(2, ff.get_n_A_misses());
+}
+
+TEST(CarrierCarrierFormFactors, IjgMatchesDirectSum)
+{
+    const auto subbands = make_subbands(2);
+    const auto z  = subbands[0].z_array();
+    const auto dz = z[1] - z[0];
+    const arma::vec psi_jg = subbands[0].psi_array() % subbands[1].psi_array();
+
+    for(const double q : {0.0, 1e8, 5e8})
+    {
+        const arma::vec Ijg = CarrierCarrierFormFactors::find_Ijg(q, psi_jg, z);
+
+        for(unsigned int iz0 = 0; iz0 < z.size(); iz0 += 20)
+        {
+            const arma::vec integrand = psi_jg % arma::exp(-q*arma::abs(z - z[iz0]));
+            const double Ijg_direct = arma::accu(integrand)*dz;
+            EXPECT_NEAR(Ijg_direct, Ijg[iz0], 1e-10*arma::abs(psi_jg).max()*z[z.size()-1]);
+        }
+    }
+}
+
+TEST(CarrierCarrierFormFactors, matrixElementAtZeroScatteringVector)
+{
+    const auto subbands = make_subbands(2);
+    CarrierCarrierFormFactors ff(subbands, arma::linspace(0, 5e8, 51), 77);
+
+    // At q = 0, A_ijfg is the product of the overlaps ∫ψ_i ψ_f dz ∫ψ_j ψ_g dz
+    EXPECT_NEAR(1.0, ff.get_A_table(0, 1, 0, 1)[0], 1e-2);
+    EXPECT_NEAR(0.0, ff.get_A_table(0, 0, 1, 0)[0], 1e-2);
+
+    // The matrix element falls off at large scattering vectors
+    const auto &A = ff.get_A_table(0, 0, 0, 0);
+    EXPECT_LT(A[A.size()-1], A[0]);
+}
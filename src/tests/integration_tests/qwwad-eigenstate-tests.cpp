@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "qwwad/eigenstate.h"
+#include "qwwad/schroedinger-solver-infinite-well.h"
+#include "qwwad/constants.h"
+#include "qwwad/maths-helpers.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+static const double L   = 20e-9; // Well width [m]
+static const size_t nst = 4;     // Number of states
+
+static std::vector<Eigenstate> make_states()
+{
+    SchroedingerSolverInfWell se(0.067*me, L, 201, 0, 0, nst);
+    return se.get_solutions();
+}
+
+TEST(Eigenstate, overlapMatrixIsIdentity)
+{
+    const auto states = make_states();
+    const arma::mat S = Eigenstate::get_overlap_matrix(states);
+
+    ASSERT_EQ(nst, S.n_rows);
+    ASSERT_EQ(nst, S.n_cols);
+
+    for(unsigned int i = 0; i < nst; ++i)
+        for(unsigned int j = 0; j < nst; ++j)
+            EXPECT_NEAR((i == j) ? 1.0 : 0.0, S(i,j), 1e-8);
+}
+
+TEST(Eigenstate, positionMatrixMatchesPairwiseElements)
+{
+    const auto states = make_states();
+    const arma::mat Z = Eigenstate::get_position_matrix(states);
+
+    for(unsigned int i = 0; i < nst; ++i)
+    {
+        EXPECT_NEAR(states[i].get_expectation_position(), Z(i,i), 1e-12*L);
+
+        for(unsigned int j = 0; j < nst; ++j)
+        {
+            if(i != j)
+                EXPECT_NEAR(Eigenstate::get_position_matrix_element(states[i], states[j]), Z(i,j), 1e-12*L);
+        }
+    }
+}
+
+TEST(Eigenstate, positionSquaredMatrixMatchesDirectIntegral)
+{
+    const auto states = make_states();
+    const arma::mat Z2 = Eigenstate::get_position_squared_matrix(states);
+    const auto z  = states[0].get_position_samples();
+    const auto dz = z[1] - z[0];
+
+    for(unsigned int i = 0; i < nst; ++i)
+    {
+        for(unsigned int j = 0; j < nst; ++j)
+        {
+            const arma::vec integrand = states[i].get_wavefunction_samples() % z % z %
+                                        states[j].get_wavefunction_samples();
+            EXPECT_NEAR(integral(integrand, dz), Z2(i,j), 1e-12*L*L);
+        }
+    }
+}
+
+TEST(Eigenstate, momentumMatrixMatchesPairwiseDerivative)
+{
+    const auto states = make_states();
+    const arma::mat D = Eigenstate::get_momentum_matrix(states);
+    const auto z  = states[0].get_position_samples();
+    const auto dz = z[1] - z[0];
+    const auto nz = z.size();
+
+    for(unsigned int i = 0; i < nst; ++i)
+    {
+        const auto psi_i = states[i].get_wavefunction_samples();
+
+        for(unsigned int j = 0; j < nst; ++j)
+        {
+            // Central-difference derivative, with zero at each end
+            const auto psi_j = states[j].get_wavefunction_samples();
+            arma::vec d_psi_j(nz, arma::fill::zeros);
+
+            for(unsigned int iz = 1; iz < nz-1; ++iz)
+                d_psi_j[iz] = (psi_j[iz+1] - psi_j[iz-1])/(2*dz);
+
+            const arma::vec integrand = psi_i % d_psi_j;
+            EXPECT_NEAR(integral(integrand, dz), D(i,j), 1e-10/L);
+
+            // Analytical result for an infinite well is 4ij/(L(i²-j²)) if
+            // i+j is odd, and zero otherwise (with states counted from 1)
+            const double n_i = i + 1;
+            const double n_j = j + 1;
+            const double D_exact = ((i + j) % 2 == 1) ? 4*n_i*n_j/(L*(n_i*n_i - n_j*n_j)) : 0.0;
+            EXPECT_NEAR(std::abs(D_exact), std::abs(D(i,j)), 1e-3/L);
+        }
+    }
+
+    // The derivative operator is antisymmetric for states that vanish at the
+    // edges of the grid
+    EXPECT_LT(arma::abs(D + D.t()).max(), 1e-3/L);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "qwwad/ensemble-monte-carlo.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Create a pair of degenerate subbands, so that elastic scattering between
+ * them is allowed at any energy, with constant rates in each direction
+ */
+static EnsembleMonteCarlo make_two_subband_system(const double W_01,
+                                                  const double W_10)
+{
+    const arma::vec z   = arma::linspace(0, 10e-9, 3);
+    const arma::vec psi = arma::ones(3);
+    const double    m   = 0.067*me;
+
+    std::vector<Subband> subbands;
+    subbands.push_back(Subband(Eigenstate(0.0, z, psi), m));
+    subbands.push_back(Subband(Eigenstate(0.0, z, psi), m));
+
+    const double Ek_max = 0.5*e;
+    EnsembleMonteCarlo emc(subbands, Ek_max, 101);
+
+    const arma::vec Ek = arma::linspace(0, Ek_max, 2);
+    emc.add_rate_table(0, 1, 0.0, Ek, W_01*arma::ones(2));
+    emc.add_rate_table(1, 0, 0.0, Ek, W_10*arma::ones(2));
+    emc.set_initial_temperature(77);
+
+    return emc;
+}
+
+TEST(EnsembleMonteCarlo, twoSubbandPopulationRatio)
+{
+    const double W_01 = 3e12;
+    const double W_10 = 1e12;
+    const auto   emc  = make_two_subband_system(W_01, W_10);
+
+    arma::vec pop0(2);
+    pop0[0] = 1.0;
+    pop0[1] = 0.0;
+
+    // Run for many scattering times, so that the steady state is reached
+    const auto result = emc.run(pop0, 4000, 20e-12, 200, 1234);
+
+    ASSERT_EQ(2, result.population.size());
+    EXPECT_NEAR(1.0, arma::accu(result.population), 1e-12);
+    EXPECT_NEAR(W_10/(W_01 + W_10), result.population[0], 0.03);
+    EXPECT_NEAR(W_01/(W_01 + W_10), result.population[1], 0.03);
+
+    // Both directions should have been used many times
+    EXPECT_GT(result.n_scatter[0], 1000);
+    EXPECT_GT(result.n_scatter[1], 1000);
+
+    // No field is applied, so there's no drift
+    EXPECT_NEAR(0.0, result.v_drift_total, 1e4);
+
+    // Elastic scattering between identical subbands conserves kinetic
+    // energy, so the mean stays at the thermal value
+    EXPECT_NEAR(kB*77, result.Ek_mean, 0.05*kB*77);
+}
+
+TEST(EnsembleMonteCarlo, sameSeedGivesSameResult)
+{
+    const auto emc = make_two_subband_system(3e12, 1e12);
+
+    arma::vec pop0(2);
+    pop0[0] = 1.0;
+    pop0[1] = 1.0;
+
+    const auto result1 = emc.run(pop0, 600, 5e-12, 50, 42);
+    const auto result2 = emc.run(pop0, 600, 5e-12, 50, 42);
+
+    EXPECT_DOUBLE_EQ(result1.population[0], result2.population[0]);
+    EXPECT_DOUBLE_EQ(result1.Ek_mean,       result2.Ek_mean);
+    EXPECT_DOUBLE_EQ(result1.v_drift_total, result2.v_drift_total);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "qwwad/fermi.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Find the Fermi energy by plain bisection on the total population, as a
+ * reference for the Newton solver
+ */
+static double find_fermi_bisection(const arma::vec &Esb,
+                                   const double     m0,
+                                   const double     N,
+                                   const double     Te,
+                                   const double     alpha)
+{
+    double E_lo = Esb.min() - 1.0*e;
+    double E_hi = Esb.max() + 1.0*e;
+
+    for(unsigned int iter = 0; iter < 200; ++iter)
+    {
+        const double E_F = 0.5*(E_lo + E_hi);
+        double N_total = 0.0;
+
+        for(unsigned int ist = 0; ist < Esb.size(); ++ist)
+            N_total += find_pop(Esb[ist], E_F, m0, Te, alpha);
+
+        if(N_total > N)
+            E_hi = E_F;
+        else
+            E_lo = E_F;
+    }
+
+    return 0.5*(E_lo + E_hi);
+}
+
+static arma::vec make_subbands()
+{
+    arma::vec Esb(3);
+    Esb[0] = 20e-3*e;
+    Esb[1] = 35e-3*e;
+    Esb[2] = 90e-3*e;
+    return Esb;
+}
+
+TEST(Fermi, singleSubbandMatchesAnalyticalResult)
+{
+    const double m0  = 0.067*me;
+    const double N   = 1e15;
+    const double Te  = 77;
+    const double Esb = 20e-3*e;
+
+    arma::vec Esb_array(1);
+    Esb_array[0] = Esb;
+
+    EXPECT_NEAR(find_fermi(Esb, m0, N, Te),
+                find_fermi_global(Esb_array, m0, N, Te), 1e-8*e);
+}
+
+TEST(Fermi, newtonMatchesBisectionParabolic)
+{
+    const double m0  = 0.067*me;
+    const auto   Esb = make_subbands();
+
+    // Nondegenerate to strongly degenerate cases
+    const double N_list[]  = {1e12, 1e15, 3e16};
+    const double Te_list[] = {4, 77, 300};
+
+    for(const auto N : N_list)
+    {
+        for(const auto Te : Te_list)
+        {
+            const double E_F_newton    = find_fermi_global(Esb, m0, N, Te);
+            const double E_F_bisection = find_fermi_bisection(Esb, m0, N, Te, 0.0);
+            EXPECT_NEAR(E_F_bisection, E_F_newton, 1e-8*e) << "N = " << N << ", Te = " << Te;
+        }
+    }
+}
+
+TEST(Fermi, newtonMatchesBisectionNonparabolic)
+{
+    const double m0    = 0.067*me;
+    const double alpha = 0.7/e;
+    const auto   Esb   = make_subbands();
+
+    const double N_list[]  = {1e14, 3e16};
+    const double Te_list[] = {77, 300};
+
+    for(const auto N : N_list)
+    {
+        for(const auto Te : Te_list)
+        {
+            const double E_F_newton    = find_fermi_global(Esb, m0, N, Te, alpha);
+            const double E_F_bisection = find_fermi_bisection(Esb, m0, N, Te, alpha);
+            EXPECT_NEAR(E_F_bisection, E_F_newton, 1e-8*e) << "N = " << N << ", Te = " << Te;
+        }
+    }
+}
+
+TEST(Fermi, populationDerivativeMatchesFiniteDifference)
+{
+    const double m0    = 0.067*me;
+    const double Te    = 77;
+    const double Esb   = 20e-3*e;
+    const double alpha = 0.7/e;
+    const double h     = 1e-6*e;
+
+    for(const auto E_F : {0.0, 20e-3*e, 50e-3*e})
+    {
+        const double dN_dEF = (find_pop(Esb, E_F + h, m0, Te, alpha) -
+                               find_pop(Esb, E_F - h, m0, Te, alpha))/(2*h);
+
+        EXPECT_NEAR(dN_dEF, find_pop_derivative(Esb, E_F, m0, Te, alpha), 1e-6*dN_dEF);
+    }
+}
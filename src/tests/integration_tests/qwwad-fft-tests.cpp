@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "qwwad/fft.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Find the forward transform of a 3D grid by summing the series directly
+ */
+static arma::cx_vec naive_dft(const arma::cx_vec &data,
+                              const size_t        n1,
+                              const size_t        n2,
+                              const size_t        n3)
+{
+    arma::cx_vec result = arma::zeros<arma::cx_vec>(data.size());
+
+    for(unsigned int q3 = 0; q3 < n3; ++q3)
+    for(unsigned int q2 = 0; q2 < n2; ++q2)
+    for(unsigned int q1 = 0; q1 < n1; ++q1)
+    {
+        std::complex<double> sum = 0.0;
+
+        for(unsigned int x3 = 0; x3 < n3; ++x3)
+        for(unsigned int x2 = 0; x2 < n2; ++x2)
+        for(unsigned int x1 = 0; x1 < n1; ++x1)
+        {
+            const double phase = -2.0*pi*(double(q1*x1)/n1 + double(q2*x2)/n2 + double(q3*x3)/n3);
+            sum += data(x1 + n1*(x2 + n2*x3)) * std::polar(1.0, phase);
+        }
+
+        result(q1 + n1*(q2 + n2*q3)) = sum;
+    }
+
+    return result;
+}
+
+/**
+ * Create a reproducible set of test data, with no special symmetry
+ */
+static arma::cx_vec make_data(const size_t n)
+{
+    arma::cx_vec data(n);
+
+    for(unsigned int i = 0; i < n; ++i)
+        data(i) = std::complex<double>(sin(0.7*i + 0.3), cos(1.3*i*i + 0.1));
+
+    return data;
+}
+
+static void check_against_naive_dft(const size_t n1,
+                                    const size_t n2,
+                                    const size_t n3)
+{
+    const FFT3D fft(n1, n2, n3);
+    ASSERT_EQ(n1*n2*n3, fft.get_n_total());
+
+    const arma::cx_vec data     = make_data(n1*n2*n3);
+    const arma::cx_vec expected = naive_dft(data, n1, n2, n3);
+
+    arma::cx_vec result = data;
+    fft.forward(result);
+
+    for(unsigned int i = 0; i < data.size(); ++i)
+    {
+        EXPECT_NEAR(expected(i).real(), result(i).real(), 1e-10*data.size());
+        EXPECT_NEAR(expected(i).imag(), result(i).imag(), 1e-10*data.size());
+    }
+}
+
+TEST(FFT3D, powerOfTwoMatchesNaiveDFT)
+{
+    check_against_naive_dft(8, 4, 2);
+}
+
+TEST(FFT3D, mixedRadixMatchesNaiveDFT)
+{
+    check_against_naive_dft(6, 10, 9);
+}
+
+TEST(FFT3D, primeSizesMatchNaiveDFT)
+{
+    check_against_naive_dft(7, 11, 1);
+}
+
+TEST(FFT3D, forwardThenBackwardScalesByGridSize)
+{
+    const size_t n1 = 12;
+    const size_t n2 = 5;
+    const size_t n3 = 6;
+    const FFT3D fft(n1, n2, n3);
+
+    const arma::cx_vec data = make_data(n1*n2*n3);
+    arma::cx_vec round_trip = data;
+    fft.forward(round_trip);
+    fft.backward(round_trip);
+    round_trip /= double(n1*n2*n3);
+
+    for(unsigned int i = 0; i < data.size(); ++i)
+    {
+        EXPECT_NEAR(data(i).real(), round_trip(i).real(), 1e-12);
+        EXPECT_NEAR(data(i).imag(), round_trip(i).imag(), 1e-12);
+    }
+}
+
+TEST(FFT3D, goodSizesHaveSmallFactors)
+{
+    EXPECT_EQ(1,  FFT3D::get_good_size(0));
+    EXPECT_EQ(1,  FFT3D::get_good_size(1));
+    EXPECT_EQ(8,  FFT3D::get_good_size(7));
+    EXPECT_EQ(12, FFT3D::get_good_size(11));
+    EXPECT_EQ(15, FFT3D::get_good_size(13));
+    EXPECT_EQ(16, FFT3D::get_good_size(16));
+    EXPECT_EQ(54, FFT3D::get_good_size(53));
+}
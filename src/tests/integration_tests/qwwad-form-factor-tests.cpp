@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "qwwad/form-factor.h"
+#include "qwwad/constants.h"
+#include "qwwad/maths-helpers.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Check that the phasor recurrence matches direct integration of
+ * psi_i psi_f exp(iKz z) at every wave-vector, including those well past
+ * the first resynchronisation of the phasors
+ */
+static void check_against_direct_integral(const size_t nz)
+{
+    const double L   = 20e-9;
+    const arma::vec z = arma::linspace(0, L, nz);
+    const double dz  = z[1] - z[0];
+
+    // Ground and first excited states of an infinite well
+    const arma::vec psi_i = sqrt(2.0/L) * arma::sin(pi*z/L);
+    const arma::vec psi_f = sqrt(2.0/L) * arma::sin(2.0*pi*z/L);
+
+    const arma::vec Kz = arma::linspace(0, 4e9, 500);
+    const arma::vec Gsqr = find_Gsqr_table(z, psi_i, psi_f, Kz);
+
+    ASSERT_EQ(Kz.size(), Gsqr.size());
+
+    for(unsigned int iKz = 0; iKz < Kz.size(); ++iKz)
+    {
+        arma::cx_vec integrand(nz);
+
+        for(unsigned int iz = 0; iz < nz; ++iz)
+            integrand[iz] = psi_i[iz]*psi_f[iz]*std::polar(1.0, Kz[iKz]*z[iz]);
+
+        const double Gsqr_expected = std::norm(integral(integrand, dz));
+        EXPECT_NEAR(Gsqr_expected, Gsqr[iKz], 1e-10);
+    }
+}
+
+TEST(FormFactor, simpsonMatchesDirectIntegral)
+{
+    check_against_direct_integral(401);
+}
+
+TEST(FormFactor, trapeziumMatchesDirectIntegral)
+{
+    check_against_direct_integral(400);
+}
+
+TEST(FormFactor, orthogonalStatesAtZeroWaveVector)
+{
+    const double L   = 20e-9;
+    const arma::vec z = arma::linspace(0, L, 1001);
+    const arma::vec psi_i = sqrt(2.0/L) * arma::sin(pi*z/L);
+    const arma::vec psi_f = sqrt(2.0/L) * arma::sin(2.0*pi*z/L);
+
+    const arma::vec Kz = arma::zeros(1);
+
+    // Diagonal form factor is the normalisation of the state
+    EXPECT_NEAR(1.0, find_Gsqr_table(z, psi_i, psi_i, Kz)[0], 1e-10);
+
+    // Orthogonal states have no overlap at Kz = 0
+    EXPECT_NEAR(0.0, find_Gsqr_table(z, psi_i, psi_f, Kz)[0], 1e-10);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "qwwad/gain-spectrum.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Create a pair of parabolic subbands with the same mass, separated by
+ * 100 meV, with most of the carriers in the lower one
+ */
+static std::vector<Subband> make_two_subbands()
+{
+    const arma::vec z   = arma::linspace(0, 10e-9, 3);
+    const arma::vec psi = arma::ones(3);
+    const double    m   = 0.067*me;
+    const double    Te  = 77;
+
+    std::vector<Subband> subbands;
+    subbands.push_back(Subband(Eigenstate(0.0,      z, psi), m));
+    subbands.push_back(Subband(Eigenstate(100e-3*e, z, psi), m));
+    subbands[0].set_distribution_from_Ef_Te(20e-3*e, Te);
+    subbands[1].set_distribution_from_Ef_Te(60e-3*e, Te);
+
+    return subbands;
+}
+
+static arma::mat make_dipole_matrix()
+{
+    arma::mat z_ij = arma::zeros(2,2);
+    z_ij(0,1) = 2e-9;
+    z_ij(1,0) = 2e-9;
+    return z_ij;
+}
+
+TEST(GainSpectrum, lorentzianPeakAtTransitionEnergy)
+{
+    const auto   subbands = make_two_subbands();
+    const auto   z_ij     = make_dipole_matrix();
+    const double n_r      = 3.3;
+    const double L        = 50e-9;
+    const double Gamma    = 5e-3*e;
+
+    GainSpectrum gain(subbands, z_ij, n_r, L);
+    gain.set_linewidth(Gamma);
+
+    ASSERT_EQ(1, gain.get_n_transitions());
+
+    arma::vec E(1);
+    E[0] = 100e-3*e;
+    const double g = gain.get_gain(E)[0];
+
+    // Peak of a unit-area Lorentzian is 1/(π γ), where γ is the half-width
+    const double dN    = subbands[1].get_total_population() - subbands[0].get_total_population();
+    const double omega = E[0]/hBar;
+    const double g_expected = pi*e*e*omega/(eps0*n_r*c*L) * z_ij(1,0)*z_ij(1,0) * dN / (pi*Gamma/2);
+
+    // Lower subband is fuller, so this is absorption
+    EXPECT_LT(g, 0.0);
+    EXPECT_NEAR(g_expected, g, 1e-10*std::abs(g_expected));
+
+    // The single-transition spectrum is the same as the total
+    EXPECT_NEAR(g, gain.get_gain(E, 0, 1)[0], 1e-10*std::abs(g));
+}
+
+TEST(GainSpectrum, dispersionMatchesSingleLineForEqualMasses)
+{
+    const auto subbands = make_two_subbands();
+    const auto z_ij     = make_dipole_matrix();
+
+    GainSpectrum gain(subbands, z_ij, 3.3, 50e-9);
+    gain.set_linewidth(5e-3*e);
+
+    const arma::vec E = arma::linspace(80e-3*e, 120e-3*e, 41);
+    const arma::vec g_line = gain.get_gain(E);
+
+    // All vertical transitions have the same energy when the masses are
+    // equal, so summing over wave-vector only changes the population
+    // difference by the quadrature error
+    gain.enable_dispersion(true);
+    gain.set_k_samples(2001);
+    const arma::vec g_disp = gain.get_gain(E);
+
+    for(unsigned int iE = 0; iE < E.size(); ++iE)
+        EXPECT_NEAR(g_line[iE], g_disp[iE], 1e-2*std::abs(g_line[iE]));
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "qwwad/maths-helpers.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+TEST(MathsHelpers, adaptiveIntegralOfSmoothFunction)
+{
+    arma::vec breakpoints(2);
+    breakpoints(0) = 0.0;
+    breakpoints(1) = pi;
+
+    bool converged = false;
+    const double I = integral_adaptive([](const double x) {return sin(x);},
+                                       breakpoints, 1e-10, 30, 100000, &converged);
+
+    EXPECT_TRUE(converged);
+    EXPECT_NEAR(2.0, I, 1e-9);
+}
+
+TEST(MathsHelpers, adaptiveIntegralUsesBreakpoints)
+{
+    // A kink at x = 1/3 is handled exactly if it is given as a breakpoint
+    const auto kink = [](const double x) {return fabs(x - 1.0/3.0);};
+
+    arma::vec breakpoints(3);
+    breakpoints(0) = 0.0;
+    breakpoints(1) = 1.0/3.0;
+    breakpoints(2) = 1.0;
+
+    bool converged = false;
+    const double I = integral_adaptive(kink, breakpoints, 1e-12, 30, 100000, &converged);
+
+    EXPECT_TRUE(converged);
+    EXPECT_NEAR(5.0/18.0, I, 1e-12);
+}
+
+TEST(MathsHelpers, adaptiveIntegralStopsAtEvaluationLimit)
+{
+    // The singularity at x = 0 can never be resolved to this tolerance
+    size_t n_evals = 0;
+    const auto f = [&n_evals](const double x) {++n_evals; return (x > 0.0) ? 1.0/sqrt(x) : 0.0;};
+
+    arma::vec breakpoints(2);
+    breakpoints(0) = 0.0;
+    breakpoints(1) = 1.0;
+
+    const size_t max_evals = 1000;
+    bool converged = true;
+    const double I = integral_adaptive(f, breakpoints, 1e-15, 60, max_evals, &converged);
+
+    EXPECT_FALSE(converged);
+
+    // Initial sampling uses 17 points in the single interval
+    EXPECT_LE(n_evals, 17 + max_evals);
+
+    // The estimate is still sensible
+    EXPECT_NEAR(2.0, I, 0.1);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "qwwad/poisson-solver-2d.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Find the largest error in the potential for a sinusoidal charge density
+ * in a box with zero potential at every edge.  The exact solution is
+ *   φ = sin(πx/Lx) sin(πy/Ly)
+ */
+static double find_sine_error(const unsigned int n)
+{
+    const double Lx  = 40e-9;
+    const double Ly  = 20e-9;
+    const double dx  = Lx/n;
+    const double dy  = Ly/n;
+    const double eps = 13.18*eps0;
+
+    PoissonSolver2D poisson(eps*arma::ones(n,n), dx, dy);
+
+    for(const auto edge : {EDGE_X_MIN, EDGE_X_MAX, EDGE_Y_MIN, EDGE_Y_MAX})
+        poisson.set_dirichlet(edge, 0.0);
+
+    poisson.set_tolerance(1e-12);
+
+    arma::mat rho(n,n);
+    arma::mat phi_exact(n,n);
+
+    for(unsigned int j = 0; j < n; ++j)
+    {
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            const double x = (i + 0.5)*dx;
+            const double y = (j + 0.5)*dy;
+            phi_exact(i,j) = sin(pi*x/Lx)*sin(pi*y/Ly);
+            rho(i,j)       = eps*pi*pi*(1.0/(Lx*Lx) + 1.0/(Ly*Ly))*phi_exact(i,j);
+        }
+    }
+
+    const arma::mat phi = poisson.solve(rho);
+
+    return arma::abs(phi - phi_exact).max();
+}
+
+TEST(PoissonSolver2D, sineChargeMatchesAnalyticalSolution)
+{
+    const double err_coarse = find_sine_error(32);
+    const double err_fine   = find_sine_error(64);
+
+    EXPECT_LT(err_fine, 1e-3);
+
+    // The discretisation is second-order accurate
+    EXPECT_GT(err_coarse/err_fine, 3.0);
+}
+
+TEST(PoissonSolver2D, seriesDielectricsGivePiecewiseLinearPotential)
+{
+    const unsigned int nx   = 40;
+    const unsigned int ny   = 8;
+    const double       dx   = 1e-9;
+    const double       eps1 = 13.18*eps0;
+    const double       eps2 = 10.0*eps0;
+    const double       V    = 0.5;
+
+    // Two layers, with the interface half way along x
+    arma::mat eps(nx, ny);
+    eps.rows(0, nx/2-1).fill(eps1);
+    eps.rows(nx/2, nx-1).fill(eps2);
+
+    // Potential is fixed at each end in x, and there is no field through the
+    // edges in y
+    PoissonSolver2D poisson(eps, dx, dx);
+    poisson.set_dirichlet(EDGE_X_MIN, 0.0);
+    poisson.set_dirichlet(EDGE_X_MAX, V);
+    poisson.set_tolerance(1e-12);
+
+    const arma::mat phi = poisson.solve(arma::zeros(nx, ny));
+
+    // The displacement field is the same in both layers
+    const double L1 = nx/2*dx;
+    const double L2 = nx*dx - L1;
+    const double D  = V/(L1/eps1 + L2/eps2);
+
+    for(unsigned int j = 0; j < ny; ++j)
+    {
+        for(unsigned int i = 0; i < nx; ++i)
+        {
+            const double x = (i + 0.5)*dx;
+            const double phi_exact = (x < L1) ? D*x/eps1 : D*(L1/eps1 + (x - L1)/eps2);
+            EXPECT_NEAR(phi_exact, phi(i,j), 1e-9*V);
+        }
+    }
+}
+
+TEST(PoissonSolver2D, iterationsIndependentOfGridSize)
+{
+    // The multigrid preconditioner should keep the number of iterations
+    // roughly constant as the grid is refined
+    size_t n_iter_min = 1000;
+    size_t n_iter_max = 0;
+
+    for(const unsigned int n : {32u, 64u, 128u})
+    {
+        PoissonSolver2D poisson(13.18*eps0*arma::ones(n,n), 1e-9, 1e-9);
+        poisson.set_dirichlet(EDGE_X_MIN, 0.0);
+        poisson.solve(1e6*arma::ones(n,n));
+
+        n_iter_min = std::min(n_iter_min, poisson.get_iterations());
+        n_iter_max = std::max(n_iter_max, poisson.get_iterations());
+    }
+
+    EXPECT_LE(n_iter_max, 2*n_iter_min + 2);
+}
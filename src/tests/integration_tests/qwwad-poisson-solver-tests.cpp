@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "qwwad/poisson-solver.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * A charge density that varies linearly with the potential,
+ *   ρ(φ) = ρ₀ - cφ
+ */
+class LinearChargeModel : public ChargeModel
+{
+private:
+    arma::vec _rho0; ///< Charge density at zero potential [C m^{-3}]
+    double    _c;    ///< Rate of change of charge density with potential [C V^{-1} m^{-3}]
+
+public:
+    LinearChargeModel(const arma::vec &rho0,
+                      const double     c) :
+        _rho0(rho0),
+        _c(c)
+    {}
+
+    void get_charge_density(const arma::vec &phi,
+                            arma::vec       &rho,
+                            arma::vec       &drho_dphi) const
+    {
+        rho       = _rho0 - _c*phi;
+        drho_dphi = -_c*arma::ones(phi.size());
+    }
+
+    double get_potential_scale() const {return 0.025;}
+};
+
+static const size_t nz = 100;
+static const double dz = 1e-10;
+
+/// A permittivity profile with a step in the middle
+static arma::vec make_permittivity()
+{
+    arma::vec eps = 13.18*eps0*arma::ones(nz);
+    eps.subvec(nz/2, nz-1).fill(12.0*eps0);
+    return eps;
+}
+
+TEST(PoissonSolver, nonlinearMatchesLaplaceWithNoCharge)
+{
+    const double V_drop = 0.1;
+    const PoissonSolver poisson(make_permittivity(), dz, DIRICHLET);
+    const LinearChargeModel model(arma::zeros(nz), 0.0);
+
+    const arma::vec phi_linear    = poisson.solve_laplace(V_drop);
+    const arma::vec phi_nonlinear = poisson.solve_nonlinear(model, arma::zeros(nz), V_drop);
+
+    ASSERT_EQ(nz, phi_nonlinear.size());
+
+    for(unsigned int iz = 0; iz < nz; ++iz)
+        EXPECT_NEAR(phi_linear[iz], phi_nonlinear[iz], 1e-10);
+}
+
+TEST(PoissonSolver, nonlinearMatchesLinearWithFixedCharge)
+{
+    const double V_drop = 0.1;
+    const PoissonSolver poisson(make_permittivity(), dz, DIRICHLET);
+
+    const arma::vec rho = 1e6*arma::sin(arma::linspace(0, pi, nz));
+    const LinearChargeModel model(rho, 0.0);
+
+    const arma::vec phi_linear    = poisson.solve(rho, V_drop);
+    const arma::vec phi_nonlinear = poisson.solve_nonlinear(model, arma::zeros(nz), V_drop);
+
+    for(unsigned int iz = 0; iz < nz; ++iz)
+        EXPECT_NEAR(phi_linear[iz], phi_nonlinear[iz], 1e-8);
+}
+
+TEST(PoissonSolver, nonlinearIsFixedPointOfLinearSolution)
+{
+    const double V_drop = 0.1;
+    const PoissonSolver poisson(make_permittivity(), dz, DIRICHLET);
+
+    // Charge density responds to the potential, so the reference point
+    // enters the Jacobian
+    const arma::vec rho0 = 1e6*arma::ones(nz);
+    const LinearChargeModel model(rho0, 1e7);
+
+    const arma::vec phi = poisson.solve_nonlinear(model, arma::zeros(nz), V_drop);
+
+    arma::vec rho;
+    arma::vec drho_dphi;
+    model.get_charge_density(phi, rho, drho_dphi);
+    const arma::vec phi_linear = poisson.solve(rho, V_drop);
+
+    EXPECT_NEAR(0.0, phi[0], 1e-12);
+
+    for(unsigned int iz = 0; iz < nz; ++iz)
+        EXPECT_NEAR(phi_linear[iz], phi[iz], 1e-8);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "qwwad/pplb-functions.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+static const double A0 = 5.65e-10; // Lattice constant [m]
+
+/// Create a reciprocal lattice vector in units of 2 pi/A0
+static arma::vec make_G(const double x,
+                        const double y,
+                        const double z)
+{
+    arma::vec G(3);
+    G(0) = x;
+    G(1) = y;
+    G(2) = z;
+    return G*2.0*pi/A0;
+}
+
+TEST(PPLBFunctions, latticeIndicesForFCCVectors)
+{
+    std::vector<arma::vec> G;
+    G.push_back(make_G( 0,  0,  0));
+    G.push_back(make_G( 1,  1,  1));
+    G.push_back(make_G(-1,  1, -1));
+    G.push_back(make_G( 2,  0,  0));
+    G.push_back(make_G( 0, -2,  0));
+
+    arma::vec b;
+    const arma::imat m = find_lattice_indices(G, A0, b);
+
+    ASSERT_EQ(3, m.n_rows);
+    ASSERT_EQ(G.size(), m.n_cols);
+
+    for(unsigned int dim = 0; dim < 3; ++dim)
+    {
+        EXPECT_NEAR(2.0*pi/A0, b(dim), 1e-10*2.0*pi/A0);
+
+        for(unsigned int iG = 0; iG < G.size(); ++iG)
+            EXPECT_EQ(std::llround(G[iG](dim)*A0/(2.0*pi)), m(dim,iG));
+    }
+}
+
+TEST(PPLBFunctions, latticeIndicesForSupercell)
+{
+    // Vectors of a supercell that is doubled in x and tripled in z
+    std::vector<arma::vec> G;
+    G.push_back(make_G(0.5, 1, 0));
+    G.push_back(make_G(1,   0, 1.0/3.0));
+    G.push_back(make_G(0,   1, 2.0/3.0));
+
+    arma::vec b;
+    const arma::imat m = find_lattice_indices(G, A0, b);
+
+    EXPECT_NEAR(pi/A0,       b(0), 1e-10*pi/A0);
+    EXPECT_NEAR(2.0*pi/A0,   b(1), 1e-10*pi/A0);
+    EXPECT_NEAR(2.0*pi/3/A0, b(2), 1e-10*pi/A0);
+
+    EXPECT_EQ(1, m(0,0));
+    EXPECT_EQ(2, m(0,1));
+    EXPECT_EQ(1, m(2,1));
+    EXPECT_EQ(2, m(2,2));
+
+    // Every vector is recovered from its indices
+    for(unsigned int iG = 0; iG < G.size(); ++iG)
+        for(unsigned int dim = 0; dim < 3; ++dim)
+            EXPECT_NEAR(G[iG](dim), m(dim,iG)*b(dim), 1e-10*2.0*pi/A0);
+}
+
+TEST(PPLBFunctions, latticeIndicesRejectIncommensurateVectors)
+{
+    std::vector<arma::vec> G;
+    G.push_back(make_G(pi/10, 0, 0));
+
+    arma::vec b;
+    EXPECT_THROW(find_lattice_indices(G, A0, b), std::domain_error);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "qwwad/rate-equation-solver.h"
+
+using namespace QWWAD;
+
+TEST(RateEquationSolver, twoLevelSteadyState)
+{
+    const double W_01 = 1e12; // Downward rate from the upper subband [1/s]
+    const double W_10 = 3e11; // Upward rate from the lower subband [1/s]
+    const double N    = 1e15; // Total population [m^-2]
+
+    // Subband 1 lies below subband 0, so element (i,f) is the rate i→f
+    arma::mat W = arma::zeros(2,2);
+    W(0,1) = W_01;
+    W(1,0) = W_10;
+
+    const RateEquationSolver solver(W);
+    const auto n = solver.solve(N);
+
+    ASSERT_EQ(2, n.size());
+
+    // Detailed balance: n_0 W_01 = n_1 W_10
+    EXPECT_NEAR(N*W_10/(W_01 + W_10), n[0], 1e-10*N);
+    EXPECT_NEAR(N*W_01/(W_01 + W_10), n[1], 1e-10*N);
+
+    // Populations should not change in steady state
+    const auto dn_dt = solver.get_dn_dt(n);
+    EXPECT_NEAR(0.0, dn_dt[0], 1e-10*N*W_01);
+    EXPECT_NEAR(0.0, dn_dt[1], 1e-10*N*W_01);
+}
+
+TEST(RateEquationSolver, twoBodyProcessConservesPopulation)
+{
+    const double N = 1e15; // Total population [m^-2]
+
+    arma::mat W = arma::zeros(3,3);
+    W(2,1) = 5e11;
+    W(1,0) = 2e12;
+    W(0,2) = 1e11;
+    W(2,0) = 1e11;
+
+    RateEquationSolver solver(W);
+
+    // Auger-like process: two carriers in subband 1 scatter to subbands 0 and 2
+    solver.add_two_body_rate(1, 1, 0, 2, 1e-3);
+
+    const auto n = solver.solve(N);
+
+    ASSERT_EQ(3, n.size());
+    EXPECT_NEAR(N, arma::accu(n), 1e-10*N);
+
+    const auto dn_dt = solver.get_dn_dt(n);
+
+    for(unsigned int ist = 0; ist < n.size(); ++ist)
+    {
+        EXPECT_GE(n[ist], 0.0);
+        EXPECT_NEAR(0.0, dn_dt[ist], 1e-8*N*2e12);
+    }
+}
+
+TEST(RateEquationSolver, jacobianMatchesFiniteDifference)
+{
+    arma::mat W = arma::zeros(2,2);
+    W(0,1) = 1e12;
+    W(1,0) = 3e11;
+
+    RateEquationSolver solver(W);
+    solver.add_two_body_rate(0, 0, 1, 1, 1e-3);
+
+    arma::vec n(2);
+    n[0] = 4e14;
+    n[1] = 6e14;
+
+    const auto J  = solver.get_jacobian(n);
+    const double h = 1e8;
+
+    for(unsigned int j = 0; j < 2; ++j)
+    {
+        arma::vec n_plus  = n;
+        arma::vec n_minus = n;
+        n_plus[j]  += h;
+        n_minus[j] -= h;
+
+        const arma::vec dJ = (solver.get_dn_dt(n_plus) - solver.get_dn_dt(n_minus))/(2*h);
+
+        for(unsigned int i = 0; i < 2; ++i)
+            EXPECT_NEAR(dJ[i], J(i,j), 1e-6*std::abs(J(i,j)) + 1.0);
+    }
+}
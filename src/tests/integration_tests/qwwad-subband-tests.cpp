@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "qwwad/subband.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Check that the array versions of the dispersion and occupation lookups
+ * give the same results as the scalar versions
+ */
+static void check_batch_matches_scalar(const Subband &sb)
+{
+    const arma::vec k = arma::linspace(0, 5e8, 51);
+
+    arma::vec Ek;
+    sb.get_Ek_at_k(k, Ek);
+
+    arma::vec f_FD;
+    arma::vec Ek_occ;
+    sb.get_occupation_at_k(k, f_FD, Ek_occ);
+
+    arma::vec k_back;
+    sb.get_k_at_Ek(Ek, k_back);
+
+    ASSERT_EQ(k.size(), Ek.size());
+    ASSERT_EQ(k.size(), f_FD.size());
+    ASSERT_EQ(k.size(), k_back.size());
+
+    for(unsigned int ik = 0; ik < k.size(); ++ik)
+    {
+        const double Ek_scalar = sb.get_Ek_at_k(k[ik]);
+        EXPECT_NEAR(Ek_scalar, Ek[ik],     1e-12*Ek_scalar + 1e-30);
+        EXPECT_NEAR(Ek_scalar, Ek_occ[ik], 1e-12*Ek_scalar + 1e-30);
+        EXPECT_NEAR(sb.get_occupation_at_k(k[ik]), f_FD[ik], 1e-12);
+        EXPECT_NEAR(sb.get_k_at_Ek(Ek[ik]), k_back[ik], 1e-12*k[ik] + 1e-3);
+
+        // The dispersion and its inverse are consistent
+        EXPECT_NEAR(k[ik], k_back[ik], 1e-9*k[ik] + 1e-3);
+    }
+}
+
+TEST(Subband, batchLookupsMatchScalarParabolic)
+{
+    const arma::vec z   = arma::linspace(0, 10e-9, 3);
+    const arma::vec psi = arma::ones(3);
+
+    Subband sb(Eigenstate(50e-3*e, z, psi), 0.067*me);
+    sb.set_distribution_from_Ef_Te(60e-3*e, 77);
+
+    check_batch_matches_scalar(sb);
+}
+
+TEST(Subband, batchLookupsMatchScalarNonparabolic)
+{
+    const arma::vec z   = arma::linspace(0, 10e-9, 3);
+    const arma::vec psi = arma::ones(3);
+
+    Subband sb(Eigenstate(50e-3*e, z, psi), 0.067*me, 0.7/e, 10e-3*e);
+    sb.set_distribution_from_Ef_Te(60e-3*e, 300);
+
+    check_batch_matches_scalar(sb);
+}
+
+TEST(Subband, batchLookupsAcceptEmptyArrays)
+{
+    const arma::vec z   = arma::linspace(0, 10e-9, 3);
+    const arma::vec psi = arma::ones(3);
+
+    Subband sb(Eigenstate(0.0, z, psi), 0.067*me, 0.7/e, 0.0);
+    sb.set_distribution_from_Ef_Te(0.0, 77);
+
+    const arma::vec k;
+    arma::vec Ek(5);
+    arma::vec f_FD(5);
+    arma::vec k_back(5);
+    sb.get_Ek_at_k(k, Ek);
+    sb.get_occupation_at_k(k, f_FD, Ek);
+    sb.get_k_at_Ek(Ek, k_back);
+
+    EXPECT_TRUE(Ek.is_empty());
+    EXPECT_TRUE(f_FD.is_empty());
+    EXPECT_TRUE(k_back.is_empty());
+}